@@ -2,27 +2,65 @@
 #define ASTEROIDS_H
 
 #include <raylib.h>
+#include <stdbool.h>
+#include "ecs.h"
 
 // Defining constants
-#define MAX_ASTEROIDS  20
+#define MAX_ASTEROIDS  256   // slots, how many are used depends on the world size (worldAsteroidLimit)
 #define ASTEROID_SPEED 0.8f    // Reduced the asteroid speed from 2 to 1.0 (v1.0 had 2.0)
+#define ASTEROID_VERTICES 8    // points in the jagged outline
+#define ASTEROID_LOD_FULL  8.0f    // radius on screen in pixels from which the whole outline is drawn
+#define ASTEROID_LOD_POINT 2.0f    // below this only a point, in between every other point of the outline
 
-// Asteroids structure code
+#define ASTEROID_COMPONENTS (COMPONENT_BIT(COMPONENT_POSITION) | COMPONENT_BIT(COMPONENT_VELOCITY) | COMPONENT_BIT(COMPONENT_RADIUS) | \
+                             COMPONENT_BIT(COMPONENT_SPIN) | COMPONENT_BIT(COMPONENT_OUTLINE))
+
+// How an asteroid turns, the COMPONENT_SPIN column, in radians
+typedef struct AsteroidSpin {
+    float rotation;
+    float rotationSpeed;
+} AsteroidSpin;
+
+// Its outline in local space (unrotated, centered on 0,0), the COMPONENT_OUTLINE column
+typedef struct AsteroidOutline {
+    float x[ASTEROID_VERTICES + 1];    // the last point repeats the first so every edge is k -> k + 1
+    float y[ASTEROID_VERTICES + 1];
+} AsteroidOutline;
+
+// Asteroids structure code, one asteroid's components in one place: what GetAsteroid gathers from the
+// tables and PutAsteroid scatters back. The asteroids themselves live in the game's EcsWorld, at the
+// indices 0 to MAX_ASTEROIDS - 1 of their archetype
 typedef struct Asteroid {
     Vector2 position;
     Vector2 velocity;
     float   rotation;
     float   rotationSpeed;
     float   radius;
-    bool    active;
+    float   outlineX[ASTEROID_VERTICES + 1];    // outline in local space (unrotated, centered on 0,0)
+    float   outlineY[ASTEROID_VERTICES + 1];    // the last point repeats the first so every edge is k -> k + 1
 } Asteroid;
 
 // Function prototypes
 
-void InitAsteroid( Asteroid asteroids[] );
-void UpdateAsteroid( Asteroid asteroids[] );
-void DrawAsteroids( Asteroid asteroids[] );
-void SpawnAsteroids( Asteroid asteroids[] );
-void SplitAsteroid( Asteroid asteroids[], int index );
+void InitAsteroid( EcsWorld *world );                            // removes them all
+bool GetAsteroid( const EcsWorld *world, int index, Asteroid *asteroid );    // false when the index is free
+void PutAsteroid( EcsWorld *world, int index, const Asteroid *asteroid );    // spawned at the index if it was free
+void RemoveAsteroid( EcsWorld *world, int index );
+void MoveAsteroid( Vector2 *position, Vector2 velocity, AsteroidSpin *spin, int ticks );    // float or fixed point, picked at build time
+void DrawAsteroids( const EcsWorld *world, const int indices[], int count );
+int SpawnAsteroids( EcsWorld *world, int from );                 // the index it filled or -1, the scan starts at from
+void SplitAsteroid( EcsWorld *world, Vector2 position, float radius );    // the pieces of one that was just removed
+void BuildAsteroidOutline( Asteroid *asteroid );
+
+void UpdateAsteroidFloat( EcsWorld *world );
+void MoveAsteroidFloat( Vector2 *position, Vector2 velocity, AsteroidSpin *spin, int ticks );
+int SpawnAsteroidsFloat( EcsWorld *world, int from );
+void SplitAsteroidFloat( EcsWorld *world, Vector2 position, float radius );
+void UpdateAsteroidFixed( EcsWorld *world );
+void MoveAsteroidFixed( Vector2 *position, Vector2 velocity, AsteroidSpin *spin, int ticks );
+int SpawnAsteroidsFixed( EcsWorld *world, int from );
+void SplitAsteroidFixed( EcsWorld *world, Vector2 position, float radius );
+void BuildAsteroidOutlineFixed( Asteroid *asteroid );
+void AsteroidOutlinePoints( const Asteroid *asteroid, float sinA, float cosA, Vector2 points[ASTEROID_VERTICES + 1] );
 
 #endif
@@ -0,0 +1,40 @@
+/*
+ * Bots fly the ship through the same PlayerInput struct the keyboard and mouse fill in,
+ * so a bot plays by exactly the same rules as a person does.
+ */
+
+#ifndef BOT_H
+#define BOT_H
+
+#include <raylib.h>
+#include "game.h"
+#include "player.h"
+#include "spatial.h"
+
+#define BOT_DANGER_DISTANCE   90.0f            // start evading when an asteroid outline is this close
+#define BOT_AIM_TOLERANCE     6.0f             // degrees off target we still fire at
+#define BOT_FIRE_RANGE        600.0f           // don't waste shots on asteroids further away than this
+
+// What a bot gets to see: the game, read only, and the asteroid grid for queries
+typedef struct BotView {
+    const Game *game;
+    const Player *ship;                        // a copy of the ship the bot flies, a versus game has two
+    SpatialGrid *asteroidGrid;                 // queries use it as scratch space, nothing else changes
+} BotView;
+
+typedef PlayerInput (*BotThinkFunc)(void *state, const BotView *view);
+
+// Bot structure, state is whatever the bot wants to remember between ticks
+typedef struct Bot {
+    const char *name;
+    BotThinkFunc think;
+    void *state;
+} Bot;
+
+// Function prototypes
+PlayerInput RunBot(Bot *bot, Game *game);
+PlayerInput RunBotForShip(Bot *bot, Game *game, int ship);
+Bot CreateAimEvadeBot(void);
+PlayerInput RunAimEvadeBot(Game *game);
+
+#endif // BOT_H
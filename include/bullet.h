@@ -2,6 +2,8 @@
 #define BULLET_H 
 
 #include <raylib.h>
+#include <stdbool.h>
+#include "ecs.h"
 
 // Defining constants
 
@@ -12,21 +14,45 @@
 #define BULLET_SPREAD    2.0f                       // Slight spread when shooting (in degrees)
 
 
-// Bullets structure
+#define BULLET_FADE_TICKS 40                        // the last ticks of a bullet, it fades out over them
+#define BULLET_SLOTS     (2 * MAX_BULLETS)          // a pool of MAX_BULLETS per ship, the first ship's first
+
+#define BULLET_COMPONENTS (COMPONENT_BIT(COMPONENT_POSITION) | COMPONENT_BIT(COMPONENT_VELOCITY) | COMPONENT_BIT(COMPONENT_RADIUS) | \
+                           COMPONENT_BIT(COMPONENT_LIFETIME) | COMPONENT_BIT(COMPONENT_COLOR))
+
+// Bullets structure, one bullet's components in one place (GetBullet and PutBullet). The bullets
+// live in the game's EcsWorld at the indices 0 to BULLET_SLOTS - 1 of their archetype, the alpha
+// isn't kept anywhere, it follows from the lifetime (BulletAlpha)
 typedef struct Bullet {
     Vector2 position;
     Vector2 velocity;
     float radius;
-    bool active;
-    float lifeTime;
+    int lifeTime;                                   // ticks, the LIFETIME column
     Color color;                                    // Added color for visual variety
-    float alpha;                                    // Added alpha for fading effect
 } Bullet;
 
+// One ship's bullets copied out of the table in the order of their indices, the order the
+// collisions go through them in. The copies stay put when a hit destroys one of them
+typedef struct BulletList {
+    int      count;
+    EntityId entity[MAX_BULLETS];
+    Vector2  position[MAX_BULLETS];
+    Vector2  velocity[MAX_BULLETS];
+    float    radius[MAX_BULLETS];
+} BulletList;
+
 // Functions prototypes
-void InitBullets(Bullet bullets[]);
-void UpdateBullets(Bullet bullets[]);
-void DrawBullets(Bullet bullets[]);
-void ShootBullets(Bullet bullets[], Vector2 position, float rotation);
+void InitBullets(EcsWorld *world, int ship);                                          // removes the ship's bullets
+bool GetBullet(const EcsWorld *world, int index, Bullet *bullet);                     // false when the index is free
+void PutBullet(EcsWorld *world, int index, const Bullet *bullet);                     // spawned at the index if it was free
+void ListShipBullets(const EcsWorld *world, int ship, BulletList *list);
+float BulletAlpha(int lifeTime);
+void UpdateBullets(EcsWorld *world);                                                  // float or fixed point, picked at build time
+void UpdateBulletsFloat(EcsWorld *world);
+void UpdateBulletsFixed(EcsWorld *world);
+void DrawBullets(const EcsWorld *world);
+void ShootBullets(EcsWorld *world, int ship, Vector2 position, float rotation);       // rotation in degrees
+void ShootBulletsFloat(EcsWorld *world, int ship, Vector2 position, float rotation);
+void ShootBulletsFixed(EcsWorld *world, int ship, Vector2 position, float rotation);
 
 #endif                 // BULLET_H end config
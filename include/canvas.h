@@ -0,0 +1,29 @@
+/*
+ * The virtual canvas everything is drawn on. It is always screenWidth x screenHeight (SCREEN_WIDTH
+ * x SCREEN_HEIGHT, or what a stream or replay was made with), whatever size the window is. Picking
+ * a resolution or going fullscreen only changes how big the canvas is shown: it is scaled to the
+ * window in one textured quad at the end of the frame, with black bars where the shapes differ.
+ *
+ * The canvas texture is the canvas size times the render scale, so a 4K monitor doesn't mean four
+ * times the pixels to fill, and a render scale under 1 makes it cheaper still on slow machines.
+ */
+
+#ifndef CANVAS_H
+#define CANVAS_H
+
+#include <raylib.h>
+
+#define MIN_RENDER_SCALE     0.25f
+#define MAX_RENDER_SCALE     2.0f      // above 1 is supersampling
+
+// Function prototypes
+void InitCanvas(float renderScale);                  // after InitWindow, screenWidth and screenHeight set
+void UnloadCanvas(void);
+void SetRenderScale(float renderScale);              // clamped, reloads the texture when it changes
+float CanvasScale(void);                             // texture pixels per canvas pixel
+
+void BeginCanvas(void);                              // instead of BeginDrawing
+void EndCanvas(void);                                // instead of EndDrawing, shows the canvas in the window
+void BeginCanvasMode(void);                          // back to canvas coordinates after an EndMode2D
+
+#endif // CANVAS_H
@@ -0,0 +1,41 @@
+/*
+ * What the state stream sends instead of the derived fields of an entity. A bullet's row in the
+ * entity tables is 28 bytes and an asteroid's 100, much of which is there for the drawing's
+ * convenience: the bullet's color (it follows from which of the three bullets of a volley it is,
+ * its alpha isn't stored at all but follows from the lifetime, see BulletAlpha) and the asteroid's
+ * outline (its wobble is one sine with one phase, see BuildAsteroidOutline). Here they are a byte
+ * each and the viewer works the rest out again:
+ *
+ *   radius          half pixels, every radius the game makes is a whole or half pixel
+ *   bullet color    index into the volley's palette, the radius and the color both follow from it
+ *   outline         the phase of the wobble, the outline is built again from it
+ *
+ * STREAM_VERSION 4 sends these as the slot attributes. tools/bench_compact checks every round trip
+ * of them against what the game had.
+ */
+
+#ifndef COMPACT_H
+#define COMPACT_H
+
+#include <raylib.h>
+#include "asteroids.h"
+#include "bullet.h"
+
+#define COMPACT_PHASES          256            // of the outline's wobble
+
+// The three bullets of a volley, see ActivateBullet
+typedef enum BulletKind {
+    BULLET_CENTER,                             // white, the bigger one
+    BULLET_LEFT,                               // blue
+    BULLET_RIGHT,                              // yellow
+    BULLET_KINDS
+} BulletKind;
+
+// Function prototypes
+BulletKind FindBulletKind(const Bullet *bullet);                   // the nearest of the palette
+Color BulletKindColor(BulletKind kind);
+float BulletKindRadius(BulletKind kind);
+int AsteroidOutlinePhase(const Asteroid *asteroid);                // 0 to COMPACT_PHASES - 1
+void RebuildAsteroidOutline(Asteroid *asteroid, int phase);        // the radius has to be set
+
+#endif // COMPACT_H
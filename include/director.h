@@ -0,0 +1,60 @@
+/*
+ * The wave director. The asteroids and the saucers used to come from a roll every tick, the same
+ * at any difficulty and at any point of the game. Now the game runs in waves of WAVE_SECONDS, and
+ * when a wave starts the director draws all of its spawn times at once and sorts them into a
+ * timeline. A tick only looks at the next entry of it.
+ *
+ * How many spawns a wave gets comes from the difficulty (fixed when the game starts, versus games
+ * always play on normal so both sides agree) and from how many waves went before. Normal's first
+ * wave has what the old rolls gave, ASTEROID_SPAWN_CHANCE in 101 per tick for the asteroids and
+ * one in UFO_SPAWN_ODDS for the saucers (none in the first UFO_FIRST_TICK), and every later wave
+ * a bit more, up to a cap. The saucers are what the ship mostly dies of, so they are where the
+ * difficulty shows the most.
+ *
+ * Every asteroid can still break into pieces: anything bigger than 20 into two of half its size,
+ * and those (20 and less) not again, so a spawn of 20 to 40 is one or two pieces. Before a spawn
+ * the director counts what the asteroids on the field can become, and when the new one could
+ * take that past the difficulty's budget the spawn is held back. A saucer is held back while
+ * there already is one per screen of world. That keeps the entities (and what the collisions and
+ * the draw cost) under a bound no wave can push past. No budget is more than worldAsteroidLimit,
+ * the slots spawns and splits have, so a split always finds room for both of its pieces.
+ *
+ * All of it is integer math on the simulation's random numbers and lives in the SimSnapshot, so
+ * rewinds, replays and network games carry it like the rest of the state.
+ */
+
+#ifndef DIRECTOR_H
+#define DIRECTOR_H
+
+#include <stdbool.h>
+#include "asteroids.h"
+#include "ecs.h"
+
+#define WAVE_SECONDS          30
+#define WAVE_MAX_SPAWNS       80               // timeline entries per wave, the caps of every difficulty stay below it
+#define DIRECTOR_DIFFICULTIES 3                // settings.difficulty: 0 easy, 1 normal, 2 hard
+#define DIRECTOR_NORMAL       1
+
+typedef struct WaveDirector {
+    int            difficulty;                 // for the whole game, see StartWaveDirector
+    int            wave;                       // 1 for the first, 0 before it started
+    unsigned int   waveStart;                  // game tick the wave started on
+    unsigned short timeline[WAVE_MAX_SPAWNS];  // ticks from the wave start * 2, + 1 for a saucer, sorted
+    int            spawnCount;
+    int            nextSpawn;                  // first timeline entry still to come
+
+    int            spawned;                    // this game, shown with the FPS counter
+    int            saucers;
+    int            heldBack;                   // spawns the budget turned away
+    int            peakPieces;                 // the most the field could have broken into
+} WaveDirector;
+
+// Function prototypes
+void StartWaveDirector(WaveDirector *director, int difficulty, unsigned int tick);   // and builds the first wave
+void RunWaveDirector(WaveDirector *director, EcsWorld *world, bool saucers, int score, unsigned int tick);   // once per tick, versus games skip the saucers
+int WaveSpawnCount(int difficulty, int wave);                                         // asteroids in a wave's timeline
+int WaveSaucerCount(int difficulty, int wave);
+int DirectorPieceBudget(int difficulty);                                              // for the current world size
+int AsteroidPieces(const EcsWorld *world);                                            // what the asteroids can still break into
+
+#endif // DIRECTOR_H
@@ -0,0 +1,109 @@
+/*
+ * Entities made of components, stored by archetype. Every set of components that is in use
+ * (an archetype) gets a table with one densely packed column per component, so a system that
+ * needs positions and velocities walks two plain arrays with nothing else in between, for every
+ * archetype that has both. Adding an enemy type is a new set of components and a system or two,
+ * not another array in Game and another copy of every loop.
+ *
+ * Every archetype also owns a range of entity slots, as many as it has rows. Where in its range
+ * an entity sits is its index, which stays put while the rows move around underneath, so the
+ * ships, asteroids and bullets keep the numbers they had when they were arrays: the game declares
+ * their tables at their pool sizes up front (InitGameWorld) and spawns into a given index when
+ * the order matters.
+ *
+ * All the storage is fixed and lives inside the EcsWorld, no pointers and no heap, so a world is
+ * copied into a snapshot with the rest of the simulation and restored by copying it back. Which
+ * slot and row an entity gets only depends on what happened before, never on addresses, so two
+ * games fed the same inputs lay out their entities the same way.
+ */
+
+#ifndef ECS_H
+#define ECS_H
+
+#include <raylib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define ECS_MAX_ENTITIES      544              // slots across all archetypes, the game's tables take 538 of them
+#define ECS_MAX_ARCHETYPES    8
+#define ECS_DEFAULT_ROWS      64               // for an archetype that is spawned into without being declared first
+#define ECS_DATA_BYTES        (36 * 1024)      // component storage of all the tables together, the game's take about 33 KB
+
+// The components there are. The archetypes are made from these, a new entity type adds its own
+typedef enum ComponentId {
+    COMPONENT_POSITION,                        // Vector2
+    COMPONENT_VELOCITY,                        // Vector2, added to the position every tick
+    COMPONENT_RADIUS,                          // float, for collisions and culling
+    COMPONENT_LIFETIME,                        // int, ticks left, the entity goes when it runs out
+    COMPONENT_UFO,                             // UfoBrain (ufo.h)
+    COMPONENT_SPIN,                            // AsteroidSpin (asteroids.h)
+    COMPONENT_OUTLINE,                         // AsteroidOutline (asteroids.h)
+    COMPONENT_COLOR,                           // Color
+    COMPONENT_SHIP,                            // ShipState (player.h)
+    COMPONENT_HOSTILE,                         // no data, marks the saucers and their shots
+    COMPONENT_COUNT
+} ComponentId;
+
+typedef uint32_t ComponentMask;
+#define COMPONENT_BIT(component) ((ComponentMask)1 << (component))
+
+// Entity ids are the slot plus one in the low 16 bits and the slot's generation above, 0 is no entity
+typedef uint32_t EntityId;
+#define ECS_NO_ENTITY 0u
+
+// One table per archetype, a column per component it has, rows packed from 0 to count - 1
+typedef struct EcsArchetype {
+    ComponentMask mask;
+    int           count;
+    int           capacity;                         // rows, and entity slots from firstSlot on
+    int           firstSlot;
+    uint32_t      columnOffset[COMPONENT_COUNT];    // where each column starts in the world's data, for the components in the mask
+} EcsArchetype;
+
+// Where an entity slot's components are
+typedef struct EcsRecord {
+    uint16_t generation;                       // bumped every time the slot is freed, so old ids stop matching
+    uint8_t  alive;
+    uint8_t  archetype;
+    uint16_t row;
+    uint16_t reserved;
+} EcsRecord;
+
+typedef struct EcsWorld {
+    int          archetypeCount;
+    int          slotsUsed;                    // handed out to archetypes so far
+    int          bytesUsed;                    // of data
+    EcsArchetype archetypes[ECS_MAX_ARCHETYPES];
+    EcsRecord    records[ECS_MAX_ENTITIES];
+    uint16_t     rowSlot[ECS_MAX_ENTITIES];    // the slot of the entity in every row, an archetype's rows start at its firstSlot
+    _Alignas(8) unsigned char data[ECS_DATA_BYTES];
+} EcsWorld;
+
+// Walks the archetypes that have every component of a mask, one table at a time
+typedef struct EcsQuery {
+    EcsWorld     *world;
+    ComponentMask mask;
+    int           next;                        // archetype to look at next
+    EcsArchetype *archetype;                   // the current one, after EcsNextArchetype returned true
+    int           count;                       // its rows
+} EcsQuery;
+
+// Function prototypes, the ones taking a const world hand out writable components like strchr does
+void InitEcsWorld(EcsWorld *world);
+int EcsDeclareArchetype(EcsWorld *world, ComponentMask mask, int capacity);    // -1 when the slots or the storage run out
+EntityId EcsSpawn(EcsWorld *world, ComponentMask mask);           // components start zeroed, at the lowest free index, ECS_NO_ENTITY when full
+EntityId EcsSpawnAt(EcsWorld *world, ComponentMask mask, int index);    // ECS_NO_ENTITY when that index is taken
+void EcsDestroy(EcsWorld *world, EntityId entity);                // the last row moves into its place
+bool EcsAlive(const EcsWorld *world, EntityId entity);
+void *EcsGet(const EcsWorld *world, EntityId entity, ComponentId component);
+EntityId EcsEntityAt(const EcsWorld *world, ComponentMask mask, int index);    // ECS_NO_ENTITY when the index is free
+int EcsCount(const EcsWorld *world, ComponentMask mask);          // entities that have all of these
+int EcsCapacity(const EcsWorld *world, ComponentMask mask);       // indices of that exact archetype, 0 before it exists
+
+EcsQuery EcsQueryAll(const EcsWorld *world, ComponentMask mask);
+bool EcsNextArchetype(EcsQuery *query);
+void *EcsColumn(const EcsQuery *query, ComponentId component);
+EntityId EcsRowEntity(const EcsQuery *query, int row);
+int EcsRowIndex(const EcsQuery *query, int row);
+
+#endif // ECS_H
@@ -0,0 +1,72 @@
+/*
+ * Fixed-point math for the deterministic simulation build (make FIXED_SIM=1). Everything here is
+ * integer arithmetic, so it gives the same bits with any compiler, optimization level and libm:
+ * no float rounding, no fused multiply-adds and no sin/cos that differ in the last bit between
+ * machines. Values are Q16.16, angles are binary angles (65536 per turn) looked up in a table.
+ *
+ * The game structs keep their float fields. The fixed path reads a float, does all of its math
+ * in integers and stores the result back as a float, both conversions are exactly defined by
+ * IEEE 754 so that doesn't bring any of the differences back. Positions have to stay inside
+ * +-32767 pixels for Q16.16 to hold them.
+ */
+
+#ifndef FIXED_H
+#define FIXED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef int32_t  Fixed;                        // Q16.16
+typedef uint16_t BinaryAngle;                  // 65536 per turn, wraps around on its own
+
+#define FIXED_SHIFT         16
+#define FIXED_ONE           (1 << FIXED_SHIFT)
+#define FIXED_SINE_STEPS    256                // table entries per quarter turn, linear in between
+
+// A constant in Q16.16, the compiler rounds it once at build time
+#define FIXED_CONST(x)      ((Fixed)((x) >= 0 ? (x) * 65536.0 + 0.5 : (x) * 65536.0 - 0.5))
+#define FIXED_INT(x)        ((Fixed)(x) * FIXED_ONE)
+
+#define FIXED_TWO_PI        FIXED_CONST(6.283185307179586)
+#define FIXED_DEG2RAD       FIXED_CONST(0.017453292519943295)
+#define ANGLE_QUARTER_TURN  16384
+#define ANGLE_HALF_TURN     32768
+
+// Small helpers, inline so the per-entity loops don't pay for a call
+static inline Fixed FixedMul(Fixed a, Fixed b)      // rounded to nearest
+{
+    return (Fixed)(((int64_t)a * b + (FIXED_ONE / 2)) >> FIXED_SHIFT);
+}
+
+static inline Fixed FixedDiv(Fixed a, Fixed b)      // truncated toward zero
+{
+    return (Fixed)(((int64_t)a * FIXED_ONE) / b);
+}
+
+static inline Fixed FixedFromFloat(float value)     // exact for anything a float holds at 1/65536 or coarser
+{
+    return (Fixed)(value * 65536.0f);
+}
+
+static inline float FixedToFloat(Fixed value)       // rounded to the nearest float
+{
+    return (float)value * (1.0f / 65536.0f);
+}
+
+static inline Fixed FixedAbs(Fixed value)
+{
+    return value < 0 ? -value : value;
+}
+
+// Function prototypes
+Fixed FixedSin(BinaryAngle angle);                  // max error 2/65536
+Fixed FixedCos(BinaryAngle angle);
+BinaryAngle FixedAtan2(Fixed y, Fixed x);           // within 2 of the true angle, 0 for (0, 0)
+Fixed FixedLength(Fixed x, Fixed y);                // sqrt(x*x + y*y), truncated
+uint32_t IntegerSqrt64(uint64_t value);             // floor(sqrt(value))
+
+BinaryAngle FixedDegreesToAngle(Fixed degrees);
+BinaryAngle FixedRadiansToAngle(Fixed radians);
+Fixed FixedWrapCoordinate(Fixed value, Fixed size); // same rule as WrapPosition: past an edge goes to the other edge
+
+#endif // FIXED_H
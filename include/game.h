@@ -2,12 +2,18 @@
 #define GAME_H
 
 #define MAX_RESOLUTIONS 4    // Number of supported resolutions NEW
+#define GAME_TICK_RATE  60   // UpdateGame() is called this many times per second
+#define SAFE_SPAWN_CLEARANCE 120.0f   // distance the ship wants between itself and any asteroid on respawn
 
 #include "asteroids.h"
 #include "bullet.h"
 #include "player.h"
+#include "snapshot.h"
 #include "sound.h"
+#include "spatial.h"
 #include "stars.h"    // included the stars.h wasnt present in v1.0
+#include "tunables.h"
+#include "director.h"
 
 #include <raylib.h>
 
@@ -33,16 +39,16 @@ typedef struct GameSettings {
     bool showFPS;
     int  difficulty;    // 0 - easy, 1 - normal, 2 - Hard
     bool fullscreen;    // Added the fullscreen flag NEW!
+    float renderScale;  // size of the canvas texture next to the canvas, see canvas.h
 } GameSettings;
 
 // Game Architecture
 typedef struct Game {
     GameState     state;
     int           score;
-    Player        player;    // still missing needs to be implemented in player.h first
-    Asteroid      asteroids[MAX_ASTEROIDS];
-    Bullet        bullets[MAX_BULLETS];
     Star          stars[MAX_STARS];    // added the array of Star structures that we need
+    EcsWorld      entities;            // the ships, asteroids, bullets and saucers, see InitGameWorld and ecs.h
+    WaveDirector  director;            // when the asteroids come, see director.h
     int           selectedOption;      // used for tracking which menu option has been selected
     GameSettings  settings;            // structure containg game settings to the game
     int           highScore;           // added additionally as well not present in v1.0
@@ -51,8 +57,38 @@ typedef struct Game {
     int           defaultScreenWidth;
     int           defaultScreenHeight;
     SoundManager *soundManager;    // Added sound manager pointer
+    SpatialGrid   asteroidGrid;    // acceleration structure over the asteroids, rebuilt from them at any time
+    SpatialGrid   chunkGrid;       // the same with WORLD_CHUNK_SIZE cells, what is in every chunk of the world
+    unsigned int  rngState;        // simulation random generator, see SimRandomValue()
+    Tunables      tunables;        // speeds, handling and odds this game plays with, see tunables.h
+    unsigned int  tick;            // gameplay ticks since the last reset
+    bool          autopilot;       // F2, the built-in bot flies the ship instead of the player
+    RewindBuffer  rewind;          // the last REWIND_SECONDS of gameplay, R plays it backwards
+    bool          rewinding;       // R is held this tick
+
+    // Versus games, two ships in the same field (see StartVersusGame)
+    bool          versus;          // the second ship is ship 1 of the entities, its bullets the second bullet pool
+    int           secondScore;
+    int           versusLoser;     // ship that got hit, 0 or 1, 2 if both were hit on the same tick, -1 while playing
+    struct RollbackSession *netSession;   // set while a network game is running, owned by main()
+    struct ReplayWriter *replayWriter;    // set while --record is on, owned by main()
+    struct InputLatch *inputLatch;        // set by main(), gameplay reads the keys through it (input.h)
+    struct FramePacer *pacer;             // set by main(), only read for the FPS overlay (pacing.h)
+    struct Telemetry *telemetry;          // set while --telemetry is on, owned by main() (telemetry.h)
+    struct SaveWriter *saveWriter;        // set by main(), F5 and the high score are saved through it (savegame.h)
+    const char   *notice;          // "GAME SAVED" and the like, shown for noticeTicks more ticks
+    int           noticeTicks;
 } Game;
 
+// What the sounds of a tick are worked out from, taken right before it (see PlayTickSounds)
+typedef struct TickSounds {
+    bool      wasThrusting;
+    int       shootCooldown;
+    GameState state;
+    int       score;
+    int       ufoShots;
+} TickSounds;
+
 /* 
  * If a bullet was just an array: -> {1, 2, 3, 4}
  * 
@@ -61,8 +97,19 @@ typedef struct Game {
 
 // Function prototypes
 void initGame( Game *game );
+void InitHeadlessGame( Game *game, unsigned int seed );
+void InitTunedHeadlessGame( Game *game, unsigned int seed, const Tunables *tunables );
+void InitGameWorld( EcsWorld *world );
 void UpdateGame( Game *game );
+void StepGameplay( Game *game, const PlayerInput *input );
+void StartVersusGame( Game *game, unsigned int seed );
+void StepVersusGameplay( Game *game, const PlayerInput inputs[2] );
 void DrawGame( Game *game );
 void ResetGame( Game *game );
+void UnloadGame( Game *game );
+void RefreshAsteroidGrid( Game *game );
+Vector2 FindSafeSpawnPosition( Game *game, Vector2 preferred );
+void NoteTickSounds( const Game *game, TickSounds *before );
+void PlayTickSounds( Game *game, const TickSounds *before );
 
 #endif    // ending GAME_H config
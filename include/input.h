@@ -0,0 +1,88 @@
+/*
+ * Late latched input. raylib polls the devices once per frame, at the end of EndDrawing, and the
+ * frame after that is simulated, drawn and then waits for the swap, so a key pressed just after the
+ * poll waits most of two frames before it shows. During gameplay the latch sleeps through the part
+ * of the frame the update and draw don't need, polling every millisecond, and the tick starts from
+ * what the last of those polls saw. The frame is still presented at the same vblank, the input
+ * going into it is just more than ten milliseconds newer.
+ *
+ * Every poll turns what changed into timestamped events, including the taps that went down and
+ * up between two polls (raylib only has those in its GetKeyPressed queue). The events are applied
+ * to the ticks in order, a second press of a key that is already pressed this tick waits for the
+ * next tick, so two quick taps are two shots and not one.
+ *
+ * Timestamps are the poll that saw the event, never earlier than the real press, so the latency
+ * numbers are what the latch adds on top of the operating system, not all of it.
+ *
+ * While latching the frame has several polls, so raylib's IsKeyPressed can miss a press that came
+ * in an earlier one. Everything gameplay reads goes through LatchedKeyPressed instead, the menus
+ * don't latch and keep using raylib directly.
+ */
+
+#ifndef INPUT_H
+#define INPUT_H
+
+#include <raylib.h>
+#include <stdbool.h>
+#include "player.h"
+
+#define INPUT_KEYS             512             // raylib key codes stay under 350, the mouse buttons go at the top
+#define INPUT_MOUSE_LEFT       510
+#define INPUT_MOUSE_RIGHT      511
+#define INPUT_MAX_EVENTS       64              // waiting to be applied, the oldest go when it overflows
+#define INPUT_LATENCY_SAMPLES  1024            // latest presses the percentiles are taken over
+#define INPUT_POLL_SECONDS     0.001           // between polls while the latch sleeps
+#define INPUT_LATCH_MARGIN     0.003           // seconds left over for the driver and the GPU after the draw calls
+#define INPUT_WORK_DECAY       0.02            // how fast the work estimate comes back down after a long frame
+
+// One change of one key, seen by the poll at time
+typedef struct InputEvent {
+    double time;                               // GetTime() of the poll that saw it
+    int    key;                                // raylib key code, or INPUT_MOUSE_LEFT or INPUT_MOUSE_RIGHT
+    bool   down;
+} InputEvent;
+
+// The last few hundred latencies of one kind, in milliseconds
+typedef struct LatencySamples {
+    float samples[INPUT_LATENCY_SAMPLES];
+    int   count;                               // filled, up to INPUT_LATENCY_SAMPLES
+    int   next;                                // where the next one goes
+} LatencySamples;
+
+typedef struct InputLatch {
+    bool           lateLatching;               // off with --no-late-input, the latch still orders and times the events
+    InputEvent     events[INPUT_MAX_EVENTS];   // ring, oldest first from firstEvent
+    int            firstEvent;
+    int            eventCount;
+    unsigned char  seenDown[INPUT_KEYS];       // what the polls saw last
+    unsigned char  appliedDown[INPUT_KEYS];    // after the events the ticks have taken so far
+    unsigned char  tickDown[INPUT_KEYS];       // down at the end of this tick's events, or pressed during them
+    unsigned char  tickPressed[INPUT_KEYS];    // went down during this tick's events
+
+    double         workStart;                  // when the latch let the frame go
+    double         workEstimate;               // seconds from there to the draw calls being in, the longest lately
+    double         latchedAt;                  // when the current frame's input was taken
+
+    double         pendingPress[INPUT_MAX_EVENTS];   // presses in this frame, timed again when it is presented
+    int            pendingCount;
+
+    LatencySamples toSimulation;               // press to the tick that used it
+    LatencySamples toPresent;                  // press to the swap of the frame that showed it
+    double         sleptSeconds;               // total time the latch slept, to show what it moved
+    unsigned long  frames;
+    unsigned long  tapsCaught;                 // presses that were already up again at the poll
+} InputLatch;
+
+// Function prototypes
+void InitInputLatch(InputLatch *latch, bool lateLatching);
+void LatchInput(InputLatch *latch, double secondsLeft);     // before the update, sleeps into the time left before the swap (0 doesn't), hands the tick its events
+void MarkInputFrameDrawn(InputLatch *latch);                // just before EndCanvas, the work the latch has to leave room for ends here
+void FinishInputFrame(InputLatch *latch);                   // right after EndCanvas, times the presented frame and reads its poll
+
+bool LatchedKeyPressed(const InputLatch *latch, int key);   // pressed during this tick, taps included
+bool LatchedKeyDown(const InputLatch *latch, int key);      // down during this tick, or pressed and let go within it
+PlayerInput ReadLatchedInput(const InputLatch *latch, const Player *player);   // the latched ReadPlayerInput
+
+float LatencyPercentile(const LatencySamples *latency, float percent);
+
+#endif // INPUT_H
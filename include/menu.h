@@ -18,8 +18,9 @@
 #define MENU_DIFFICULTY                 3
 #define MENU_RESOLUTION                 4
 #define MENU_FULLSCREEN                 5                           // added this new setting for fullscreen game NEW
-#define MENU_BACK                       6
-#define MENU_OPTIONS_COUNT              7
+#define MENU_RENDER_SCALE               6
+#define MENU_BACK                       7
+#define MENU_OPTIONS_COUNT              8
 
                                                                     // Making function prototypes for the fully functional menu
 void DrawMainMenu(Game *game);
@@ -0,0 +1,20 @@
+/*
+ * Exact collision tests against the asteroid outline and the ship triangle. These run
+ * only for pairs whose bounding circles already touch, the circle test stays in front of
+ * them as the cheap early out.
+ */
+
+#ifndef NARROWPHASE_H
+#define NARROWPHASE_H
+
+#include <raylib.h>
+#include <stdbool.h>
+#include "asteroids.h"
+
+// Function prototypes
+float SegmentOutlineImpact(const Asteroid *asteroid, Vector2 from, Vector2 to);              // local space, NO_IMPACT if it misses
+float BulletAsteroidImpact(const Asteroid *asteroid, Vector2 asteroidStart, Vector2 bulletStart, Vector2 bulletEnd);
+bool ShipTouchesAsteroid(const Vector2 ship[3], const Asteroid *asteroid);
+bool PointInShip(const Vector2 ship[3], Vector2 point);
+
+#endif // NARROWPHASE_H
@@ -0,0 +1,55 @@
+/*
+ * Small UDP link between two peers for network games. It can also pretend to be a bad
+ * network: packets are held back for a latency plus some random jitter and some of them
+ * are dropped, so rollback can be tested on localhost.
+ */
+
+#ifndef NET_H
+#define NET_H
+
+#include <stdbool.h>
+#include <netinet/in.h>
+
+#define NET_DEFAULT_PORT   27960
+#define NET_MAX_PACKET     512                 // largest packet we send or accept
+#define NET_DELAY_QUEUE    256                 // packets that can be held back at once
+
+// Artificial network conditions, all zero is a normal link
+typedef struct NetConditions {
+    float latencyMs;                           // one way, added to everything we send
+    float jitterMs;                            // random extra delay between -jitter and +jitter
+    float lossPercent;                         // chance that a packet never leaves
+} NetConditions;
+
+typedef struct DelayedPacket {
+    double sendAt;
+    int size;
+    unsigned char data[NET_MAX_PACKET];
+} DelayedPacket;
+
+typedef struct NetLink {
+    int socket;
+    struct sockaddr_in peer;
+    bool hasPeer;                              // the host learns the address from the first packet
+    NetConditions conditions;
+    DelayedPacket *queue;                      // packets waiting for their time to go out
+    int queued;
+    unsigned int randomState;                  // for jitter and loss, separate from the simulation
+
+    unsigned long packetsSent;
+    unsigned long packetsDropped;
+    unsigned long packetsReceived;
+    unsigned long bytesSent;
+    unsigned long bytesReceived;
+} NetLink;
+
+// Function prototypes
+bool OpenNetLink(NetLink *link, unsigned short port, NetConditions conditions);     // port 0 picks any free one
+bool SetNetPeer(NetLink *link, const char *host, unsigned short port);
+unsigned short GetNetLinkPort(const NetLink *link);
+void SendNetPacket(NetLink *link, const void *data, int size, double now);
+void FlushNetLink(NetLink *link, double now);                  // sends held back packets that are due
+int ReceiveNetPacket(NetLink *link, void *buffer, int size);   // size of the packet, -1 when there is none
+void CloseNetLink(NetLink *link);
+
+#endif // NET_H
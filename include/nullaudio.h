@@ -0,0 +1,60 @@
+/*
+ * Null audio device: a small software mixer that stands in for the real
+ * audio device when there is no sound card (test hosts, headless runs).
+ * Sounds are mixed into memory at the simulation rate and can be written
+ * out as a WAV file afterwards.
+ */
+
+#ifndef NULLAUDIO_H
+#define NULLAUDIO_H
+
+#include <raylib.h>
+#include <stdbool.h>
+
+#define NULL_AUDIO_SAMPLE_RATE     44100           // output sample rate of the mixer
+#define NULL_AUDIO_CHANNELS        2               // always mixed to 16-bit stereo
+#define NULL_AUDIO_MAX_WAVES       8               // one slot per SoundType (same as MAX_SOUNDS)
+#define NULL_AUDIO_MUSIC_MENU      0
+#define NULL_AUDIO_MUSIC_GAME      1
+#define NULL_AUDIO_MUSIC_TRACKS    2
+
+// A voice is one playing instance of a wave, just like a raylib Sound can only play once at a time
+typedef struct NullAudioVoice {
+    const short *samples;                          // interleaved stereo samples (points into a loaded wave)
+    unsigned int frameCount;
+    unsigned int cursor;                           // next frame to mix
+    float volume;
+    bool looping;
+    bool playing;
+} NullAudioVoice;
+
+typedef struct NullAudioDevice {
+    Wave waves[NULL_AUDIO_MAX_WAVES];              // sound effects converted to the mixer format
+    Wave music[NULL_AUDIO_MUSIC_TRACKS];           // music tracks converted to the mixer format
+    NullAudioVoice voices[NULL_AUDIO_MAX_WAVES];
+    NullAudioVoice musicVoices[NULL_AUDIO_MUSIC_TRACKS];
+
+    bool capture;                                  // keep the mixed output so it can be exported
+    short *output;                                 // interleaved stereo output of every tick so far
+    unsigned int outputFrames;
+    unsigned int outputCapacity;
+
+    unsigned long long mixedFrames;                // counters used for profiling the mixer
+    double mixSeconds;
+} NullAudioDevice;
+
+// Function prototypes
+void InitNullAudio(NullAudioDevice *device, bool capture);
+void CloseNullAudio(NullAudioDevice *device);
+bool LoadNullAudioWave(NullAudioDevice *device, int slot, const char *fileName);
+bool LoadNullAudioMusic(NullAudioDevice *device, int track, const char *fileName);
+void PlayNullAudioWave(NullAudioDevice *device, int slot, float volume);
+void PlayNullAudioMusic(NullAudioDevice *device, int track, float volume);
+void StopNullAudioMusic(NullAudioDevice *device, int track);
+void PauseNullAudioMusic(NullAudioDevice *device, int track);
+void SetNullAudioMusicVolume(NullAudioDevice *device, int track, float volume);
+bool IsNullAudioMusicPlaying(NullAudioDevice *device, int track);
+void MixNullAudio(NullAudioDevice *device, unsigned int frames);
+bool ExportNullAudio(NullAudioDevice *device, const char *fileName);
+
+#endif // NULLAUDIO_H
@@ -0,0 +1,79 @@
+/*
+ * Frame pacing. raylib's SetTargetFPS sleeps after the swap for whatever is left of the frame, on
+ * top of vsync, and on a compositor that ignores vsync it is the only clock there is: its sleep
+ * wakes up late by a different amount every frame and the frames come out uneven. The pacer keeps
+ * its own schedule of deadlines instead and measures when the frames really went out.
+ *
+ *   PACE_POWER_SAVING   vsync on. As long as the swaps take long enough to show they wait for the
+ *                       display, that is the clock and nothing else waits. When they don't (the
+ *                       driver or compositor ignores vsync) the pacer sleeps until the deadline,
+ *                       never spins, so the CPU is idle between frames either way
+ *   PACE_LOW_LATENCY    vsync off, nothing queued behind the swap. Sleeps until a little before
+ *                       the deadline and spins the rest, the spin is as long as the sleeps have
+ *                       lately been late by, so the frame goes out within a few microseconds
+ *   PACE_UNCAPPED       no waiting and no vsync, for benchmarking. The game runs faster than real
+ *                       time, every frame is still one tick
+ *
+ * A frame that runs long moves the schedule to start from when it went out, the next frames
+ * don't try to catch up on the time that was lost.
+ *
+ * The pacer has its own monotonic clock so it works without a window (tools/bench_pacing).
+ */
+
+#ifndef PACING_H
+#define PACING_H
+
+#include <stdbool.h>
+
+#define PACE_HISTOGRAM_BUCKETS  32
+#define PACE_BUCKET_SECONDS     0.0005         // histogram of interval minus period, 0.5 ms per bucket
+#define PACE_HISTOGRAM_LOW      -0.004         // the first bucket starts here, the last one ends at +12 ms
+#define PACE_MIN_SPIN           0.0002         // seconds, the spin never gets shorter than this
+#define PACE_MAX_SPIN           0.004
+#define PACE_SWAP_BLOCKING      0.001          // seconds, a swap that takes this long on average is waiting for the display
+#define PACE_LATE_SECONDS       0.0005         // a frame that goes out this much after its deadline was late
+
+typedef enum PaceMode {
+    PACE_POWER_SAVING,
+    PACE_LOW_LATENCY,
+    PACE_UNCAPPED,
+    PACE_MODE_COUNT
+} PaceMode;
+
+typedef struct FramePacer {
+    PaceMode      mode;
+    double        period;                      // seconds per frame, 1 / GAME_TICK_RATE
+    double        deadline;                    // when the frame being made should go to the swap, 0 before the first
+    double        lastPresent;
+    double        intervalAverage;             // smoothed present interval, seconds
+    double        swapStart;                   // when WaitForFrameDeadline returned
+    double        swapAverage;                 // smoothed time the swaps took, tells whether vsync is doing the pacing
+    double        spinSeconds;                 // low latency: sleeping stops this long before the deadline
+    double        oversleep;                   // how late the sleeps woke up lately, decays slowly
+
+    unsigned long frames;                      // presented frames with an interval, the first has none
+    unsigned long longFrames;                  // went out after their deadline and moved the schedule
+    unsigned long histogram[PACE_HISTOGRAM_BUCKETS];
+    double        errorSum;                    // interval minus period, for the mean and the spread
+    double        errorSquares;
+    double        worstError;
+    double        sleptSeconds;
+    double        spunSeconds;
+} FramePacer;
+
+// Function prototypes
+void InitFramePacer(FramePacer *pacer, PaceMode mode, double period);
+bool PaceModeFromName(const char *name, PaceMode *mode);
+const char *PaceModeName(PaceMode mode);
+bool PaceModeWantsVsync(PaceMode mode);
+
+double PacerSeconds(void);                           // the pacer's clock
+double PacerTimeLeft(const FramePacer *pacer);       // until this frame's deadline, 0 when there is none to wait for
+void WaitForFrameDeadline(FramePacer *pacer);        // just before the swap
+void FramePresented(FramePacer *pacer);              // just after the swap, measures the interval and sets the next deadline
+
+double PacingErrorMean(const FramePacer *pacer);     // seconds
+double PacingErrorSpread(const FramePacer *pacer);   // standard deviation, seconds
+void PrintPacingReport(const FramePacer *pacer);
+
+#endif // PACING_H
@@ -2,7 +2,9 @@
 #define PLAYER_H 
 
 #include <raylib.h>
+#include <stdbool.h>
 #include "bullet.h"
+#include "ecs.h"
 
 // defining CONSTANTS
 #define SHIP_SIZE              20                 
@@ -12,7 +14,33 @@
                                                   // version 1.0 has 0.98f drag value, been updated now
                                                   // This allowed the ship to be more responsive
 
-// Player ship structure
+// Control modes
+#define CONTROL_KEYBOARD 0
+#define CONTROL_MOUSE    1
+
+// Everything the ship is told to do on one tick, read from the keyboard/mouse or returned by a bot
+typedef struct PlayerInput {
+    bool rotateLeft;
+    bool rotateRight;
+    bool thrust;
+    bool shoot;
+    bool toggleControlMode;    // M key, switches between keyboard and mouse controls
+    Vector2 aimTarget;         // mouse position, only used in mouse control mode
+} PlayerInput;
+
+#define SHIP_COMPONENTS (COMPONENT_BIT(COMPONENT_POSITION) | COMPONENT_BIT(COMPONENT_VELOCITY) | COMPONENT_BIT(COMPONENT_SHIP))
+
+// What a ship has besides its position and velocity, the COMPONENT_SHIP column
+typedef struct ShipState {
+    float rotation;            // degrees
+    float rotationVelocity;
+    bool isThrusting;
+    int shootCooldown;
+    int controlMode;
+} ShipState;
+
+// Player ship structure, one ship's components in one place (GetPlayer and PutPlayer). The ships
+// live in the game's EcsWorld, the first one at index 0 and a versus game's second at 1
 typedef struct Player {
     Vector2 position;
     Vector2 velocity;
@@ -24,10 +52,19 @@ typedef struct Player {
 } Player;
 
 // Function prototypes
-void InitPlayer(Player *player);
-void UpdatePlayer(Player *player, Bullet bullets[]);
-void UpdatePlayerKeyboard(Player *player, Bullet bullets[]); // Added for keyboard controls
-void UpdatePlayerMouse(Player *player, Bullet bullets[]);    // Added for mouse controls
+void InitPlayer(EcsWorld *world, int ship);
+Player GetPlayer(const EcsWorld *world, int ship);
+void PutPlayer(EcsWorld *world, int ship, const Player *player);
+PlayerInput ReadPlayerInput(const Player *player);            // Samples the keyboard and mouse
+void UpdatePlayer(EcsWorld *world, int ship, const PlayerInput *input);       // float or fixed point, picked at build time
+void UpdatePlayerFloat(EcsWorld *world, int ship, const PlayerInput *input);
+void UpdatePlayerFixed(EcsWorld *world, int ship, const PlayerInput *input);
+void UpdatePlayerKeyboard(Player *player, EcsWorld *world, int ship, const PlayerInput *input); // Added for keyboard controls
+void UpdatePlayerMouse(Player *player, EcsWorld *world, int ship, const PlayerInput *input);    // Added for mouse controls
+void GetShipTriangle(const Player *player, Vector2 vertices[3]);   // Outline used for drawing and collisions
+void GetShipTriangleFloat(const Player *player, Vector2 vertices[3]);
+void GetShipTriangleFixed(const Player *player, Vector2 vertices[3]);
 void DrawPlayer(Player player);
+void DrawPlayerColored(Player player, Color color);
 
 #endif                        // PLAYER_H end config
@@ -0,0 +1,88 @@
+/*
+ * Seekable replay files. An input-only replay has to be simulated from the first tick to get
+ * anywhere, so every REPLAY_KEYFRAME_TICKS the whole simulation state goes into the file as a
+ * keyframe, followed by the inputs of the ticks after it. An index of the keyframes sits at the
+ * end of the file. Getting to any tick is finding the keyframe before it, loading it and
+ * simulating at most REPLAY_KEYFRAME_TICKS ticks.
+ *
+ * Layout: header, then segments (keyframe snapshot, then 5 bytes of input per tick), then the
+ * index. The snapshots are raw SimSnapshot structs, so a replay only plays back in a build with
+ * the same SimSnapshot; the header keeps its size to catch the obvious cases.
+ */
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "player.h"
+#include "snapshot.h"
+
+#define REPLAY_MAGIC            0x52545341u    // "ASTR" at the start of every replay
+#define REPLAY_VERSION          7              // 2: sine and cosine from trig.h, 3: collisions across the edges, 4: world size, 5: saucers, 6: waves, 7: entities
+#define REPLAY_KEYFRAME_TICKS   300            // five seconds, a seek simulates at most this many ticks
+#define REPLAY_INPUT_BYTES      5              // buttons, aim x, aim y
+
+struct Game;
+
+typedef struct ReplayHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t tickRate;
+    uint16_t screenWidth;                      // the canvas the game was drawn on, the world can be bigger
+    uint16_t screenHeight;
+    uint32_t snapshotSize;                     // sizeof(SimSnapshot) of the build that wrote it
+    uint32_t ticks;                            // recorded ticks, filled in on close
+    uint32_t keyframes;
+    uint64_t indexOffset;                      // 0 until the file was closed properly
+} ReplayHeader;
+
+// One segment: a keyframe and the ticks played from it
+typedef struct ReplayKeyframe {
+    uint32_t tick;                             // replay tick the snapshot is the state before
+    uint32_t inputCount;                       // ticks in this segment
+    uint16_t worldWidth;                       // the wrapping depends on it, F11 starts a new segment
+    uint16_t worldHeight;
+    uint16_t asteroidLimit;                    // worldAsteroidLimit, the spawns depend on it
+    uint16_t reserved;
+    uint64_t snapshotOffset;
+    uint64_t inputsOffset;
+} ReplayKeyframe;
+
+typedef struct ReplayWriter {
+    FILE           *file;
+    ReplayHeader    header;
+    ReplayKeyframe *index;
+    int             indexCapacity;
+    ReplayKeyframe  segment;                   // the one being written, not in the index yet
+    bool            hasSegment;
+    unsigned int    expectedGameTick;          // game->tick we expect next, anything else needs a new keyframe
+    uint64_t        offset;                    // where the next write goes
+    SimSnapshot     keyframe;                  // scratch for capturing the state
+} ReplayWriter;
+
+// A replay mapped into memory, read only, so any number of threads can play it at once
+typedef struct Replay {
+    const unsigned char  *data;
+    size_t                size;
+    const ReplayHeader   *header;
+    const ReplayKeyframe *keyframes;
+} Replay;
+
+// Function prototypes
+bool OpenReplayWriter(ReplayWriter *writer, const char *path);
+void RecordReplayTick(ReplayWriter *writer, const struct Game *game, PlayerInput *input);   // before StepGameplay, rounds the input to what the file keeps
+bool CloseReplayWriter(ReplayWriter *writer);                                                 // writes the index, false if the file is incomplete
+
+bool OpenReplay(Replay *replay, const char *path);
+void CloseReplay(Replay *replay);
+unsigned int ReplayTicks(const Replay *replay);
+int FindReplayKeyframe(const Replay *replay, unsigned int tick);                    // last keyframe at or before the tick
+PlayerInput GetReplayInput(const Replay *replay, unsigned int tick);
+bool RestoreReplayKeyframe(const Replay *replay, int keyframe, struct Game *game);     // also sets the screen size it was played at
+bool SeekReplay(const Replay *replay, unsigned int tick, struct Game *game);        // the state before the tick is played
+void StepReplay(const Replay *replay, unsigned int tick, struct Game *game);        // plays one tick
+
+#endif // REPLAY_H
@@ -8,7 +8,6 @@
 void InitResolutions(Game *game);
 void ChangeResolution(Game *game, int newResolutionIndex);
 void ToggleFullscreenMode(Game *game);
-void HandleResolutionChange(Game *game);
 
 // Get current screen dimensions
 int GetCurrentScreenWidth(void);
@@ -0,0 +1,80 @@
+/*
+ * Rollback netcode for two player versus games. Only the inputs go over the network, every
+ * tick is simulated straight away with a guess for the other player's input, and when their
+ * real input turns out to be different the game goes back to the saved state of that tick
+ * and simulates forward again. No input delay, the cost is the re-simulation.
+ */
+
+#ifndef ROLLBACK_H
+#define ROLLBACK_H
+
+#include <stdbool.h>
+#include "game.h"
+#include "net.h"
+#include "player.h"
+#include "snapshot.h"
+
+#define ROLLBACK_MAX_PREDICTION  12            // ticks we run ahead of the other side's inputs before waiting (200 ms)
+#define ROLLBACK_HISTORY         32            // ring size for inputs and saved states, more than twice the above
+
+// A PlayerInput as it goes over the network, 5 bytes
+typedef struct NetInput {
+    unsigned char  buttons;
+    unsigned short aimX;                       // mouse aim in whole pixels, signed (the world can scroll past 0)
+    unsigned short aimY;
+} NetInput;
+
+typedef struct RollbackStats {
+    unsigned long frames;                      // frames since the match started
+    unsigned long ticks;                       // ticks simulated for the first time
+    unsigned long stalls;                      // frames we had to wait for the other side
+    unsigned long syncWaits;                   // frames we held back on purpose to let the other side catch up
+    unsigned long rollbacks;                   // frames that had to go back and simulate again
+    unsigned long resimulatedTicks;
+    unsigned long predictedTicks;              // ticks that were simulated with a guessed input
+    unsigned long correctPredictions;
+    unsigned long checksumsCompared;           // confirmed states compared with the other side
+    unsigned long desyncs;                     // ... that turned out different
+    double        resimMicros;                 // total time spent simulating again
+    double        lastResimMicros;
+    double        maxResimMicros;
+} RollbackStats;
+
+typedef struct RollbackSession {
+    Game        *game;
+    NetLink      link;
+    int          localSlot;                    // 0 hosts and flies ship 0 of the entities, 1 joins and flies ship 1
+    bool         connected;                    // both sides have the seed and are simulating
+    bool         heardFromPeer;                // the host keeps sending the seed until the first inputs come back
+    unsigned int seed;
+
+    unsigned int currentTick;                  // next tick to simulate
+    unsigned int remoteTick;                   // the other side's inputs are known for every tick below this
+    unsigned int remoteAck;                    // the other side has our inputs for every tick below this
+    int          remoteAdvantage;              // how far the other side is ahead of our inputs, from its last packet
+    NetInput     localInputs[ROLLBACK_HISTORY];
+    NetInput     remoteInputs[ROLLBACK_HISTORY];    // the real input below remoteTick, the guess above it
+    SimSnapshot  states[ROLLBACK_HISTORY];          // state at the start of every tick in the window
+
+    unsigned int checksumTicks[ROLLBACK_HISTORY];   // checksums of confirmed states, to catch desyncs
+    unsigned int checksums[ROLLBACK_HISTORY];
+    unsigned int lastChecksumTick;
+    unsigned int remoteChecksumTick;                // the other side's newest, waits here until we have that tick too
+    unsigned int remoteChecksum;
+    unsigned int lastComparedTick;
+
+    RollbackStats stats;
+} RollbackSession;
+
+// Function prototypes
+bool HostRollbackSession(RollbackSession *session, Game *game, unsigned short port, NetConditions conditions, unsigned int seed);
+bool JoinRollbackSession(RollbackSession *session, Game *game, const char *host, unsigned short port, NetConditions conditions);
+void AdvanceRollbackSession(RollbackSession *session, const PlayerInput *localInput, double now);   // once per frame
+void CloseRollbackSession(RollbackSession *session);
+
+Player RollbackLocalPlayer(const RollbackSession *session);          // a copy of this side's ship
+int RollbackLocalSlot(const RollbackSession *session);
+int RollbackPredictedTicks(const RollbackSession *session);     // how far ahead of the confirmed state we are
+bool RollbackChecksum(const RollbackSession *session, unsigned int tick, unsigned int *checksum);
+
+#endif // ROLLBACK_H
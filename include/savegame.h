@@ -0,0 +1,135 @@
+/*
+ * Saving and loading. The profile (asteroids.sav) keeps the settings and the high score from one
+ * run of the game to the next: it is read at start, written when the high score goes up and again
+ * at exit. F5 quick saves the game being played to quicksave.sav, the whole simulation with the
+ * settings and the high score, and F9 carries on from it, also after a restart or a game over.
+ * --save-dir puts both somewhere other than the working directory.
+ *
+ * Both are the same file: a fixed SaveHeader and, in a quick save, the SimSnapshot right after it
+ * as it is in memory, the way the replays keep their keyframes. Loading maps the file and checks
+ * it (magic, version, sizes, the checksum over all of it) and the game is restored straight from
+ * the mapping, so there is nothing to parse. A file from another build or cut short is refused as
+ * a whole, the game doesn't change at all then.
+ *
+ * Saving never waits for the disk. The main thread only captures the state into the slot of the
+ * file, a few microseconds, and a worker thread writes it to <file>.tmp, syncs it and renames it
+ * over the old one. A crash in the middle leaves the old file or the new one, never half of one.
+ * A newer save for the same file that comes in while the older one still waits replaces it.
+ */
+
+#ifndef SAVEGAME_H
+#define SAVEGAME_H
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "snapshot.h"
+#include "tunables.h"
+
+#define SAVE_MAGIC          0x56535341u        // "ASSV"
+#define SAVE_VERSION        1
+#define SAVE_HEADER_BYTES   128                // the snapshot starts here, 8 byte aligned like the mapping needs
+#define SAVE_PATH_LENGTH    512
+#define SAVE_NOTICE_TICKS   120                // "GAME SAVED" and the like stay up two seconds
+#define SAVE_PROFILE_NAME   "asteroids.sav"
+#define SAVE_QUICK_NAME     "quicksave.sav"
+
+// flags
+#define SAVE_HAS_GAME       0x01               // a quick save, the snapshot follows the header
+#define SAVE_FIXED_SIM      0x02               // written by a FIXED_SIM build, the other build can't read its snapshot
+#define SAVE_AUTOPILOT      0x04               // F2 was on
+
+// The files the writer looks after, one slot each
+typedef enum SaveKind {
+    SAVE_PROFILE,
+    SAVE_QUICK,
+    SAVE_KINDS
+} SaveKind;
+
+// The start of every save, exactly as it is in the file (little endian on every machine we build for)
+typedef struct SaveHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t headerSize;                       // SAVE_HEADER_BYTES
+    uint32_t snapshotSize;                     // sizeof(SimSnapshot) of the build that wrote it, 0 in a profile
+    uint32_t checksum;                         // FNV-1a over the header (this field as 0) and the snapshot
+    uint64_t savedTime;                        // unix seconds
+    int32_t  highScore;
+    uint16_t worldWidth;                       // the wrapping depends on it, like in a replay keyframe
+    uint16_t worldHeight;
+    uint16_t asteroidLimit;                    // worldAsteroidLimit
+    uint8_t  flags;
+    uint8_t  difficulty;
+    uint8_t  soundEnabled;
+    uint8_t  musicEnabled;
+    uint8_t  showFPS;
+    uint8_t  fullscreen;
+    uint8_t  resolution;                       // index into the window sizes, see resolution.c
+    uint8_t  unused[3];
+    float    renderScale;
+    Tunables tunables;                         // a new tunable bumps SAVE_VERSION
+    uint8_t  reserved[44];
+} SaveHeader;
+
+// A quick save as the file has it, a profile is only the header
+typedef struct SaveFile {
+    SaveHeader  header;
+    SimSnapshot snapshot;
+} SaveFile;
+
+// A validated save, mapped
+typedef struct MappedSave {
+    const unsigned char *data;
+    size_t               size;
+    const SaveHeader    *header;
+    const SimSnapshot   *snapshot;             // NULL in a profile
+} MappedSave;
+
+// The latest save of one file, waiting for the worker
+typedef struct SaveSlot {
+    char      path[SAVE_PATH_LENGTH];
+    SaveFile *file;
+    size_t    size;
+    bool      pending;
+} SaveSlot;
+
+typedef struct SaveWriter {
+    pthread_t       thread;
+    pthread_mutex_t lock;
+    pthread_cond_t  wake;                      // something to write, or stop
+    pthread_cond_t  idle;                      // nothing left to write
+    SaveSlot        slots[SAVE_KINDS];
+    SaveFile       *writing;                   // the worker's buffer, swapped with a slot's and written outside the lock
+    bool            busy;                      // the worker is writing
+    bool            stopping;
+    bool            running;
+
+    // for the report at exit
+    unsigned long   saved;
+    unsigned long   failed;
+    unsigned long   replaced;                  // a newer save came in before the older one was written
+    double          queueSecondsMax;           // main thread, capturing the state
+    double          writeSeconds;              // worker, all of it
+    double          writeSecondsMax;
+} SaveWriter;
+
+struct Game;
+
+// Function prototypes
+bool StartSaveWriter(SaveWriter *writer, const char *directory);          // NULL for the working directory
+void StopSaveWriter(SaveWriter *writer);                                  // writes what is still waiting first
+void QueueSave(SaveWriter *writer, const struct Game *game, SaveKind kind);
+void WaitForSaves(SaveWriter *writer);                                    // until everything queued is on disk
+void PrintSaveReport(const SaveWriter *writer);
+
+size_t FillSaveFile(SaveFile *file, const struct Game *game, bool withGame);   // the bytes to write
+bool WriteSaveFile(const char *path, SaveFile *file, size_t size);            // sets the checksum, atomic
+
+bool MapSaveFile(MappedSave *save, const char *path);                     // false when missing or not valid
+void UnmapSaveFile(MappedSave *save);
+void ApplySavedSettings(struct Game *game, const SaveHeader *header, bool display);   // display: window size, fullscreen, render scale
+bool RestoreSavedGame(const MappedSave *save, struct Game *game);
+bool QuickLoadGame(struct Game *game, const char *path);
+
+#endif // SAVEGAME_H
@@ -0,0 +1,76 @@
+/*
+ * Snapshots of the simulation state and the rewind buffer built on top of them.
+ * A snapshot is the part of the Game that StepGameplay() changes, copied out flat,
+ * so putting one back gives a game that plays on exactly as it did the first time.
+ */
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <raylib.h>
+#include <stddef.h>
+#include "director.h"
+#include "ecs.h"
+
+#define REWIND_SECONDS        10               // how far back the R key can go
+#define REWIND_BYTES_PER_TICK 1024             // delta storage budget, an average single player tick needs around 400 bytes
+
+struct Game;
+
+// Everything the simulation needs to carry on from a tick, menus, stars and sound are not part of it
+typedef struct SimSnapshot {
+    int          score;
+    int          state;                        // GameState, kept as an int so this header doesn't need game.h
+    unsigned int rngState;
+    unsigned int tick;
+    int          secondScore;                  // versus games only
+    int          versusLoser;
+    EcsWorld     entities;                     // ships, asteroids, bullets and saucers, the whole world is flat data
+    WaveDirector director;                     // the wave and what is left of its timeline
+} SimSnapshot;
+
+// Where one delta lives in the rewind storage
+typedef struct RewindEntry {
+    size_t offset;
+    size_t size;
+} RewindEntry;
+
+/*
+ * Rewind ring. The newest state is kept whole, every older state is kept as the difference
+ * to the state after it, so stepping back is undoing one delta and dropping the oldest
+ * state when the ring is full is just forgetting its delta.
+ */
+typedef struct RewindBuffer {
+    SimSnapshot  head;                         // newest state in the ring
+    bool         hasHead;
+    unsigned char *data;                       // delta storage, used as a ring of variable sized records
+    size_t       dataSize;
+    size_t       writeOffset;                  // where the next delta goes
+    RewindEntry *entries;                      // one per stored delta, oldest first starting at first
+    int          capacity;
+    int          first;
+    int          count;
+    unsigned char *scratch;                    // a delta is encoded here before it is copied into the ring
+
+    // measured per push, shown with the FPS counter and printed by tools/bench_rewind
+    double       lastPushMicros;
+    double       maxPushMicros;
+    double       totalPushMicros;
+    unsigned long pushes;
+    size_t       lastDeltaSize;
+    size_t       bytesUsed;
+} RewindBuffer;
+
+// Function prototypes
+void CaptureSimSnapshot(const struct Game *game, SimSnapshot *snapshot);
+void RestoreSimSnapshot(struct Game *game, const SimSnapshot *snapshot);
+unsigned int HashSimSnapshot(const SimSnapshot *snapshot);                 // checksums, replay and bench checks
+
+bool InitRewindBuffer(RewindBuffer *rewind, int seconds);
+void FreeRewindBuffer(RewindBuffer *rewind);
+void ClearRewindBuffer(RewindBuffer *rewind);
+void PushRewindState(RewindBuffer *rewind, const struct Game *game);       // call after every tick
+bool StepBackRewind(RewindBuffer *rewind, struct Game *game);              // puts the game one tick back, false when out of history
+float RewindSecondsAvailable(const RewindBuffer *rewind);
+
+#endif // SNAPSHOT_H
@@ -2,12 +2,13 @@
 #define SOUND_H
 
 #include <raylib.h>
+#include "nullaudio.h"
 
 // Forward declaration for Game struct to avoid circular dependency
 typedef struct Game Game;
 
 // Sound Constants
-#define MAX_SOUNDS 8
+#define MAX_SOUNDS 9
 
 // Sound Types
 typedef enum {
@@ -18,7 +19,8 @@ typedef enum {
     SOUND_EXPLOSION_SMALL,// Small asteroid explosion
     SOUND_THRUST,         // Player ship thrust sound
     SOUND_MENU_SELECT,    // Menu selection sound
-    SOUND_GAME_OVER       // Game over sound
+    SOUND_GAME_OVER,      // Game over sound
+    SOUND_UFO_SHOOT       // A flying saucer shooting
 } SoundType;
 
 // Sound structure
@@ -30,10 +32,13 @@ typedef struct SoundManager {
     bool musicLoaded;
     float musicVolume;
     float soundVolume;
+    bool nullDevice;         // true when mixing into memory instead of using the audio device
+    bool soundMuted;         // only used by the null device, the real one mutes by setting volume 0
+    NullAudioDevice nullAudio;
 } SoundManager;
 
 // Function prototypes
-void InitSoundManager(SoundManager *soundManager);
+void InitSoundManager(SoundManager *soundManager, bool useNullDevice, bool captureAudio);
 void LoadGameSounds(SoundManager *soundManager);
 void UnloadGameSounds(SoundManager *soundManager);
 void PlayGameSound(SoundManager *soundManager, SoundType soundType);
@@ -44,5 +49,6 @@ void ToggleSoundEnabled(SoundManager *soundManager, bool enabled);
 void ToggleMusicEnabled(SoundManager *soundManager, bool enabled);
 void PauseGameMusic(SoundManager *soundManager);
 void ResumeGameMusic(SoundManager *soundManager);
+bool ExportGameAudio(SoundManager *soundManager, const char *fileName);   // null device only
 
 #endif // SOUND_H
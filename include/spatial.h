@@ -0,0 +1,48 @@
+/*
+ * Spatial queries over the asteroid field. A uniform grid that wraps around the
+ * screen edges the same way WrapPosition() does, so anything that needs to know
+ * "what is close to this point" or "what does this line hit first" does not have
+ * to walk every asteroid. The grid keeps its own copy of each asteroid's position
+ * and radius, by index, so a query doesn't go back to the component tables.
+ */
+
+#ifndef SPATIAL_H
+#define SPATIAL_H
+
+#include <raylib.h>
+#include <stdbool.h>
+#include "asteroids.h"
+
+#define SPATIAL_CELL_SIZE      64.0f               // should be at least as big as the largest asteroid radius
+
+// Grid structure, every cell keeps a doubly linked list of the asteroids whose center is inside it
+typedef struct SpatialGrid {
+    float worldWidth;
+    float worldHeight;
+    float cellWidth;                               // the cells always tile the world exactly
+    float cellHeight;
+    int columns;
+    int rows;
+    int capacity;                                  // number of asteroid indices the grid can track
+    float maxRadius;                               // largest radius currently in the grid
+    int *cellHead;                                 // first asteroid in every cell, -1 when empty
+    int *next;                                     // per asteroid links inside its cell
+    int *prev;
+    int *cellOf;                                   // cell the asteroid is linked into, -1 if not in the grid
+    unsigned int *stamp;                           // used to visit every asteroid only once per query
+    unsigned int queryStamp;
+    Vector2 *position;                             // per asteroid, as of the last update
+    float *radius;                                 // below 0 for an index that is free
+} SpatialGrid;
+
+// Function prototypes
+bool InitSpatialGrid(SpatialGrid *grid, float worldWidth, float worldHeight, float cellSize, int capacity);
+void FreeSpatialGrid(SpatialGrid *grid);
+void ClearSpatialGrid(SpatialGrid *grid);
+void UpdateSpatialGrid(SpatialGrid *grid, const EcsWorld *world);
+void UpdateSpatialGridArrays(SpatialGrid *grid, const Vector2 positions[], const float radii[], int count);    // a radius below 0 is no asteroid
+int QueryNearestAsteroids(SpatialGrid *grid, Vector2 point, int k, int outIndices[], float outDistances[]);
+int QueryAsteroidsInRadius(SpatialGrid *grid, Vector2 point, float radius, int outIndices[], int maxResults);
+int RaycastAsteroids(SpatialGrid *grid, Vector2 origin, Vector2 direction, float maxDistance, float *hitDistance);
+
+#endif // SPATIAL_H
@@ -9,6 +9,8 @@
 
 #define MAX_STARS          100                 // number of stars 
 #define STAR_LAYERS        3                   // using this to try to make a parallax effect in the game
+#define STAR_LOD_POINT     1.5f                // on screen pixels, smaller stars are a single pixel
+#define STAR_LOD_SQUARE    4.0f                // smaller than this a square, a circle only from here up
 
 // Star structure architecture
 typedef struct Star {
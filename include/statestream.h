@@ -0,0 +1,96 @@
+/*
+ * State stream for spectators and recordings. Unlike an input replay, a viewer doesn't need to
+ * simulate anything: every frame says where things are, so it can join at any point and just
+ * draw. Every STREAM_KEYFRAME_TICKS there is a keyframe with everything in it, in between only
+ * what didn't move the way it was expected to, bit packed.
+ */
+
+#ifndef STATESTREAM_H
+#define STATESTREAM_H
+
+#include <stdbool.h>
+#include <stdio.h>
+#include "asteroids.h"
+#include "bullet.h"
+#include "ecs.h"
+#include "ufo.h"
+
+#define STREAM_MAGIC            0x53545341u    // "ASTS" at the start of every stream
+#define STREAM_VERSION          6              // 2: world size in the header, 3: saucers and their shots, 4: compact.h attributes, 5: packed motion, 6: slots by table index
+#define STREAM_KEYFRAME_TICKS   120            // a late viewer waits at most this long for a picture
+#define STREAM_MAX_FRAME        16384          // bytes, a keyframe with every slot full is about 3 KB, 6 KB in a big world (MAX_ASTEROIDS)
+#define STREAM_MAX_VIEWERS      4
+
+#define STREAM_MAX_FIELDS       6              // quantized values per slot
+#define STREAM_MAX_ATTRIBUTES   2              // bytes per slot that only change when something spawns
+#define STREAM_SLOTS            (1 + 2 + MAX_ASTEROIDS + BULLET_SLOTS + UFO_MAX_SAUCERS + UFO_MAX_SHOTS)    // game, two ships, asteroids, both bullet pools, saucers, shots
+
+struct Game;
+
+// One thing in the stream, as the viewer knows it. Positions are in 1/256 pixel, angles in 1/65536 of a turn
+typedef struct StreamSlot {
+    bool          active;
+    int           value[STREAM_MAX_FIELDS];
+    int           step[STREAM_MAX_FIELDS];      // how much each value is expected to change per tick
+    unsigned char attributes[STREAM_MAX_ATTRIBUTES];
+} StreamSlot;
+
+// The encoder keeps a copy of what the viewers have so both make the same guesses
+typedef struct StreamCodec {
+    StreamSlot slots[STREAM_SLOTS];
+    bool       synced;                          // decoder only, false until the first keyframe
+    int        ticksSinceKeyframe;              // encoder only
+    bool       forceKeyframe;                   // encoder only, set when a viewer joins
+} StreamCodec;
+
+typedef struct StreamHeader {
+    unsigned int magic;
+    unsigned short version;
+    unsigned short screenWidth;                 // the canvas the game was drawn on
+    unsigned short screenHeight;
+    unsigned short tickRate;
+    unsigned short worldWidth;                  // the size the positions wrap at, bigger than the canvas if it scrolled
+    unsigned short worldHeight;
+} StreamHeader;
+
+// Where a stream goes: a recording, spectators on a local socket, or both
+typedef struct StreamOutput {
+    StreamCodec   codec;
+    FILE         *file;
+    int           listenSocket;                 // -1 without spectators
+    char          socketPath[108];              // removed again on close
+    int           viewers[STREAM_MAX_VIEWERS];
+    int           viewerCount;
+    unsigned char frame[STREAM_MAX_FRAME];
+
+    unsigned long frames;
+    unsigned long keyframes;
+    unsigned long bytes;                        // frames including their size prefix, without the header
+    unsigned long keyframeBytes;
+    int           lastFrameBytes;
+} StreamOutput;
+
+// Where a viewer reads it from
+typedef struct StreamInput {
+    StreamCodec   codec;
+    StreamHeader  header;
+    FILE         *file;
+    int           socket;                       // -1 for a file
+    bool          ended;
+    unsigned char buffer[STREAM_MAX_FRAME * 2];
+    int           buffered;
+} StreamInput;
+
+// Function prototypes
+int EncodeStreamFrame(StreamCodec *codec, const struct Game *game, unsigned char *out, int capacity);   // bytes written
+bool DecodeStreamFrame(StreamCodec *codec, const unsigned char *data, int size, struct Game *game);   // false until synced
+
+bool OpenStreamOutput(StreamOutput *output, const char *filePath, const char *socketPath);   // either path can be NULL
+void WriteStreamFrame(StreamOutput *output, const struct Game *game);                        // once per frame
+void CloseStreamOutput(StreamOutput *output);
+
+bool OpenStreamInput(StreamInput *input, const char *path);     // a recording, or the socket of a running game
+bool ReadStreamFrame(StreamInput *input, struct Game *game);    // true when the game was updated
+void CloseStreamInput(StreamInput *input);
+
+#endif // STATESTREAM_H
@@ -0,0 +1,75 @@
+/*
+ * The stress scenario, --stress. It ramps the asteroids, the bullets and the particles (saucer
+ * shots, the only short lived effect entities there are) up a schedule of plateaus, 1k, 10k, 100k
+ * and 1M of each unless it is given another, and at every plateau measures the frame, what each
+ * phase of it took and the memory. A scripted pilot turns and fires in the middle of it all. At
+ * the end the report says where the frame stopped fitting a tick and which phase got it there.
+ *
+ * The game's entities are tables of fixed sizes in an EcsWorld (InitGameWorld), MAX_ASTEROIDS
+ * asteroids, MAX_BULLETS bullets a ship and UFO_MAX_SHOTS shots, and the kernels are written for
+ * exactly that. So the pools are pages on the heap that are each a game's world, as many as the
+ * kind that needs the most, and the real functions run over every page: UpdateWorldAsteroids,
+ * UpdateBullets and UpdateUfos, checkCollisions for every pair of an asteroid page and a bullet page
+ * (what one big field would have to test), DrawAsteroids, DrawBullets and DrawUfos. Nothing is
+ * rewritten for the scenario, so what it measures is what the game's code costs at that size.
+ *
+ * Everything that dies is spawned again before the next frame, that part isn't timed. A frame
+ * that takes longer than STRESS_GIVE_UP_SECONDS is given up on in the middle and the ramp stops
+ * there, the plateaus after it would only be slower.
+ */
+
+#ifndef STRESS_H
+#define STRESS_H
+
+#include <stdbool.h>
+
+#define STRESS_MAX_PLATEAUS    16
+#define STRESS_WARMUP_FRAMES   30              // per plateau, before anything is measured
+#define STRESS_PLATEAU_FRAMES  240             // measured per plateau, fewer if they run past the next limit
+#define STRESS_PLATEAU_SECONDS 20.0            // a slow plateau stops measuring after this long (at least 3 frames)
+#define STRESS_GIVE_UP_SECONDS 2.0             // a frame this long ends the ramp
+#define STRESS_DEFAULT_SCHEDULE "1k,10k,100k,1M"
+
+typedef enum StressPhase {
+    STRESS_ASTEROIDS,                          // UpdateWorldAsteroids
+    STRESS_BULLETS,                            // UpdateBullets and the pilot
+    STRESS_PARTICLES,                          // UpdateUfos
+    STRESS_COLLISIONS,                         // checkCollisions
+    STRESS_DRAW,                               // building the frame, raylib only batches it up
+    STRESS_PRESENT,                            // EndCanvas, the batches go to the GPU and the frame out
+    STRESS_PHASE_COUNT
+} StressPhase;
+
+typedef struct StressPlateau {
+    int asteroids;
+    int bullets;
+    int particles;
+} StressPlateau;
+
+typedef struct StressOptions {
+    StressPlateau plateaus[STRESS_MAX_PLATEAUS];
+    int           plateauCount;
+    const char   *csvFile;                     // NULL for no CSV, the report goes to stdout either way
+} StressOptions;
+
+// What one plateau measured, the times in seconds
+typedef struct StressResult {
+    StressPlateau plateau;
+    int           frames;
+    double        frameMean, frameP50, frameP99, frameMax;
+    double        phase[STRESS_PHASE_COUNT];   // means per frame
+    double        refill;                      // mean, not part of the frame
+    long long     poolBytes;                   // the pages of this plateau
+    long long     peakRssBytes;                // of the process so far, 0 where there is no way to ask
+    bool          gaveUp;                      // a frame ran past STRESS_GIVE_UP_SECONDS
+    bool          outOfMemory;                 // the pages could not be allocated, nothing was measured
+} StressResult;
+
+// Function prototypes
+bool ParseStressSchedule(const char *text, StressOptions *options);   // "1k,10k" or "asteroids/bullets/particles,..."
+int RunStressScenario(const StressOptions *options);                  // after InitWindow and InitCanvas, the exit code
+const char *StressPhaseName(StressPhase phase);
+void PrintStressReport(const StressResult results[], int count);
+bool WriteStressCsv(const char *fileName, const StressResult results[], int count);
+
+#endif // STRESS_H
@@ -0,0 +1,125 @@
+/*
+ * Gameplay telemetry. A session (one run of the game, from launch to exit) counts the shots, the
+ * hits by asteroid size and saucer kind, the deaths and what caused them, how long the ship stays
+ * alive, the most asteroids, bullets and entities there were at once, and the frames spent in
+ * every GameState. At exit the counters go into one fixed size record at the end of a log file,
+ * --telemetry <file>. The file is only ever appended to, and tools/telemetry_report reads
+ * thousands of sessions in a few milliseconds.
+ *
+ * The simulation reports its events (CountShots in ShootBullets, CountAsteroidHit in checkCollisions and so on) to the telemetry
+ * bound on its thread, like the random generator and the tunables. UpdateGame only binds it
+ * around a live single player tick, so replays, rewinds, network games (the rollback plays ticks
+ * more than once), the tools and the stress scenario never count anything. An event is a pointer
+ * test and an add, and there are a few a second. The peaks are sampled every
+ * TELEMETRY_PEAK_TICKS outside the tick. tools/bench_telemetry measures what all of it costs.
+ *
+ * The record has fixed width fields and is written as it is in memory (little endian on every
+ * machine we build for). A new field takes one from reserved and bumps TELEMETRY_VERSION.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define TELEMETRY_MAGIC         0x4C545341u    // "ASTL" at the start of every record
+#define TELEMETRY_VERSION       2              // 2: two asteroid sizes by the split rule, were three
+#define TELEMETRY_RECORD_BYTES  128
+#define TELEMETRY_STATES        6              // the GameState values, MAIN_MENU to PAUSED
+#define TELEMETRY_PEAK_TICKS    6              // ticks between samples of the entity counts
+
+// Asteroid sizes as checkCollisions sees them: only one bigger than 20 splits, into two of half
+// its size, so a spawn (20 to 40) is large or small and its pieces are always small
+typedef enum TelemetrySize {
+    TELEMETRY_SMALL,                           // 20 and under, gone when hit
+    TELEMETRY_LARGE,                           // over 20, splits in two when hit
+    TELEMETRY_SIZES
+} TelemetrySize;
+
+typedef enum TelemetryCause {
+    TELEMETRY_DEATH_ASTEROID,
+    TELEMETRY_DEATH_SAUCER,                    // running into one or hit by its shot
+    TELEMETRY_DEATHS
+} TelemetryCause;
+
+// flags
+#define TELEMETRY_FIXED_SIM     0x01           // a FIXED_SIM build
+#define TELEMETRY_AUTOPILOT     0x02           // F2 was on for some of it, the bot's play is in the numbers
+#define TELEMETRY_WORLD         0x04           // --world, bigger than the canvas
+
+// One session, exactly as it is in the file
+typedef struct TelemetryRecord {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t recordSize;                       // TELEMETRY_RECORD_BYTES
+    uint64_t startTime;                        // unix seconds
+    uint64_t scoreTotal;                       // of every game
+    uint32_t frames;                           // frames the session ran
+    uint32_t stateFrames[TELEMETRY_STATES];    // by GameState
+    uint32_t ticksPlayed;                      // gameplay ticks stepped, rewound ones not taken off
+    uint32_t games;                            // lives, the ones still going at exit too
+    uint32_t deaths[TELEMETRY_DEATHS];
+    uint32_t longestLife;                      // ticks
+    uint32_t bestScore;
+    uint32_t volleys;                          // ShootBullets calls that fired anything
+    uint32_t bulletsFired;
+    uint32_t asteroidHits[TELEMETRY_SIZES];
+    uint32_t saucerHits[2];                    // UfoKind, big and small
+    uint16_t peakAsteroids;
+    uint16_t peakBullets;
+    uint16_t peakEntities;                     // saucers and their shots
+    uint8_t  difficulty;
+    uint8_t  flags;
+    uint8_t  reserved[20];
+} TelemetryRecord;
+
+// The counters of the session that is running
+typedef struct Telemetry {
+    TelemetryRecord record;
+    uint32_t        lifeTicks;                 // of the life going on now
+    uint32_t        lifeScore;
+    uint32_t        sinceSample;               // ticks since the peaks were looked at
+} Telemetry;
+
+// What a log adds up to, see SummarizeTelemetryLog
+typedef struct TelemetrySummary {
+    long long sessions;
+    long long badRecords;                      // wrong magic, version or size, skipped
+    long long frames;
+    long long stateFrames[TELEMETRY_STATES];
+    long long ticksPlayed;
+    long long games;
+    long long deaths[TELEMETRY_DEATHS];
+    long long scoreTotal;
+    long long volleys;
+    long long bulletsFired;
+    long long asteroidHits[TELEMETRY_SIZES];
+    long long saucerHits[2];
+    long long autopilotSessions;
+    uint32_t  longestLife;
+    uint32_t  bestScore;
+    uint32_t  sessionFramesP50, sessionFramesP90;   // how long sessions are
+    uint32_t  longestLifeP50, longestLifeP90;       // of the best life in every session
+    uint16_t  peakAsteroidsP50, peakAsteroidsP99, peakAsteroidsMax;
+    uint16_t  peakBulletsP50, peakBulletsP99, peakBulletsMax;
+    uint16_t  peakEntitiesP50, peakEntitiesP99, peakEntitiesMax;
+} TelemetrySummary;
+
+struct Game;
+
+// Function prototypes
+void InitTelemetry(Telemetry *telemetry, int difficulty);
+void BindTelemetry(Telemetry *telemetry);                          // NULL counts nothing, the default
+void CountShots(int bullets);                                      // the simulation's events, to the bound telemetry
+void CountAsteroidHit(float radius);
+void CountSaucerHit(int kind);
+void CountDeath(TelemetryCause cause);
+void TelemetryTick(Telemetry *telemetry, const struct Game *game);  // after every counted tick, lives and peaks
+void TelemetryFrame(Telemetry *telemetry, const struct Game *game); // once a frame, the time in each state
+bool AppendTelemetryRecord(Telemetry *telemetry, const char *path); // at exit, ends the life that is going on
+
+bool SummarizeTelemetryLog(const char *path, TelemetrySummary *summary);
+void PrintTelemetrySummary(const TelemetrySummary *summary);
+
+#endif // TELEMETRY_H
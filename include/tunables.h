@@ -0,0 +1,45 @@
+/*
+ * Gameplay tunables. The numbers balance is made of (how fast things fly, how the ship handles,
+ * how often the bullets go and how long they last, how often asteroids turn up) used to be
+ * #defines and literals, now every Game has its own copy and the simulation reads them from
+ * there. The #defines in asteroids.h, player.h and bullet.h stay as the defaults.
+ *
+ * The simulation functions don't take the Game, so like the random generator (BindSimulationRandom)
+ * the tunables of the game being stepped are bound per thread. Nothing bound means the defaults,
+ * so the tools that drive the update functions directly keep working as they are.
+ *
+ * The tunables aren't part of the snapshots or the replays, a game only ever runs with the
+ * defaults except in tools/tune_sweep.
+ */
+
+#ifndef TUNABLES_H
+#define TUNABLES_H
+
+#include <stdbool.h>
+
+typedef struct Tunables {
+    float asteroidSpeed;             // ASTEROID_SPEED
+    float splitFactor;               // fragments fly this much faster than ASTEROID_SPEED, was the 1.5f in SplitAsteroid
+    int   asteroidSpawnChance;       // in 101 per tick, was the roll in UpdateAsteroid, now the size of the waves (director.h)
+    float shipAcceleration;          // SHIP_ACCELERATION
+    float shipDrag;                  // SHIP_DRAG
+    float rotationSpeed;             // ROTATION_SPEED
+    float bulletSpeed;               // BULLET_SPEED
+    int   bulletCooldown;            // BULLET_COOLDOWN, ticks
+    int   bulletLifetime;            // BULLET_LIFETIME, ticks
+} Tunables;
+
+#define TUNABLE_COUNT 9
+
+// Function prototypes
+Tunables DefaultTunables(void);
+void BindTunables(const Tunables *tunables);         // NULL goes back to the defaults
+const Tunables *ActiveTunables(void);                // what the simulation on this thread reads
+
+const char *TunableName(int index);                  // ASTEROID_SPEED and so on, the names of the old #defines
+int FindTunable(const char *name);                   // -1 when there is none by that name, case doesn't matter
+bool TunableIsInteger(int index);
+double GetTunable(const Tunables *tunables, int index);
+void SetTunable(Tunables *tunables, int index, double value);   // integers are rounded
+
+#endif // TUNABLES_H
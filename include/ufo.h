@@ -0,0 +1,55 @@
+/*
+ * Flying saucers that cross the field and shoot back, made of components (ecs.h) like everything
+ * else that moves. The saucers and their shots carry the HOSTILE tag, which keeps the systems here
+ * off the asteroids and bullets that share position, velocity and lifetime columns with them. A big saucer is slow and shoots anywhere, a small one
+ * is fast and aims at the ship, and the higher the score the more of them are small.
+ */
+
+#ifndef UFO_H
+#define UFO_H
+
+#include <raylib.h>
+#include <stdbool.h>
+#include "ecs.h"
+#include "bullet.h"
+#include "player.h"
+
+#define UFO_FIRST_TICK        600              // none in the first ten seconds of a game
+#define UFO_SPAWN_ODDS        900              // one in this many ticks on normal, about every 15 seconds (director.h)
+#define UFO_BIG_RADIUS        16.0f
+#define UFO_SMALL_RADIUS      9.0f
+#define UFO_BIG_SPEED         1.2f
+#define UFO_SMALL_SPEED       2.0f
+#define UFO_BIG_POINTS        200
+#define UFO_SMALL_POINTS      1000
+#define UFO_SHOT_SPEED        4.0f
+#define UFO_SHOT_RADIUS       2.5f
+#define UFO_SHOT_LIFETIME     100              // ticks
+#define UFO_AIM_ERROR         12               // degrees either way a small saucer misses by at most
+#define UFO_MAX_SAUCERS       16               // rows of their table, SpawnUfo allows one per screen of world
+#define UFO_MAX_SHOTS         64
+
+#define UFO_SHOT_COMPONENTS   (COMPONENT_BIT(COMPONENT_POSITION) | COMPONENT_BIT(COMPONENT_VELOCITY) | COMPONENT_BIT(COMPONENT_RADIUS) | \
+                               COMPONENT_BIT(COMPONENT_LIFETIME) | COMPONENT_BIT(COMPONENT_HOSTILE))
+#define UFO_COMPONENTS        (UFO_SHOT_COMPONENTS | COMPONENT_BIT(COMPONENT_UFO))
+
+typedef enum UfoKind {
+    UFO_BIG,
+    UFO_SMALL
+} UfoKind;
+
+// What a saucer is up to, the COMPONENT_UFO column
+typedef struct UfoBrain {
+    int   kind;                                // UfoKind
+    int   shootCooldown;                       // ticks until the next shot
+    int   turnCooldown;                        // ticks until it picks a new up or down drift
+    float speed;
+} UfoBrain;
+
+// Function prototypes
+bool SpawnUfo(EcsWorld *world, int score);                                                   // false when there are as many as the world has room for
+bool UpdateUfos(EcsWorld *world, int ship, int *score);                                      // true when the ship got hit, its bullets score
+void DrawUfos(EcsWorld *world);
+int CountUfoShots(const EcsWorld *world);
+
+#endif // UFO_H
@@ -6,6 +6,7 @@
 #include "player.h"
 #include "bullet.h"
 #include "asteroids.h"
+#include "world.h"
 
 // Defining constants
 #define SCREEN_WIDTH      1280
@@ -15,10 +16,36 @@
 extern int screenWidth;
 extern int screenHeight;
 
+#define NO_IMPACT         2.0f         // impact time returned when two circles don't touch during the tick
+#define SWEEP_BATCH_WIDTH 8            // batches are padded to this many lanes so the loops need no scalar tail
+#define EDGE_COPIES       4            // an entity in a corner is drawn four times, once per side of both edges
+#define SWEEP_BATCH_CAPACITY (((MAX_ASTEROIDS) + SWEEP_BATCH_WIDTH - 1) / SWEEP_BATCH_WIDTH * SWEEP_BATCH_WIDTH)
+
+// Start of tick state of the asteroids, laid out column by column so the swept tests vectorize
+typedef struct AsteroidSweepBatch {
+    int   count;
+    int   paddedCount;                   // count rounded up to SWEEP_BATCH_WIDTH, the extra lanes are zeros
+    int   index[SWEEP_BATCH_CAPACITY];   // the asteroid's index (asteroids.h)
+    float x[SWEEP_BATCH_CAPACITY];
+    float y[SWEEP_BATCH_CAPACITY];
+    float vx[SWEEP_BATCH_CAPACITY];
+    float vy[SWEEP_BATCH_CAPACITY];
+    float radius[SWEEP_BATCH_CAPACITY];
+} AsteroidSweepBatch;
+
 // Function Prototypes
 bool CheckCollisionCircles(Vector2 center1, float radius1, Vector2 center2, float radius2);
-void checkCollisions(Player *player, Asteroid asteroids[], Bullet bullets[], int *score, GameState *gameState);
+float SweptCircleImpactTime(Vector2 start1, Vector2 motion1, float radius1, Vector2 start2, Vector2 motion2, float radius2);
+void GatherAsteroidSweepBatch(AsteroidSweepBatch *batch, const EcsWorld *world, const unsigned char chunks[]);
+void SweepCircleAgainstBatch(const AsteroidSweepBatch *batch, Vector2 start, Vector2 motion, float radius, float impactTimes[]);
+void checkCollisions(EcsWorld *field, EcsWorld *fleet, int ship, int *score, GameState *gameState);
 void WrapPosition(Vector2 *position);
+Vector2 WrapImageOffset(Vector2 anchor, Vector2 point);
+int EdgeGhostOffsets(Vector2 position, float radius, Vector2 offsets[EDGE_COPIES]);
+
+// Simulation random numbers, every Game has its own generator so runs can be repeated from a seed
+void BindSimulationRandom(unsigned int *state);
+int SimRandomValue(int min, int max);
 
 
 #endif             // UTILS_H end config
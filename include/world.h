@@ -0,0 +1,67 @@
+/*
+ * The world the game is played in and the view of it. By default the world is the canvas (canvas.h),
+ * like it always was: nothing scrolls and everything is simulated every tick. --world WxH makes it an
+ * arena of its own size that wraps at its own edges, and the camera follows the ship around it.
+ *
+ * The world is cut into chunks of about WORLD_CHUNK_SIZE. Only the chunks the camera can see get
+ * drawn, and only the ones around a ship are simulated every tick, everything further away moves
+ * every WORLD_DISTANT_STEP ticks in bigger steps. What a frame costs then depends on what is on
+ * screen and close by, not on how much there is in the whole world.
+ */
+
+#ifndef WORLD_H
+#define WORLD_H
+
+#include <raylib.h>
+#include <stdbool.h>
+#include "asteroids.h"
+#include "spatial.h"
+
+#define WORLD_CHUNK_SIZE     640.0f    // chunks are at least this big, they always tile the world exactly
+#define WORLD_NEAR_CHUNKS    1         // chunks this many away from a ship's own (or closer) run every tick
+#define WORLD_DISTANT_STEP   4         // everything else moves every 4th tick, 4 ticks at a time
+#define MIN_WORLD_SIZE       256       // per side
+#define MAX_WORLD_SIZE       16384     // per side, positions have to fit Q16.16 and the 16 bit file headers
+#define WORLD_CHUNK_SPAN     ((int)(MAX_WORLD_SIZE / WORLD_CHUNK_SIZE))
+#define MAX_WORLD_CHUNKS     (WORLD_CHUNK_SPAN * WORLD_CHUNK_SPAN)
+#define SCREEN_ASTEROIDS     20        // asteroids per SCREEN_WIDTH x SCREEN_HEIGHT of world
+
+// What the last frame drew, and what it skipped, shown with the FPS counter
+typedef struct DrawStats {
+    int asteroidsFull;                                   // the whole outline
+    int asteroidsReduced;                                // every other point of it
+    int asteroidsPoint;                                  // too small on screen for more than a pixel
+    int asteroidsCulled;                                 // out of view, in a chunk the camera sees or not
+    int bulletsDrawn;
+    int bulletsCulled;
+    int starsFull;                                       // circles
+    int starsReduced;                                    // squares
+    int starsPoint;
+} DrawStats;
+
+extern DrawStats drawStats;
+
+// Size of the world in pixels, the simulation wraps everything at these. The asteroid limit is how
+// many of the MAX_ASTEROIDS indices spawns and splits may use, SCREEN_ASTEROIDS unless --world is given
+extern int worldWidth;
+extern int worldHeight;
+extern int worldAsteroidLimit;
+
+// Function prototypes
+void SetWorldSize(int width, int height);            // 0 x 0 goes back to following the canvas
+void FollowScreenSize(void);                         // call after the canvas size changed
+bool WorldScrolls(void);                             // false while the whole world fits the canvas
+
+int WorldChunkAt(Vector2 position);
+void MarkChunksAround(unsigned char marks[MAX_WORLD_CHUNKS], Vector2 position, int reach);
+void UpdateWorldAsteroids(EcsWorld *world, const Vector2 focus[], int focusCount, unsigned int tick);
+
+void FocusWorldView(Vector2 focus);
+Camera2D WorldViewCamera(void);
+Vector2 WorldViewTravel(void);                       // how far the camera moved in total, for the star parallax
+Vector2 ScreenToWorld(Vector2 point);
+float ViewPixelScale(void);                          // canvas texture pixels per world pixel, for picking the level of detail
+int ViewImageOffsets(Vector2 position, float radius, Vector2 offsets[]);    // room for EDGE_COPIES
+int GatherVisibleAsteroids(const SpatialGrid *chunks, const EcsWorld *world, int indices[]);
+
+#endif // WORLD_H
@@ -11,153 +11,445 @@
 
 #include "../include/asteroids.h"
 #include "../include/utils.h"
+#include "../include/fixed.h"
+#include "../include/trig.h"
+#include "../include/world.h"
+#include "../include/tunables.h"
 
 #include <math.h>
 #include <raylib.h>
+#include <string.h>
 
-// External globals for screen dimensions
-extern int screenWidth;
-extern int screenHeight;
+_Static_assert( sizeof( AsteroidSpin ) == 8, "componentSize[COMPONENT_SPIN] in ecs.c has to match AsteroidSpin" );
+_Static_assert( sizeof( AsteroidOutline ) == 72, "componentSize[COMPONENT_OUTLINE] in ecs.c has to match AsteroidOutline" );
 
-void InitAsteroid( Asteroid *asteroids )
+void InitAsteroid( EcsWorld *world )
 {
     for ( int i = 0; i < MAX_ASTEROIDS; i++ )
     {
-        asteroids[i].active = false;
+        RemoveAsteroid( world, i );
     }
 }
-void UpdateAsteroid( Asteroid *asteroids )
+
+// Gathers the asteroid at an index out of its columns, for the places that look at one at a time
+bool GetAsteroid( const EcsWorld *world, int index, Asteroid *asteroid )
 {
-    for ( int i = 0; i < MAX_ASTEROIDS; i++ )
+    EntityId entity = EcsEntityAt( world, ASTEROID_COMPONENTS, index );
+    if ( entity == ECS_NO_ENTITY ) return false;
+
+    const AsteroidSpin    *spin    = EcsGet( world, entity, COMPONENT_SPIN );
+    const AsteroidOutline *outline = EcsGet( world, entity, COMPONENT_OUTLINE );
+
+    asteroid->position      = *( const Vector2 * ) EcsGet( world, entity, COMPONENT_POSITION );
+    asteroid->velocity      = *( const Vector2 * ) EcsGet( world, entity, COMPONENT_VELOCITY );
+    asteroid->radius        = *( const float * ) EcsGet( world, entity, COMPONENT_RADIUS );
+    asteroid->rotation      = spin->rotation;
+    asteroid->rotationSpeed = spin->rotationSpeed;
+    memcpy( asteroid->outlineX, outline->x, sizeof( outline->x ) );
+    memcpy( asteroid->outlineY, outline->y, sizeof( outline->y ) );
+    return true;
+}
+
+void PutAsteroid( EcsWorld *world, int index, const Asteroid *asteroid )
+{
+    EntityId entity = EcsEntityAt( world, ASTEROID_COMPONENTS, index );
+    if ( entity == ECS_NO_ENTITY ) entity = EcsSpawnAt( world, ASTEROID_COMPONENTS, index );
+    if ( entity == ECS_NO_ENTITY ) return;    // a world without the asteroid table (InitGameWorld)
+
+    AsteroidSpin    *spin    = EcsGet( world, entity, COMPONENT_SPIN );
+    AsteroidOutline *outline = EcsGet( world, entity, COMPONENT_OUTLINE );
+
+    *( Vector2 * ) EcsGet( world, entity, COMPONENT_POSITION ) = asteroid->position;
+    *( Vector2 * ) EcsGet( world, entity, COMPONENT_VELOCITY ) = asteroid->velocity;
+    *( float * ) EcsGet( world, entity, COMPONENT_RADIUS )     = asteroid->radius;
+    spin->rotation      = asteroid->rotation;
+    spin->rotationSpeed = asteroid->rotationSpeed;
+    memcpy( outline->x, asteroid->outlineX, sizeof( outline->x ) );
+    memcpy( outline->y, asteroid->outlineY, sizeof( outline->y ) );
+}
+
+void RemoveAsteroid( EcsWorld *world, int index )
+{
+    EcsDestroy( world, EcsEntityAt( world, ASTEROID_COMPONENTS, index ) );
+}
+
+// The asteroid physics come in two versions, the build picks one (make FIXED_SIM=1 for fixed point)
+void MoveAsteroid( Vector2 *position, Vector2 velocity, AsteroidSpin *spin, int ticks )
+{
+#ifdef FIXED_SIM
+    MoveAsteroidFixed( position, velocity, spin, ticks );
+#else
+    MoveAsteroidFloat( position, velocity, spin, ticks );
+#endif
+}
+
+// The index it filled or -1 if the world has no room, nothing below from may be free
+int SpawnAsteroids( EcsWorld *world, int from )
+{
+#ifdef FIXED_SIM
+    return SpawnAsteroidsFixed( world, from );
+#else
+    return SpawnAsteroidsFloat( world, from );
+#endif
+}
+
+void SplitAsteroid( EcsWorld *world, Vector2 position, float radius )
+{
+#ifdef FIXED_SIM
+    SplitAsteroidFixed( world, position, radius );
+#else
+    SplitAsteroidFloat( world, position, radius );
+#endif
+}
+
+// The lowest free index from from on that the world size allows, -1 when they are all taken
+static int FreeAsteroid( const EcsWorld *world, int from )
+{
+    for ( int i = from; i < worldAsteroidLimit; i++ )
     {
-        if ( asteroids[i].active )
-        {
-            // Then we move the asteroids
-            asteroids[i].position.x += asteroids[i].velocity.x;
-            asteroids[i].position.y += asteroids[i].velocity.y;
+        if ( EcsEntityAt( world, ASTEROID_COMPONENTS, i ) == ECS_NO_ENTITY ) return i;
+    }
+    return -1;
+}
 
-            // Now we can rotate the asteroids
-            asteroids[i].rotation += asteroids[i].rotationSpeed;
+// Every asteroid one tick, the game itself goes through UpdateWorldAsteroids() which also skips the distant ones
+void UpdateAsteroidFloat( EcsWorld *world )
+{
+    EcsQuery query = EcsQueryAll( world, ASTEROID_COMPONENTS );
+    while ( EcsNextArchetype( &query ) )
+    {
+        Vector2       *position = EcsColumn( &query, COMPONENT_POSITION );
+        const Vector2 *velocity = EcsColumn( &query, COMPONENT_VELOCITY );
+        AsteroidSpin  *spin     = EcsColumn( &query, COMPONENT_SPIN );
 
-            // Now we wrap their position
-            WrapPosition( &asteroids[i].position );
+        for ( int row = 0; row < query.count; row++ )
+        {
+            MoveAsteroidFloat( &position[row], velocity[row], &spin[row], 1 );
         }
     }
 
     // Spawn new asteroids ocassionally
-    if ( GetRandomValue( 0, 100 ) < 1 )
+    if ( SimRandomValue( 0, 100 ) < ActiveTunables()->asteroidSpawnChance )
     {
-        SpawnAsteroids( asteroids );
+        SpawnAsteroidsFloat( world, 0 );
     }
 }
 
-void DrawAsteroids( Asteroid *asteroids )
+// One tick's movement, or several at once for the distant asteroids (see UpdateWorldAsteroids)
+void MoveAsteroidFloat( Vector2 *position, Vector2 velocity, AsteroidSpin *spin, int ticks )
 {
+    // Then we move the asteroids
+    position->x += velocity.x * ( float ) ticks;
+    position->y += velocity.y * ( float ) ticks;
+
+    // Now we can rotate the asteroids
+    spin->rotation += spin->rotationSpeed * ( float ) ticks;
+
+    // Now we wrap their position
+    WrapPosition( position );
+}
+
+/*
+ * Draws the asteroids whose slots are listed, the ones in the chunks the camera sees (GatherVisibleAsteroids).
+ * How much of the outline is drawn depends on how big the asteroid comes out on screen: all 8 edges,
+ * every other point of it (4 edges), or a single point once it is smaller than a couple of pixels.
+ */
+void DrawAsteroids( const EcsWorld *world, const int *indices, int count )
+{
+    if ( count <= 0 ) return;
+
+    float pixelScale = ViewPixelScale();
+
+    // the turn of every listed asteroid in one batch
+    float rotations[MAX_ASTEROIDS], sines[MAX_ASTEROIDS], cosines[MAX_ASTEROIDS];
+    for ( int k = 0; k < count; k++ )
+    {
+        const AsteroidSpin *spin = EcsGet( world, EcsEntityAt( world, ASTEROID_COMPONENTS, indices[k] ), COMPONENT_SPIN );
+        rotations[k]             = spin->rotation;
+    }
+    SinCosArray( rotations, sines, cosines, count );
+
     // we need to draw some interesting asteroid shape
-    for ( int i = 0; i < MAX_ASTEROIDS; i++ )
+    for ( int k = 0; k < count; k++ )
     {
-        if ( asteroids[i].active )
+        Asteroid gathered;
+        GetAsteroid( world, indices[k], &gathered );
+        const Asteroid *asteroid = &gathered;
+
+        // a chunk can be in view without all of its asteroids, and near an edge the part that sticks
+        // out is drawn again on the other side, so it slides over instead of popping
+        Vector2 offsets[EDGE_COPIES];
+        int     copies = ViewImageOffsets( asteroid->position, asteroid->radius, offsets );
+        if ( copies == 0 )
         {
-            // we make it a irregular polygon of 8 sides
-            int     points  = 8;
-            Vector2 prev    = { 0 };
-            Vector2 current = { 0 };
+            drawStats.asteroidsCulled++;
+            continue;
+        }
+
+        float onScreen = asteroid->radius * pixelScale;
+        if ( onScreen < ASTEROID_LOD_POINT )
+        {
+            for ( int c = 0; c < copies; c++ )
+            {
+                DrawPixelV( ( Vector2 ) { asteroid->position.x + offsets[c].x, asteroid->position.y + offsets[c].y }, WHITE );
+            }
+            drawStats.asteroidsPoint++;
+            continue;
+        }
+
+        // the irregular polygon of 8 sides is cached in its outline, we only rotate it into place
+        Vector2 outline[ASTEROID_VERTICES + 1];
+        AsteroidOutlinePoints( asteroid, sines[k], cosines[k], outline );
+
+        int step = onScreen < ASTEROID_LOD_FULL ? 2 : 1;
+        if ( step == 1 ) drawStats.asteroidsFull++;
+        else drawStats.asteroidsReduced++;
 
-            for ( int j = 0; j <= points; j++ )
+        for ( int c = 0; c < copies; c++ )
+        {
+            for ( int j = step; j <= ASTEROID_VERTICES; j += step )
             {
-                // we divide the circles into equal segments
-                float angle  = j * ( 2.0f * PI / points ) + asteroids[i].rotation;
-                float radius = asteroids[i].radius * ( 0.8f + 0.2f * sinf( angle * 5 ) );
-
-                current.x = asteroids[i].position.x + radius * cosf( angle );
-                current.y = asteroids[i].position.y + radius * sinf( angle );
-
-                if ( j > 0 )
-                {
-                    DrawLineV( prev, current, WHITE );
-                }
-                prev = current;
+                DrawLineV( ( Vector2 ) { outline[j - step].x + offsets[c].x, outline[j - step].y + offsets[c].y },
+                           ( Vector2 ) { outline[j].x + offsets[c].x, outline[j].y + offsets[c].y }, WHITE );
             }
         }
     }
 }
 
-void SpawnAsteroids( Asteroid *asteroids )
+/*
+ * Works out the jagged outline once, when the asteroid is made, so drawing and the polygon
+ * collision test use the exact same shape. The radius is modulated by 0.8 + 0.2 * sin(5 angle)
+ * with the angle measured at the rotation the asteroid has right now, after that the shape
+ * just turns with the asteroid instead of wobbling.
+ */
+void BuildAsteroidOutline( Asteroid *asteroid )
 {
-    for ( int i = 0; i < MAX_ASTEROIDS; i++ )
+    // the directions of the points first, then the angles for the wobble, all in one batch
+    float angles[2 * ASTEROID_VERTICES], sines[2 * ASTEROID_VERTICES], cosines[2 * ASTEROID_VERTICES];
+    for ( int j = 0; j < ASTEROID_VERTICES; j++ )
     {
-        if ( !asteroids[i].active )
-        {
-            // randomly choose from one of the window edges
-            float edge = GetRandomValue( 0, 3 );
-            // if the edge is 0 then we get the following;
-            if ( edge == 0 )
-            {
-                // this will make an asteroid that will spawn from the top
-                asteroids[i].position = ( Vector2 ) { GetRandomValue( 0, screenWidth ), 0 };
-            }
-            else if ( edge == 1 )    // Right
-            {
-                asteroids[i].position = ( Vector2 ) { screenWidth, GetRandomValue( 0, screenHeight ) };
-            }
-            else if ( edge == 2 )    // BOTTOM
-            {
-                asteroids[i].position = ( Vector2 ) { GetRandomValue( 0, screenWidth ), screenHeight };
-            }
-            else    // Left
-            {
-                asteroids[i].position = ( Vector2 ) { 0, GetRandomValue( 0, screenHeight ) };
-            }
+        // we divide the circles into equal segments
+        angles[j]                     = j * ( 2.0f * PI / ASTEROID_VERTICES );
+        angles[ASTEROID_VERTICES + j] = ( angles[j] + asteroid->rotation ) * 5;
+    }
+    SinCosArray( angles, sines, cosines, 2 * ASTEROID_VERTICES );
 
-            // random velocity we need to do this first
-            float angle             = GetRandomValue( 0, 360 ) * DEG2RAD;
-            asteroids[i].velocity.x = cos( angle ) * ASTEROID_SPEED;
-            asteroids[i].velocity.y = sin( angle ) * ASTEROID_SPEED;
+    for ( int j = 0; j < ASTEROID_VERTICES; j++ )
+    {
+        float radius = asteroid->radius * ( 0.8f + 0.2f * sines[ASTEROID_VERTICES + j] );
 
-            // Now we do the size and rotational part, we need to program that as well
-            asteroids[i].radius        = GetRandomValue( 20, 40 );
-            asteroids[i].rotation      = GetRandomValue( 0, 360 ) * DEG2RAD;
-            asteroids[i].rotationSpeed = ( ( float ) GetRandomValue( -10, 10 ) / 100.0f );
+        asteroid->outlineX[j] = radius * cosines[j];
+        asteroid->outlineY[j] = radius * sines[j];
+    }
 
-            asteroids[i].active = true;
-            break;
-        }
+    asteroid->outlineX[ASTEROID_VERTICES] = asteroid->outlineX[0];
+    asteroid->outlineY[ASTEROID_VERTICES] = asteroid->outlineY[0];
+}
+
+// The whole outline in screen space, first point repeated at the end, for the turn whose sine and cosine are given
+void AsteroidOutlinePoints( const Asteroid *asteroid, float sinA, float cosA, Vector2 points[ASTEROID_VERTICES + 1] )
+{
+    for ( int j = 0; j <= ASTEROID_VERTICES; j++ )
+    {
+        float x = asteroid->outlineX[j];
+        float y = asteroid->outlineY[j];
+
+        points[j] = ( Vector2 ) { asteroid->position.x + x * cosA - y * sinA, asteroid->position.y + x * sinA + y * cosA };
+    }
+}
+
+// A random point on one of the world edges, whole pixels
+static Vector2 SpawnEdgePosition( void )
+{
+    // randomly choose from one of the world edges
+    float edge = SimRandomValue( 0, 3 );
+    // if the edge is 0 then we get the following;
+    if ( edge == 0 )
+    {
+        // this will make an asteroid that will spawn from the top
+        return ( Vector2 ) { SimRandomValue( 0, worldWidth ), 0 };
+    }
+    else if ( edge == 1 )    // Right
+    {
+        return ( Vector2 ) { worldWidth, SimRandomValue( 0, worldHeight ) };
+    }
+    else if ( edge == 2 )    // BOTTOM
+    {
+        return ( Vector2 ) { SimRandomValue( 0, worldWidth ), worldHeight };
+    }
+    else    // Left
+    {
+        return ( Vector2 ) { 0, SimRandomValue( 0, worldHeight ) };
     }
 }
 
-// Now we need to implement the functionality of the SPlitting of the asteroid
-void SplitAsteroid( Asteroid *asteroids, int index )
+int SpawnAsteroidsFloat( EcsWorld *world, int from )
 {
-    Vector2 position = asteroids[index].position;      // we get the position of the asteroid
-    float   radius   = asteroids[index].radius / 2;    // here we are splitting the radius
+    // only the slots the world size allows, a bigger world has room for more
+    int i = FreeAsteroid( world, from );
+    if ( i < 0 ) return -1;
+
+    Asteroid asteroid;
+    asteroid.position = SpawnEdgePosition();
+
+    // random velocity we need to do this first
+    float sinA, cosA;
+    SinCosDegrees( SimRandomValue( 0, 360 ), &sinA, &cosA );
+    asteroid.velocity.x = cosA * ActiveTunables()->asteroidSpeed;
+    asteroid.velocity.y = sinA * ActiveTunables()->asteroidSpeed;
+
+    // Now we do the size and rotational part, we need to program that as well
+    asteroid.radius        = SimRandomValue( 20, 40 );
+    asteroid.rotation      = SimRandomValue( 0, 360 ) * DEG2RAD;
+    asteroid.rotationSpeed = ( ( float ) SimRandomValue( -10, 10 ) / 100.0f );
+    BuildAsteroidOutline( &asteroid );
+
+    PutAsteroid( world, i, &asteroid );
+    return i;
+}
+
+// Now we need to implement the functionality of the SPlitting of the asteroid, the one that was hit is gone already
+void SplitAsteroidFloat( EcsWorld *world, Vector2 position, float radius )
+{
+    radius = radius / 2;    // here we are splitting the radius
+
+    const Tunables *tune = ActiveTunables();
 
     // we need to split only if the radius is big enough
     if ( radius >= 10 )    // we only make fragments if that radius is larger than 10 pixels
     {
         for ( int i = 0; i < 2; i++ )
         {
-            for ( int j = 0; j < MAX_ASTEROIDS; j++ )
-            {
-                if ( !asteroids[j].active )
-                {
-                    asteroids[j].position
-                        = position;    // here we are setting the position of the fragmented asteroid to the original position of the asteroid
-                    float angle = GetRandomValue( 0, 360 )
-                                  * DEG2RAD;    // we need to make a new angle for this fragment to move in
-                    asteroids[j].velocity.x
-                        = cos( angle ) * ASTEROID_SPEED
-                          * 1.5f;    // we need to make sure that fragments move faster than big asteroids
-                    asteroids[j].velocity.y = sin( angle ) * ASTEROID_SPEED
-                                              * 1.5f;    // factor of 1.5 is to make sure it moves faster than regular
-                    asteroids[j].radius   = radius;
-                    asteroids[j].rotation = GetRandomValue( 0, 360 ) * DEG2RAD;
-                    asteroids[j].rotationSpeed
-                        = ( ( float ) GetRandomValue( -15, 15 )
-                            / 100.0f );    // it is from -15 to 15 because they spin faster
-                    asteroids[j].active = true;
-                    break;
-                }
-            }
+            int j = FreeAsteroid( world, 0 );
+            if ( j < 0 ) break;
+
+            Asteroid fragment;
+            fragment.position = position;    // here we are setting the position of the fragmented asteroid to the original position of the asteroid
+            float sinA, cosA;
+            SinCosDegrees( SimRandomValue( 0, 360 ), &sinA,
+                           &cosA );    // we need to make a new angle for this fragment to move in
+            fragment.velocity.x
+                = cosA * tune->asteroidSpeed
+                  * tune->splitFactor;    // we need to make sure that fragments move faster than big asteroids
+            fragment.velocity.y = sinA * tune->asteroidSpeed
+                                  * tune->splitFactor;    // the split factor (1.5) is to make sure it moves faster than regular
+            fragment.radius   = radius;
+            fragment.rotation = SimRandomValue( 0, 360 ) * DEG2RAD;
+            fragment.rotationSpeed
+                = ( ( float ) SimRandomValue( -15, 15 )
+                    / 100.0f );    // it is from -15 to 15 because they spin faster
+            BuildAsteroidOutline( &fragment );
+            PutAsteroid( world, j, &fragment );
         }
     }
 }
+
+/*
+ * Fixed-point versions (see fixed.h). They draw the same random numbers in the same order as the
+ * float ones, only the math on them is integer. The rotation is kept inside one turn here, so it
+ * can't grow past what Q16.16 holds however long an asteroid lives.
+ */
+void BuildAsteroidOutlineFixed( Asteroid *asteroid )
+{
+    Fixed       radius   = FixedFromFloat( asteroid->radius );
+    BinaryAngle rotation = FixedRadiansToAngle( FixedFromFloat( asteroid->rotation ) );
+
+    for ( int j = 0; j < ASTEROID_VERTICES; j++ )
+    {
+        BinaryAngle angle  = ( BinaryAngle ) ( j * ( 65536 / ASTEROID_VERTICES ) );
+        Fixed       wobble = FIXED_CONST( 0.8 ) + FixedMul( FIXED_CONST( 0.2 ), FixedSin( ( BinaryAngle ) ( ( angle + rotation ) * 5 ) ) );
+        Fixed       length = FixedMul( radius, wobble );
+
+        asteroid->outlineX[j] = FixedToFloat( FixedMul( length, FixedCos( angle ) ) );
+        asteroid->outlineY[j] = FixedToFloat( FixedMul( length, FixedSin( angle ) ) );
+    }
+
+    asteroid->outlineX[ASTEROID_VERTICES] = asteroid->outlineX[0];
+    asteroid->outlineY[ASTEROID_VERTICES] = asteroid->outlineY[0];
+}
+
+// Heading in whole degrees, speed in pixels per tick, spin in hundredths of a radian per tick
+static void LaunchAsteroidFixed( Asteroid *asteroid, int degrees, Fixed speed, float radius, int rotationDegrees, int spin )
+{
+    BinaryAngle heading = FixedDegreesToAngle( FIXED_INT( degrees ) );
+
+    asteroid->velocity.x    = FixedToFloat( FixedMul( FixedCos( heading ), speed ) );
+    asteroid->velocity.y    = FixedToFloat( FixedMul( FixedSin( heading ), speed ) );
+    asteroid->radius        = radius;
+    asteroid->rotation      = FixedToFloat( FixedMul( FIXED_INT( rotationDegrees ), FIXED_DEG2RAD ) );
+    asteroid->rotationSpeed = FixedToFloat( FIXED_INT( spin ) / 100 );
+    BuildAsteroidOutlineFixed( asteroid );
+}
+
+void UpdateAsteroidFixed( EcsWorld *world )
+{
+    EcsQuery query = EcsQueryAll( world, ASTEROID_COMPONENTS );
+    while ( EcsNextArchetype( &query ) )
+    {
+        Vector2       *position = EcsColumn( &query, COMPONENT_POSITION );
+        const Vector2 *velocity = EcsColumn( &query, COMPONENT_VELOCITY );
+        AsteroidSpin  *spin     = EcsColumn( &query, COMPONENT_SPIN );
+
+        for ( int row = 0; row < query.count; row++ ) MoveAsteroidFixed( &position[row], velocity[row], &spin[row], 1 );
+    }
+
+    if ( SimRandomValue( 0, 100 ) < ActiveTunables()->asteroidSpawnChance )
+    {
+        SpawnAsteroidsFixed( world, 0 );
+    }
+}
+
+// Several ticks at once is exact here, the steps just add up (a spin of at most 4 x 0.15 stays under a turn)
+void MoveAsteroidFixed( Vector2 *position, Vector2 velocity, AsteroidSpin *spin, int ticks )
+{
+    Fixed x        = FixedFromFloat( position->x ) + FixedFromFloat( velocity.x ) * ticks;
+    Fixed y        = FixedFromFloat( position->y ) + FixedFromFloat( velocity.y ) * ticks;
+    Fixed rotation = FixedFromFloat( spin->rotation ) + FixedFromFloat( spin->rotationSpeed ) * ticks;
+
+    if ( rotation >= FIXED_TWO_PI ) rotation -= FIXED_TWO_PI;
+    else if ( rotation < 0 ) rotation += FIXED_TWO_PI;
+
+    position->x    = FixedToFloat( FixedWrapCoordinate( x, FIXED_INT( worldWidth ) ) );
+    position->y    = FixedToFloat( FixedWrapCoordinate( y, FIXED_INT( worldHeight ) ) );
+    spin->rotation = FixedToFloat( rotation );
+}
+
+int SpawnAsteroidsFixed( EcsWorld *world, int from )
+{
+    int i = FreeAsteroid( world, from );
+    if ( i < 0 ) return -1;
+
+    Asteroid asteroid;
+    asteroid.position = SpawnEdgePosition();
+
+    // one draw per argument, in the order the float version draws them
+    int degrees         = SimRandomValue( 0, 360 );
+    int radius          = SimRandomValue( 20, 40 );
+    int rotationDegrees = SimRandomValue( 0, 360 );
+    int spin            = SimRandomValue( -10, 10 );
+    LaunchAsteroidFixed( &asteroid, degrees, FIXED_CONST( ActiveTunables()->asteroidSpeed ), ( float ) radius, rotationDegrees, spin );
+    PutAsteroid( world, i, &asteroid );
+    return i;
+}
+
+void SplitAsteroidFixed( EcsWorld *world, Vector2 position, float radius )
+{
+    radius = radius / 2;
+
+    if ( radius < 10 ) return;
+
+    for ( int i = 0; i < 2; i++ )
+    {
+        int j = FreeAsteroid( world, 0 );
+        if ( j < 0 ) break;
+
+        Asteroid fragment;
+        fragment.position = position;
+
+        int degrees         = SimRandomValue( 0, 360 );
+        int rotationDegrees = SimRandomValue( 0, 360 );
+        int spin            = SimRandomValue( -15, 15 );
+        LaunchAsteroidFixed( &fragment, degrees, FIXED_CONST( ( double ) ActiveTunables()->asteroidSpeed * ActiveTunables()->splitFactor ), radius, rotationDegrees, spin );
+        PutAsteroid( world, j, &fragment );
+    }
+}
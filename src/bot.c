@@ -0,0 +1,164 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-16 11:12:09
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-16 16:34:51
+*/
+
+/*
+ * Bots for the Asteroids game. A bot looks at the game and returns a PlayerInput, which
+ * then goes through StepGameplay() like the keyboard input would. We use them for soak
+ * testing balance changes (see tools/bot_harness.c) and as an autopilot in the game.
+ *
+ * The baseline bot is simple on purpose: if an asteroid is about to hit us, turn away
+ * and thrust, otherwise turn towards the closest asteroid (leading it a bit) and shoot
+ * when the nose is lined up.
+ */
+
+#include "bot.h"
+#include "asteroids.h"
+#include "bullet.h"
+#include "game.h"
+#include "player.h"
+#include "spatial.h"
+#include "trig.h"
+#include "utils.h"
+#include <raylib.h>
+#include <math.h>
+#include <stddef.h>
+
+// Shortest signed difference between two angles in degrees, in the range -180..180
+static float AngleDifference(float target, float current)
+{
+    float diff = fmodf(target - current, 360.0f);
+    if (diff > 180.0f) diff -= 360.0f;
+    if (diff < -180.0f) diff += 360.0f;
+    return diff;
+}
+
+// Picks the rotate key that brings the nose to the target angle without overshooting too much
+static void SteerTowards(PlayerInput *input, const Player *ship, float targetAngle)
+{
+    // the ship keeps turning for a few ticks after the key is released, so aim where it will end up
+    float error = AngleDifference(targetAngle, ship->rotation + ship->rotationVelocity * 6.0f);
+
+    if (error > 2.0f) input->rotateRight = true;
+    else if (error < -2.0f) input->rotateLeft = true;
+}
+
+// Where an asteroid is from the ship, to its copy closest to the ship like the collisions see it (checkCollisions)
+static Vector2 AsteroidOffset(const Player *ship, const Asteroid *asteroid)
+{
+    Vector2 shift = WrapImageOffset(ship->position, asteroid->position);
+    return (Vector2){ asteroid->position.x + shift.x - ship->position.x, asteroid->position.y + shift.y - ship->position.y };
+}
+
+static PlayerInput ThinkAimEvade(void *state, const BotView *view)
+{
+    (void)state;
+
+    const Game *game = view->game;
+    const Player *ship = view->ship;
+    PlayerInput input = { 0 };
+
+    int nearest[4];
+    float clearance[4];
+    int found = QueryNearestAsteroids(view->asteroidGrid, ship->position, 4, nearest, clearance);
+    if (found == 0) return input;
+
+    Asteroid near[4];
+    for (int i = 0; i < found; i++) GetAsteroid(&game->entities, nearest[i], &near[i]);
+
+    // Evade first: anything inside the danger distance that is still getting closer
+    for (int i = 0; i < found && clearance[i] < BOT_DANGER_DISTANCE; i++)
+    {
+        const Asteroid *asteroid = &near[i];
+        Vector2 offset = AsteroidOffset(ship, asteroid);
+        float dx = offset.x;
+        float dy = offset.y;
+        float closing = dx * (asteroid->velocity.x - ship->velocity.x) + dy * (asteroid->velocity.y - ship->velocity.y);
+
+        if (closing < 0.0f)
+        {
+            float away = atan2f(-dy, -dx) * RAD2DEG;
+            SteerTowards(&input, ship, away);
+            input.thrust = fabsf(AngleDifference(away, ship->rotation)) < 45.0f;
+            return input;
+        }
+    }
+
+    // Attack: the closest asteroid on screen, bullets don't wrap around so use the direct distance
+    const Asteroid *target = NULL;
+    float targetDistance = BOT_FIRE_RANGE;
+    for (int i = 0; i < found; i++)
+    {
+        const Asteroid *asteroid = &near[i];
+        float dx = asteroid->position.x - ship->position.x;
+        float dy = asteroid->position.y - ship->position.y;
+        float distance = sqrtf(dx * dx + dy * dy);
+
+        if (distance < targetDistance)
+        {
+            target = asteroid;
+            targetDistance = distance;
+        }
+    }
+
+    if (target == NULL)
+    {
+        // nothing in range, drift back towards the middle where it's safest
+        float dx = worldWidth / 2.0f - ship->position.x;
+        float dy = worldHeight / 2.0f - ship->position.y;
+        if (dx * dx + dy * dy > 200.0f * 200.0f)
+        {
+            float home = atan2f(dy, dx) * RAD2DEG;
+            SteerTowards(&input, ship, home);
+            input.thrust = fabsf(AngleDifference(home, ship->rotation)) < 20.0f;
+        }
+        return input;
+    }
+
+    // lead the target by the time the bullet needs to get there, at the speed this game's bullets fly
+    float flightTime = targetDistance / game->tunables.bulletSpeed;
+    float aimX = target->position.x + target->velocity.x * flightTime - ship->position.x;
+    float aimY = target->position.y + target->velocity.y * flightTime - ship->position.y;
+    float aim = atan2f(aimY, aimX) * RAD2DEG;
+
+    SteerTowards(&input, ship, aim);
+
+    // fire when lined up, or when whatever is straight ahead is close anyway
+    Vector2 heading;
+    SinCosDegrees(ship->rotation, &heading.y, &heading.x);
+    float hitDistance = 0.0f;
+    int ahead = RaycastAsteroids(view->asteroidGrid, ship->position, heading, BOT_FIRE_RANGE, &hitDistance);
+
+    input.shoot = fabsf(AngleDifference(aim, ship->rotation)) < BOT_AIM_TOLERANCE || ahead >= 0;
+
+    return input;
+}
+
+// Runs one tick of a bot against a game
+PlayerInput RunBot(Bot *bot, Game *game)
+{
+    return RunBotForShip(bot, game, 0);
+}
+
+// Same for either ship of a versus game, 0 or 1
+PlayerInput RunBotForShip(Bot *bot, Game *game, int ship)
+{
+    Player player = GetPlayer(&game->entities, ship);
+    BotView view = { .game = game, .ship = &player, .asteroidGrid = &game->asteroidGrid };
+    return bot->think(bot->state, &view);
+}
+
+Bot CreateAimEvadeBot(void)
+{
+    return (Bot){ .name = "aim-evade", .think = ThinkAimEvade, .state = NULL };
+}
+
+// Shortcut for the autopilot in the game
+PlayerInput RunAimEvadeBot(Game *game)
+{
+    Bot bot = CreateAimEvadeBot();
+    return RunBot(&bot, game);
+}
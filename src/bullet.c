@@ -11,128 +11,288 @@
 
 #include "bullet.h"
 #include "utils.h"
+#include "fixed.h"
+#include "trig.h"
+#include "tunables.h"
+#include "telemetry.h"
 #include <raylib.h>
 #include <stdlib.h>
 #include <math.h>
 #include <time.h>
 
-// External globals for screen dimensions
-extern int screenWidth;
-extern int screenHeight;
-
-void InitBullets(Bullet *bullets)
+void InitBullets(EcsWorld *world, int ship)
 {
     /* this technique is known as the object pooling where we don't use dynamic memory allocation 
-     * but instead, we use only the existing amount of bullets or objects that we need
-     * and instead of creating and destroying the existing ones, we just use and iterate over the 
-     * ones that are already existing, so we use the active flag boolean that allows us to keep track
-     * of everything that we will be using
+     * but instead, we use only the existing amount of bullets or objects that we need, the bullet
+     * table has a row for every one of them from the start (InitGameWorld) and a bullet that goes
+     * just gives its row back
      */
     for (int i = 0; i < MAX_BULLETS; i++)
     {
-        bullets[i].active = false;
+        EcsDestroy(world, EcsEntityAt(world, BULLET_COMPONENTS, ship * MAX_BULLETS + i));
     }
 }
 
-void UpdateBullets(Bullet *bullets)
+bool GetBullet(const EcsWorld *world, int index, Bullet *bullet)
+{
+    EntityId entity = EcsEntityAt(world, BULLET_COMPONENTS, index);
+    if (entity == ECS_NO_ENTITY) return false;
+
+    bullet->position = *(const Vector2 *)EcsGet(world, entity, COMPONENT_POSITION);
+    bullet->velocity = *(const Vector2 *)EcsGet(world, entity, COMPONENT_VELOCITY);
+    bullet->radius = *(const float *)EcsGet(world, entity, COMPONENT_RADIUS);
+    bullet->lifeTime = *(const int *)EcsGet(world, entity, COMPONENT_LIFETIME);
+    bullet->color = *(const Color *)EcsGet(world, entity, COMPONENT_COLOR);
+    return true;
+}
+
+void PutBullet(EcsWorld *world, int index, const Bullet *bullet)
+{
+    EntityId entity = EcsEntityAt(world, BULLET_COMPONENTS, index);
+    if (entity == ECS_NO_ENTITY) entity = EcsSpawnAt(world, BULLET_COMPONENTS, index);
+    if (entity == ECS_NO_ENTITY) return;
+
+    *(Vector2 *)EcsGet(world, entity, COMPONENT_POSITION) = bullet->position;
+    *(Vector2 *)EcsGet(world, entity, COMPONENT_VELOCITY) = bullet->velocity;
+    *(float *)EcsGet(world, entity, COMPONENT_RADIUS) = bullet->radius;
+    *(int *)EcsGet(world, entity, COMPONENT_LIFETIME) = bullet->lifeTime;
+    *(Color *)EcsGet(world, entity, COMPONENT_COLOR) = bullet->color;
+}
+
+// One pass over the rows sorts them by index, then the copies are made in that order
+void ListShipBullets(const EcsWorld *world, int ship, BulletList *list)
 {
+    list->count = 0;
+
+    // the bullets are the only archetype with all of these
+    EcsQuery query = EcsQueryAll(world, BULLET_COMPONENTS);
+    if (!EcsNextArchetype(&query)) return;
+
+    int rowAt[MAX_BULLETS];
+    for (int i = 0; i < MAX_BULLETS; i++) rowAt[i] = -1;
+    for (int row = 0; row < query.count; row++)
+    {
+        int i = EcsRowIndex(&query, row) - ship * MAX_BULLETS;
+        if (i >= 0 && i < MAX_BULLETS) rowAt[i] = row;
+    }
+
+    const Vector2 *position = EcsColumn(&query, COMPONENT_POSITION);
+    const Vector2 *velocity = EcsColumn(&query, COMPONENT_VELOCITY);
+    const float *radius = EcsColumn(&query, COMPONENT_RADIUS);
     for (int i = 0; i < MAX_BULLETS; i++)
     {
-        // Update active bullets
-        if(bullets[i].active)
+        int row = rowAt[i];
+        if (row < 0) continue;
+
+        list->entity[list->count] = EcsRowEntity(&query, row);
+        list->position[list->count] = position[row];
+        list->velocity[list->count] = velocity[row];
+        list->radius[list->count] = radius[row];
+        list->count++;
+    }
+}
+
+// Fade bullets as they get older
+float BulletAlpha(int lifeTime)
+{
+    return lifeTime < BULLET_FADE_TICKS ? lifeTime / (float)BULLET_FADE_TICKS : 1.0f;
+}
+
+// Float or fixed point, picked when the game is built (make FIXED_SIM=1)
+void UpdateBullets(EcsWorld *world)
+{
+#ifdef FIXED_SIM
+    UpdateBulletsFixed(world);
+#else
+    UpdateBulletsFloat(world);
+#endif
+}
+
+void UpdateBulletsFloat(EcsWorld *world)
+{
+    EcsQuery query = EcsQueryAll(world, BULLET_COMPONENTS);
+    while (EcsNextArchetype(&query))
+    {
+        Vector2 *position = EcsColumn(&query, COMPONENT_POSITION);
+        const Vector2 *velocity = EcsColumn(&query, COMPONENT_VELOCITY);
+        int *lifeTime = EcsColumn(&query, COMPONENT_LIFETIME);
+
+        // from the back, the row that moves into a destroyed one has been updated already
+        for (int row = query.count - 1; row >= 0; row--)
         {
             // Move the bullets
-            bullets[i].position.x += bullets[i].velocity.x;
-            bullets[i].position.y += bullets[i].velocity.y;
+            position[row].x += velocity[row].x;
+            position[row].y += velocity[row].y;
 
-            // We don't wrap bullets around edges anymore - they disappear offscreen
+            // We don't wrap bullets around edges anymore - they disappear at the edges of the world
             
-            // If bullet goes off-screen, deactivate it
-            if (bullets[i].position.x < 0 || 
-                bullets[i].position.x > screenWidth ||
-                bullets[i].position.y < 0 || 
-                bullets[i].position.y > screenHeight)
+            // If bullet goes out of the world, deactivate it
+            if (position[row].x < 0 || 
+                position[row].x > worldWidth ||
+                position[row].y < 0 || 
+                position[row].y > worldHeight)
             {
-                bullets[i].active = false;
+                EcsDestroy(world, EcsRowEntity(&query, row));
                 continue;
             }
 
-            // Update lifetime
-            bullets[i].lifeTime--;
-            
-            // Fade bullets as they get older
-            if (bullets[i].lifeTime < 40) {
-                bullets[i].alpha = bullets[i].lifeTime / 40.0f;
-            }
-            
-            // Deactivate expired bullets
-            if (bullets[i].lifeTime <= 0)
+            // Update lifetime, and deactivate expired bullets
+            if (--lifeTime[row] <= 0)
             {
-                bullets[i].active = false;
+                EcsDestroy(world, EcsRowEntity(&query, row));
             }
         }
     }
 }
 
 // Now we need to do the drawing part of all of this
-void DrawBullets(Bullet *bullets)
+void DrawBullets(const EcsWorld *world)
 {
-    for (int i = 0; i < MAX_BULLETS; i++)
+    EcsQuery query = EcsQueryAll(world, BULLET_COMPONENTS);
+    while (EcsNextArchetype(&query))
     {
-        if (bullets[i].active)
+        const Vector2 *positions = EcsColumn(&query, COMPONENT_POSITION);
+        const float *radius = EcsColumn(&query, COMPONENT_RADIUS);
+        const int *lifeTime = EcsColumn(&query, COMPONENT_LIFETIME);
+        const Color *color = EcsColumn(&query, COMPONENT_COLOR);
+
+        for (int row = 0; row < query.count; row++)
         {
+            // only if it is in view, at the copy of it the camera sees
+            Vector2 offsets[EDGE_COPIES];
+            if (ViewImageOffsets(positions[row], radius[row], offsets) == 0) {
+                drawStats.bulletsCulled++;
+                continue;
+            }
+            drawStats.bulletsDrawn++;
+            Vector2 position = { positions[row].x + offsets[0].x, positions[row].y + offsets[0].y };
+            float alpha = BulletAlpha(lifeTime[row]);
+
             // Create a color with adjusted alpha for fading effect
-            Color bulletColor = bullets[i].color;
-            bulletColor.a = (unsigned char)(bullets[i].alpha * 255.0f);
+            Color bulletColor = color[row];
+            bulletColor.a = (unsigned char)(alpha * 255.0f);
             
             // Draw the bullet
-            DrawCircle(bullets[i].position.x, bullets[i].position.y, bullets[i].radius, bulletColor);
+            DrawCircle(position.x, position.y, radius[row], bulletColor);
             
             // Draw a smaller inner circle for a more interesting visual
             Color innerColor = WHITE;
-            innerColor.a = (unsigned char)(bullets[i].alpha * 255.0f);
-            DrawCircle(bullets[i].position.x, bullets[i].position.y, bullets[i].radius * 0.5f, innerColor);
+            innerColor.a = (unsigned char)(alpha * 255.0f);
+            DrawCircle(position.x, position.y, radius[row] * 0.5f, innerColor);
         }
     }
 }
 
+// The lowest free index of the ship's pool, -1 when all its bullets are flying
+static int FreeBullet(const EcsWorld *world, int ship)
+{
+    for (int i = ship * MAX_BULLETS; i < (ship + 1) * MAX_BULLETS; i++)
+    {
+        if (EcsEntityAt(world, BULLET_COMPONENTS, i) == ECS_NO_ENTITY) return i;
+    }
+    return -1;
+}
+
+// Sets up one bullet of the three, the middle one (spread 0) is bigger and lasts longer
+static void ActivateBullet(EcsWorld *world, int index, Vector2 position, Vector2 velocity, int spread)
+{
+    Bullet bullet;
+    bullet.position = position;
+    bullet.velocity = velocity;
+    bullet.radius = 3 + (float)abs(spread) * 0.5f; // Slightly different sizes
+    bullet.lifeTime = ActiveTunables()->bulletLifetime - abs(spread) * 10; // Center bullet lasts longer
+
+    // Set different colors for visual interest
+    if (spread == 0) {
+        bullet.color = (Color){ 255, 255, 255, 255 }; // White for center
+    } else if (spread == -1) {
+        bullet.color = (Color){ 0, 200, 255, 255 };   // Blue-ish
+    } else {
+        bullet.color = (Color){ 255, 200, 0, 255 };   // Yellow-ish
+    }
+
+    PutBullet(world, index, &bullet);
+}
+
+void ShootBullets(EcsWorld *world, int ship, Vector2 position, float rotation)
+{
+#ifdef FIXED_SIM
+    ShootBulletsFixed(world, ship, position, rotation);
+#else
+    ShootBulletsFloat(world, ship, position, rotation);
+#endif
+}
+
 // We also need to program the shooting of the bullets
-void ShootBullets(Bullet *bullets, Vector2 position, float rotation)
+void ShootBulletsFloat(EcsWorld *world, int ship, Vector2 position, float rotation)
 {
     // We'll shoot 3 bullets with a slight spread for a more interesting effect
+    int fired = 0;
     for (int spread = -1; spread <= 1; spread++)
     {
         // Find an inactive bullet to use
-        for (int i = 0; i < MAX_BULLETS; i++)
+        int i = FreeBullet(world, ship);
+        if (i < 0) continue;
+
+        // Get the actual rotation with spread
+        float bulletRotation = rotation + spread * BULLET_SPREAD;
+
+        // Calculate velocity based on spread-adjusted rotation
+        float cosA, sinA;
+        SinCosDegrees(bulletRotation, &sinA, &cosA);
+
+        ActivateBullet(world, i, position, (Vector2){ cosA * ActiveTunables()->bulletSpeed, sinA * ActiveTunables()->bulletSpeed }, spread);
+        fired++;
+    }
+    CountShots(fired);
+}
+
+/*
+ * Fixed-point versions (see fixed.h). Same rules, but the movement, the edge test and the
+ * direction of each bullet are integer math, the rotation comes in degrees like above.
+ */
+void UpdateBulletsFixed(EcsWorld *world)
+{
+    Fixed width = FIXED_INT(worldWidth);
+    Fixed height = FIXED_INT(worldHeight);
+
+    EcsQuery query = EcsQueryAll(world, BULLET_COMPONENTS);
+    while (EcsNextArchetype(&query))
+    {
+        Vector2 *position = EcsColumn(&query, COMPONENT_POSITION);
+        const Vector2 *velocity = EcsColumn(&query, COMPONENT_VELOCITY);
+        int *lifeTime = EcsColumn(&query, COMPONENT_LIFETIME);
+
+        for (int row = query.count - 1; row >= 0; row--)
         {
-            if(!bullets[i].active)
+            Fixed x = FixedFromFloat(position[row].x) + FixedFromFloat(velocity[row].x);
+            Fixed y = FixedFromFloat(position[row].y) + FixedFromFloat(velocity[row].y);
+            position[row] = (Vector2){ FixedToFloat(x), FixedToFloat(y) };
+
+            if (x < 0 || x > width || y < 0 || y > height || --lifeTime[row] <= 0)
             {
-                // Get the actual rotation with spread
-                float bulletRotation = rotation + spread * BULLET_SPREAD;
-                
-                // Calculate velocity based on spread-adjusted rotation
-                float cosA = cos(bulletRotation * DEG2RAD);
-                float sinA = sin(bulletRotation * DEG2RAD);
-                
-                bullets[i].position = position;
-                bullets[i].velocity.x = cosA * BULLET_SPEED;
-                bullets[i].velocity.y = sinA * BULLET_SPEED;
-                bullets[i].radius = 3 + (float)abs(spread) * 0.5f; // Slightly different sizes
-                bullets[i].lifeTime = BULLET_LIFETIME - abs(spread) * 10; // Center bullet lasts longer
-                bullets[i].active = true;
-                bullets[i].alpha = 1.0f;
-                
-                // Set different colors for visual interest
-                if (spread == 0) {
-                    bullets[i].color = (Color){ 255, 255, 255, 255 }; // White for center
-                } else if (spread == -1) {
-                    bullets[i].color = (Color){ 0, 200, 255, 255 };   // Blue-ish
-                } else {
-                    bullets[i].color = (Color){ 255, 200, 0, 255 };   // Yellow-ish
-                }
-                
-                break; // We found an inactive bullet to use, so break the inner loop
+                EcsDestroy(world, EcsRowEntity(&query, row));
             }
         }
     }
 }
+
+void ShootBulletsFixed(EcsWorld *world, int ship, Vector2 position, float rotation)
+{
+    Fixed degrees = FixedFromFloat(rotation);
+    int fired = 0;
+
+    for (int spread = -1; spread <= 1; spread++)
+    {
+        int i = FreeBullet(world, ship);
+        if (i < 0) continue;
+
+        BinaryAngle angle = FixedDegreesToAngle(degrees + spread * FIXED_CONST(BULLET_SPREAD));
+        Fixed speed = FIXED_CONST(ActiveTunables()->bulletSpeed);     // exact for whole numbers, like the old * BULLET_SPEED
+        Vector2 velocity = { FixedToFloat(FixedMul(FixedCos(angle), speed)), FixedToFloat(FixedMul(FixedSin(angle), speed)) };
+
+        ActivateBullet(world, i, position, velocity, spread);
+        fired++;
+    }
+    CountShots(fired);
+}
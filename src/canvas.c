@@ -0,0 +1,102 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-24 11:20:47
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-24 15:02:19
+*/
+
+/*
+ * The canvas the game is drawn on, see canvas.h. Everything between BeginCanvas and EndCanvas
+ * goes into a render texture through a camera that only scales, so the drawing code keeps using
+ * canvas coordinates whatever the render scale is. The mouse is mapped back the same way, so
+ * GetMousePosition gives canvas coordinates too.
+ */
+
+#include "canvas.h"
+#include "utils.h"
+
+static RenderTexture2D canvas;
+static bool canvasLoaded = false;
+static float canvasScale = 1.0f;
+
+static void LoadCanvasTexture(void)
+{
+    if (canvasLoaded) UnloadRenderTexture(canvas);
+
+    int width = (int)(screenWidth * canvasScale + 0.5f);
+    int height = (int)(screenHeight * canvasScale + 0.5f);
+    canvas = LoadRenderTexture(width > 0 ? width : 1, height > 0 ? height : 1);
+
+    // the blit to the window is the only place the picture gets scaled
+    SetTextureFilter(canvas.texture, TEXTURE_FILTER_BILINEAR);
+    canvasLoaded = true;
+}
+
+void InitCanvas(float renderScale)
+{
+    canvasScale = renderScale < MIN_RENDER_SCALE ? MIN_RENDER_SCALE : (renderScale > MAX_RENDER_SCALE ? MAX_RENDER_SCALE : renderScale);
+    LoadCanvasTexture();
+}
+
+void UnloadCanvas(void)
+{
+    if (canvasLoaded) UnloadRenderTexture(canvas);
+    canvasLoaded = false;
+}
+
+void SetRenderScale(float renderScale)
+{
+    renderScale = renderScale < MIN_RENDER_SCALE ? MIN_RENDER_SCALE : (renderScale > MAX_RENDER_SCALE ? MAX_RENDER_SCALE : renderScale);
+    if (renderScale == canvasScale) return;
+
+    canvasScale = renderScale;
+    if (canvasLoaded) LoadCanvasTexture();
+}
+
+float CanvasScale(void)
+{
+    return canvasScale;
+}
+
+void BeginCanvasMode(void)
+{
+    BeginMode2D((Camera2D){ .zoom = canvasScale });
+}
+
+void BeginCanvas(void)
+{
+    BeginTextureMode(canvas);
+    ClearBackground(BLACK);
+    BeginCanvasMode();
+}
+
+// Where the canvas goes in the window: as big as fits without changing its shape, centered
+static Rectangle CanvasPlacement(void)
+{
+    float windowWidth = (float)GetScreenWidth();
+    float windowHeight = (float)GetScreenHeight();
+    float fit = windowWidth / screenWidth < windowHeight / screenHeight ? windowWidth / screenWidth : windowHeight / screenHeight;
+
+    float width = screenWidth * fit, height = screenHeight * fit;
+    return (Rectangle){ (windowWidth - width) * 0.5f, (windowHeight - height) * 0.5f, width, height };
+}
+
+void EndCanvas(void)
+{
+    EndMode2D();
+    EndTextureMode();
+
+    Rectangle placement = CanvasPlacement();
+
+    // the mouse in canvas coordinates from the next frame on, it follows the window whatever changed it
+    SetMouseOffset(-(int)placement.x, -(int)placement.y);
+    SetMouseScale(screenWidth / placement.width, screenHeight / placement.height);
+
+    BeginDrawing();
+        ClearBackground(BLACK);
+
+        // render textures are upside down in OpenGL, hence the negative height
+        Rectangle source = { 0.0f, 0.0f, (float)canvas.texture.width, -(float)canvas.texture.height };
+        DrawTexturePro(canvas.texture, source, placement, (Vector2){ 0.0f, 0.0f }, 0.0f, WHITE);
+    EndDrawing();
+}
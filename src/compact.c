@@ -0,0 +1,74 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-06-02 09:31:18
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-06-02 15:07:44
+*/
+
+/*
+ * The stream's stand-ins for the derived fields, see compact.h. The palette and the radius are
+ * exact, the outline's phase is rounded to the nearest of COMPACT_PHASES: what tools/bench_compact
+ * checks.
+ */
+
+#include <math.h>
+#include "compact.h"
+
+// What ActivateBullet gives the three bullets of a volley
+static const Color bulletPalette[BULLET_KINDS] = {
+    { 255, 255, 255, 255 },
+    { 0, 200, 255, 255 },
+    { 255, 200, 0, 255 }
+};
+
+BulletKind FindBulletKind(const Bullet *bullet)
+{
+    BulletKind nearest = BULLET_CENTER;
+    int nearestDistance = 0x7FFFFFFF;
+    for (int kind = 0; kind < BULLET_KINDS; kind++)
+    {
+        int dr = bullet->color.r - bulletPalette[kind].r;
+        int dg = bullet->color.g - bulletPalette[kind].g;
+        int db = bullet->color.b - bulletPalette[kind].b;
+        int distance = dr * dr + dg * dg + db * db;
+        if (distance < nearestDistance)
+        {
+            nearest = (BulletKind)kind;
+            nearestDistance = distance;
+        }
+    }
+    return nearest;
+}
+
+Color BulletKindColor(BulletKind kind)
+{
+    return bulletPalette[kind];
+}
+
+float BulletKindRadius(BulletKind kind)
+{
+    return kind == BULLET_CENTER ? 3.0f : 3.5f;
+}
+
+/*
+ * The outline's points are radius * (0.8 + 0.2 * sin(5 * (angle + rotation))), so the first
+ * point (angle 0) has the sine of the phase and the third (a quarter turn) its cosine.
+ */
+int AsteroidOutlinePhase(const Asteroid *asteroid)
+{
+    if (asteroid->radius <= 0.0f) return 0;
+
+    float first = sqrtf(asteroid->outlineX[0] * asteroid->outlineX[0] + asteroid->outlineY[0] * asteroid->outlineY[0]);
+    float third = sqrtf(asteroid->outlineX[2] * asteroid->outlineX[2] + asteroid->outlineY[2] * asteroid->outlineY[2]);
+    float phase = atan2f(first / asteroid->radius - 0.8f, third / asteroid->radius - 0.8f);
+    return (int)(lrintf(phase * (COMPACT_PHASES / (2.0f * PI))) & (COMPACT_PHASES - 1));
+}
+
+// The same outline BuildAsteroidOutline made, from a rotation that has the phase
+void RebuildAsteroidOutline(Asteroid *asteroid, int phase)
+{
+    float rotation = asteroid->rotation;
+    asteroid->rotation = phase * (2.0f * PI / COMPACT_PHASES) / 5.0f;
+    BuildAsteroidOutline(asteroid);
+    asteroid->rotation = rotation;
+}
@@ -0,0 +1,184 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-28 09:21:37
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-28 14:05:12
+*/
+
+/*
+ * The wave director, see director.h. The tables are per difficulty, in percent of what the old
+ * roll spawned in a wave, and all the math is integers so the fixed point build stays the same
+ * on every machine.
+ */
+
+#include "director.h"
+#include "game.h"
+#include "ufo.h"
+#include "tunables.h"
+#include "utils.h"
+#include "world.h"
+
+#define WAVE_TICKS          (WAVE_SECONDS * GAME_TICK_RATE)
+#define MAX_ASTEROID_PIECES 2                  // a new asteroid can be as big as 40, which ends up as two 20s
+
+static const int waveStartPercent[DIRECTOR_DIFFICULTIES]  = {  60, 100, 150 };   // the first wave
+static const int waveGrowthPercent[DIRECTOR_DIFFICULTIES] = {  10,  15,  20 };   // added with every wave after it
+static const int waveCapPercent[DIRECTOR_DIFFICULTIES]    = { 150, 250, 350 };   // no wave gets more than this
+static const int pieceBudgetPercent[DIRECTOR_DIFFICULTIES] = { 60, 100, 100 };   // of worldAsteroidLimit, more and a split runs out of slots
+static const int saucerStartPercent[DIRECTOR_DIFFICULTIES] = { 50, 100, 150 };   // the same for the saucers
+static const int saucerGrowthPercent[DIRECTOR_DIFFICULTIES] = { 10, 20, 30 };
+static const int saucerCapPercent[DIRECTOR_DIFFICULTIES]   = { 150, 300, 450 };
+
+static int ClampDifficulty(int difficulty)
+{
+    return difficulty < 0 ? 0 : (difficulty >= DIRECTOR_DIFFICULTIES ? DIRECTOR_DIFFICULTIES - 1 : difficulty);
+}
+
+static long long WavePercent(int wave, int start, int growth, int cap)
+{
+    long long percent = start + (long long)growth * (wave - 1);
+    return percent > cap ? cap : percent;
+}
+
+int WaveSpawnCount(int difficulty, int wave)
+{
+    difficulty = ClampDifficulty(difficulty);
+    long long chance = ActiveTunables()->asteroidSpawnChance;
+    if (chance <= 0 || wave < 1) return 0;
+
+    // what the old roll gave per wave (chance in 101 every tick), scaled
+    long long percent = WavePercent(wave, waveStartPercent[difficulty], waveGrowthPercent[difficulty], waveCapPercent[difficulty]);
+    long long count = chance * WAVE_TICKS * percent / (101 * 100);
+    return count > WAVE_MAX_SPAWNS ? WAVE_MAX_SPAWNS : (int)count;
+}
+
+// The first wave only has the part after UFO_FIRST_TICK for them
+int WaveSaucerCount(int difficulty, int wave)
+{
+    difficulty = ClampDifficulty(difficulty);
+    if (wave < 1) return 0;
+
+    long long ticks = wave == 1 ? WAVE_TICKS - UFO_FIRST_TICK : WAVE_TICKS;
+    long long percent = WavePercent(wave, saucerStartPercent[difficulty], saucerGrowthPercent[difficulty], saucerCapPercent[difficulty]);
+    return (int)(ticks * percent / ((long long)UFO_SPAWN_ODDS * 100));
+}
+
+int DirectorPieceBudget(int difficulty)
+{
+    int budget = worldAsteroidLimit * pieceBudgetPercent[ClampDifficulty(difficulty)] / 100;
+    return budget < MAX_ASTEROID_PIECES ? MAX_ASTEROID_PIECES : budget;
+}
+
+// Only a hit on something bigger than 20 splits it, into two of half the radius (checkCollisions,
+// SplitAsteroid), the parent goes away. So 21 to 40 end up as two pieces and 20 and less as one
+static int PiecesOf(float radius)
+{
+    return radius > 20.0f ? 2 * PiecesOf(radius / 2.0f) : 1;
+}
+
+// What the field can still break into and the first index a spawn can have, in one pass over the rows
+static int SurveyAsteroids(const EcsWorld *world, int *firstFree)
+{
+    int pieces = 0;
+    EcsQuery query = EcsQueryAll(world, ASTEROID_COMPONENTS);
+    while (EcsNextArchetype(&query))
+    {
+        const float *radius = EcsColumn(&query, COMPONENT_RADIUS);
+        for (int row = 0; row < query.count; row++) pieces += PiecesOf(radius[row]);
+    }
+
+    *firstFree = 0;
+    while (*firstFree < worldAsteroidLimit && EcsEntityAt(world, ASTEROID_COMPONENTS, *firstFree) != ECS_NO_ENTITY) (*firstFree)++;
+    return pieces;
+}
+
+int AsteroidPieces(const EcsWorld *world)
+{
+    int firstFree;
+    return SurveyAsteroids(world, &firstFree);
+}
+
+// Draws the wave's spawn times and sorts them, a few dozen entries at most so insertion sort it is
+static void BuildWave(WaveDirector *director, int wave, unsigned int tick)
+{
+    int asteroids = WaveSpawnCount(director->difficulty, wave);
+    int saucers = WaveSaucerCount(director->difficulty, wave);
+    if (asteroids + saucers > WAVE_MAX_SPAWNS) saucers = WAVE_MAX_SPAWNS - asteroids;
+
+    director->wave = wave;
+    director->waveStart = tick;
+    director->spawnCount = asteroids + saucers;
+    director->nextSpawn = 0;
+
+    for (int i = 0; i < director->spawnCount; i++)
+    {
+        // the kind goes in the lowest bit so sorting by the entry sorts by the time
+        bool saucer = i >= asteroids;
+        int earliest = saucer && wave == 1 ? UFO_FIRST_TICK : 0;
+        unsigned short at = (unsigned short)(SimRandomValue(earliest, WAVE_TICKS - 1) * 2 + saucer);
+        int j = i;
+        while (j > 0 && director->timeline[j - 1] > at)
+        {
+            director->timeline[j] = director->timeline[j - 1];
+            j--;
+        }
+        director->timeline[j] = at;
+    }
+}
+
+void StartWaveDirector(WaveDirector *director, int difficulty, unsigned int tick)
+{
+    director->difficulty = ClampDifficulty(difficulty);
+    director->spawned = 0;
+    director->saucers = 0;
+    director->heldBack = 0;
+    director->peakPieces = 0;
+    BuildWave(director, 1, tick);
+}
+
+void RunWaveDirector(WaveDirector *director, EcsWorld *world, bool saucers, int score, unsigned int tick)
+{
+    if (director->wave == 0) return;                           // never started, a game some tool put together by hand
+
+    if (tick - director->waveStart >= WAVE_TICKS) BuildWave(director, director->wave + 1, tick);
+
+    unsigned int into = tick - director->waveStart;
+    int pieces = -1;                                           // surveyed for the tick's first asteroid, then kept running
+    int freeSlot = 0;
+    while (director->nextSpawn < director->spawnCount && director->timeline[director->nextSpawn] / 2u <= into)
+    {
+        bool saucer = director->timeline[director->nextSpawn] & 1;
+        director->nextSpawn++;
+
+        if (saucer)
+        {
+            if (!saucers) continue;
+            if (SpawnUfo(world, score)) director->saucers++;
+            else director->heldBack++;
+            continue;
+        }
+
+        // splits never add pieces, so the count only goes up here and this is also the peak
+        if (pieces < 0) pieces = SurveyAsteroids(world, &freeSlot);
+        if (pieces + MAX_ASTEROID_PIECES > DirectorPieceBudget(director->difficulty))
+        {
+            director->heldBack++;
+            continue;
+        }
+
+        // the budget stays inside the slots, this is for a world some tool filled by hand
+        int slot = SpawnAsteroids(world, freeSlot);
+        if (slot < 0)
+        {
+            director->heldBack++;
+            continue;
+        }
+        director->spawned++;
+        freeSlot = slot + 1;
+
+        Asteroid spawned;
+        GetAsteroid(world, slot, &spawned);
+        pieces += PiecesOf(spawned.radius);
+        if (pieces > director->peakPieces) director->peakPieces = pieces;
+    }
+}
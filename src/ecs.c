@@ -0,0 +1,260 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-24 17:41:03
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-24 22:15:36
+*/
+
+/*
+ * The archetype tables behind ecs.h. An archetype is made when it is declared, or the first time
+ * an entity with its set of components is spawned, and gets its entity slots and its share of the
+ * world's data right then: its columns are laid out one after the other, each aligned to 8 bytes.
+ * Destroying an entity moves the last row of its table into the hole, so the columns never have
+ * gaps. A system that destroys while it walks a table goes through the rows from the back, the row
+ * that moves in has then been looked at already.
+ */
+
+#include "ecs.h"
+#include <string.h>
+
+static const uint16_t componentSize[COMPONENT_COUNT] = {
+    [COMPONENT_POSITION] = sizeof(Vector2),
+    [COMPONENT_VELOCITY] = sizeof(Vector2),
+    [COMPONENT_RADIUS]   = sizeof(float),
+    [COMPONENT_LIFETIME] = sizeof(int),
+    [COMPONENT_UFO]      = 16,                 // sizeof(UfoBrain), checked in ufo.c
+    [COMPONENT_SPIN]     = 8,                  // sizeof(AsteroidSpin), checked in asteroid.c
+    [COMPONENT_OUTLINE]  = 72,                 // sizeof(AsteroidOutline), checked in asteroid.c
+    [COMPONENT_COLOR]    = sizeof(Color),
+    [COMPONENT_SHIP]     = 20,                 // sizeof(ShipState), checked in player.c
+    [COMPONENT_HOSTILE]  = 0,
+};
+
+void InitEcsWorld(EcsWorld *world)
+{
+    // all of it, padding too, snapshots of two worlds in the same state have to be the same bytes
+    memset(world, 0, sizeof(*world));
+}
+
+static int LookUpArchetype(const EcsWorld *world, ComponentMask mask)
+{
+    for (int a = 0; a < world->archetypeCount; a++)
+    {
+        if (world->archetypes[a].mask == mask) return a;
+    }
+    return -1;
+}
+
+int EcsDeclareArchetype(EcsWorld *world, ComponentMask mask, int capacity)
+{
+    int found = LookUpArchetype(world, mask);
+    if (found >= 0) return found;
+
+    if (world->archetypeCount == ECS_MAX_ARCHETYPES || capacity < 1 || world->slotsUsed + capacity > ECS_MAX_ENTITIES) return -1;
+
+    // every column rounded up to 8 bytes, all of them or nothing
+    int bytes = 0;
+    for (int c = 0; c < COMPONENT_COUNT; c++)
+    {
+        if (mask & COMPONENT_BIT(c)) bytes += (capacity * componentSize[c] + 7) & ~7;
+    }
+    if (world->bytesUsed + bytes > ECS_DATA_BYTES) return -1;
+
+    EcsArchetype *archetype = &world->archetypes[world->archetypeCount];
+    archetype->mask = mask;
+    archetype->capacity = capacity;
+    archetype->firstSlot = world->slotsUsed;
+
+    for (int c = 0; c < COMPONENT_COUNT; c++)
+    {
+        if (!(mask & COMPONENT_BIT(c))) continue;
+        archetype->columnOffset[c] = (uint32_t)world->bytesUsed;
+        world->bytesUsed += (capacity * componentSize[c] + 7) & ~7;
+    }
+
+    world->slotsUsed += capacity;
+    return world->archetypeCount++;
+}
+
+// An archetype nobody declared gets the default size, or whatever is left of the slots
+static int FindArchetype(EcsWorld *world, ComponentMask mask)
+{
+    int found = LookUpArchetype(world, mask);
+    if (found >= 0) return found;
+
+    int capacity = ECS_MAX_ENTITIES - world->slotsUsed;
+    return EcsDeclareArchetype(world, mask, capacity < ECS_DEFAULT_ROWS ? capacity : ECS_DEFAULT_ROWS);
+}
+
+static inline unsigned char *Cell(EcsWorld *world, const EcsArchetype *archetype, ComponentId component, int row)
+{
+    return world->data + archetype->columnOffset[component] + row * componentSize[component];
+}
+
+// The slot of a live id, -1 for a stale or empty one
+static int SlotOf(const EcsWorld *world, EntityId entity)
+{
+    int slot = (int)(entity & 0xFFFF) - 1;
+    if (slot < 0 || slot >= ECS_MAX_ENTITIES) return -1;
+
+    const EcsRecord *record = &world->records[slot];
+    return record->alive && record->generation == (uint16_t)(entity >> 16) ? slot : -1;
+}
+
+static EntityId IdOf(const EcsWorld *world, int slot)
+{
+    return ((EntityId)world->records[slot].generation << 16) | (EntityId)(slot + 1);
+}
+
+// A free slot of the archetype gets the next row
+static EntityId Occupy(EcsWorld *world, int a, int slot)
+{
+    EcsArchetype *archetype = &world->archetypes[a];
+    int row = archetype->count++;
+    for (int c = 0; c < COMPONENT_COUNT; c++)
+    {
+        if (archetype->mask & COMPONENT_BIT(c)) memset(Cell(world, archetype, (ComponentId)c, row), 0, componentSize[c]);
+    }
+    world->rowSlot[archetype->firstSlot + row] = (uint16_t)slot;
+
+    EcsRecord *record = &world->records[slot];
+    record->alive = 1;
+    record->archetype = (uint8_t)a;
+    record->row = (uint16_t)row;
+
+    return IdOf(world, slot);
+}
+
+EntityId EcsSpawn(EcsWorld *world, ComponentMask mask)
+{
+    int a = FindArchetype(world, mask);
+    if (a < 0) return ECS_NO_ENTITY;
+
+    EcsArchetype *archetype = &world->archetypes[a];
+    if (archetype->count == archetype->capacity) return ECS_NO_ENTITY;
+
+    // the lowest free index, so the ids only depend on the order things happened in
+    int slot = archetype->firstSlot;
+    while (world->records[slot].alive) slot++;
+    return Occupy(world, a, slot);
+}
+
+EntityId EcsSpawnAt(EcsWorld *world, ComponentMask mask, int index)
+{
+    int a = FindArchetype(world, mask);
+    if (a < 0 || index < 0 || index >= world->archetypes[a].capacity) return ECS_NO_ENTITY;
+
+    int slot = world->archetypes[a].firstSlot + index;
+    return world->records[slot].alive ? ECS_NO_ENTITY : Occupy(world, a, slot);
+}
+
+void EcsDestroy(EcsWorld *world, EntityId entity)
+{
+    int slot = SlotOf(world, entity);
+    if (slot < 0) return;
+
+    EcsRecord *record = &world->records[slot];
+    EcsArchetype *archetype = &world->archetypes[record->archetype];
+    uint16_t *rowSlot = &world->rowSlot[archetype->firstSlot];
+    int row = record->row;
+    int last = --archetype->count;
+
+    // the last row fills the hole, the columns stay packed
+    if (row != last)
+    {
+        for (int c = 0; c < COMPONENT_COUNT; c++)
+        {
+            if (archetype->mask & COMPONENT_BIT(c)) memcpy(Cell(world, archetype, (ComponentId)c, row), Cell(world, archetype, (ComponentId)c, last), componentSize[c]);
+        }
+        rowSlot[row] = rowSlot[last];
+        world->records[rowSlot[row]].row = (uint16_t)row;
+    }
+
+    // cleared, so a removed row leaves no trace in a snapshot
+    for (int c = 0; c < COMPONENT_COUNT; c++)
+    {
+        if (archetype->mask & COMPONENT_BIT(c)) memset(Cell(world, archetype, (ComponentId)c, last), 0, componentSize[c]);
+    }
+    rowSlot[last] = 0;
+
+    record->alive = 0;
+    record->archetype = 0;
+    record->row = 0;
+    record->generation++;
+}
+
+bool EcsAlive(const EcsWorld *world, EntityId entity)
+{
+    return SlotOf(world, entity) >= 0;
+}
+
+void *EcsGet(const EcsWorld *world, EntityId entity, ComponentId component)
+{
+    int slot = SlotOf(world, entity);
+    if (slot < 0) return NULL;
+
+    const EcsArchetype *archetype = &world->archetypes[world->records[slot].archetype];
+    if (!(archetype->mask & COMPONENT_BIT(component))) return NULL;
+    return Cell((EcsWorld *)world, archetype, component, world->records[slot].row);
+}
+
+EntityId EcsEntityAt(const EcsWorld *world, ComponentMask mask, int index)
+{
+    int a = LookUpArchetype(world, mask);
+    if (a < 0 || index < 0 || index >= world->archetypes[a].capacity) return ECS_NO_ENTITY;
+
+    int slot = world->archetypes[a].firstSlot + index;
+    return world->records[slot].alive ? IdOf(world, slot) : ECS_NO_ENTITY;
+}
+
+int EcsCount(const EcsWorld *world, ComponentMask mask)
+{
+    int count = 0;
+    for (int a = 0; a < world->archetypeCount; a++)
+    {
+        if ((world->archetypes[a].mask & mask) == mask) count += world->archetypes[a].count;
+    }
+    return count;
+}
+
+int EcsCapacity(const EcsWorld *world, ComponentMask mask)
+{
+    int a = LookUpArchetype(world, mask);
+    return a < 0 ? 0 : world->archetypes[a].capacity;
+}
+
+EcsQuery EcsQueryAll(const EcsWorld *world, ComponentMask mask)
+{
+    return (EcsQuery){ .world = (EcsWorld *)world, .mask = mask };
+}
+
+// On to the next archetype that has all the components and at least one row
+bool EcsNextArchetype(EcsQuery *query)
+{
+    while (query->next < query->world->archetypeCount)
+    {
+        EcsArchetype *archetype = &query->world->archetypes[query->next++];
+        if ((archetype->mask & query->mask) == query->mask && archetype->count > 0)
+        {
+            query->archetype = archetype;
+            query->count = archetype->count;
+            return true;
+        }
+    }
+    return false;
+}
+
+void *EcsColumn(const EcsQuery *query, ComponentId component)
+{
+    return query->world->data + query->archetype->columnOffset[component];
+}
+
+EntityId EcsRowEntity(const EcsQuery *query, int row)
+{
+    return IdOf(query->world, query->world->rowSlot[query->archetype->firstSlot + row]);
+}
+
+int EcsRowIndex(const EcsQuery *query, int row)
+{
+    return query->world->rowSlot[query->archetype->firstSlot + row] - query->archetype->firstSlot;
+}
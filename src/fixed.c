@@ -0,0 +1,169 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-21 14:06:52
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-21 18:37:20
+*/
+
+/*
+ * Integer trig and square roots for the fixed-point simulation, see fixed.h. The tables are
+ * written out as numbers rather than filled in with sin() at startup, a table computed by the
+ * libm of the machine it runs on would bring back exactly the differences this is here to avoid.
+ */
+
+#include "fixed.h"
+
+// 65536 * sin(i / 256 * pi / 2), a quarter of a turn, the other three quarters are mirrors of it
+static const int32_t quarterSine[FIXED_SINE_STEPS + 1] = {
+        0,   402,   804,  1206,  1608,  2010,  2412,  2814,  3216,  3617,
+     4019,  4420,  4821,  5222,  5623,  6023,  6424,  6824,  7224,  7623,
+     8022,  8421,  8820,  9218,  9616, 10014, 10411, 10808, 11204, 11600,
+    11996, 12391, 12785, 13180, 13573, 13966, 14359, 14751, 15143, 15534,
+    15924, 16314, 16703, 17091, 17479, 17867, 18253, 18639, 19024, 19409,
+    19792, 20175, 20557, 20939, 21320, 21699, 22078, 22457, 22834, 23210,
+    23586, 23961, 24335, 24708, 25080, 25451, 25821, 26190, 26558, 26925,
+    27291, 27656, 28020, 28383, 28745, 29106, 29466, 29824, 30182, 30538,
+    30893, 31248, 31600, 31952, 32303, 32652, 33000, 33347, 33692, 34037,
+    34380, 34721, 35062, 35401, 35738, 36075, 36410, 36744, 37076, 37407,
+    37736, 38064, 38391, 38716, 39040, 39362, 39683, 40002, 40320, 40636,
+    40951, 41264, 41576, 41886, 42194, 42501, 42806, 43110, 43412, 43713,
+    44011, 44308, 44604, 44898, 45190, 45480, 45769, 46056, 46341, 46624,
+    46906, 47186, 47464, 47741, 48015, 48288, 48559, 48828, 49095, 49361,
+    49624, 49886, 50146, 50404, 50660, 50914, 51166, 51417, 51665, 51911,
+    52156, 52398, 52639, 52878, 53114, 53349, 53581, 53812, 54040, 54267,
+    54491, 54714, 54934, 55152, 55368, 55582, 55794, 56004, 56212, 56418,
+    56621, 56823, 57022, 57219, 57414, 57607, 57798, 57986, 58172, 58356,
+    58538, 58718, 58896, 59071, 59244, 59415, 59583, 59750, 59914, 60075,
+    60235, 60392, 60547, 60700, 60851, 60999, 61145, 61288, 61429, 61568,
+    61705, 61839, 61971, 62101, 62228, 62353, 62476, 62596, 62714, 62830,
+    62943, 63054, 63162, 63268, 63372, 63473, 63572, 63668, 63763, 63854,
+    63944, 64031, 64115, 64197, 64277, 64354, 64429, 64501, 64571, 64639,
+    64704, 64766, 64827, 64884, 64940, 64993, 65043, 65091, 65137, 65180,
+    65220, 65259, 65294, 65328, 65358, 65387, 65413, 65436, 65457, 65476,
+    65492, 65505, 65516, 65525, 65531, 65535, 65536,
+};
+
+// atan(2^-i) in 1/2^32 of a turn, the steps CORDIC turns the vector by
+#define CORDIC_STEPS 24
+static const uint32_t cordicAngles[CORDIC_STEPS] = {
+    536870912u, 316933406u, 167458907u,  85004756u,  42667331u,  21354465u,
+     10679838u,   5340245u,   2670163u,   1335087u,    667544u,    333772u,
+       166886u,     83443u,     41722u,     20861u,     10430u,      5215u,
+         2608u,      1304u,       652u,       326u,       163u,        81u,
+};
+
+Fixed FixedSin(BinaryAngle angle)
+{
+    unsigned int quadrant = angle >> 14;
+    unsigned int within = angle & (ANGLE_QUARTER_TURN - 1);
+
+    // the second and fourth quarters run the table backwards
+    if (quadrant & 1) within = ANGLE_QUARTER_TURN - within;
+
+    // 64 angle steps between two table entries, interpolated with 6 bits of fraction
+    unsigned int index = within >> 6;
+    int fraction = (int)(within & 63);
+    Fixed low = quarterSine[index];
+    Fixed high = index < FIXED_SINE_STEPS ? quarterSine[index + 1] : low;
+    Fixed value = low + (((high - low) * fraction + 32) >> 6);
+
+    return (quadrant & 2) ? -value : value;
+}
+
+Fixed FixedCos(BinaryAngle angle)
+{
+    return FixedSin((BinaryAngle)(angle + ANGLE_QUARTER_TURN));
+}
+
+/*
+ * CORDIC in vectoring mode: the vector is turned towards the +x axis by smaller and smaller
+ * known angles, adding them up gives its own angle. Only shifts and adds, done in 64 bits so
+ * the growth of the vector (about 1.65 times) can't overflow.
+ */
+BinaryAngle FixedAtan2(Fixed y, Fixed x)
+{
+    int64_t vx = x, vy = y;
+    uint32_t angle = 0;
+
+    if (vx == 0 && vy == 0) return 0;
+
+    // the steps only add up to about 100 degrees, so start from the right half
+    if (vx < 0)
+    {
+        vx = -vx;
+        vy = -vy;
+        angle = 0x80000000u;
+    }
+
+    for (int i = 0; i < CORDIC_STEPS; i++)
+    {
+        int64_t nx, ny;
+        if (vy > 0)
+        {
+            nx = vx + (vy >> i);
+            ny = vy - (vx >> i);
+            angle += cordicAngles[i];
+        }
+        else
+        {
+            nx = vx - (vy >> i);
+            ny = vy + (vx >> i);
+            angle -= cordicAngles[i];
+        }
+        vx = nx;
+        vy = ny;
+    }
+
+    // rounded from 32 to 16 bits
+    return (BinaryAngle)((angle + 0x8000u) >> 16);
+}
+
+// One result bit per step, from the top
+uint32_t IntegerSqrt64(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit = (uint64_t)1 << 62;
+
+    while (bit > value) bit >>= 2;
+
+    while (bit != 0)
+    {
+        if (value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+// The squares are Q32.32, so their square root is already Q16.16
+Fixed FixedLength(Fixed x, Fixed y)
+{
+    uint64_t squared = (uint64_t)((int64_t)x * x) + (uint64_t)((int64_t)y * y);
+    return (Fixed)IntegerSqrt64(squared);
+}
+
+// degrees * 65536 / 360 with degrees in Q16.16 is just a division by 360
+BinaryAngle FixedDegreesToAngle(Fixed degrees)
+{
+    return (BinaryAngle)(degrees / 360);
+}
+
+// radians / 2pi * 65536, the multiplier is 2^32 / 2pi
+BinaryAngle FixedRadiansToAngle(Fixed radians)
+{
+    return (BinaryAngle)(((int64_t)radians * 683565276) >> 32);
+}
+
+Fixed FixedWrapCoordinate(Fixed value, Fixed size)
+{
+    if (value > size) return 0;
+    if (value < 0) return size;
+    return value;
+}
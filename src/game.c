@@ -13,6 +13,7 @@
 #include <raylib.h>
 #include <raymath.h>
 #include <stdlib.h> // Add this for NULL
+#include <string.h>
 #include "asteroids.h"
 #include "bullet.h"
 #include "menu.h"
@@ -22,6 +23,18 @@
 #include "utils.h"
 #include "game.h"
 #include "sound.h"
+#include "bot.h"
+#include "narrowphase.h"
+#include "rollback.h"
+#include "replay.h"
+#include "world.h"
+#include "ufo.h"
+#include "input.h"
+#include "pacing.h"
+#include "canvas.h"
+#include "director.h"
+#include "telemetry.h"
+#include "savegame.h"
 
 // External globals for screen dimensions
 extern int screenWidth;
@@ -42,29 +55,252 @@ void initGame(Game *game)
     game->settings.musicEnabled = true;
     game->settings.showFPS = false;
     game->settings.difficulty = 1;
+    game->settings.renderScale = 1.0f;
+    game->autopilot = false;
 
+    // Seed the simulation from raylib's generator, which is seeded from the clock
+    game->rngState = (unsigned int)GetRandomValue(1, 0x7FFFFFFF);
+    game->tick = 0;
+    game->tunables = DefaultTunables();
+    BindSimulationRandom(&game->rngState);
+    BindTunables(&game->tunables);
 
-    // We initialize the player now
-    InitPlayer(&game->player);
 
-    InitAsteroid(game->asteroids);          // initialize the asteroids
-
-    InitBullets(game->bullets);             // initialize the bullets
+    // We initialize the ships, asteroids and bullets now, all of them entities
+    InitGameWorld(&game->entities);
 
     InitStars(game->stars);                 // Initialize the stars, added new not present in v1.0
 
     InitResolutions(game);                  // Initialize resolutions AFTER other components
 
+    // The grids get their real size from the current world on the first refresh
+    InitSpatialGrid(&game->asteroidGrid, worldWidth, worldHeight, SPATIAL_CELL_SIZE, MAX_ASTEROIDS);
+    InitSpatialGrid(&game->chunkGrid, worldWidth, worldHeight, WORLD_CHUNK_SIZE, MAX_ASTEROIDS);
+
+    // Rewind history, allocated once here and reused for every game
+    InitRewindBuffer(&game->rewind, REWIND_SECONDS);
+    game->rewinding = false;
+
     // Initialize the sound manager (if it exists)
     if (game->soundManager != NULL) {
         ToggleSoundEnabled(game->soundManager, game->settings.soundEnabled);
         ToggleMusicEnabled(game->soundManager, game->settings.musicEnabled);
     }
 
-    for (int i = 0; i < 5; i++)
+    int slot = 0;
+    for (int i = 0; i < 5 * worldAsteroidLimit / SCREEN_ASTEROIDS && slot >= 0; i++)
+    {
+        slot = SpawnAsteroids(&game->entities, slot);     // nothing below the last one is free
+    }
+
+    RefreshAsteroidGrid(game);
+}
+
+/*
+ * Sets up only what the simulation needs, no window, resolutions, stars or sound.
+ * Used by bots and tools that run a lot of games without a screen. Two games set
+ * up with the same seed and fed the same inputs play out exactly the same.
+ */
+void InitHeadlessGame(Game *game, unsigned int seed)
+{
+    InitTunedHeadlessGame(game, seed, NULL);
+}
+
+// The same with other tunables than the defaults (NULL), they are in place before the first asteroids launch
+void InitTunedHeadlessGame(Game *game, unsigned int seed, const Tunables *tunables)
+{
+    memset(game, 0, sizeof(*game));
+
+    game->state = GAMEPLAY;
+    game->settings.difficulty = 1;
+    game->soundManager = NULL;
+    game->rngState = seed ? seed : 1;
+    game->tunables = tunables != NULL ? *tunables : DefaultTunables();
+
+    InitSpatialGrid(&game->asteroidGrid, worldWidth, worldHeight, SPATIAL_CELL_SIZE, MAX_ASTEROIDS);
+    InitSpatialGrid(&game->chunkGrid, worldWidth, worldHeight, WORLD_CHUNK_SIZE, MAX_ASTEROIDS);
+    ResetGame(game);
+}
+
+// Gameplay keys come through the latch when main() set one up, raylib directly otherwise (see input.h)
+static bool GameplayKeyPressed(const Game *game, int key)
+{
+    return game->inputLatch != NULL ? LatchedKeyPressed(game->inputLatch, key) : IsKeyPressed(key);
+}
+
+static bool GameplayKeyDown(const Game *game, int key)
+{
+    return game->inputLatch != NULL ? LatchedKeyDown(game->inputLatch, key) : IsKeyDown(key);
+}
+
+static PlayerInput ReadGameplayInput(const Game *game, const Player *player)
+{
+    return game->inputLatch != NULL ? ReadLatchedInput(game->inputLatch, player) : ReadPlayerInput(player);
+}
+
+static void ShowNotice(Game *game, const char *notice)
+{
+    game->notice = notice;
+    game->noticeTicks = SAVE_NOTICE_TICKS;
+}
+
+// F9, the quick save replaces the game as it is, whatever state it was in
+static bool QuickLoad(Game *game)
+{
+    // an F5 just before has to be on the disk first, or this would load the one before it
+    WaitForSaves(game->saveWriter);
+    bool loaded = QuickLoadGame(game, game->saveWriter->slots[SAVE_QUICK].path);
+    ShowNotice(game, loaded ? "GAME LOADED (F9)" : "NO QUICK SAVE TO LOAD");
+    return loaded;
+}
+
+// What PlayTickSounds compares against, taken right before the tick
+void NoteTickSounds(const Game *game, TickSounds *before)
+{
+    Player player = GetPlayer(&game->entities, 0);
+    before->wasThrusting = player.isThrusting;
+    before->shootCooldown = player.shootCooldown;
+    before->state = game->state;
+    before->score = game->score;
+    before->ufoShots = CountUfoShots(&game->entities);
+}
+
+// Only from the state before and after the tick, a replay of the game sounds the same as the game did
+void PlayTickSounds(Game *game, const TickSounds *before)
+{
+    if (game->soundManager == NULL || !game->settings.soundEnabled) return;
+
+    Player player = GetPlayer(&game->entities, 0);
+
+    // Play thrust sound if player just started thrusting
+    if (!before->wasThrusting && player.isThrusting) {
+        PlayGameSound(game->soundManager, SOUND_THRUST);
+    }
+
+    // Play shooting sound
+    if (before->shootCooldown == 0 && player.shootCooldown > 0) {
+        PlayGameSound(game->soundManager, SOUND_SHOOT);
+    }
+
+    // A saucer fired
+    if (CountUfoShots(&game->entities) > before->ufoShots) {
+        PlayGameSound(game->soundManager, SOUND_UFO_SHOOT);
+    }
+
+    // If score changed, an asteroid was hit
+    if (game->score > before->score) {
+        // Small or large explosion by the tick, not raylib's random values, so the same game mixes the same audio
+        if ((game->tick & 1) == 0) {
+            PlayGameSound(game->soundManager, SOUND_EXPLOSION_SMALL);
+        } else {
+            PlayGameSound(game->soundManager, SOUND_EXPLOSION_BIG);
+        }
+    }
+
+    // If state changed to GAME_OVER, player collided with asteroid
+    if (before->state != GAME_OVER && game->state == GAME_OVER) {
+        PlayGameSound(game->soundManager, SOUND_EXPLOSION_BIG);
+        PlayGameSound(game->soundManager, SOUND_GAME_OVER);
+    }
+}
+
+/*
+ * One tick of gameplay. Everything the player does comes in through the input struct
+ * so this runs the same for the keyboard, a bot or a replay, with or without a window.
+ */
+void StepGameplay(Game *game, const PlayerInput *input)
+{
+    BindSimulationRandom(&game->rngState);
+    BindTunables(&game->tunables);
+
+    UpdatePlayer(&game->entities, 0, input);
+    Vector2 ship = GetPlayer(&game->entities, 0).position;
+    UpdateWorldAsteroids(&game->entities, &ship, 1, game->tick);
+    RunWaveDirector(&game->director, &game->entities, true, game->score, game->tick);
+    UpdateBullets(&game->entities);
+
+    checkCollisions(&game->entities, &game->entities, 0, &game->score, &game->state);
+
+    // the saucers and their shots, shot down by the same bullets
+    if (UpdateUfos(&game->entities, 0, &game->score)) {
+        if (game->state != GAME_OVER) CountDeath(TELEMETRY_DEATH_SAUCER);
+        game->state = GAME_OVER;
+    }
+
+    // keep the spatial grid in step with the asteroids for anything that queries it
+    RefreshAsteroidGrid(game);
+
+    game->tick++;
+}
+
+/*
+ * Starts a game with two ships in the field. Both sides of a network game call this with the
+ * same seed, from then on they only need each other's inputs to stay in step.
+ */
+void StartVersusGame(Game *game, unsigned int seed)
+{
+    game->versus = true;
+    game->rngState = seed ? seed : 1;
+    ResetGame(game);
+    game->state = GAMEPLAY;
+}
+
+// Any bullet from the other ship that is inside this ship, the first one by index is used up
+static bool ShipShotDown(EcsWorld *world, int ship)
+{
+    Player player = GetPlayer(world, ship);
+    Vector2 triangle[3];
+    GetShipTriangle(&player, triangle);
+
+    BulletList bullets;
+    ListShipBullets(world, 1 - ship, &bullets);
+    for (int i = 0; i < bullets.count; i++)
     {
-        SpawnAsteroids(game->asteroids);
+        if (PointInShip(triangle, bullets.position[i]))
+        {
+            EcsDestroy(world, bullets.entity[i]);
+            return true;
+        }
     }
+    return false;
+}
+
+// One tick of a versus game, inputs[0] flies ship 0 and inputs[1] the second ship
+void StepVersusGameplay(Game *game, const PlayerInput inputs[2])
+{
+    // once a ship is down the field freezes, ticks still count so both sides stay in step
+    if (game->state != GAMEPLAY)
+    {
+        game->tick++;
+        return;
+    }
+
+    BindSimulationRandom(&game->rngState);
+    BindTunables(&game->tunables);
+
+    UpdatePlayer(&game->entities, 0, &inputs[0]);
+    UpdatePlayer(&game->entities, 1, &inputs[1]);
+    Vector2 ships[2] = { GetPlayer(&game->entities, 0).position, GetPlayer(&game->entities, 1).position };
+    UpdateWorldAsteroids(&game->entities, ships, 2, game->tick);
+    RunWaveDirector(&game->director, &game->entities, false, 0, game->tick);     // no saucers in versus games
+    UpdateBullets(&game->entities);
+
+    // the first ship's bullets always go first, both sides have to resolve hits in the same order
+    GameState firstState = GAMEPLAY, secondState = GAMEPLAY;
+    checkCollisions(&game->entities, &game->entities, 0, &game->score, &firstState);
+    checkCollisions(&game->entities, &game->entities, 1, &game->secondScore, &secondState);
+
+    if (ShipShotDown(&game->entities, 0)) firstState = GAME_OVER;
+    if (ShipShotDown(&game->entities, 1)) secondState = GAME_OVER;
+
+    if (firstState == GAME_OVER || secondState == GAME_OVER)
+    {
+        game->state = GAME_OVER;
+        game->versusLoser = firstState == GAME_OVER ? (secondState == GAME_OVER ? 2 : 0) : 1;
+    }
+
+    RefreshAsteroidGrid(game);
+    game->tick++;
 }
 
 void UpdateGame(Game *game)
@@ -82,8 +318,31 @@ void UpdateGame(Game *game)
         return;
     }
 
+    if (game->noticeTicks > 0) game->noticeTicks--;
+
+    // A network game keeps running whatever happens on this side, the other player can't be paused.
+    // It also runs on the game over screen, a late input from the other side can still undo it
+    if (game->netSession != NULL && (game->state == GAMEPLAY || game->state == GAME_OVER))
+    {
+        Player ship = RollbackLocalPlayer(game->netSession);
+        PlayerInput input = ReadGameplayInput(game, &ship);
+        AdvanceRollbackSession(game->netSession, &input, GetTime());
+        UpdateStars(game->stars);
+
+        if (GameplayKeyPressed(game, KEY_ESCAPE))
+        {
+            // leaving ends the match, main() closes the connection on exit
+            game->netSession = NULL;
+            game->versus = false;
+            ResetGame(game);
+            game->state = MAIN_MENU;
+            game->selectedOption = 0;
+        }
+        return;
+    }
+
     // Handle pausing during gameplay - ONLY pause, don't exit
-    if (game->state == GAMEPLAY && IsKeyPressed(KEY_P))
+    if (game->state == GAMEPLAY && GameplayKeyPressed(game, KEY_P))
     {
         game->state = PAUSED;
         game->selectedOption = 0;   // Default to Resume
@@ -97,7 +356,7 @@ void UpdateGame(Game *game)
     }
     
     // Handle ESC during gameplay to return to main menu
-    if (game->state == GAMEPLAY && IsKeyPressed(KEY_ESCAPE))
+    if (game->state == GAMEPLAY && GameplayKeyPressed(game, KEY_ESCAPE))
     {
         game->state = MAIN_MENU;
         game->selectedOption = 0;   // Default to first option
@@ -134,63 +393,85 @@ void UpdateGame(Game *game)
 
         case GAMEPLAY:
             {  // Add braces to create a new scope for local variables
-                // Store previous thrusting state to detect changes
-                bool wasThrustingBefore = game->player.isThrusting;
-                int previousShootCooldown = game->player.shootCooldown;
-                
-                UpdatePlayer(&game->player, game->bullets); 
-                
-                // Play thrust sound if player just started thrusting
-                if (!wasThrustingBefore && game->player.isThrusting) {
-                    if (game->soundManager != NULL && game->settings.soundEnabled) {
-                        PlayGameSound(game->soundManager, SOUND_THRUST);
-                    }
+                // F2 hands the ship over to the built-in bot and back
+                if (GameplayKeyPressed(game, KEY_F2)) {
+                    game->autopilot = !game->autopilot;
                 }
-                
-                // Play shooting sound
-                if (previousShootCooldown == 0 && game->player.shootCooldown > 0) {
-                    if (game->soundManager != NULL && game->settings.soundEnabled) {
-                        PlayGameSound(game->soundManager, SOUND_SHOOT);
+
+                // F5 saves the game as it is before this tick, F9 goes back to the last save
+                if (game->saveWriter != NULL && !game->versus) {
+                    if (GameplayKeyPressed(game, KEY_F5)) {
+                        QueueSave(game->saveWriter, game, SAVE_QUICK);
+                        ShowNotice(game, "GAME SAVED (F5)");
+                    }
+                    if (GameplayKeyPressed(game, KEY_F9) && QuickLoad(game)) {
+                        UpdateStars(game->stars);
+                        break;
                     }
                 }
-                
-                UpdateAsteroid(game->asteroids);
-                UpdateBullets(game->bullets);
-                UpdateStars(game->stars);
 
-                // We check the collisions - added sound support for collisions
-                GameState previousState = game->state;
-                int previousScore = game->score;
-                
-                checkCollisions(&game->player, game->asteroids, game->bullets, &game->score, &game->state);
-                
-                // If score changed, an asteroid was hit
-                if (game->score > previousScore) {
-                    if (game->soundManager != NULL && game->settings.soundEnabled) {
-                        // Choose between small and large explosion sound randomly
-                        if (GetRandomValue(0, 1) == 0) {
-                            PlayGameSound(game->soundManager, SOUND_EXPLOSION_SMALL);
-                        } else {
-                            PlayGameSound(game->soundManager, SOUND_EXPLOSION_BIG);
-                        }
-                    }
+                // R plays the last few seconds backwards for as long as it is held, letting go
+                // carries on from there
+                game->rewinding = GameplayKeyDown(game, KEY_R) && StepBackRewind(&game->rewind, game);
+                if (game->rewinding) {
+                    UpdateStars(game->stars);
+                    break;
                 }
-                
-                // If state changed to GAME_OVER, player collided with asteroid
-                if (previousState != GAME_OVER && game->state == GAME_OVER) {
-                    if (game->soundManager != NULL && game->settings.soundEnabled) {
-                        PlayGameSound(game->soundManager, SOUND_EXPLOSION_BIG);
-                        PlayGameSound(game->soundManager, SOUND_GAME_OVER);
-                    }
+
+                Player ship = GetPlayer(&game->entities, 0);
+                PlayerInput input = game->autopilot ? RunAimEvadeBot(game) : ReadGameplayInput(game, &ship);
+
+                // What the sounds of this tick are worked out from
+                TickSounds sounds;
+                NoteTickSounds(game, &sounds);
+
+                // the history starts with the state before the first tick
+                if (!game->rewind.hasHead) {
+                    PushRewindState(&game->rewind, game);
                 }
+
+                if (game->replayWriter != NULL) {
+                    RecordReplayTick(game->replayWriter, game, &input);
+                }
+
+                // only live ticks count, the simulation's events go to whatever is bound
+                BindTelemetry(game->telemetry);
+                StepGameplay(game, &input);
+                BindTelemetry(NULL);
+                if (game->telemetry != NULL) {
+                    TelemetryTick(game->telemetry, game);
+                }
+                PushRewindState(&game->rewind, game);
+                UpdateStars(game->stars);
+
+                PlayTickSounds(game, &sounds);
             }
             break;
 
         case GAME_OVER:
-            // Check for the high score
-            if (game->score > game->highScore)
+            // Check for the high score, a versus game's score is one of two ships and maybe the other side's
+            if (!game->versus && game->score > game->highScore)
             {
                 game->highScore = game->score;
+
+                // straight into the profile, a crash later on shouldn't cost it
+                if (game->saveWriter != NULL) {
+                    QueueSave(game->saveWriter, game, SAVE_PROFILE);
+                }
+            }
+
+            // The last quick save undoes the game over
+            if (game->saveWriter != NULL && !game->versus && GameplayKeyPressed(game, KEY_F9) && QuickLoad(game))
+            {
+                break;
+            }
+
+            // Rewinding from here takes us back to just before the ship was hit
+            if (GameplayKeyDown(game, KEY_R) && StepBackRewind(&game->rewind, game))
+            {
+                game->rewinding = true;
+                UpdateStars(game->stars);
+                break;
             }
 
             // Now here we handle the restart or return to menu
@@ -228,9 +509,42 @@ static void DrawTextCenteredX(const char *text, int y, int fontSize, Color color
     DrawText(text, screenWidth/2 - textWidth/2, y, fontSize, color);
 }
 
+/*
+ * The playfield through the camera, which follows this side's ship. The asteroids come out of
+ * the chunks in view, so nothing in the rest of the world costs anything to draw.
+ */
+static void DrawWorld(Game *game)
+{
+    bool secondIsLocal = game->netSession != NULL && RollbackLocalSlot(game->netSession) == 1;
+    FocusWorldView(GetPlayer(&game->entities, secondIsLocal ? 1 : 0).position);
+
+    int visible[MAX_ASTEROIDS];
+    int count = GatherVisibleAsteroids(&game->chunkGrid, &game->entities, visible);
+
+    // whatever is in the chunks out of view is culled without being looked at
+    drawStats.asteroidsCulled += EcsCount(&game->entities, ASTEROID_COMPONENTS) - count;
+
+    BeginMode2D(WorldViewCamera());
+        DrawAsteroids(&game->entities, visible, count);
+        DrawBullets(&game->entities);      // both ships', the second only has any in a versus game
+        DrawUfos(&game->entities);
+        DrawPlayer(GetPlayer(&game->entities, 0));
+
+        if (game->versus) {
+            DrawPlayerColored(GetPlayer(&game->entities, 1), ORANGE);
+        }
+    EndMode2D();
+
+    // back to plain canvas coordinates for the HUD
+    BeginCanvasMode();
+}
+
 // Now we need to actually draw the game
 void DrawGame(Game *game) 
 {
+    // the counters are per frame
+    memset(&drawStats, 0, sizeof(drawStats));
+
     // Always draw stars first for all states
     DrawStars(game->stars);
 
@@ -249,55 +563,263 @@ void DrawGame(Game *game)
             break;
 
         case GAMEPLAY:
+            if (game->netSession != NULL && !game->netSession->connected) {
+                DrawTextCenteredX("Waiting for the other player...", screenHeight / 2 - 10, 20, WHITE);
+                DrawTextCenteredX("Press ESC to return to menu", screenHeight / 2 + 20, 20, GRAY);
+                break;
+            }
+
             // Original gameplay drawing code
-            DrawAsteroids(game->asteroids);
-            DrawBullets(game->bullets);
-            DrawPlayer(game->player);
+            DrawWorld(game);
+
+            if (game->versus) {
+                DrawText(TextFormat("P2: %d", game->secondScore), screenWidth - 150, 10, 20, ORANGE);
+            } else {
+                DrawText(TextFormat("WAVE %d", game->director.wave), screenWidth - 110, 10, 20, WHITE);
+            }
 
             // For drawing the score on the screen
             DrawText(TextFormat("SCORE: %d", game->score), 10, 10, 20, WHITE);
+            if (game->autopilot) {
+                DrawText("AUTOPILOT (F2)", 10, 35, 15, YELLOW);
+            }
+            if (game->rewinding) {
+                DrawText(TextFormat("<< REWIND %.1fs", RewindSecondsAvailable(&game->rewind)), 10, 55, 15, SKYBLUE);
+            }
             break;
 
         case PAUSED:
             // We need to make sure we Draw the game in the background
-            DrawAsteroids(game->asteroids);
-            DrawBullets(game->bullets);
-            DrawPlayer(game->player);
+            DrawWorld(game);
 
             // Then draw the pause menu overlay
             DrawPauseMenu(game);
             break;
 
         case GAME_OVER:
+            if (game->versus) {
+                // who won, seen from this side of the match
+                int localSlot = game->netSession != NULL ? RollbackLocalSlot(game->netSession) : 0;
+                const char *result = game->versusLoser == 2 ? "DRAW" : game->versusLoser == localSlot ? "YOU LOSE" : "YOU WIN";
+
+                DrawTextCenteredX(result, screenHeight / 2 - 40, 40, WHITE);
+                DrawTextCenteredX(TextFormat("P1: %d   P2: %d", game->score, game->secondScore), screenHeight / 2, 20, WHITE);
+                DrawTextCenteredX("Press ESC to return to menu", screenHeight / 2 + 40, 20, WHITE);
+                break;
+            }
+
             // Draw game over text
             DrawTextCenteredX("GAME OVER", screenHeight / 2 - 40, 40, WHITE);
             DrawTextCenteredX(TextFormat("FINAL SCORE: %d", game->score), screenHeight / 2, 20, WHITE);
             DrawTextCenteredX("Press ENTER to play again", screenHeight / 2 + 40, 20, WHITE);
             DrawTextCenteredX("Press ESC to return to menu", screenHeight / 2 + 70, 20, WHITE);
+            if (game->rewind.count > 0) {
+                DrawTextCenteredX("Hold R to rewind", screenHeight / 2 + 100, 20, SKYBLUE);
+            }
             break;
     }
 
+    if (game->noticeTicks > 0 && game->notice != NULL)
+    {
+        DrawText(game->notice, 10, 75, 15, LIME);
+    }
+
     // FIXED: Adding fps options enabled - properly use DrawFPS
     if (game->settings.showFPS) 
     {
         DrawFPS(10, screenHeight - 30);
+
+        // rollback numbers for network games
+        if (game->netSession != NULL) {
+            const RollbackStats *net = &game->netSession->stats;
+            DrawText(TextFormat("rollbacks %.1f/s  resim %.1f us/frame (max %.1f)  ahead %d  stalls %lu",
+                                net->frames > 0 ? net->rollbacks * (float)GAME_TICK_RATE / net->frames : 0.0f,
+                                net->frames > 0 ? net->resimMicros / net->frames : 0.0,
+                                net->maxResimMicros, RollbackPredictedTicks(game->netSession), net->stalls),
+                     100, screenHeight - 48, 15, LIME);
+        }
+
+        // what keeping the rewind history costs, per tick and in memory
+        if (game->rewind.pushes > 0) {
+            DrawText(TextFormat("snapshot %.1f us (max %.1f)  %d B/tick  %d KB", game->rewind.lastPushMicros,
+                                game->rewind.maxPushMicros, (int)game->rewind.lastDeltaSize,
+                                (int)(game->rewind.bytesUsed / 1024)), 100, screenHeight - 28, 15, LIME);
+        }
+
+        // what was drawn at which level of detail, and what was skipped
+        DrawText(TextFormat("asteroids %d/%d/%d culled %d  bullets %d culled %d  stars %d/%d/%d",
+                            drawStats.asteroidsFull, drawStats.asteroidsReduced, drawStats.asteroidsPoint,
+                            drawStats.asteroidsCulled, drawStats.bulletsDrawn, drawStats.bulletsCulled,
+                            drawStats.starsFull, drawStats.starsReduced, drawStats.starsPoint),
+                 100, screenHeight - 68, 15, LIME);
+
+        // how old the presses were when a tick used them and when they were on screen
+        if (game->inputLatch != NULL && game->inputLatch->toSimulation.count > 0) {
+            const InputLatch *latch = game->inputLatch;
+            DrawText(TextFormat("input to tick p50 %.1f p99 %.1f ms  to screen p50 %.1f p99 %.1f ms  latch %s",
+                                LatencyPercentile(&latch->toSimulation, 50.0f), LatencyPercentile(&latch->toSimulation, 99.0f),
+                                LatencyPercentile(&latch->toPresent, 50.0f), LatencyPercentile(&latch->toPresent, 99.0f),
+                                latch->lateLatching ? "late" : "off"),
+                     100, screenHeight - 88, 15, LIME);
+        }
+
+        // how evenly the frames went out
+        if (game->pacer != NULL && game->pacer->frames > 0) {
+            DrawText(TextFormat("pacing %s  interval %.2f ms  error spread %.2f ms worst %+.2f ms  late %lu",
+                                PaceModeName(game->pacer->mode), game->pacer->intervalAverage * 1000.0,
+                                PacingErrorSpread(game->pacer) * 1000.0, game->pacer->worstError * 1000.0,
+                                game->pacer->longFrames),
+                     100, screenHeight - 108, 15, LIME);
+        }
+
+        // how the waves are going and what the budget turned away
+        if (game->director.wave > 0) {
+            const WaveDirector *director = &game->director;
+            DrawText(TextFormat("wave %d  spawns %d/%d  asteroids %d saucers %d held back %d  pieces %d peak %d of %d",
+                                director->wave, director->nextSpawn, director->spawnCount, director->spawned,
+                                director->saucers, director->heldBack, AsteroidPieces(&game->entities), director->peakPieces,
+                                DirectorPieceBudget(director->difficulty)),
+                     100, screenHeight - 128, 15, LIME);
+        }
     }
 }
 
+/*
+ * The entities of a game: the tables of the ships, asteroids, bullets, saucers and their shots,
+ * declared in that order at the sizes of their pools, and both ships in their starting spot. The
+ * indices of the first three are the ones their arrays used to have, so the collisions, the grid
+ * and everything else that goes by index see them the same way.
+ */
+void InitGameWorld(EcsWorld *world)
+{
+    _Static_assert(2 + MAX_ASTEROIDS + BULLET_SLOTS + UFO_MAX_SAUCERS + UFO_MAX_SHOTS <= ECS_MAX_ENTITIES, "the game's tables need more entity slots");
+    _Static_assert(2 * (2 * sizeof(Vector2) + sizeof(ShipState)) +
+                   MAX_ASTEROIDS * (2 * sizeof(Vector2) + sizeof(float) + sizeof(AsteroidSpin) + sizeof(AsteroidOutline)) +
+                   BULLET_SLOTS * (2 * sizeof(Vector2) + sizeof(float) + sizeof(int) + sizeof(Color)) +
+                   UFO_MAX_SAUCERS * (2 * sizeof(Vector2) + sizeof(float) + sizeof(int) + sizeof(UfoBrain)) +
+                   UFO_MAX_SHOTS * (2 * sizeof(Vector2) + sizeof(float) + sizeof(int)) <= ECS_DATA_BYTES, "the game's tables need more storage");
+
+    InitEcsWorld(world);
+    const ComponentMask masks[] = { SHIP_COMPONENTS, ASTEROID_COMPONENTS, BULLET_COMPONENTS, UFO_COMPONENTS, UFO_SHOT_COMPONENTS };
+    const int capacities[] = { 2, MAX_ASTEROIDS, BULLET_SLOTS, UFO_MAX_SAUCERS, UFO_MAX_SHOTS };
+    for (int i = 0; i < 5; i++)
+    {
+        if (EcsDeclareArchetype(world, masks[i], capacities[i]) < 0) TraceLog(LOG_WARNING, "GAME: no room for entity table %d", i);
+    }
+
+    InitPlayer(world, 0);
+    InitPlayer(world, 1);
+}
+
 // Implementing the reset game feature
 void ResetGame(Game *game)
 {
-    // We reset the player
-    InitPlayer(&game->player);
+    BindSimulationRandom(&game->rngState);
+    BindTunables(&game->tunables);
 
-    InitAsteroid(game->asteroids);
-    InitBullets(game->bullets);
+    // We reset the ships, the asteroids, the bullets and the saucers all at once
+    InitGameWorld(&game->entities);
+    game->secondScore = 0;
+    game->versusLoser = -1;
 
-    // now we spawn those initial asteroids once again
-    for (int i = 0; i < 5; i++)
+    // now we spawn those initial asteroids once again, five for every screen's worth of world
+    int slot = 0;
+    for (int i = 0; i < 5 * worldAsteroidLimit / SCREEN_ASTEROIDS && slot >= 0; i++)
+    {
+        slot = SpawnAsteroids(&game->entities, slot);     // nothing below the last one is free
+    }
+
+    // the first wave's timeline, versus games play on normal whatever either side has set
+    StartWaveDirector(&game->director, game->versus ? DIRECTOR_NORMAL : game->settings.difficulty, 0);
+
+    // make sure the ship does not start on top of one of them
+    RefreshAsteroidGrid(game);
+
+    Player player = GetPlayer(&game->entities, 0);
+    if (game->versus)
     {
-        SpawnAsteroids(game->asteroids);
+        // the two ships start on opposite sides facing each other
+        Player second = GetPlayer(&game->entities, 1);
+        player.position = (Vector2){ worldWidth / 3.0f, worldHeight / 2.0f };
+        second.position = FindSafeSpawnPosition(game, (Vector2){ worldWidth * 2.0f / 3.0f, worldHeight / 2.0f });
+        second.rotation = 180;
+        PutPlayer(&game->entities, 1, &second);
     }
+    player.position = FindSafeSpawnPosition(game, player.position);
+    PutPlayer(&game->entities, 0, &player);
+
     // reset the score finally
     game->score = 0; 
+    game->tick = 0;
+
+    // there is nothing to rewind into from a new game
+    ClearRewindBuffer(&game->rewind);
+    game->rewinding = false;
+}
+
+// Frees what initGame allocated, the Game itself is owned by the caller
+void UnloadGame(Game *game)
+{
+    FreeSpatialGrid(&game->asteroidGrid);
+    FreeSpatialGrid(&game->chunkGrid);
+    FreeRewindBuffer(&game->rewind);
+}
+
+// Keeps one grid in step with the world size and the asteroids, only asteroids that changed cells get relinked
+static void RefreshGrid(SpatialGrid *grid, const EcsWorld *world, float cellSize)
+{
+    // a replay or a stream from another world size means a rebuild
+    if (grid->worldWidth != (float)worldWidth || grid->worldHeight != (float)worldHeight)
+    {
+        FreeSpatialGrid(grid);
+        InitSpatialGrid(grid, worldWidth, worldHeight, cellSize, MAX_ASTEROIDS);
+    }
+
+    if (grid->cellHead != NULL)
+    {
+        UpdateSpatialGrid(grid, world);
+    }
+}
+
+// Brings the asteroid grid and the chunk lists up to date
+void RefreshAsteroidGrid(Game *game)
+{
+    RefreshGrid(&game->asteroidGrid, &game->entities, SPATIAL_CELL_SIZE);
+    RefreshGrid(&game->chunkGrid, &game->entities, WORLD_CHUNK_SIZE);
+}
+
+// Returns the preferred position if it is clear of asteroids, otherwise the clearest spot we can find
+Vector2 FindSafeSpawnPosition(Game *game, Vector2 preferred)
+{
+    SpatialGrid *grid = &game->asteroidGrid;
+    if (grid->cellHead == NULL) return preferred;
+
+    int nearest;
+    float clearance;
+    if (QueryNearestAsteroids(grid, preferred, 1, &nearest, &clearance) == 0 ||
+        clearance >= SAFE_SPAWN_CLEARANCE)
+    {
+        return preferred;
+    }
+
+    // try a coarse grid of candidates over the world and keep the one furthest from everything
+    Vector2 best = preferred;
+    float bestClearance = clearance;
+
+    for (int y = 1; y < 6; y++)
+    {
+        for (int x = 1; x < 8; x++)
+        {
+            Vector2 candidate = { worldWidth * x / 8.0f, worldHeight * y / 6.0f };
+
+            if (QueryNearestAsteroids(grid, candidate, 1, &nearest, &clearance) > 0 &&
+                clearance > bestClearance)
+            {
+                best = candidate;
+                bestClearance = clearance;
+            }
+        }
+    }
+
+    return best;
 }
@@ -0,0 +1,239 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-25 14:37:12
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-25 19:26:05
+*/
+
+/*
+ * The input latch, see input.h. A frame goes:
+ *
+ *   FinishInputFrame   the swap is done, the presses that went into it get their latency, and
+ *                      the poll EndDrawing just made is turned into events
+ *   LatchInput         during gameplay it sleeps in 1 ms steps, polling after each, until only
+ *                      the time the update and draw took lately (and a margin) is left before
+ *                      the frame pacer's deadline (pacing.h). Then this tick takes its events
+ *   UpdateGame, DrawGame, MarkInputFrameDrawn, EndCanvas
+ *
+ * The work estimate jumps up straight away when a frame takes longer and comes down slowly, a
+ * late frame costs a whole vblank while waking up a bit too early only costs a little latency.
+ */
+
+#include "input.h"
+#include "world.h"
+#include <stdlib.h>
+#include <string.h>
+
+// The keys gameplay reads, nothing else is worth an event
+static const int latchedKeys[] = {
+    KEY_LEFT, KEY_A, KEY_RIGHT, KEY_D, KEY_UP, KEY_W, KEY_SPACE, KEY_M,
+    KEY_P, KEY_ESCAPE, KEY_F2, KEY_F5, KEY_F9, KEY_F11, KEY_R, INPUT_MOUSE_LEFT, INPUT_MOUSE_RIGHT
+};
+#define LATCHED_KEY_COUNT ((int)(sizeof(latchedKeys) / sizeof(latchedKeys[0])))
+
+void InitInputLatch(InputLatch *latch, bool lateLatching)
+{
+    memset(latch, 0, sizeof(*latch));
+    latch->lateLatching = lateLatching;
+}
+
+static bool IsLatchedKey(int key)
+{
+    for (int i = 0; i < LATCHED_KEY_COUNT; i++)
+    {
+        if (latchedKeys[i] == key) return true;
+    }
+    return false;
+}
+
+static bool DeviceDown(int key)
+{
+    if (key == INPUT_MOUSE_LEFT) return IsMouseButtonDown(MOUSE_LEFT_BUTTON);
+    if (key == INPUT_MOUSE_RIGHT) return IsMouseButtonDown(MOUSE_RIGHT_BUTTON);
+    return IsKeyDown(key);
+}
+
+static void RecordLatency(LatencySamples *latency, double seconds)
+{
+    latency->samples[latency->next] = (float)(seconds * 1000.0);
+    latency->next = (latency->next + 1) % INPUT_LATENCY_SAMPLES;
+    if (latency->count < INPUT_LATENCY_SAMPLES) latency->count++;
+}
+
+static void ApplyEvent(InputLatch *latch, const InputEvent *event)
+{
+    latch->appliedDown[event->key] = event->down;
+    if (event->down) latch->tickPressed[event->key] = 1;
+}
+
+static void PushEvent(InputLatch *latch, double time, int key, bool down)
+{
+    // full, the oldest is applied to nothing rather than lost, the key state stays right
+    if (latch->eventCount == INPUT_MAX_EVENTS)
+    {
+        latch->appliedDown[latch->events[latch->firstEvent].key] = latch->events[latch->firstEvent].down;
+        latch->firstEvent = (latch->firstEvent + 1) % INPUT_MAX_EVENTS;
+        latch->eventCount--;
+    }
+
+    InputEvent *event = &latch->events[(latch->firstEvent + latch->eventCount) % INPUT_MAX_EVENTS];
+    event->time = time;
+    event->key = key;
+    event->down = down;
+    latch->eventCount++;
+}
+
+/*
+ * What the poll that just happened changed. Keys in raylib's pressed queue went down during the
+ * poll whatever they are now, so they get a press of their own (after a release if they were
+ * already down), and comparing with the state afterwards adds the release of a tap.
+ */
+static void SampleInput(InputLatch *latch, double now)
+{
+    int key;
+    while ((key = GetKeyPressed()) != 0)
+    {
+        if (key < 0 || key >= INPUT_KEYS || !IsLatchedKey(key)) continue;
+
+        if (latch->seenDown[key]) PushEvent(latch, now, key, false);
+        PushEvent(latch, now, key, true);
+        latch->seenDown[key] = 1;
+        if (!IsKeyDown(key)) latch->tapsCaught++;
+    }
+
+    for (int i = 0; i < LATCHED_KEY_COUNT; i++)
+    {
+        int k = latchedKeys[i];
+        bool down = DeviceDown(k);
+        if (down != (latch->seenDown[k] != 0))
+        {
+            PushEvent(latch, now, k, down);
+            latch->seenDown[k] = down;
+        }
+    }
+}
+
+/*
+ * Hands the events to this tick in the order they came. A second press of a key that already
+ * went down this tick is where the tick stops, it and everything after it is the next tick's.
+ */
+static void TakeTickEvents(InputLatch *latch, double now)
+{
+    memset(latch->tickPressed, 0, sizeof(latch->tickPressed));
+
+    while (latch->eventCount > 0)
+    {
+        const InputEvent *event = &latch->events[latch->firstEvent];
+        if (event->down && latch->tickPressed[event->key]) break;
+
+        if (event->down)
+        {
+            RecordLatency(&latch->toSimulation, now - event->time);
+            if (latch->pendingCount < INPUT_MAX_EVENTS) latch->pendingPress[latch->pendingCount++] = event->time;
+        }
+        ApplyEvent(latch, event);
+
+        latch->firstEvent = (latch->firstEvent + 1) % INPUT_MAX_EVENTS;
+        latch->eventCount--;
+    }
+
+    for (int i = 0; i < LATCHED_KEY_COUNT; i++)
+    {
+        int k = latchedKeys[i];
+        latch->tickDown[k] = latch->appliedDown[k] || latch->tickPressed[k];
+    }
+}
+
+void LatchInput(InputLatch *latch, double secondsLeft)
+{
+    double now = GetTime();
+
+    // the last moment the input can be taken and the frame still make its swap
+    if (latch->lateLatching && secondsLeft > 0.0)
+    {
+        double wake = now + secondsLeft - latch->workEstimate - INPUT_LATCH_MARGIN;
+        double sleepStart = now;
+
+        while (now < wake)
+        {
+            WaitTime(wake - now < INPUT_POLL_SECONDS ? wake - now : INPUT_POLL_SECONDS);
+            PollInputEvents();
+            now = GetTime();
+            SampleInput(latch, now);
+        }
+        latch->sleptSeconds += now - sleepStart;
+    }
+
+    TakeTickEvents(latch, now);
+    latch->latchedAt = now;
+    latch->workStart = now;
+    latch->frames++;
+}
+
+void MarkInputFrameDrawn(InputLatch *latch)
+{
+    double work = GetTime() - latch->workStart;
+
+    // straight up after a long frame, slowly back down
+    if (work > latch->workEstimate) latch->workEstimate = work;
+    else latch->workEstimate += (work - latch->workEstimate) * INPUT_WORK_DECAY;
+}
+
+void FinishInputFrame(InputLatch *latch)
+{
+    double now = GetTime();
+
+    for (int i = 0; i < latch->pendingCount; i++) RecordLatency(&latch->toPresent, now - latch->pendingPress[i]);
+    latch->pendingCount = 0;
+
+    SampleInput(latch, now);
+}
+
+bool LatchedKeyPressed(const InputLatch *latch, int key)
+{
+    return key >= 0 && key < INPUT_KEYS && latch->tickPressed[key];
+}
+
+bool LatchedKeyDown(const InputLatch *latch, int key)
+{
+    return key >= 0 && key < INPUT_KEYS && latch->tickDown[key];
+}
+
+// ReadPlayerInput with the latched keys, a tap shorter than a frame still fires
+PlayerInput ReadLatchedInput(const InputLatch *latch, const Player *player)
+{
+    PlayerInput input = { 0 };
+
+    input.toggleControlMode = LatchedKeyPressed(latch, KEY_M);
+    input.aimTarget = ScreenToWorld(GetMousePosition());
+
+    if (player->controlMode == CONTROL_KEYBOARD) {
+        input.rotateLeft = LatchedKeyDown(latch, KEY_LEFT) || LatchedKeyDown(latch, KEY_A);
+        input.rotateRight = LatchedKeyDown(latch, KEY_RIGHT) || LatchedKeyDown(latch, KEY_D);
+        input.thrust = LatchedKeyDown(latch, KEY_UP) || LatchedKeyDown(latch, KEY_W);
+        input.shoot = LatchedKeyDown(latch, KEY_SPACE);
+    } else {
+        input.thrust = LatchedKeyDown(latch, INPUT_MOUSE_RIGHT);
+        input.shoot = LatchedKeyDown(latch, INPUT_MOUSE_LEFT);
+    }
+
+    return input;
+}
+
+static int CompareFloats(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+float LatencyPercentile(const LatencySamples *latency, float percent)
+{
+    if (latency->count == 0) return 0.0f;
+
+    float sorted[INPUT_LATENCY_SAMPLES];
+    memcpy(sorted, latency->samples, sizeof(float) * latency->count);
+    qsort(sorted, latency->count, sizeof(float), CompareFloats);
+
+    int index = (int)(percent / 100.0f * (latency->count - 1) + 0.5f);
+    return sorted[index < 0 ? 0 : (index >= latency->count ? latency->count - 1 : index)];
+}
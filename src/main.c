@@ -14,22 +14,177 @@
 #include <raymath.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 #include "utils.h"
 #include "game.h"
 #include "resolution.h"
 #include "sound.h"
-
-// Global screen dimensions
-int screenWidth = SCREEN_WIDTH;
-int screenHeight = SCREEN_HEIGHT;
+#include "net.h"
+#include "rollback.h"
+#include "statestream.h"
+#include "replay.h"
+#include "world.h"
+#include "canvas.h"
+#include "input.h"
+#include "pacing.h"
+#include "stress.h"
+#include "telemetry.h"
+#include "savegame.h"
 
 // defining necessary things
 
-int main(void)
+int main(int argc, char *argv[])
 {
-    // Initialize global screen dimensions
+    // Command line options
+    // --null-audio          mix audio in memory instead of using the audio device
+    // --audio-out <file>    same as --null-audio and writes everything that was played to a WAV file
+    // --host [port]         host a two player network game
+    // --join <host[:port]>  join a network game
+    // --net-latency <ms>    pretend the network is slow (one way, added to everything we send)
+    // --net-jitter <ms>     random extra delay on top of the latency
+    // --net-loss <percent>  drop some of the packets we send
+    // --stream-out <file>   record a state stream of everything that happens on screen
+    // --stream-listen <path> let spectators watch through a local socket at this path
+    // --watch <path>        watch a state stream, a recording or the socket of a running game
+    // --record <file>       record a seekable replay of every single player game
+    // --replay <file>       play a replay back, left/right jump 5 seconds, space pauses
+    // --world <WxH>         play in a world of this size instead of the canvas, the camera follows the ship
+    // --render-scale <s>    draw the canvas at this scale (0.25 to 2) before it is stretched to the window
+    // --no-late-input       read the keys right after the last frame instead of just before the tick (input.h)
+    // --pacing <mode>       power (vsync, sleeps only), latency (no vsync, sleep then spin) or uncapped (pacing.h)
+    // --stress [schedule]   ramp the entity counts up a schedule and print where the frame falls apart (stress.h)
+    // --stress-csv <file>   the stress report as CSV as well
+    // --telemetry <file>    count what happens in this session and add it to the end of a log (telemetry.h)
+    // --save-dir <dir>      where the profile (settings, high score) and the F5 quick save go (savegame.h)
+    bool useNullAudio = false;
+    const char *audioOutFile = NULL;
+    bool hostGame = false;
+    char joinHost[256] = { 0 };
+    unsigned short netPort = NET_DEFAULT_PORT;
+    NetConditions netConditions = { 0 };
+    const char *streamFile = NULL;
+    const char *streamSocket = NULL;
+    const char *watchPath = NULL;
+    const char *recordFile = NULL;
+    const char *replayFile = NULL;
+    int worldSize[2] = { 0, 0 };
+    float renderScale = 1.0f;
+    bool renderScaleGiven = false;
+    bool lateInput = true;
+    PaceMode paceMode = PACE_POWER_SAVING;
+    const char *telemetryFile = NULL;
+    const char *saveDirectory = NULL;
+    bool stressTest = false;
+    StressOptions stressOptions = { 0 };
+    ParseStressSchedule(STRESS_DEFAULT_SCHEDULE, &stressOptions);
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--null-audio") == 0) {
+            useNullAudio = true;
+        } else if (strcmp(argv[i], "--audio-out") == 0 && i + 1 < argc) {
+            useNullAudio = true;
+            audioOutFile = argv[++i];
+        } else if (strcmp(argv[i], "--host") == 0) {
+            hostGame = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') netPort = (unsigned short)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--join") == 0 && i + 1 < argc) {
+            // host:port, the port is optional
+            snprintf(joinHost, sizeof(joinHost), "%s", argv[++i]);
+            char *colon = strrchr(joinHost, ':');
+            if (colon != NULL) {
+                *colon = '\0';
+                netPort = (unsigned short)atoi(colon + 1);
+            }
+        } else if (strcmp(argv[i], "--net-latency") == 0 && i + 1 < argc) {
+            netConditions.latencyMs = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--net-jitter") == 0 && i + 1 < argc) {
+            netConditions.jitterMs = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--net-loss") == 0 && i + 1 < argc) {
+            netConditions.lossPercent = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "--stream-out") == 0 && i + 1 < argc) {
+            streamFile = argv[++i];
+        } else if (strcmp(argv[i], "--stream-listen") == 0 && i + 1 < argc) {
+            streamSocket = argv[++i];
+        } else if (strcmp(argv[i], "--watch") == 0 && i + 1 < argc) {
+            watchPath = argv[++i];
+        } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            recordFile = argv[++i];
+        } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            replayFile = argv[++i];
+        } else if (strcmp(argv[i], "--world") == 0 && i + 1 < argc &&
+                   sscanf(argv[++i], "%dx%d", &worldSize[0], &worldSize[1]) == 2) {
+            // checked and clamped by SetWorldSize
+        } else if (strcmp(argv[i], "--render-scale") == 0 && i + 1 < argc) {
+            renderScale = (float)atof(argv[++i]);
+            renderScaleGiven = true;
+        } else if (strcmp(argv[i], "--no-late-input") == 0) {
+            lateInput = false;
+        } else if (strcmp(argv[i], "--pacing") == 0 && i + 1 < argc && PaceModeFromName(argv[i + 1], &paceMode)) {
+            i++;
+        } else if (strcmp(argv[i], "--stress") == 0) {
+            stressTest = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-' && !ParseStressSchedule(argv[++i], &stressOptions)) {
+                fprintf(stderr, "Bad stress schedule %s, counts like 1k,10k,100k or asteroids/bullets/particles\n", argv[i]);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--stress-csv") == 0 && i + 1 < argc) {
+            stressOptions.csvFile = argv[++i];
+        } else if (strcmp(argv[i], "--telemetry") == 0 && i + 1 < argc) {
+            telemetryFile = argv[++i];
+        } else if (strcmp(argv[i], "--save-dir") == 0 && i + 1 < argc) {
+            saveDirectory = argv[++i];
+        } else {
+            fprintf(stderr, "Unknown option: %s\n", argv[i]);
+            fprintf(stderr, "Usage: %s [--null-audio] [--audio-out file.wav] [--host [port] | --join host[:port]]\n"
+                            "       [--net-latency ms] [--net-jitter ms] [--net-loss percent]\n"
+                            "       [--stream-out file] [--stream-listen path] [--watch path]\n"
+                            "       [--record file] [--replay file] [--world WxH] [--render-scale s]\n"
+                            "       [--no-late-input] [--pacing power|latency|uncapped]\n"
+                            "       [--stress [schedule]] [--stress-csv file] [--telemetry file]\n"
+                            "       [--save-dir dir]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // The stress ramp wants the frames as fast as they go, nothing should wait for the display
+    if (stressTest) paceMode = PACE_UNCAPPED;
+
+    // The size of the canvas, the window only changes how big it is shown
     screenWidth = SCREEN_WIDTH;
     screenHeight = SCREEN_HEIGHT;
+
+    // The world is the canvas unless it was given a size (both sides of a network game need the same one)
+    SetWorldSize(worldSize[0], worldSize[1]);
+
+    // A spectator only draws what the stream says, the canvas matches the size the game was played at
+    StreamInput *watching = NULL;
+    if (watchPath != NULL)
+    {
+        watching = malloc(sizeof(StreamInput));
+        if (watching == NULL || !OpenStreamInput(watching, watchPath))
+        {
+            fprintf(stderr, "Could not open the stream %s\n", watchPath);
+            return 1;
+        }
+        screenWidth = watching->header.screenWidth;
+        screenHeight = watching->header.screenHeight;
+        SetWorldSize(watching->header.worldWidth, watching->header.worldHeight);
+    }
+
+    // Replays are mapped, not loaded, opening a long one costs the same as a short one
+    Replay replay = { 0 };
+    if (replayFile != NULL)
+    {
+        if (!OpenReplay(&replay, replayFile))
+        {
+            fprintf(stderr, "Could not open the replay %s\n", replayFile);
+            return 1;
+        }
+        screenWidth = replay.header->screenWidth;
+        screenHeight = replay.header->screenHeight;
+    }
    
     // Set a custom trace log level to ignore non-important trace logs
     // Helps avoid spamming the console with "Viewport changed" messages when resizing
@@ -38,43 +193,284 @@ int main(void)
     // We initialize the window first
     InitWindow(screenWidth, screenHeight, "Asteroids game in C using Raylib");
     
-    // Enable vsync
-    SetWindowState(FLAG_VSYNC_HINT);
-    SetTargetFPS(60);  // Changed from 240 to 60 for better sound timing
+    // Vsync only when the pacing mode wants it, the pacer does the waiting instead of raylib
+    if (PaceModeWantsVsync(paceMode)) SetWindowState(FLAG_VSYNC_HINT);
+    else ClearWindowState(FLAG_VSYNC_HINT);
+    SetTargetFPS(0);
+
+    // One frame per game tick (GAME_TICK_RATE a second), the sound timing depends on it as well
+    FramePacer pacer;
+    InitFramePacer(&pacer, paceMode, 1.0 / GAME_TICK_RATE);
     
     // Disable default exit key (escape)
     SetExitKey(0);
 
+    // Everything is drawn on the canvas and scaled to the window at the end of the frame
+    InitCanvas(renderScale);
+
+    // The stress scenario only needs the window and the canvas, it runs and reports and that's it
+    if (stressTest)
+    {
+        int result = RunStressScenario(&stressOptions);
+        UnloadCanvas();
+        CloseWindow();
+        return result;
+    }
+
     // Initialize the sound system
     SoundManager soundManager;
-    InitSoundManager(&soundManager);
+    InitSoundManager(&soundManager, useNullAudio, audioOutFile != NULL);
     
     // Initialize the Game itself
+    // zeroed first, network games checksum the state and the padding has to match on both sides
     Game game;
+    memset(&game, 0, sizeof(game));
     game.soundManager = &soundManager;  // Link the sound manager to the game
     initGame(&game);
+    game.settings.renderScale = CanvasScale();
+
+    // Saves are written on their own thread, the settings and the high score from last time are
+    // read right away (a missing or broken profile just leaves the defaults)
+    SaveWriter saveWriter;
+    if (StartSaveWriter(&saveWriter, saveDirectory)) game.saveWriter = &saveWriter;
+    else fprintf(stderr, "Could not start the save thread, nothing will be saved\n");
+
+    MappedSave profile;
+    if (MapSaveFile(&profile, saveWriter.slots[SAVE_PROFILE].path))
+    {
+        ApplySavedSettings(&game, profile.header, true);
+        UnmapSaveFile(&profile);
+    }
+    if (renderScaleGiven)
+    {
+        SetRenderScale(renderScale);
+        game.settings.renderScale = CanvasScale();
+    }
+
+    // Keys are timestamped and, during gameplay, read as late in the frame as the draw allows
+    InputLatch inputLatch;
+    InitInputLatch(&inputLatch, lateInput);
+    game.inputLatch = &inputLatch;
+    game.pacer = &pacer;
+
+    // The session's counters, one record at the end of the log when the game closes
+    Telemetry telemetry;
+    InitTelemetry(&telemetry, game.settings.difficulty);
+    if (telemetryFile != NULL) game.telemetry = &telemetry;
+
+    // A network game skips the menu, it starts as soon as the other side shows up.
+    // The session is big (it keeps a snapshot for every tick it can roll back), so it goes on the heap
+    RollbackSession *session = NULL;
+    if (hostGame || joinHost[0] != '\0')
+    {
+        session = malloc(sizeof(RollbackSession));
+        bool opened = session != NULL && (hostGame ? HostRollbackSession(session, &game, netPort, netConditions, (unsigned int)time(NULL))
+                                                   : JoinRollbackSession(session, &game, joinHost, netPort, netConditions));
+        if (!opened)
+        {
+            fprintf(stderr, "Could not start the network game\n");
+            free(session);
+            session = NULL;
+        }
+        else
+        {
+            game.netSession = session;
+            game.state = GAMEPLAY;
+        }
+    }
+
+    // Recording and spectators, the stream is written after every update
+    StreamOutput *streaming = NULL;
+    if (streamFile != NULL || streamSocket != NULL)
+    {
+        streaming = malloc(sizeof(StreamOutput));
+        if (streaming == NULL || !OpenStreamOutput(streaming, streamFile, streamSocket))
+        {
+            fprintf(stderr, "Could not open the state stream\n");
+            free(streaming);
+            streaming = NULL;
+        }
+    }
+
+    // Recording, every tick of a single player game goes through RecordReplayTick()
+    ReplayWriter *recording = NULL;
+    if (recordFile != NULL)
+    {
+        recording = malloc(sizeof(ReplayWriter));
+        if (recording == NULL || !OpenReplayWriter(recording, recordFile))
+        {
+            fprintf(stderr, "Could not open %s for recording\n", recordFile);
+            free(recording);
+            recording = NULL;
+        }
+        game.replayWriter = recording;
+    }
+
+    unsigned int replayTick = 0;
+    bool replayPaused = false;
+    if (replay.data != NULL) SeekReplay(&replay, 0, &game);
 
     while(!WindowShouldClose())
     {
+        if (replay.data != NULL)
+        {
+            if (IsKeyPressed(KEY_ESCAPE)) break;
+            if (IsKeyPressed(KEY_SPACE)) replayPaused = !replayPaused;
+
+            // a jump is a keyframe and at most REPLAY_KEYFRAME_TICKS ticks of simulation
+            int jump = 0;
+            if (IsKeyPressed(KEY_RIGHT)) jump = 5 * GAME_TICK_RATE;
+            if (IsKeyPressed(KEY_LEFT)) jump = -5 * GAME_TICK_RATE;
+            if (IsKeyPressed(KEY_HOME)) jump = -(int)replayTick;
+
+            // the music and the mix go on one tick per frame like in the game, paused or not
+            UpdateGameMusic(&soundManager, &game);
+
+            if (jump != 0)
+            {
+                long target = (long)replayTick + jump;
+                replayTick = target < 0 ? 0 : (target > (long)ReplayTicks(&replay) ? ReplayTicks(&replay) : (unsigned int)target);
+                SeekReplay(&replay, replayTick, &game);
+            }
+            else if (!replayPaused && replayTick < ReplayTicks(&replay))
+            {
+                // the ticks played sound like they did in the game, so --audio-out writes the replay's audio
+                TickSounds sounds;
+                NoteTickSounds(&game, &sounds);
+                StepReplay(&replay, replayTick++, &game);
+                PlayTickSounds(&game, &sounds);
+            }
+            UpdateStars(game.stars);
+
+            BeginCanvas();
+                DrawGame(&game);
+                DrawText(TextFormat("REPLAY %d:%02d / %d:%02d%s", replayTick / GAME_TICK_RATE / 60, (replayTick / GAME_TICK_RATE) % 60,
+                                    ReplayTicks(&replay) / GAME_TICK_RATE / 60, (ReplayTicks(&replay) / GAME_TICK_RATE) % 60,
+                                    replayPaused ? "  PAUSED" : ""), 10, screenHeight - 60, 20, GRAY);
+                WaitForFrameDeadline(&pacer);
+            EndCanvas();
+            FramePresented(&pacer);
+            continue;
+        }
+
+        if (watching != NULL)
+        {
+            if (IsKeyPressed(KEY_ESCAPE)) break;
+
+            ReadStreamFrame(watching, &game);
+            UpdateStars(game.stars);
+
+            BeginCanvas();
+                DrawGame(&game);
+                if (watching->ended) DrawText("END OF STREAM", 10, screenHeight - 60, 20, GRAY);
+                WaitForFrameDeadline(&pacer);
+            EndCanvas();
+            FramePresented(&pacer);
+            continue;
+        }
+
+        // Sleeps through the part of the frame the update and draw don't need, then takes the keys
+        LatchInput(&inputLatch, game.state == GAMEPLAY ? PacerTimeLeft(&pacer) : 0.0);
+
         // We handle the F11 key for fullscreen toggle
-        if (IsKeyPressed(KEY_F11))
+        if (LatchedKeyPressed(&inputLatch, KEY_F11))
         {
             ToggleFullscreenMode(&game);
         }
         
         UpdateGame(&game);
+        if (streaming != NULL) WriteStreamFrame(streaming, &game);
+        if (game.telemetry != NULL) TelemetryFrame(game.telemetry, &game);
         
-        // Begin Drawing
-        BeginDrawing();
-            ClearBackground(BLACK);
+        // Begin Drawing, into the canvas
+        BeginCanvas();
             DrawGame(&game);
-        // End Drawing
-        EndDrawing();
+            MarkInputFrameDrawn(&inputLatch);
+            WaitForFrameDeadline(&pacer);
+        // End Drawing, the canvas goes to the window
+        EndCanvas();
+        FramePresented(&pacer);
+        FinishInputFrame(&inputLatch);
     }
     
+    // Write out what the null audio device mixed, before the sounds get unloaded
+    if (audioOutFile != NULL)
+    {
+        if (!ExportGameAudio(&soundManager, audioOutFile)) {
+            fprintf(stderr, "Could not write audio to %s\n", audioOutFile);
+        }
+    }
+
+    if (soundManager.nullDevice)
+    {
+        printf("Null audio: mixed %llu frames in %.2f ms\n",
+               soundManager.nullAudio.mixedFrames, soundManager.nullAudio.mixSeconds * 1000.0);
+    }
+
+    PrintPacingReport(&pacer);
+
+    // The settings and the high score for next time, the thread writes what is left before it ends
+    if (game.saveWriter != NULL) QueueSave(game.saveWriter, &game, SAVE_PROFILE);
+    StopSaveWriter(&saveWriter);
+    PrintSaveReport(&saveWriter);
+
+    if (game.telemetry != NULL && !AppendTelemetryRecord(game.telemetry, telemetryFile))
+    {
+        fprintf(stderr, "Could not add the session to %s\n", telemetryFile);
+    }
+
+    if (inputLatch.toSimulation.count > 0)
+    {
+        printf("Input latency: %d presses, to tick p50 %.1f p95 %.1f p99 %.1f ms, to screen p50 %.1f p95 %.1f p99 %.1f ms\n",
+               inputLatch.toSimulation.count, LatencyPercentile(&inputLatch.toSimulation, 50.0f),
+               LatencyPercentile(&inputLatch.toSimulation, 95.0f), LatencyPercentile(&inputLatch.toSimulation, 99.0f),
+               LatencyPercentile(&inputLatch.toPresent, 50.0f), LatencyPercentile(&inputLatch.toPresent, 95.0f),
+               LatencyPercentile(&inputLatch.toPresent, 99.0f));
+        printf("Input latch: %s, slept %.1f ms per frame on average, %lu taps shorter than a poll\n",
+               inputLatch.lateLatching ? "late" : "off", inputLatch.frames > 0 ? inputLatch.sleptSeconds * 1000.0 / inputLatch.frames : 0.0,
+               inputLatch.tapsCaught);
+    }
+
+    if (streaming != NULL)
+    {
+        double seconds = (double)streaming->frames / GAME_TICK_RATE;
+        printf("State stream: %lu frames, %lu keyframes, %.0f bytes/s\n", streaming->frames, streaming->keyframes,
+               seconds > 0.0 ? streaming->bytes / seconds : 0.0);
+        CloseStreamOutput(streaming);
+        free(streaming);
+    }
+
+    if (recording != NULL)
+    {
+        printf("Replay: %u ticks in %u keyframes\n", recording->header.ticks, recording->header.keyframes);
+        if (!CloseReplayWriter(recording)) fprintf(stderr, "The replay %s is incomplete\n", recordFile);
+        free(recording);
+    }
+
+    if (replay.data != NULL) CloseReplay(&replay);
+
+    if (watching != NULL)
+    {
+        CloseStreamInput(watching);
+        free(watching);
+    }
+
+    if (session != NULL)
+    {
+        const RollbackStats *stats = &session->stats;
+        printf("Rollback: %lu frames, %lu rollbacks (%lu ticks resimulated, %.1f us max), %lu stalls, %lu/%lu predictions right, %lu desyncs\n",
+               stats->frames, stats->rollbacks, stats->resimulatedTicks, stats->maxResimMicros, stats->stalls,
+               stats->correctPredictions, stats->predictedTicks, stats->desyncs);
+        CloseRollbackSession(session);
+        free(session);
+    }
+
+    UnloadGame(&game);
+
     // Unload game sounds before closing
     UnloadGameSounds(&soundManager);
-    
+
+    UnloadCanvas();
     CloseWindow();
     return 0;
 }
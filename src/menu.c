@@ -16,6 +16,7 @@
 #include "utils.h"
 #include "resolution.h"
 #include "sound.h"
+#include "canvas.h"
 #include <raylib.h>
 #include <stdio.h>
 #include <stdlib.h> // Added for NULL
@@ -139,12 +140,14 @@ void DrawOptionsMenu(Game *game)
     char difficultyText[30];                                                        // Increased size to be safe
     char fullscreenText[30];                                                        // added a buffer to hold FULLSCREEN NEW!!
     char resolutionText[40];                                                        // Buffer for resolution text
+    char renderScaleText[30];
 
     sprintf(soundText, "SOUND: %s", game->settings.soundEnabled ? "ON" : "OFF");
     sprintf(musicText, "MUSIC: %s", game->settings.musicEnabled ? "ON" : "OFF");
     sprintf(fpsText, "SHOW FPS: %s", game->settings.showFPS ? "ON" : "OFF");
     sprintf(fullscreenText, "FULLSCREEN: %s", game->settings.fullscreen ? "ON" : "OFF");
     sprintf(resolutionText, "RESOLUTION: %s", game->resolutions[game->currentResolution].name);
+    sprintf(renderScaleText, "RENDER SCALE: %d%%", (int)(game->settings.renderScale * 100.0f + 0.5f));
 
     // setting difficulty switch case
     switch(game->settings.difficulty)
@@ -166,13 +169,28 @@ void DrawOptionsMenu(Game *game)
     DrawMenuOption(difficultyText, startY +  spacing * 3, game->selectedOption == MENU_DIFFICULTY);
     DrawMenuOption(resolutionText, startY + spacing * 4, game->selectedOption == MENU_RESOLUTION);
     DrawMenuOption(fullscreenText, startY + spacing * 5, game->selectedOption == MENU_FULLSCREEN); 
-    DrawMenuOption("BACK", startY + spacing * 6, game->selectedOption == MENU_BACK);
+    DrawMenuOption(renderScaleText, startY + spacing * 6, game->selectedOption == MENU_RENDER_SCALE);
+    DrawMenuOption("BACK", startY + spacing * 7, game->selectedOption == MENU_BACK);
 
     // Instructions in the menu
     DrawText("<- -> to change settings", screenWidth / 2 - MeasureText("<- -> to change settings", 15) / 2, 
              screenHeight - 30, 15, GRAY);
 }
 
+// The render scales the options menu goes through, a scale from --render-scale joins in at the closest one
+static const float renderScales[] = { 0.5f, 0.75f, 1.0f, 1.5f, 2.0f };
+#define RENDER_SCALE_COUNT ((int)(sizeof(renderScales) / sizeof(renderScales[0])))
+
+static float NextRenderScale(float current, int direction)
+{
+    int index = 0;
+    while (index < RENDER_SCALE_COUNT - 1 && renderScales[index] < current) index++;
+    if (direction < 0 && renderScales[index] >= current) index--;
+    else if (direction > 0 && renderScales[index] <= current) index++;
+
+    return renderScales[(index + RENDER_SCALE_COUNT) % RENDER_SCALE_COUNT];
+}
+
 void UpdateOptionsMenu(Game *game)
 {
     // Navigation
@@ -239,6 +257,10 @@ void UpdateOptionsMenu(Game *game)
             case MENU_FULLSCREEN:
                 ToggleFullscreenMode(game);
                 break;
+            case MENU_RENDER_SCALE:
+                game->settings.renderScale = NextRenderScale(game->settings.renderScale, IsKeyPressed(KEY_RIGHT) ? 1 : -1);
+                SetRenderScale(game->settings.renderScale);
+                break;
             case MENU_DIFFICULTY:
                 if (IsKeyPressed(KEY_RIGHT))
                 {
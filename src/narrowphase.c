@@ -0,0 +1,155 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-17 10:04:37
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-17 12:48:15
+*/
+
+/*
+ * Polygon narrowphase for the asteroids. The bounding circle is a lot bigger than the jagged
+ * outline in the gaps between the spikes, so circle tests alone give hits where the player can
+ * clearly see empty space. Every pair that passes the circle test ends up here and is tested
+ * against the cached outline of the asteroid (see BuildAsteroidOutline) instead.
+ *
+ * Everything is done in the asteroid's local space: the other shape is moved and rotated onto
+ * the outline, which is cheaper than rotating the 8 outline points out to the screen. All the
+ * edges are tested in one branch free loop over the outline arrays, the compiler turns it into
+ * SIMD code the same way it does for the swept circle test in utils.c.
+ */
+
+#include "narrowphase.h"
+#include "asteroids.h"
+#include "utils.h"
+#include "fixed.h"
+#include "trig.h"
+#include <raylib.h>
+#include <math.h>
+#include <stdbool.h>
+
+// The asteroid's turn, from the sine table in the fixed-point build so hits are the same on every machine
+static inline void RotationCosSin(float radians, float *cosA, float *sinA)
+{
+#ifdef FIXED_SIM
+    SinCosAngle(FixedRadiansToAngle(FixedFromFloat(radians)), sinA, cosA);
+#else
+    SinCos(radians, sinA, cosA);
+#endif
+}
+
+// Moves a screen space point into the asteroid's local space
+static inline Vector2 ToAsteroidSpace(Vector2 point, Vector2 center, float cosA, float sinA)
+{
+    float x = point.x - center.x;
+    float y = point.y - center.y;
+    return (Vector2){ x * cosA + y * sinA, y * cosA - x * sinA };
+}
+
+/*
+ * Tests the segment a + t * d (t from 0 to 1) against every outline edge at once. For each edge
+ * it writes where along the segment it crosses that edge (NO_IMPACT if it doesn't) and whether
+ * a ray from a towards +x crosses the edge, which gives the point in polygon test for free.
+ */
+static void OutlineEdgeLanes(const float *restrict ex, const float *restrict ey, float ax, float ay, float dx, float dy,
+                             float *restrict crossAt, int *restrict rayCrossings)
+{
+    for (int k = 0; k < ASTEROID_VERTICES; k++)
+    {
+        float wx = ex[k + 1] - ex[k];
+        float wy = ey[k + 1] - ey[k];
+        float qx = ex[k] - ax;
+        float qy = ey[k] - ay;
+
+        // both parameters are numerator / denominator, flip the signs so the denominator is
+        // positive and the range checks need no division, parallel lines get a denominator of 0
+        float denominator = dx * wy - dy * wx;
+        float sign = copysignf(1.0f, denominator);
+        float size = fabsf(denominator);
+        float t = (qx * wy - qy * wx) * sign;           // along the segment
+        float s = (qx * dy - qy * dx) * sign;           // along the edge
+
+        bool crosses = (size > 0.0f) & (t >= 0.0f) & (t <= size) & (s >= 0.0f) & (s <= size);
+        crossAt[k] = crosses ? t / (size + 1e-30f) : NO_IMPACT;
+
+        // even-odd rule, the edge counts if it straddles the ray's height and passes to the right
+        // of a, which is the side a is on times the direction of the edge (again without dividing)
+        bool straddles = (ey[k] > ay) != (ey[k + 1] > ay);
+        float side = (qx * wy - qy * wx) * copysignf(1.0f, wy);
+        rayCrossings[k] = straddles & (side > 0.0f);
+    }
+}
+
+/*
+ * Where the segment from -> to (asteroid local space) first touches the outline, as a fraction
+ * of the segment. 0 if it already starts inside and NO_IMPACT if it never gets there.
+ */
+float SegmentOutlineImpact(const Asteroid *asteroid, Vector2 from, Vector2 to)
+{
+    float crossAt[ASTEROID_VERTICES];
+    int rayCrossings[ASTEROID_VERTICES];
+
+    OutlineEdgeLanes(asteroid->outlineX, asteroid->outlineY, from.x, from.y, to.x - from.x, to.y - from.y,
+                     crossAt, rayCrossings);
+
+    int inside = 0;
+    float first = NO_IMPACT;
+    for (int k = 0; k < ASTEROID_VERTICES; k++)
+    {
+        inside ^= rayCrossings[k];
+        first = crossAt[k] < first ? crossAt[k] : first;
+    }
+
+    return inside ? 0.0f : first;
+}
+
+/*
+ * Bullet against the outline, over the path it took this tick. The asteroid moved as well, so
+ * the start of the path is measured from where the asteroid was at the start of the tick and the
+ * end from where it is now. Returns the fraction of the tick at which the bullet reaches the
+ * outline, or NO_IMPACT. Bullets are small next to the outline detail so we follow their center.
+ */
+float BulletAsteroidImpact(const Asteroid *asteroid, Vector2 asteroidStart, Vector2 bulletStart, Vector2 bulletEnd)
+{
+    float startRotation = asteroid->rotation - asteroid->rotationSpeed;
+    float startCos, startSin, endCos, endSin;
+    RotationCosSin(startRotation, &startCos, &startSin);
+    RotationCosSin(asteroid->rotation, &endCos, &endSin);
+
+    Vector2 from = ToAsteroidSpace(bulletStart, asteroidStart, startCos, startSin);
+    Vector2 to = ToAsteroidSpace(bulletEnd, asteroid->position, endCos, endSin);
+
+    return SegmentOutlineImpact(asteroid, from, to);
+}
+
+/*
+ * Ship triangle against the outline. The shapes overlap if any triangle edge crosses the outline,
+ * otherwise one can only be completely inside the other, so checking one corner of each is enough.
+ */
+bool ShipTouchesAsteroid(const Vector2 ship[3], const Asteroid *asteroid)
+{
+    float cosA, sinA;
+    RotationCosSin(asteroid->rotation, &cosA, &sinA);
+    Vector2 local[3];
+
+    for (int i = 0; i < 3; i++) local[i] = ToAsteroidSpace(ship[i], asteroid->position, cosA, sinA);
+
+    // every edge, the first one also tells us if the nose is inside the asteroid
+    for (int i = 0; i < 3; i++)
+    {
+        if (SegmentOutlineImpact(asteroid, local[i], local[(i + 1) % 3]) <= 1.0f) return true;
+    }
+
+    // the asteroid could still be small enough to sit inside the ship
+    return PointInShip(local, (Vector2){ asteroid->outlineX[0], asteroid->outlineY[0] });
+}
+
+// Inside test for the ship triangle, the point has to be on the same side of all three edges
+bool PointInShip(const Vector2 ship[3], Vector2 point)
+{
+    bool sides[3];
+    for (int i = 0; i < 3; i++)
+    {
+        Vector2 a = ship[i], b = ship[(i + 1) % 3];
+        sides[i] = (b.x - a.x) * (point.y - a.y) - (b.y - a.y) * (point.x - a.x) >= 0.0f;
+    }
+    return sides[0] == sides[1] && sides[1] == sides[2];
+}
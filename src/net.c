@@ -0,0 +1,191 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-18 10:15:40
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-18 13:02:17
+*/
+
+/*
+ * UDP transport for network games. Plain non-blocking BSD sockets, one socket per side and
+ * one peer. Nothing here knows what is in the packets, see rollback.c for that.
+ *
+ * Every packet goes through the delay queue, even with no latency set, so the test mode and
+ * the real thing use the same path. A packet that is due gets sent the next time the queue is
+ * flushed, which happens on every send and once per frame.
+ */
+
+#include "net.h"
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <raylib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// xorshift, only decides delays and drops so it doesn't matter that it differs between the sides
+static float NetRandomFloat(NetLink *link)
+{
+    unsigned int x = link->randomState;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    link->randomState = x;
+    return (x >> 8) / 16777216.0f;
+}
+
+bool OpenNetLink(NetLink *link, unsigned short port, NetConditions conditions)
+{
+    memset(link, 0, sizeof(*link));
+    link->conditions = conditions;
+    link->randomState = 0x9E3779B9u ^ port;
+
+    link->socket = socket(AF_INET, SOCK_DGRAM, 0);
+    if (link->socket < 0)
+    {
+        TraceLog(LOG_WARNING, "NET: Could not create a UDP socket");
+        return false;
+    }
+
+    struct sockaddr_in address = { 0 };
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+
+    if (bind(link->socket, (struct sockaddr *)&address, sizeof(address)) < 0)
+    {
+        TraceLog(LOG_WARNING, "NET: Could not bind UDP port %d", port);
+        close(link->socket);
+        link->socket = -1;
+        return false;
+    }
+
+    // the game loop polls, it never waits for the network
+    fcntl(link->socket, F_SETFL, fcntl(link->socket, F_GETFL, 0) | O_NONBLOCK);
+
+    link->queue = malloc(sizeof(DelayedPacket) * NET_DELAY_QUEUE);
+    return link->queue != NULL;
+}
+
+bool SetNetPeer(NetLink *link, const char *host, unsigned short port)
+{
+    struct addrinfo hints = { 0 };
+    struct addrinfo *result = NULL;
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_DGRAM;
+
+    if (getaddrinfo(host, NULL, &hints, &result) != 0 || result == NULL)
+    {
+        TraceLog(LOG_WARNING, "NET: Could not resolve %s", host);
+        return false;
+    }
+
+    memcpy(&link->peer, result->ai_addr, sizeof(link->peer));
+    link->peer.sin_port = htons(port);
+    link->hasPeer = true;
+
+    freeaddrinfo(result);
+    return true;
+}
+
+unsigned short GetNetLinkPort(const NetLink *link)
+{
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+
+    if (getsockname(link->socket, (struct sockaddr *)&address, &length) < 0) return 0;
+    return ntohs(address.sin_port);
+}
+
+void SendNetPacket(NetLink *link, const void *data, int size, double now)
+{
+    if (!link->hasPeer || size > NET_MAX_PACKET) return;
+
+    // the loss happens here, as if the packet got lost on the way
+    if (link->conditions.lossPercent > 0.0f && NetRandomFloat(link) * 100.0f < link->conditions.lossPercent)
+    {
+        link->packetsDropped++;
+        return;
+    }
+
+    if (link->queued == NET_DELAY_QUEUE)
+    {
+        link->packetsDropped++;
+        return;
+    }
+
+    float delayMs = link->conditions.latencyMs + link->conditions.jitterMs * (NetRandomFloat(link) * 2.0f - 1.0f);
+
+    DelayedPacket *packet = &link->queue[link->queued++];
+    packet->sendAt = now + (delayMs > 0.0f ? delayMs / 1000.0 : 0.0);
+    packet->size = size;
+    memcpy(packet->data, data, size);
+
+    FlushNetLink(link, now);
+}
+
+void FlushNetLink(NetLink *link, double now)
+{
+    // jitter means packets can overtake each other, so look at all of them and not just the first
+    int kept = 0;
+    for (int i = 0; i < link->queued; i++)
+    {
+        DelayedPacket *packet = &link->queue[i];
+
+        if (packet->sendAt <= now)
+        {
+            if (sendto(link->socket, packet->data, packet->size, 0, (struct sockaddr *)&link->peer, sizeof(link->peer)) == packet->size)
+            {
+                link->packetsSent++;
+                link->bytesSent += packet->size;
+            }
+            else
+            {
+                link->packetsDropped++;
+            }
+        }
+        else
+        {
+            if (kept != i) link->queue[kept] = *packet;
+            kept++;
+        }
+    }
+    link->queued = kept;
+}
+
+int ReceiveNetPacket(NetLink *link, void *buffer, int size)
+{
+    struct sockaddr_in from;
+    socklen_t length = sizeof(from);
+
+    for (;;)
+    {
+        ssize_t received = recvfrom(link->socket, buffer, size, 0, (struct sockaddr *)&from, &length);
+        if (received < 0) return -1;    // EWOULDBLOCK, nothing waiting
+
+        // the first peer that talks to us is the one we play with, everyone else is ignored
+        if (!link->hasPeer)
+        {
+            link->peer = from;
+            link->hasPeer = true;
+        }
+        else if (from.sin_addr.s_addr != link->peer.sin_addr.s_addr || from.sin_port != link->peer.sin_port)
+        {
+            continue;
+        }
+
+        link->packetsReceived++;
+        link->bytesReceived += (unsigned long)received;
+        return (int)received;
+    }
+}
+
+void CloseNetLink(NetLink *link)
+{
+    if (link->socket >= 0) close(link->socket);
+    free(link->queue);
+    link->socket = -1;
+    link->queue = NULL;
+    link->queued = 0;
+}
@@ -0,0 +1,238 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-14 10:02:31
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-14 12:40:18
+*/
+
+/*
+ * Null audio device for the Asteroids game. When there is no sound card we still
+ * want the game to start and we still want to know which sounds would have been
+ * played and when, so instead of talking to the audio device we mix everything
+ * ourselves in memory, one simulation tick at a time. The mix only depends on
+ * which sounds were triggered on which tick, so two runs of the same game give
+ * the exact same WAV file which makes it possible to diff them.
+ */
+
+#include "nullaudio.h"
+#include <raylib.h>
+#include <stdlib.h>
+#include <string.h>
+
+void InitNullAudio(NullAudioDevice *device, bool capture)
+{
+    // everything starts empty, waves get filled in by the loaders
+    memset(device, 0, sizeof(*device));
+    device->capture = capture;
+}
+
+void CloseNullAudio(NullAudioDevice *device)
+{
+    for (int i = 0; i < NULL_AUDIO_MAX_WAVES; i++) {
+        if (device->waves[i].data != NULL) {
+            UnloadWave(device->waves[i]);
+        }
+    }
+
+    for (int i = 0; i < NULL_AUDIO_MUSIC_TRACKS; i++) {
+        if (device->music[i].data != NULL) {
+            UnloadWave(device->music[i]);
+        }
+    }
+
+    free(device->output);
+    memset(device, 0, sizeof(*device));
+}
+
+// Loads a file and converts it into the format the mixer works in (44.1kHz, 16-bit, stereo)
+static bool LoadMixerWave(Wave *wave, const char *fileName)
+{
+    if (!FileExists(fileName)) return false;
+
+    Wave loaded = LoadWave(fileName);
+    if (loaded.data == NULL || loaded.frameCount == 0) {
+        UnloadWave(loaded);
+        return false;
+    }
+
+    WaveFormat(&loaded, NULL_AUDIO_SAMPLE_RATE, 16, NULL_AUDIO_CHANNELS);
+    *wave = loaded;
+    return true;
+}
+
+bool LoadNullAudioWave(NullAudioDevice *device, int slot, const char *fileName)
+{
+    if (slot < 0 || slot >= NULL_AUDIO_MAX_WAVES) return false;
+
+    if (!LoadMixerWave(&device->waves[slot], fileName)) return false;
+
+    device->voices[slot].samples = device->waves[slot].data;
+    device->voices[slot].frameCount = device->waves[slot].frameCount;
+    device->voices[slot].volume = 1.0f;
+    return true;
+}
+
+bool LoadNullAudioMusic(NullAudioDevice *device, int track, const char *fileName)
+{
+    if (track < 0 || track >= NULL_AUDIO_MUSIC_TRACKS) return false;
+
+    if (!LoadMixerWave(&device->music[track], fileName)) return false;
+
+    // music loops by default, same as raylib music streams
+    device->musicVoices[track].samples = device->music[track].data;
+    device->musicVoices[track].frameCount = device->music[track].frameCount;
+    device->musicVoices[track].volume = 1.0f;
+    device->musicVoices[track].looping = true;
+    return true;
+}
+
+void PlayNullAudioWave(NullAudioDevice *device, int slot, float volume)
+{
+    if (slot < 0 || slot >= NULL_AUDIO_MAX_WAVES || device->voices[slot].samples == NULL) return;
+
+    // like PlaySound() a sound that is already playing starts again from the beginning
+    device->voices[slot].cursor = 0;
+    device->voices[slot].volume = volume;
+    device->voices[slot].playing = true;
+}
+
+void PlayNullAudioMusic(NullAudioDevice *device, int track, float volume)
+{
+    if (track < 0 || track >= NULL_AUDIO_MUSIC_TRACKS || device->musicVoices[track].samples == NULL) return;
+
+    // music keeps its position so playing after a pause carries on where it was
+    device->musicVoices[track].volume = volume;
+    device->musicVoices[track].playing = true;
+}
+
+void StopNullAudioMusic(NullAudioDevice *device, int track)
+{
+    if (track < 0 || track >= NULL_AUDIO_MUSIC_TRACKS) return;
+
+    device->musicVoices[track].playing = false;
+    device->musicVoices[track].cursor = 0;
+}
+
+void PauseNullAudioMusic(NullAudioDevice *device, int track)
+{
+    if (track < 0 || track >= NULL_AUDIO_MUSIC_TRACKS) return;
+
+    device->musicVoices[track].playing = false;
+}
+
+void SetNullAudioMusicVolume(NullAudioDevice *device, int track, float volume)
+{
+    if (track < 0 || track >= NULL_AUDIO_MUSIC_TRACKS) return;
+
+    device->musicVoices[track].volume = volume;
+}
+
+bool IsNullAudioMusicPlaying(NullAudioDevice *device, int track)
+{
+    if (track < 0 || track >= NULL_AUDIO_MUSIC_TRACKS) return false;
+
+    return device->musicVoices[track].playing;
+}
+
+// Adds a voice on top of the accumulation buffer, returns nothing but moves the voice cursor
+static void MixVoice(NullAudioVoice *voice, int *accumulator, unsigned int frames)
+{
+    if (!voice->playing || voice->samples == NULL) return;
+
+    // volume is applied in 8.8 fixed point so the result never depends on float rounding
+    int gain = (int)(voice->volume * 256.0f + 0.5f);
+    unsigned int written = 0;
+
+    while (written < frames && voice->playing)
+    {
+        unsigned int available = voice->frameCount - voice->cursor;
+        unsigned int count = frames - written;
+        if (count > available) count = available;
+
+        const short *src = voice->samples + (size_t)voice->cursor * NULL_AUDIO_CHANNELS;
+        int *dst = accumulator + (size_t)written * NULL_AUDIO_CHANNELS;
+
+        for (unsigned int i = 0; i < count * NULL_AUDIO_CHANNELS; i++) {
+            dst[i] += (src[i] * gain) >> 8;
+        }
+
+        written += count;
+        voice->cursor += count;
+
+        if (voice->cursor >= voice->frameCount) {
+            voice->cursor = 0;
+            if (!voice->looping) voice->playing = false;
+        }
+    }
+}
+
+// Makes sure the captured output has room for the given amount of extra frames
+static bool ReserveOutput(NullAudioDevice *device, unsigned int frames)
+{
+    unsigned int needed = device->outputFrames + frames;
+    if (needed <= device->outputCapacity) return true;
+
+    unsigned int capacity = device->outputCapacity ? device->outputCapacity : NULL_AUDIO_SAMPLE_RATE;
+    while (capacity < needed) capacity *= 2;
+
+    short *grown = realloc(device->output, (size_t)capacity * NULL_AUDIO_CHANNELS * sizeof(short));
+    if (grown == NULL) return false;
+
+    device->output = grown;
+    device->outputCapacity = capacity;
+    return true;
+}
+
+void MixNullAudio(NullAudioDevice *device, unsigned int frames)
+{
+    // one simulation tick is only a few hundred frames so a stack buffer is plenty
+    enum { CHUNK_FRAMES = 1024 };
+    int accumulator[CHUNK_FRAMES * NULL_AUDIO_CHANNELS];
+
+    double start = GetTime();
+
+    while (frames > 0)
+    {
+        unsigned int count = frames > CHUNK_FRAMES ? CHUNK_FRAMES : frames;
+        memset(accumulator, 0, sizeof(int) * count * NULL_AUDIO_CHANNELS);
+
+        for (int i = 0; i < NULL_AUDIO_MUSIC_TRACKS; i++) {
+            MixVoice(&device->musicVoices[i], accumulator, count);
+        }
+
+        for (int i = 0; i < NULL_AUDIO_MAX_WAVES; i++) {
+            MixVoice(&device->voices[i], accumulator, count);
+        }
+
+        if (device->capture && ReserveOutput(device, count))
+        {
+            short *out = device->output + (size_t)device->outputFrames * NULL_AUDIO_CHANNELS;
+            for (unsigned int i = 0; i < count * NULL_AUDIO_CHANNELS; i++) {
+                // clip instead of wrapping around when several sounds overlap
+                int sample = accumulator[i];
+                out[i] = (short)(sample > 32767 ? 32767 : (sample < -32768 ? -32768 : sample));
+            }
+            device->outputFrames += count;
+        }
+
+        device->mixedFrames += count;
+        frames -= count;
+    }
+
+    device->mixSeconds += GetTime() - start;
+}
+
+bool ExportNullAudio(NullAudioDevice *device, const char *fileName)
+{
+    if (!device->capture || device->output == NULL) return false;
+
+    Wave wave = {
+        .frameCount = device->outputFrames,
+        .sampleRate = NULL_AUDIO_SAMPLE_RATE,
+        .sampleSize = 16,
+        .channels = NULL_AUDIO_CHANNELS,
+        .data = device->output
+    };
+
+    return ExportWave(wave, fileName);
+}
@@ -0,0 +1,202 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-26 09:48:30
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-26 13:57:11
+*/
+
+/*
+ * The frame pacer, see pacing.h. The sleeps are nanosleep, which can wake up a good deal after
+ * the time asked for, so the low latency mode keeps track of how late they have been and stops
+ * sleeping that much (and a bit) before the deadline, spinning on the clock for the rest.
+ */
+
+#include "pacing.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+static const char *modeNames[PACE_MODE_COUNT] = {
+    [PACE_POWER_SAVING] = "power",
+    [PACE_LOW_LATENCY]  = "latency",
+    [PACE_UNCAPPED]     = "uncapped",
+};
+
+double PacerSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void SleepSeconds(double seconds)
+{
+    if (seconds <= 0.0) return;
+
+    struct timespec ts;
+    ts.tv_sec = (time_t)seconds;
+    ts.tv_nsec = (long)((seconds - (double)ts.tv_sec) * 1e9);
+    nanosleep(&ts, NULL);
+}
+
+void InitFramePacer(FramePacer *pacer, PaceMode mode, double period)
+{
+    memset(pacer, 0, sizeof(*pacer));
+    pacer->mode = mode;
+    pacer->period = period;
+    pacer->spinSeconds = 0.001;
+}
+
+bool PaceModeFromName(const char *name, PaceMode *mode)
+{
+    for (int m = 0; m < PACE_MODE_COUNT; m++)
+    {
+        if (strcmp(name, modeNames[m]) == 0)
+        {
+            *mode = (PaceMode)m;
+            return true;
+        }
+    }
+    return false;
+}
+
+const char *PaceModeName(PaceMode mode)
+{
+    return mode >= 0 && mode < PACE_MODE_COUNT ? modeNames[mode] : "?";
+}
+
+bool PaceModeWantsVsync(PaceMode mode)
+{
+    return mode == PACE_POWER_SAVING;
+}
+
+// Vsync is doing the pacing when the swaps block, without it they only hand the frame over
+static bool SwapIsPacing(const FramePacer *pacer)
+{
+    return pacer->mode == PACE_POWER_SAVING && pacer->swapAverage > PACE_SWAP_BLOCKING;
+}
+
+double PacerTimeLeft(const FramePacer *pacer)
+{
+    if (pacer->mode == PACE_UNCAPPED || pacer->deadline <= 0.0) return 0.0;
+
+    double left = pacer->deadline - PacerSeconds();
+    return left > 0.0 ? left : 0.0;
+}
+
+void WaitForFrameDeadline(FramePacer *pacer)
+{
+    double now = PacerSeconds();
+    pacer->swapStart = now;
+    if (pacer->mode == PACE_UNCAPPED || pacer->deadline <= 0.0 || SwapIsPacing(pacer)) return;
+
+    double stopSleeping = pacer->deadline - (pacer->mode == PACE_LOW_LATENCY ? pacer->spinSeconds : 0.0);
+
+    // sleeping, as long as there is more than the spin left
+    while (now < stopSleeping)
+    {
+        double asked = stopSleeping - now;
+        double before = now;
+        SleepSeconds(asked);
+        now = PacerSeconds();
+        pacer->sleptSeconds += now - before;
+
+        // how late it woke up, straight up and slowly back down like the input latch's estimate
+        double late = (now - before) - asked;
+        pacer->oversleep = late > pacer->oversleep ? late : pacer->oversleep + (late - pacer->oversleep) * 0.02;
+    }
+
+    if (pacer->mode == PACE_LOW_LATENCY)
+    {
+        double spinStart = now;
+        while (now < pacer->deadline) now = PacerSeconds();
+        pacer->spunSeconds += now - spinStart;
+
+        double spin = pacer->oversleep * 1.25 + PACE_MIN_SPIN;
+        pacer->spinSeconds = spin < PACE_MIN_SPIN ? PACE_MIN_SPIN : (spin > PACE_MAX_SPIN ? PACE_MAX_SPIN : spin);
+    }
+    pacer->swapStart = now;
+}
+
+void FramePresented(FramePacer *pacer)
+{
+    double now = PacerSeconds();
+
+    if (pacer->lastPresent > 0.0)
+    {
+        double interval = now - pacer->lastPresent;
+        double error = interval - pacer->period;
+
+        int bucket = (int)floor((error - PACE_HISTOGRAM_LOW) / PACE_BUCKET_SECONDS);
+        pacer->histogram[bucket < 0 ? 0 : (bucket >= PACE_HISTOGRAM_BUCKETS ? PACE_HISTOGRAM_BUCKETS - 1 : bucket)]++;
+        pacer->errorSum += error;
+        pacer->errorSquares += error * error;
+        if (fabs(error) > fabs(pacer->worstError)) pacer->worstError = error;
+
+        pacer->intervalAverage = pacer->frames == 0 ? interval : pacer->intervalAverage + (interval - pacer->intervalAverage) * 0.05;
+        pacer->frames++;
+    }
+    pacer->lastPresent = now;
+    if (pacer->swapStart > 0.0) pacer->swapAverage += (now - pacer->swapStart - pacer->swapAverage) * 0.1;
+    if (pacer->mode == PACE_UNCAPPED) return;
+
+    // a period after this frame's deadline, or after the swap when the display sets the time.
+    // A frame that missed its deadline starts the schedule again from where it went out, the
+    // next frame gets a whole period rather than what is left of one
+    bool late = pacer->deadline > 0.0 && now > pacer->deadline + PACE_LATE_SECONDS;
+    if (late) pacer->longFrames++;
+
+    if (pacer->deadline <= 0.0 || late || SwapIsPacing(pacer)) pacer->deadline = now + pacer->period;
+    else pacer->deadline += pacer->period;
+}
+
+double PacingErrorMean(const FramePacer *pacer)
+{
+    return pacer->frames > 0 ? pacer->errorSum / pacer->frames : 0.0;
+}
+
+double PacingErrorSpread(const FramePacer *pacer)
+{
+    if (pacer->frames == 0) return 0.0;
+
+    double mean = PacingErrorMean(pacer);
+    double variance = pacer->errorSquares / pacer->frames - mean * mean;
+    return variance > 0.0 ? sqrt(variance) : 0.0;
+}
+
+// A line per bucket that has anything in it, with a bar scaled to the fullest one
+void PrintPacingReport(const FramePacer *pacer)
+{
+    printf("Frame pacing: %s, %lu frames, interval error mean %+.3f ms spread %.3f ms worst %+.3f ms, %lu late\n",
+           PaceModeName(pacer->mode), pacer->frames, PacingErrorMean(pacer) * 1000.0, PacingErrorSpread(pacer) * 1000.0,
+           pacer->worstError * 1000.0, pacer->longFrames);
+    printf("  slept %.1f ms and spun %.2f ms per frame\n",
+           pacer->frames > 0 ? pacer->sleptSeconds * 1000.0 / pacer->frames : 0.0,
+           pacer->frames > 0 ? pacer->spunSeconds * 1000.0 / pacer->frames : 0.0);
+
+    unsigned long fullest = 1;
+    for (int b = 0; b < PACE_HISTOGRAM_BUCKETS; b++)
+    {
+        if (pacer->histogram[b] > fullest) fullest = pacer->histogram[b];
+    }
+
+    for (int b = 0; b < PACE_HISTOGRAM_BUCKETS; b++)
+    {
+        if (pacer->histogram[b] == 0) continue;
+
+        double from = (PACE_HISTOGRAM_LOW + b * PACE_BUCKET_SECONDS) * 1000.0;
+        double to = from + PACE_BUCKET_SECONDS * 1000.0;
+        char range[32];
+        if (b == 0) snprintf(range, sizeof(range), "under %+.1f", to);
+        else if (b == PACE_HISTOGRAM_BUCKETS - 1) snprintf(range, sizeof(range), "over %+.1f", from);
+        else snprintf(range, sizeof(range), "%+.1f to %+.1f", from, to);
+
+        char bar[41];
+        int length = (int)(pacer->histogram[b] * 40 / fullest);
+        memset(bar, '#', length);
+        bar[length] = '\0';
+
+        printf("  %-15s ms %7lu %s\n", range, pacer->histogram[b], bar);
+    }
+}
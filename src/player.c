@@ -14,41 +14,111 @@
 #include "bullet.h"
 #include "raylib.h"
 #include "utils.h"
+#include "fixed.h"
+#include "trig.h"
+#include "tunables.h"
 #include <math.h>
 
-// External globals for screen dimensions
-extern int screenWidth;
-extern int screenHeight;
+_Static_assert(sizeof(ShipState) == 20, "componentSize[COMPONENT_SHIP] in ecs.c has to match ShipState");
 
-// Control modes
-#define CONTROL_KEYBOARD 0
-#define CONTROL_MOUSE    1
-
-void InitPlayer(Player *player)
+void InitPlayer(EcsWorld *world, int ship)
 {
+    Player player;
+
     // Setting up initially
-    player->position = (Vector2){ screenWidth / 2, screenHeight / 2};
-    player->velocity = (Vector2){ 0, 0 };
-    player->rotation = 0;
-    player->rotationVelocity = 0;          // Add rotation velocity for smooth turning
-    player->isThrusting = false;
-    player->shootCooldown = 0;
-    player->controlMode = CONTROL_KEYBOARD; // Default to keyboard controls
+    player.position = (Vector2){ worldWidth / 2, worldHeight / 2};
+    player.velocity = (Vector2){ 0, 0 };
+    player.rotation = 0;
+    player.rotationVelocity = 0;          // Add rotation velocity for smooth turning
+    player.isThrusting = false;
+    player.shootCooldown = 0;
+    player.controlMode = CONTROL_KEYBOARD; // Default to keyboard controls
+    PutPlayer(world, ship, &player);
+}
+
+// Gathers the ship out of its columns, a world without that ship gives one that is all zeros
+Player GetPlayer(const EcsWorld *world, int ship)
+{
+    Player player = { 0 };
+    EntityId entity = EcsEntityAt(world, SHIP_COMPONENTS, ship);
+    if (entity == ECS_NO_ENTITY) return player;
+
+    const ShipState *state = EcsGet(world, entity, COMPONENT_SHIP);
+    player.position = *(const Vector2 *)EcsGet(world, entity, COMPONENT_POSITION);
+    player.velocity = *(const Vector2 *)EcsGet(world, entity, COMPONENT_VELOCITY);
+    player.rotation = state->rotation;
+    player.rotationVelocity = state->rotationVelocity;
+    player.isThrusting = state->isThrusting;
+    player.shootCooldown = state->shootCooldown;
+    player.controlMode = state->controlMode;
+    return player;
 }
 
-// Now we update the player
-void UpdatePlayer(Player *player, Bullet bullets[])
+// Field by field, the padding in ShipState stays the zeros it was spawned with and snapshots stay comparable
+void PutPlayer(EcsWorld *world, int ship, const Player *player)
 {
+    EntityId entity = EcsEntityAt(world, SHIP_COMPONENTS, ship);
+    if (entity == ECS_NO_ENTITY) entity = EcsSpawnAt(world, SHIP_COMPONENTS, ship);
+    if (entity == ECS_NO_ENTITY) return;
+
+    ShipState *state = EcsGet(world, entity, COMPONENT_SHIP);
+    *(Vector2 *)EcsGet(world, entity, COMPONENT_POSITION) = player->position;
+    *(Vector2 *)EcsGet(world, entity, COMPONENT_VELOCITY) = player->velocity;
+    state->rotation = player->rotation;
+    state->rotationVelocity = player->rotationVelocity;
+    state->isThrusting = player->isThrusting;
+    state->shootCooldown = player->shootCooldown;
+    state->controlMode = player->controlMode;
+}
+
+// Reads the keyboard and mouse into the input struct, the simulation itself never touches the devices
+PlayerInput ReadPlayerInput(const Player *player)
+{
+    PlayerInput input = { 0 };
+
+    input.toggleControlMode = IsKeyPressed(KEY_M);
+    input.aimTarget = ScreenToWorld(GetMousePosition());
+
+    if (player->controlMode == CONTROL_KEYBOARD) {
+        input.rotateLeft = IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A);
+        input.rotateRight = IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D);
+        input.thrust = IsKeyDown(KEY_UP) || IsKeyDown(KEY_W);
+        input.shoot = IsKeyDown(KEY_SPACE) || IsKeyPressed(KEY_SPACE);
+    } else {
+        input.thrust = IsMouseButtonDown(MOUSE_RIGHT_BUTTON);
+        input.shoot = IsMouseButtonDown(MOUSE_LEFT_BUTTON);
+    }
+
+    return input;
+}
+
+// The ship physics come in two versions, the build picks one (make FIXED_SIM=1 for fixed point)
+void UpdatePlayer(EcsWorld *world, int ship, const PlayerInput *input)
+{
+#ifdef FIXED_SIM
+    UpdatePlayerFixed(world, ship, input);
+#else
+    UpdatePlayerFloat(world, ship, input);
+#endif
+}
+
+// Now we update the player, on a copy gathered out of its columns that goes back in at the end
+void UpdatePlayerFloat(EcsWorld *world, int ship, const PlayerInput *input)
+{
+    Player gathered = GetPlayer(world, ship);
+    Player *player = &gathered;
+
+
     // Handle control mode switching
-    if (IsKeyPressed(KEY_M)) {
+    if (input->toggleControlMode) {
         player->controlMode = (player->controlMode == CONTROL_KEYBOARD) ? 
                                CONTROL_MOUSE : CONTROL_KEYBOARD;
     }
     
     if (player->controlMode == CONTROL_KEYBOARD) {
-        UpdatePlayerKeyboard(player, bullets);
+        UpdatePlayerKeyboard(player, world, ship, input);
     } else {
-        UpdatePlayerMouse(player, bullets);
+        UpdatePlayerMouse(player, world, ship, input);
     }
     
     // Apply velocities to position (common for both control modes)
@@ -56,8 +126,8 @@ void UpdatePlayer(Player *player, Bullet bullets[])
     player->position.y += player->velocity.y; 
     
     // Apply dampening (space drag)
-    player->velocity.x *= SHIP_DRAG;
-    player->velocity.y *= SHIP_DRAG;
+    player->velocity.x *= ActiveTunables()->shipDrag;
+    player->velocity.y *= ActiveTunables()->shipDrag;
     
     // Apply rotation velocity and dampening for smooth rotation
     player->rotation += player->rotationVelocity;
@@ -74,18 +144,20 @@ void UpdatePlayer(Player *player, Bullet bullets[])
     if (player->shootCooldown > 0) {
         player->shootCooldown--;
     }
+
+    PutPlayer(world, ship, player);
 }
 
-void UpdatePlayerKeyboard(Player *player, Bullet bullets[])
+void UpdatePlayerKeyboard(Player *player, EcsWorld *world, int ship, const PlayerInput *input)
 {
     // Smoother rotation with acceleration
-    if (IsKeyDown(KEY_LEFT) || IsKeyDown(KEY_A)) {
+    if (input->rotateLeft) {
         // Add rotation acceleration with a cap
-        player->rotationVelocity = fmaxf(player->rotationVelocity - 0.3f, -ROTATION_SPEED);
+        player->rotationVelocity = fmaxf(player->rotationVelocity - 0.3f, -ActiveTunables()->rotationSpeed);
     } 
-    else if (IsKeyDown(KEY_RIGHT) || IsKeyDown(KEY_D)) {
+    else if (input->rotateRight) {
         // Add rotation acceleration with a cap
-        player->rotationVelocity = fminf(player->rotationVelocity + 0.3f, ROTATION_SPEED);
+        player->rotationVelocity = fminf(player->rotationVelocity + 0.3f, ActiveTunables()->rotationSpeed);
     }
     else {
         // If no keys are pressed, apply more dampening to stop rotation more quickly
@@ -93,15 +165,16 @@ void UpdatePlayerKeyboard(Player *player, Bullet bullets[])
     }
     
     // Handle thrusting with smoother acceleration
-    player->isThrusting = IsKeyDown(KEY_UP) || IsKeyDown(KEY_W);
+    player->isThrusting = input->thrust;
     if (player->isThrusting) {
         // Calculate the acceleration vector based on the ship's rotation
-        float cosA = cos(player->rotation * DEG2RAD);
-        float sinA = sin(player->rotation * DEG2RAD);
+        float cosA, sinA;
+        SinCosDegrees(player->rotation, &sinA, &cosA);
         
         // Apply acceleration with slightly increasing force for better control
-        float thrustFactor = SHIP_ACCELERATION * (1.0f + 0.1f * (fabsf(player->velocity.x) + fabsf(player->velocity.y)) / 10.0f);
-        thrustFactor = fminf(thrustFactor, SHIP_ACCELERATION * 1.5f); // Cap the boost
+        float acceleration = ActiveTunables()->shipAcceleration;
+        float thrustFactor = acceleration * (1.0f + 0.1f * (fabsf(player->velocity.x) + fabsf(player->velocity.y)) / 10.0f);
+        thrustFactor = fminf(thrustFactor, acceleration * 1.5f); // Cap the boost
         
         player->velocity.x += cosA * thrustFactor;
         player->velocity.y += sinA * thrustFactor;
@@ -115,16 +188,16 @@ void UpdatePlayerKeyboard(Player *player, Bullet bullets[])
     }
     
     // Shooting with keyboard
-    if ((IsKeyDown(KEY_SPACE) || IsKeyPressed(KEY_SPACE)) && player->shootCooldown == 0) {
-        ShootBullets(bullets, player->position, player->rotation);
-        player->shootCooldown = BULLET_COOLDOWN;
+    if (input->shoot && player->shootCooldown == 0) {
+        ShootBullets(world, ship, player->position, player->rotation);
+        player->shootCooldown = ActiveTunables()->bulletCooldown;
     }
 }
 
-void UpdatePlayerMouse(Player *player, Bullet bullets[])
+void UpdatePlayerMouse(Player *player, EcsWorld *world, int ship, const PlayerInput *input)
 {
     // Get mouse position
-    Vector2 mousePos = GetMousePosition();
+    Vector2 mousePos = input->aimTarget;
     
     // Calculate direction to mouse from player
     Vector2 direction = {
@@ -147,18 +220,19 @@ void UpdatePlayerMouse(Player *player, Bullet bullets[])
     player->rotationVelocity = angleDiff * 0.1f;
     
     // Cap rotation speed
-    if (player->rotationVelocity > ROTATION_SPEED)
-        player->rotationVelocity = ROTATION_SPEED;
-    if (player->rotationVelocity < -ROTATION_SPEED)
-        player->rotationVelocity = -ROTATION_SPEED;
+    float maxSpin = ActiveTunables()->rotationSpeed;
+    if (player->rotationVelocity > maxSpin)
+        player->rotationVelocity = maxSpin;
+    if (player->rotationVelocity < -maxSpin)
+        player->rotationVelocity = -maxSpin;
     
     // Right mouse button for thrust
-    player->isThrusting = IsMouseButtonDown(MOUSE_RIGHT_BUTTON);
+    player->isThrusting = input->thrust;
     if (player->isThrusting) {
-        float cosA = cos(player->rotation * DEG2RAD);
-        float sinA = sin(player->rotation * DEG2RAD);
-        player->velocity.x += cosA * SHIP_ACCELERATION;
-        player->velocity.y += sinA * SHIP_ACCELERATION;
+        float cosA, sinA;
+        SinCosDegrees(player->rotation, &sinA, &cosA);
+        player->velocity.x += cosA * ActiveTunables()->shipAcceleration;
+        player->velocity.y += sinA * ActiveTunables()->shipAcceleration;
         
         // Cap maximum velocity for better control
         float currentSpeed = sqrtf(player->velocity.x * player->velocity.x + player->velocity.y * player->velocity.y);
@@ -169,59 +243,212 @@ void UpdatePlayerMouse(Player *player, Bullet bullets[])
     }
     
     // Left mouse button for shooting
-    if (IsMouseButtonDown(MOUSE_LEFT_BUTTON) && player->shootCooldown == 0) {
-        ShootBullets(bullets, player->position, player->rotation);
-        player->shootCooldown = BULLET_COOLDOWN;
+    if (input->shoot && player->shootCooldown == 0) {
+        ShootBullets(world, ship, player->position, player->rotation);
+        player->shootCooldown = ActiveTunables()->bulletCooldown;
+    }
+}
+
+// The ship triangle in screen space, nose first, shared by drawing and the collision test
+void GetShipTriangle(const Player *player, Vector2 vertices[3])
+{
+#ifdef FIXED_SIM
+    GetShipTriangleFixed(player, vertices);
+#else
+    GetShipTriangleFloat(player, vertices);
+#endif
+}
+
+void GetShipTriangleFloat(const Player *player, Vector2 vertices[3])
+{
+    float cosA, sinA;
+    SinCosDegrees(player->rotation, &sinA, &cosA);
+
+    // the back corners are 2.5 radians either side of the nose, turned by cos(2.5) and sin(2.5)
+    // instead of two more sine and cosine calls each
+    const float cosBack = -0.80114361554693370f;
+    const float sinBack = 0.59847214410395650f;
+    float backCos = cosA * cosBack, backSin = sinA * cosBack;
+
+    vertices[0].x = player->position.x + cosA * SHIP_SIZE;
+    vertices[0].y = player->position.y + sinA * SHIP_SIZE;
+
+    vertices[1].x = player->position.x + (backCos - sinA * sinBack) * SHIP_SIZE * 0.7f;
+    vertices[1].y = player->position.y + (backSin + cosA * sinBack) * SHIP_SIZE * 0.7f;
+
+    vertices[2].x = player->position.x + (backCos + sinA * sinBack) * SHIP_SIZE * 0.7f;
+    vertices[2].y = player->position.y + (backSin - cosA * sinBack) * SHIP_SIZE * 0.7f;
+}
+
+/*
+ * Fixed-point versions of the above (see fixed.h), the same physics step for step but in
+ * integers, so the ship flies exactly the same on every machine and with every compiler.
+ */
+
+// Keeps the ship under 5 pixels per tick, like the float version
+static void CapShipSpeedFixed(Fixed *vx, Fixed *vy)
+{
+    Fixed speed = FixedLength(*vx, *vy);
+    if (speed > FIXED_INT(5))
+    {
+        *vx = (Fixed)((int64_t)*vx * FIXED_INT(5) / speed);
+        *vy = (Fixed)((int64_t)*vy * FIXED_INT(5) / speed);
+    }
+}
+
+void UpdatePlayerFixed(EcsWorld *world, int ship, const PlayerInput *input)
+{
+    Player gathered = GetPlayer(world, ship);
+    Player *player = &gathered;
+
+    Fixed x = FixedFromFloat(player->position.x);
+    Fixed y = FixedFromFloat(player->position.y);
+    Fixed vx = FixedFromFloat(player->velocity.x);
+    Fixed vy = FixedFromFloat(player->velocity.y);
+    Fixed rotation = FixedFromFloat(player->rotation);              // degrees
+    Fixed spin = FixedFromFloat(player->rotationVelocity);
+
+    if (input->toggleControlMode) {
+        player->controlMode = (player->controlMode == CONTROL_KEYBOARD) ? CONTROL_MOUSE : CONTROL_KEYBOARD;
+    }
+
+    const Tunables *tune = ActiveTunables();
+    Fixed acceleration = FIXED_CONST(tune->shipAcceleration);
+    Fixed maxSpin = FIXED_CONST(tune->rotationSpeed);
+    if (player->controlMode == CONTROL_KEYBOARD) {
+        if (input->rotateLeft) {
+            spin = spin - FIXED_CONST(0.3) > -maxSpin ? spin - FIXED_CONST(0.3) : -maxSpin;
+        } else if (input->rotateRight) {
+            spin = spin + FIXED_CONST(0.3) < maxSpin ? spin + FIXED_CONST(0.3) : maxSpin;
+        } else {
+            spin = FixedMul(spin, FIXED_CONST(0.85));
+        }
+
+        // the faster we already go the harder the thrust pushes, up to 1.5 times
+        acceleration += (Fixed)((int64_t)acceleration * (FixedAbs(vx) + FixedAbs(vy)) / FIXED_INT(100));
+        Fixed boosted = FIXED_CONST((double)tune->shipAcceleration * 1.5);
+        if (acceleration > boosted) acceleration = boosted;
+    } else {
+        // turn towards the mouse, a tenth of the way per tick
+        BinaryAngle target = FixedAtan2(FixedFromFloat(input->aimTarget.y) - y, FixedFromFloat(input->aimTarget.x) - x);
+        Fixed angleDiff = (Fixed)target * 360 - rotation;           // binary angle to degrees
+        if (angleDiff > FIXED_INT(180)) angleDiff -= FIXED_INT(360);
+        if (angleDiff < -FIXED_INT(180)) angleDiff += FIXED_INT(360);
+
+        spin = FixedMul(angleDiff, FIXED_CONST(0.1));
+        if (spin > maxSpin) spin = maxSpin;
+        if (spin < -maxSpin) spin = -maxSpin;
+    }
+
+    player->isThrusting = input->thrust;
+    if (player->isThrusting) {
+        BinaryAngle heading = FixedDegreesToAngle(rotation);
+        vx += FixedMul(FixedCos(heading), acceleration);
+        vy += FixedMul(FixedSin(heading), acceleration);
+        CapShipSpeedFixed(&vx, &vy);
+    }
+
+    if (input->shoot && player->shootCooldown == 0) {
+        ShootBulletsFixed(world, ship, player->position, player->rotation);
+        player->shootCooldown = ActiveTunables()->bulletCooldown;
+    }
+
+    x += vx;
+    y += vy;
+    vx = FixedMul(vx, FIXED_CONST(tune->shipDrag));
+    vy = FixedMul(vy, FIXED_CONST(tune->shipDrag));
+
+    rotation += spin;
+    spin = FixedMul(spin, FIXED_CONST(0.9));
+    if (rotation > FIXED_INT(360)) rotation -= FIXED_INT(360);
+    if (rotation < 0) rotation += FIXED_INT(360);
+
+    player->position.x = FixedToFloat(FixedWrapCoordinate(x, FIXED_INT(worldWidth)));
+    player->position.y = FixedToFloat(FixedWrapCoordinate(y, FIXED_INT(worldHeight)));
+    player->velocity = (Vector2){ FixedToFloat(vx), FixedToFloat(vy) };
+    player->rotation = FixedToFloat(rotation);
+    player->rotationVelocity = FixedToFloat(spin);
+
+    if (player->shootCooldown > 0) {
+        player->shootCooldown--;
+    }
+
+    PutPlayer(world, ship, player);
+}
+
+void GetShipTriangleFixed(const Player *player, Vector2 vertices[3])
+{
+    Fixed x = FixedFromFloat(player->position.x);
+    Fixed y = FixedFromFloat(player->position.y);
+    BinaryAngle heading = FixedDegreesToAngle(FixedFromFloat(player->rotation));
+    BinaryAngle back = FixedRadiansToAngle(FIXED_CONST(2.5));      // the two back corners, 2.5 radians either side of the nose
+    BinaryAngle corners[3] = { heading, (BinaryAngle)(heading + back), (BinaryAngle)(heading - back) };
+    Fixed sizes[3] = { FIXED_INT(SHIP_SIZE), FIXED_CONST(SHIP_SIZE * 0.7), FIXED_CONST(SHIP_SIZE * 0.7) };
+
+    for (int i = 0; i < 3; i++)
+    {
+        vertices[i].x = FixedToFloat(x + FixedMul(FixedCos(corners[i]), sizes[i]));
+        vertices[i].y = FixedToFloat(y + FixedMul(FixedSin(corners[i]), sizes[i]));
     }
 }
 
 void DrawPlayer(Player player)
 {
-    Vector2 v1, v2, v3;
-    float cosA = cos(player.rotation * DEG2RAD);
-    float sinA = sin(player.rotation * DEG2RAD);
-    
-    // Draw the ship triangle
-    v1.x = player.position.x + cosA * SHIP_SIZE;
-    v1.y = player.position.y + sinA * SHIP_SIZE;
+    DrawPlayerColored(player, WHITE);
+}
 
-    v2.x = player.position.x + cos(player.rotation * DEG2RAD + 2.5f) * SHIP_SIZE * 0.7f;
-    v2.y = player.position.y + sin(player.rotation * DEG2RAD + 2.5f) * SHIP_SIZE * 0.7f;
+// Same as DrawPlayer, the second ship in a versus game is drawn in another color
+void DrawPlayerColored(Player player, Color color)
+{
+    Vector2 ship[3];
+    float cosA, sinA;
+    SinCosDegrees(player.rotation, &sinA, &cosA);
+    GetShipTriangle(&player, ship);
 
-    v3.x = player.position.x + cos(player.rotation * DEG2RAD - 2.5f) * SHIP_SIZE * 0.7f;
-    v3.y = player.position.y + sin(player.rotation * DEG2RAD - 2.5f) * SHIP_SIZE * 0.7f;
+    // Animated flame length, picked once so the copies over the edges flicker together
+    float flameLength = player.isThrusting ? SHIP_SIZE * GetRandomValue(5, 15) / 10.0f : 0.0f;
 
-    DrawTriangleLines(v1, v2, v3, WHITE);
+    // the flame reaches two ship sizes back, near an edge the ship is drawn on the other side too
+    Vector2 offsets[EDGE_COPIES];
+    int copies = ViewImageOffsets(player.position, SHIP_SIZE * 2.0f, offsets);
+    if (copies == 0) return;
 
-    // Draw the thrust flame with animated size for visual feedback
-    if (player.isThrusting)
+    for (int c = 0; c < copies; c++)
     {
-        Vector2 thrustPos;
-        thrustPos.x = player.position.x - cosA * SHIP_SIZE * 0.5f;
-        thrustPos.y = player.position.y - sinA * SHIP_SIZE * 0.5f;
+        Vector2 offset = offsets[c];
 
-        // Animated flame length
-        float flameLength = SHIP_SIZE * GetRandomValue(5, 15) / 10.0f;
-        
-        DrawLineEx(thrustPos, 
-                  (Vector2) { 
-                      thrustPos.x - cosA * flameLength,
-                      thrustPos.y - sinA * flameLength
-                  }, 
-                  3.0f, YELLOW);
-                  
-        // Add a second, shorter flame line for visual effect
-        DrawLineEx(thrustPos, 
-                  (Vector2) { 
-                      thrustPos.x - cosA * flameLength * 0.7f + sinA * 3.0f,
-                      thrustPos.y - sinA * flameLength * 0.7f - cosA * 3.0f
-                  }, 
-                  2.0f, RED);
+        // Draw the ship triangle
+        DrawTriangleLines((Vector2){ ship[0].x + offset.x, ship[0].y + offset.y },
+                          (Vector2){ ship[1].x + offset.x, ship[1].y + offset.y },
+                          (Vector2){ ship[2].x + offset.x, ship[2].y + offset.y }, color);
+
+        // Draw the thrust flame with animated size for visual feedback
+        if (player.isThrusting)
+        {
+            Vector2 thrustPos;
+            thrustPos.x = player.position.x + offset.x - cosA * SHIP_SIZE * 0.5f;
+            thrustPos.y = player.position.y + offset.y - sinA * SHIP_SIZE * 0.5f;
+
+            DrawLineEx(thrustPos, 
+                      (Vector2) { 
+                          thrustPos.x - cosA * flameLength,
+                          thrustPos.y - sinA * flameLength
+                      }, 
+                      3.0f, YELLOW);
+                      
+            // Add a second, shorter flame line for visual effect
+            DrawLineEx(thrustPos, 
+                      (Vector2) { 
+                          thrustPos.x - cosA * flameLength * 0.7f + sinA * 3.0f,
+                          thrustPos.y - sinA * flameLength * 0.7f - cosA * 3.0f
+                      }, 
+                      2.0f, RED);
+        }
     }
     
     // Indicate control mode with a small indicator
     DrawText(player.controlMode == CONTROL_KEYBOARD ? "K" : "M", 
-             player.position.x - 5, 
-             player.position.y - SHIP_SIZE - 10, 
+             player.position.x + offsets[0].x - 5, 
+             player.position.y + offsets[0].y - SHIP_SIZE - 10, 
              10, GRAY);
 }
@@ -0,0 +1,327 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-20 17:41:26
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-20 21:08:53
+*/
+
+/*
+ * Seekable replays, see replay.h for the layout. The writer appends as the game is played and
+ * only goes back to the start of the file on close, to fill in the header once the index is
+ * written, so a crashed game leaves a file without an index and the reader refuses it.
+ *
+ * The reader maps the whole file. Opening it touches only the header and the index, a seek
+ * touches one keyframe and a few hundred bytes of inputs, so it costs the same at minute ten
+ * as at the start, and the page cache does the rest.
+ */
+
+#include "replay.h"
+#include "game.h"
+#include "snapshot.h"
+#include "utils.h"
+#include <raylib.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define BUTTON_ROTATE_LEFT  0x01
+#define BUTTON_ROTATE_RIGHT 0x02
+#define BUTTON_THRUST       0x04
+#define BUTTON_SHOOT        0x08
+#define BUTTON_TOGGLE_MODE  0x10
+
+static void PackInput(const PlayerInput *input, unsigned char out[REPLAY_INPUT_BYTES])
+{
+    // the aim is kept in whole pixels, which is what the mouse gives anyway. It is signed, past
+    // the edge of a scrolling world the mouse points at negative world coordinates
+    float aimX = input->aimTarget.x < -32768.0f ? -32768.0f : (input->aimTarget.x > 32767.0f ? 32767.0f : input->aimTarget.x);
+    float aimY = input->aimTarget.y < -32768.0f ? -32768.0f : (input->aimTarget.y > 32767.0f ? 32767.0f : input->aimTarget.y);
+    unsigned short x = (unsigned short)(short)aimX, y = (unsigned short)(short)aimY;
+
+    out[0] = (input->rotateLeft ? BUTTON_ROTATE_LEFT : 0) | (input->rotateRight ? BUTTON_ROTATE_RIGHT : 0) |
+             (input->thrust ? BUTTON_THRUST : 0) | (input->shoot ? BUTTON_SHOOT : 0) |
+             (input->toggleControlMode ? BUTTON_TOGGLE_MODE : 0);
+    out[1] = x & 0xFF;
+    out[2] = x >> 8;
+    out[3] = y & 0xFF;
+    out[4] = y >> 8;
+}
+
+static PlayerInput UnpackInput(const unsigned char in[REPLAY_INPUT_BYTES])
+{
+    PlayerInput input = { 0 };
+
+    input.rotateLeft = (in[0] & BUTTON_ROTATE_LEFT) != 0;
+    input.rotateRight = (in[0] & BUTTON_ROTATE_RIGHT) != 0;
+    input.thrust = (in[0] & BUTTON_THRUST) != 0;
+    input.shoot = (in[0] & BUTTON_SHOOT) != 0;
+    input.toggleControlMode = (in[0] & BUTTON_TOGGLE_MODE) != 0;
+    input.aimTarget = (Vector2){ (short)(in[1] | (in[2] << 8)), (short)(in[3] | (in[4] << 8)) };
+
+    return input;
+}
+
+static bool WriteBytes(ReplayWriter *writer, const void *data, size_t size)
+{
+    if (fwrite(data, 1, size, writer->file) != size) return false;
+    writer->offset += size;
+    return true;
+}
+
+// The snapshots are read straight out of the mapping, so they start on an 8 byte boundary
+static bool PadTo8(ReplayWriter *writer)
+{
+    static const unsigned char zeros[8] = { 0 };
+    size_t padding = (size_t)((8 - writer->offset % 8) % 8);
+    return WriteBytes(writer, zeros, padding);
+}
+
+static bool FinishSegment(ReplayWriter *writer)
+{
+    if (!writer->hasSegment) return true;
+
+    if (writer->header.keyframes == (uint32_t)writer->indexCapacity)
+    {
+        int capacity = writer->indexCapacity > 0 ? writer->indexCapacity * 2 : 64;
+        ReplayKeyframe *index = realloc(writer->index, sizeof(ReplayKeyframe) * capacity);
+        if (index == NULL) return false;
+        writer->index = index;
+        writer->indexCapacity = capacity;
+    }
+
+    writer->index[writer->header.keyframes++] = writer->segment;
+    writer->hasSegment = false;
+    return true;
+}
+
+static bool StartSegment(ReplayWriter *writer, const Game *game)
+{
+    if (!FinishSegment(writer) || !PadTo8(writer)) return false;
+
+    ReplayKeyframe *segment = &writer->segment;
+    memset(segment, 0, sizeof(*segment));
+    segment->tick = writer->header.ticks;
+    segment->worldWidth = (uint16_t)worldWidth;
+    segment->worldHeight = (uint16_t)worldHeight;
+    segment->asteroidLimit = (uint16_t)worldAsteroidLimit;
+    segment->snapshotOffset = writer->offset;
+
+    // zeroed first so the padding in the file doesn't depend on what was on the stack
+    memset(&writer->keyframe, 0, sizeof(writer->keyframe));
+    CaptureSimSnapshot(game, &writer->keyframe);
+    if (!WriteBytes(writer, &writer->keyframe, sizeof(writer->keyframe))) return false;
+
+    segment->inputsOffset = writer->offset;
+    writer->hasSegment = true;
+    return true;
+}
+
+bool OpenReplayWriter(ReplayWriter *writer, const char *path)
+{
+    memset(writer, 0, sizeof(*writer));
+
+    writer->file = fopen(path, "wb");
+    if (writer->file == NULL) return false;
+
+    writer->header.magic = REPLAY_MAGIC;
+    writer->header.version = REPLAY_VERSION;
+    writer->header.tickRate = GAME_TICK_RATE;
+    writer->header.screenWidth = (uint16_t)screenWidth;
+    writer->header.screenHeight = (uint16_t)screenHeight;
+    writer->header.snapshotSize = sizeof(SimSnapshot);
+
+    // written again with the counts and the index offset on close
+    if (!WriteBytes(writer, &writer->header, sizeof(writer->header)))
+    {
+        fclose(writer->file);
+        writer->file = NULL;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * A new keyframe every REPLAY_KEYFRAME_TICKS, and whenever the game didn't simply carry on from
+ * the last recorded tick: a new game, a rewind, or a different world size. The input is rounded
+ * to what the file keeps before the game uses it, otherwise mouse aim could play out differently.
+ */
+void RecordReplayTick(ReplayWriter *writer, const Game *game, PlayerInput *input)
+{
+    if (writer->file == NULL) return;
+
+    bool carriesOn = writer->hasSegment && game->tick == writer->expectedGameTick &&
+                     writer->segment.inputCount < REPLAY_KEYFRAME_TICKS &&
+                     writer->segment.worldWidth == worldWidth && writer->segment.worldHeight == worldHeight;
+
+    unsigned char bytes[REPLAY_INPUT_BYTES];
+    PackInput(input, bytes);
+    *input = UnpackInput(bytes);
+
+    if ((!carriesOn && !StartSegment(writer, game)) || !WriteBytes(writer, bytes, sizeof(bytes)))
+    {
+        // out of disk or memory, stop recording and keep what we have
+        CloseReplayWriter(writer);
+        return;
+    }
+
+    writer->segment.inputCount++;
+    writer->header.ticks++;
+    writer->expectedGameTick = game->tick + 1;
+}
+
+bool CloseReplayWriter(ReplayWriter *writer)
+{
+    if (writer->file == NULL) return false;
+
+    bool ok = FinishSegment(writer) && PadTo8(writer);
+    if (ok)
+    {
+        writer->header.indexOffset = writer->offset;
+        ok = WriteBytes(writer, writer->index, sizeof(ReplayKeyframe) * writer->header.keyframes) &&
+             fseek(writer->file, 0, SEEK_SET) == 0 && fwrite(&writer->header, sizeof(writer->header), 1, writer->file) == 1;
+    }
+
+    ok = fclose(writer->file) == 0 && ok;
+    writer->file = NULL;
+    free(writer->index);
+    writer->index = NULL;
+    return ok;
+}
+
+bool OpenReplay(Replay *replay, const char *path)
+{
+    memset(replay, 0, sizeof(*replay));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(ReplayHeader))
+    {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);                                  // the mapping keeps the file open
+    if (data == MAP_FAILED) return false;
+
+    replay->data = data;
+    replay->size = (size_t)info.st_size;
+    replay->header = data;
+
+    // everything the reader will ever look at has to be inside the file
+    const ReplayHeader *header = replay->header;
+    bool valid = header->magic == REPLAY_MAGIC && header->version == REPLAY_VERSION &&
+                 header->snapshotSize == sizeof(SimSnapshot) && header->indexOffset != 0 && header->indexOffset % 8 == 0 &&
+                 header->indexOffset + (uint64_t)header->keyframes * sizeof(ReplayKeyframe) <= replay->size;
+
+    if (valid)
+    {
+        replay->keyframes = (const ReplayKeyframe *)(replay->data + header->indexOffset);
+
+        uint32_t tick = 0;
+        for (uint32_t i = 0; i < header->keyframes && valid; i++)
+        {
+            const ReplayKeyframe *keyframe = &replay->keyframes[i];
+            valid = keyframe->tick == tick && keyframe->inputCount > 0 && keyframe->snapshotOffset % 8 == 0 &&
+                    keyframe->snapshotOffset + sizeof(SimSnapshot) <= keyframe->inputsOffset &&
+                    keyframe->inputsOffset + (uint64_t)keyframe->inputCount * REPLAY_INPUT_BYTES <= header->indexOffset &&
+                    keyframe->worldWidth > 0 && keyframe->worldHeight > 0 && keyframe->asteroidLimit <= MAX_ASTEROIDS;
+            tick += keyframe->inputCount;
+        }
+        valid = valid && tick == header->ticks && header->keyframes > 0;
+    }
+
+    if (!valid)
+    {
+        CloseReplay(replay);
+        return false;
+    }
+    return true;
+}
+
+void CloseReplay(Replay *replay)
+{
+    if (replay->data != NULL) munmap((void *)replay->data, replay->size);
+    memset(replay, 0, sizeof(*replay));
+}
+
+unsigned int ReplayTicks(const Replay *replay)
+{
+    return replay->header->ticks;
+}
+
+// Binary search over the index
+int FindReplayKeyframe(const Replay *replay, unsigned int tick)
+{
+    int low = 0, high = (int)replay->header->keyframes - 1;
+
+    while (low < high)
+    {
+        int middle = (low + high + 1) / 2;
+        if (replay->keyframes[middle].tick <= tick) low = middle;
+        else high = middle - 1;
+    }
+    return low;
+}
+
+static PlayerInput SegmentInput(const Replay *replay, const ReplayKeyframe *keyframe, unsigned int tick)
+{
+    return UnpackInput(replay->data + keyframe->inputsOffset + (size_t)(tick - keyframe->tick) * REPLAY_INPUT_BYTES);
+}
+
+PlayerInput GetReplayInput(const Replay *replay, unsigned int tick)
+{
+    PlayerInput none = { 0 };
+    if (tick >= replay->header->ticks) return none;
+
+    return SegmentInput(replay, &replay->keyframes[FindReplayKeyframe(replay, tick)], tick);
+}
+
+bool RestoreReplayKeyframe(const Replay *replay, int keyframe, Game *game)
+{
+    if (keyframe < 0 || keyframe >= (int)replay->header->keyframes) return false;
+
+    const ReplayKeyframe *entry = &replay->keyframes[keyframe];
+
+    // only written when it changes, export threads all share the one size
+    if (worldWidth != entry->worldWidth) worldWidth = entry->worldWidth;
+    if (worldHeight != entry->worldHeight) worldHeight = entry->worldHeight;
+    if (worldAsteroidLimit != entry->asteroidLimit) worldAsteroidLimit = entry->asteroidLimit;
+
+    RestoreSimSnapshot(game, (const SimSnapshot *)(replay->data + entry->snapshotOffset));
+    return true;
+}
+
+bool SeekReplay(const Replay *replay, unsigned int tick, Game *game)
+{
+    if (tick > replay->header->ticks) return false;
+
+    int keyframe = FindReplayKeyframe(replay, tick);
+    const ReplayKeyframe *entry = &replay->keyframes[keyframe];
+    if (!RestoreReplayKeyframe(replay, keyframe, game)) return false;
+
+    for (unsigned int t = entry->tick; t < tick; t++)
+    {
+        PlayerInput input = SegmentInput(replay, entry, t);
+        StepGameplay(game, &input);
+    }
+    return true;
+}
+
+// The first tick of a segment starts from its keyframe, that is where a new game or a rewind happened
+void StepReplay(const Replay *replay, unsigned int tick, Game *game)
+{
+    if (tick >= replay->header->ticks) return;
+
+    int keyframe = FindReplayKeyframe(replay, tick);
+    const ReplayKeyframe *entry = &replay->keyframes[keyframe];
+    if (tick == entry->tick) RestoreReplayKeyframe(replay, keyframe, game);
+
+    PlayerInput input = SegmentInput(replay, entry, tick);
+    StepGameplay(game, &input);
+}
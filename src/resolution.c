@@ -5,16 +5,18 @@
 * @Last Modified time: 2025-05-11 16:46:04
 */
 
+/*
+ * Window size and fullscreen. These only change the window: the game is drawn on a canvas of its
+ * own size (canvas.h) that gets scaled to whatever the window is, so screenWidth and screenHeight,
+ * the world and everything the simulation does stay the same.
+ */
+
 #include "resolution.h"
 #include "game.h"
 #include "raylib.h"
 #include "utils.h"
 #include <stdio.h>
 
-// External globals for screen dimensions that will be updated
-extern int screenWidth;
-extern int screenHeight;
-
 void InitResolutions(Game *game)
 {
     game->resolutions[0] = (Resolution) { 800, 600, "800x600" };
@@ -55,10 +57,6 @@ void ChangeResolution(Game *game, int newResolutionIndex)
         (displayHeight - newRes.height) / 2
     );
 
-    // Update screen dimension globals
-    screenWidth = newRes.width;
-    screenHeight = newRes.height;
-
     // Update current resolution index
     game->currentResolution = newResolutionIndex;
     
@@ -66,9 +64,6 @@ void ChangeResolution(Game *game, int newResolutionIndex)
     if (game->settings.fullscreen) {
         ToggleFullscreenMode(game);
     }
-
-    // Handle any additional adjustments needed
-    HandleResolutionChange(game);
 }
 
 void ToggleFullscreenMode(Game *game)
@@ -77,8 +72,8 @@ void ToggleFullscreenMode(Game *game)
     
     if (!IsWindowFullscreen()) {
         // Save current window dimensions before going fullscreen
-        game->defaultScreenWidth = screenWidth;
-        game->defaultScreenHeight = screenHeight;
+        game->defaultScreenWidth = GetScreenWidth();
+        game->defaultScreenHeight = GetScreenHeight();
         
         // Get monitor dimensions for proper fullscreen
         int monitorWidth = GetMonitorWidth(monitor);
@@ -91,10 +86,6 @@ void ToggleFullscreenMode(Game *game)
         // Toggle fullscreen
         ToggleFullscreen();
         
-        // Update screen dimensions to monitor size
-        screenWidth = monitorWidth;
-        screenHeight = monitorHeight;
-        
         // Update fullscreen flag
         game->settings.fullscreen = true;
     } else {
@@ -107,10 +98,6 @@ void ToggleFullscreenMode(Game *game)
         // Restore window size to the selected resolution
         SetWindowSize(currentRes.width, currentRes.height);
         
-        // Update screen dimensions
-        screenWidth = currentRes.width;
-        screenHeight = currentRes.height;
-        
         // Center window
         int displayWidth = GetMonitorWidth(monitor);
         int displayHeight = GetMonitorHeight(monitor);
@@ -122,19 +109,4 @@ void ToggleFullscreenMode(Game *game)
         // Update fullscreen flag
         game->settings.fullscreen = false;
     }
-    
-    // Apply necessary adjustments for the new screen size
-    HandleResolutionChange(game);
-}
-
-void HandleResolutionChange(Game *game)
-{
-    // Adjust game elements based on new resolution if needed
-    
-    // Reinitialize stars to fill the new screen dimensions
-    InitStars(game->stars);
-    
-    // Reset player to center of new screen
-    game->player.position.x = screenWidth / 2;
-    game->player.position.y = screenHeight / 2;
 }
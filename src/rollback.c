@@ -0,0 +1,422 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-18 13:20:05
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-18 19:44:31
+*/
+
+/*
+ * Rollback netcode. Both sides run the same simulation from the same seed and only send each
+ * other their inputs, a few bytes per tick. Nobody waits for the network: the other player's
+ * input for a tick we haven't heard about yet is guessed (they keep doing what they did last),
+ * and the state at the start of every tick is saved. When the real input arrives and the guess
+ * was wrong, we load the saved state of that tick and simulate up to now again with the right
+ * input. Most of the time players hold the same keys for many ticks in a row, so most guesses
+ * are right and there is nothing to redo.
+ *
+ * Every packet carries all of our inputs the other side hasn't acknowledged yet, so a lost
+ * packet is covered by the next one and no resending is needed. If we get too far ahead of
+ * what we know about the other side (ROLLBACK_MAX_PREDICTION ticks) we stop and wait for them.
+ *
+ * The simulation has to come out bit for bit the same on both sides. Both sides send a checksum
+ * of their newest confirmed state and compare them, anything different is counted as a desync.
+ */
+
+#include "rollback.h"
+#include "game.h"
+#include "net.h"
+#include "snapshot.h"
+#include <raylib.h>
+#include <raymath.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#define PACKET_HELLO    'H'                    // joining side asking for the seed
+#define PACKET_WELCOME  'W'                    // host answering with the seed
+#define PACKET_INPUTS   'I'                    // inputs, ack and checksum
+
+#define INPUT_HEADER_SIZE 18                   // type, first tick, count, ack, checksum tick, checksum
+#define NET_INPUT_SIZE    5
+
+// Button bits in NetInput
+#define BUTTON_ROTATE_LEFT   0x01
+#define BUTTON_ROTATE_RIGHT  0x02
+#define BUTTON_THRUST        0x04
+#define BUTTON_SHOOT         0x08
+#define BUTTON_TOGGLE_MODE   0x10
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Packets are little endian whatever the machine is
+static void PutU32(unsigned char *out, unsigned int value)
+{
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+    out[2] = (value >> 16) & 0xFF;
+    out[3] = (value >> 24) & 0xFF;
+}
+
+static unsigned int GetU32(const unsigned char *in)
+{
+    return in[0] | (in[1] << 8) | (in[2] << 16) | ((unsigned int)in[3] << 24);
+}
+
+static NetInput PackInput(const PlayerInput *input, bool mouseControl)
+{
+    NetInput packed = { 0 };
+
+    packed.buttons = (input->rotateLeft ? BUTTON_ROTATE_LEFT : 0) | (input->rotateRight ? BUTTON_ROTATE_RIGHT : 0) |
+                     (input->thrust ? BUTTON_THRUST : 0) | (input->shoot ? BUTTON_SHOOT : 0) |
+                     (input->toggleControlMode ? BUTTON_TOGGLE_MODE : 0);
+
+    // the aim only matters with mouse controls, leaving it out otherwise keeps the guesses right
+    if (mouseControl || input->toggleControlMode)
+    {
+        packed.aimX = (unsigned short)(short)Clamp(input->aimTarget.x, -32768.0f, 32767.0f);
+        packed.aimY = (unsigned short)(short)Clamp(input->aimTarget.y, -32768.0f, 32767.0f);
+    }
+
+    return packed;
+}
+
+static PlayerInput UnpackInput(NetInput packed)
+{
+    PlayerInput input = { 0 };
+
+    input.rotateLeft = (packed.buttons & BUTTON_ROTATE_LEFT) != 0;
+    input.rotateRight = (packed.buttons & BUTTON_ROTATE_RIGHT) != 0;
+    input.thrust = (packed.buttons & BUTTON_THRUST) != 0;
+    input.shoot = (packed.buttons & BUTTON_SHOOT) != 0;
+    input.toggleControlMode = (packed.buttons & BUTTON_TOGGLE_MODE) != 0;
+    input.aimTarget = (Vector2){ (short)packed.aimX, (short)packed.aimY };
+
+    return input;
+}
+
+static bool SameInput(NetInput a, NetInput b)
+{
+    return a.buttons == b.buttons && a.aimX == b.aimX && a.aimY == b.aimY;
+}
+
+// Our guess for the other side: whatever they did last, but a mode switch only happens once
+static NetInput PredictRemoteInput(const RollbackSession *session)
+{
+    if (session->remoteTick == 0) return (NetInput){ 0 };
+
+    NetInput last = session->remoteInputs[(session->remoteTick - 1) % ROLLBACK_HISTORY];
+    last.buttons &= ~BUTTON_TOGGLE_MODE;
+    return last;
+}
+
+// Saves the state at the start of the tick and simulates it with the inputs we have for it
+static void SimulateTick(RollbackSession *session, unsigned int tick)
+{
+    int slot = tick % ROLLBACK_HISTORY;
+
+    CaptureSimSnapshot(session->game, &session->states[slot]);
+
+    if (tick >= session->remoteTick)
+    {
+        session->remoteInputs[slot] = PredictRemoteInput(session);
+    }
+
+    PlayerInput inputs[2];
+    inputs[session->localSlot] = UnpackInput(session->localInputs[slot]);
+    inputs[1 - session->localSlot] = UnpackInput(session->remoteInputs[slot]);
+
+    StepVersusGameplay(session->game, inputs);
+}
+
+// Goes back to the start of a tick and simulates everything after it again
+static void Resimulate(RollbackSession *session, unsigned int fromTick)
+{
+    double start = Now();
+
+    RestoreSimSnapshot(session->game, &session->states[fromTick % ROLLBACK_HISTORY]);
+    for (unsigned int tick = fromTick; tick < session->currentTick; tick++)
+    {
+        SimulateTick(session, tick);
+    }
+
+    double micros = (Now() - start) * 1e6;
+    session->stats.rollbacks++;
+    session->stats.resimulatedTicks += session->currentTick - fromTick;
+    session->stats.resimMicros += micros;
+    session->stats.lastResimMicros = micros;
+    if (micros > session->stats.maxResimMicros) session->stats.maxResimMicros = micros;
+}
+
+static void Connect(RollbackSession *session, unsigned int seed)
+{
+    session->seed = seed;
+    session->connected = true;
+    StartVersusGame(session->game, seed);
+}
+
+// Takes in the inputs from one packet, returns the earliest tick that was guessed wrong
+static unsigned int ReadInputPacket(RollbackSession *session, const unsigned char *packet, int size)
+{
+    unsigned int rollbackFrom = session->currentTick;
+
+    unsigned int firstTick = GetU32(packet + 1);
+    int count = packet[5];
+    unsigned int ack = GetU32(packet + 6);
+    unsigned int checksumTick = GetU32(packet + 10);
+    unsigned int checksum = GetU32(packet + 14);
+
+    if (size < INPUT_HEADER_SIZE + count * NET_INPUT_SIZE) return rollbackFrom;
+
+    session->heardFromPeer = true;
+    if (ack > session->remoteAck && ack <= session->currentTick) session->remoteAck = ack;
+    session->remoteAdvantage = (int)(firstTick + count) - (int)ack;
+
+    for (int i = 0; i < count; i++)
+    {
+        unsigned int tick = firstTick + i;
+        if (tick < session->remoteTick) continue;       // already have it, packets overlap
+        if (tick > session->remoteTick) break;          // a gap, the packet before this one got lost
+
+        const unsigned char *bytes = packet + INPUT_HEADER_SIZE + i * NET_INPUT_SIZE;
+        NetInput input = { bytes[0], (unsigned short)(bytes[1] | (bytes[2] << 8)), (unsigned short)(bytes[3] | (bytes[4] << 8)) };
+        int slot = tick % ROLLBACK_HISTORY;
+
+        // we already simulated this tick with a guess, was it right?
+        if (tick < session->currentTick)
+        {
+            session->stats.predictedTicks++;
+            if (SameInput(session->remoteInputs[slot], input)) session->stats.correctPredictions++;
+            else if (tick < rollbackFrom) rollbackFrom = tick;
+        }
+
+        session->remoteInputs[slot] = input;
+        session->remoteTick++;
+    }
+
+    // their newest confirmed state, we compare it with ours once we have that tick confirmed too
+    if (checksumTick > session->remoteChecksumTick)
+    {
+        session->remoteChecksumTick = checksumTick;
+        session->remoteChecksum = checksum;
+    }
+
+    return rollbackFrom;
+}
+
+static unsigned int ReceivePackets(RollbackSession *session, double now)
+{
+    unsigned char packet[NET_MAX_PACKET];
+    unsigned int rollbackFrom = session->currentTick;
+    int size;
+
+    while ((size = ReceiveNetPacket(&session->link, packet, sizeof(packet))) > 0)
+    {
+        if (packet[0] == PACKET_HELLO && session->localSlot == 0)
+        {
+            if (!session->connected) Connect(session, session->seed);
+
+            unsigned char welcome[5] = { PACKET_WELCOME };
+            PutU32(welcome + 1, session->seed);
+            SendNetPacket(&session->link, welcome, sizeof(welcome), now);
+        }
+        else if (packet[0] == PACKET_WELCOME && size >= 5 && session->localSlot == 1)
+        {
+            if (!session->connected) Connect(session, GetU32(packet + 1));
+        }
+        else if (packet[0] == PACKET_INPUTS && size >= INPUT_HEADER_SIZE && session->connected)
+        {
+            unsigned int from = ReadInputPacket(session, packet, size);
+            if (from < rollbackFrom) rollbackFrom = from;
+        }
+    }
+
+    return rollbackFrom;
+}
+
+// All of our inputs the other side hasn't confirmed yet, the newest confirmed checksum rides along
+static void SendInputs(RollbackSession *session, double now)
+{
+    unsigned char packet[NET_MAX_PACKET];
+
+    unsigned int first = session->remoteAck;
+    if (session->currentTick - first > 2 * ROLLBACK_MAX_PREDICTION) first = session->currentTick - 2 * ROLLBACK_MAX_PREDICTION;
+    int count = (int)(session->currentTick - first);
+
+    packet[0] = PACKET_INPUTS;
+    PutU32(packet + 1, first);
+    packet[5] = (unsigned char)count;
+    PutU32(packet + 6, session->remoteTick);
+    PutU32(packet + 10, session->lastChecksumTick);
+    PutU32(packet + 14, session->checksums[session->lastChecksumTick % ROLLBACK_HISTORY]);
+
+    for (int i = 0; i < count; i++)
+    {
+        NetInput input = session->localInputs[(first + i) % ROLLBACK_HISTORY];
+        unsigned char *bytes = packet + INPUT_HEADER_SIZE + i * NET_INPUT_SIZE;
+        bytes[0] = input.buttons;
+        bytes[1] = input.aimX & 0xFF;
+        bytes[2] = input.aimX >> 8;
+        bytes[3] = input.aimY & 0xFF;
+        bytes[4] = input.aimY >> 8;
+    }
+
+    SendNetPacket(&session->link, packet, INPUT_HEADER_SIZE + count * NET_INPUT_SIZE, now);
+}
+
+// The state at the start of a tick can't change any more once we have both inputs for every tick
+// before it. Every one of them gets a checksum so that both sides have the same ticks to compare
+static void CompareRemoteChecksum(RollbackSession *session)
+{
+    unsigned int tick = session->remoteChecksumTick;
+    int slot = tick % ROLLBACK_HISTORY;
+
+    if (tick <= session->lastComparedTick || session->checksumTicks[slot] != tick) return;
+
+    session->stats.checksumsCompared++;
+    if (session->checksums[slot] != session->remoteChecksum)
+    {
+        session->stats.desyncs++;
+        TraceLog(LOG_WARNING, "NET: Desync at tick %u", tick);
+    }
+    session->lastComparedTick = tick;
+}
+
+static void UpdateConfirmedChecksums(RollbackSession *session)
+{
+    if (session->currentTick == 0) return;
+
+    // the live state of currentTick isn't in the history yet, only the ones before it
+    unsigned int confirmed = session->remoteTick < session->currentTick - 1 ? session->remoteTick : session->currentTick - 1;
+
+    for (unsigned int tick = session->lastChecksumTick + 1; tick <= confirmed; tick++)
+    {
+        int slot = tick % ROLLBACK_HISTORY;
+        session->checksumTicks[slot] = tick;
+        session->checksums[slot] = HashSimSnapshot(&session->states[slot]);
+        session->lastChecksumTick = tick;
+    }
+}
+
+static bool OpenSession(RollbackSession *session, Game *game, int localSlot, unsigned short port, NetConditions conditions)
+{
+    memset(session, 0, sizeof(*session));
+    session->game = game;
+    session->localSlot = localSlot;
+
+    for (int i = 0; i < ROLLBACK_HISTORY; i++) session->checksumTicks[i] = 0xFFFFFFFFu;
+
+    return OpenNetLink(&session->link, port, conditions);
+}
+
+bool HostRollbackSession(RollbackSession *session, Game *game, unsigned short port, NetConditions conditions, unsigned int seed)
+{
+    if (!OpenSession(session, game, 0, port, conditions)) return false;
+    session->seed = seed ? seed : 1;
+    return true;
+}
+
+bool JoinRollbackSession(RollbackSession *session, Game *game, const char *host, unsigned short port, NetConditions conditions)
+{
+    if (!OpenSession(session, game, 1, 0, conditions)) return false;
+    return SetNetPeer(&session->link, host, port);
+}
+
+void AdvanceRollbackSession(RollbackSession *session, const PlayerInput *localInput, double now)
+{
+    FlushNetLink(&session->link, now);
+    unsigned int rollbackFrom = ReceivePackets(session, now);
+
+    if (!session->connected)
+    {
+        // keep knocking until the host answers
+        if (session->localSlot == 1)
+        {
+            unsigned char hello = PACKET_HELLO;
+            SendNetPacket(&session->link, &hello, 1, now);
+        }
+        return;
+    }
+
+    // the welcome can get lost too, keep sending it until the other side's inputs show up
+    if (session->localSlot == 0 && !session->heardFromPeer)
+    {
+        unsigned char welcome[5] = { PACKET_WELCOME };
+        PutU32(welcome + 1, session->seed);
+        SendNetPacket(&session->link, welcome, sizeof(welcome), now);
+    }
+
+    session->stats.frames++;
+    session->stats.lastResimMicros = 0.0;
+
+    if (rollbackFrom < session->currentTick)
+    {
+        Resimulate(session, rollbackFrom);
+    }
+
+    /*
+     * Whoever started first (or has the slower network on their side) ends up further ahead of
+     * the other side's inputs, and all the rolling back lands on them. Both sides see their own
+     * lead and the other's, so the one that leads by more skips a tick every now and then until
+     * they are about even. A skipped tick every 4 frames isn't something anyone notices.
+     */
+    int localAdvantage = (int)session->currentTick - (int)session->remoteTick;
+    bool holdBack = localAdvantage - session->remoteAdvantage >= 2 && session->stats.frames % 4 == 0;
+
+    if (holdBack)
+    {
+        session->stats.syncWaits++;
+    }
+    else if (session->currentTick < session->remoteTick + ROLLBACK_MAX_PREDICTION)
+    {
+        Player ship = RollbackLocalPlayer(session);
+        session->localInputs[session->currentTick % ROLLBACK_HISTORY] = PackInput(localInput, ship.controlMode == CONTROL_MOUSE);
+
+        SimulateTick(session, session->currentTick);
+        session->currentTick++;
+        session->stats.ticks++;
+    }
+    else
+    {
+        session->stats.stalls++;
+    }
+
+    UpdateConfirmedChecksums(session);
+    CompareRemoteChecksum(session);
+    SendInputs(session, now);
+}
+
+void CloseRollbackSession(RollbackSession *session)
+{
+    CloseNetLink(&session->link);
+    session->connected = false;
+}
+
+Player RollbackLocalPlayer(const RollbackSession *session)
+{
+    return GetPlayer(&session->game->entities, session->localSlot);
+}
+
+int RollbackLocalSlot(const RollbackSession *session)
+{
+    return session->localSlot;
+}
+
+int RollbackPredictedTicks(const RollbackSession *session)
+{
+    return session->currentTick > session->remoteTick ? (int)(session->currentTick - session->remoteTick) : 0;
+}
+
+// Checksum of a confirmed state, if it is still in the history
+bool RollbackChecksum(const RollbackSession *session, unsigned int tick, unsigned int *checksum)
+{
+    int slot = tick % ROLLBACK_HISTORY;
+    if (session->checksumTicks[slot] != tick) return false;
+
+    *checksum = session->checksums[slot];
+    return true;
+}
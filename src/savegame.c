@@ -0,0 +1,375 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-06-01 10:12:37
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-06-01 16:48:05
+*/
+
+/*
+ * The profile and the quick save, see savegame.h. Writing on the worker thread on one side,
+ * mapping and checking a file on the other.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "savegame.h"
+#include "canvas.h"
+#include "game.h"
+#include "resolution.h"
+#include "sound.h"
+#include "world.h"
+
+_Static_assert(sizeof(SaveHeader) == SAVE_HEADER_BYTES, "the save header has to stay SAVE_HEADER_BYTES");
+_Static_assert(sizeof(Tunables) == TUNABLE_COUNT * 4, "the tunables go into the header as they are, four bytes each");
+_Static_assert(offsetof(SaveFile, snapshot) == SAVE_HEADER_BYTES, "the snapshot has to start right after the header");
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint8_t BuildFlags(void)
+{
+#ifdef FIXED_SIM
+    return SAVE_FIXED_SIM;
+#else
+    return 0;
+#endif
+}
+
+// FNV-1a over the header with the checksum as 0, then over whatever follows it
+static uint32_t SaveChecksum(const SaveHeader *header, const unsigned char *rest, size_t restSize)
+{
+    SaveHeader copy = *header;
+    copy.checksum = 0;
+
+    const unsigned char *bytes = (const unsigned char *)&copy;
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < sizeof(copy); i++) hash = (hash ^ bytes[i]) * 16777619u;
+    for (size_t i = 0; i < restSize; i++) hash = (hash ^ rest[i]) * 16777619u;
+    return hash;
+}
+
+size_t FillSaveFile(SaveFile *file, const Game *game, bool withGame)
+{
+    SaveHeader *header = &file->header;
+    memset(header, 0, sizeof(*header));
+
+    header->magic = SAVE_MAGIC;
+    header->version = SAVE_VERSION;
+    header->headerSize = SAVE_HEADER_BYTES;
+    header->savedTime = (uint64_t)time(NULL);
+    header->highScore = game->highScore;      // only a single player game over raises it, see UpdateGame
+    header->worldWidth = (uint16_t)worldWidth;
+    header->worldHeight = (uint16_t)worldHeight;
+    header->asteroidLimit = (uint16_t)worldAsteroidLimit;
+    header->flags = BuildFlags() | (game->autopilot ? SAVE_AUTOPILOT : 0);
+    header->difficulty = (uint8_t)game->settings.difficulty;
+    header->soundEnabled = game->settings.soundEnabled;
+    header->musicEnabled = game->settings.musicEnabled;
+    header->showFPS = game->settings.showFPS;
+    header->fullscreen = game->settings.fullscreen;
+    header->resolution = (uint8_t)game->currentResolution;
+    header->renderScale = game->settings.renderScale;
+    header->tunables = game->tunables;
+
+    if (!withGame) return sizeof(SaveHeader);
+
+    // zeroed first so the padding in the file is always the same
+    header->flags |= SAVE_HAS_GAME;
+    header->snapshotSize = sizeof(SimSnapshot);
+    memset(&file->snapshot, 0, sizeof(file->snapshot));
+    CaptureSimSnapshot(game, &file->snapshot);
+    return sizeof(SaveFile);
+}
+
+// Everything or nothing: <path>.tmp first, synced, then renamed over the old file
+bool WriteSaveFile(const char *path, SaveFile *file, size_t size)
+{
+    file->header.checksum = SaveChecksum(&file->header, (const unsigned char *)file + sizeof(SaveHeader), size - sizeof(SaveHeader));
+
+    char temporary[SAVE_PATH_LENGTH + 8];
+    snprintf(temporary, sizeof(temporary), "%s.tmp", path);
+
+    int fd = open(temporary, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return false;
+
+    const unsigned char *bytes = (const unsigned char *)file;
+    size_t written = 0;
+    while (written < size)
+    {
+        ssize_t result = write(fd, bytes + written, size - written);
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) break;
+        written += (size_t)result;
+    }
+
+    bool ok = written == size && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    ok = ok && rename(temporary, path) == 0;
+    if (!ok) unlink(temporary);
+    return ok;
+}
+
+// Takes the slot with something waiting, writes it outside the lock, until told to stop with nothing left
+static void *SaveWorker(void *argument)
+{
+    SaveWriter *writer = argument;
+
+    pthread_mutex_lock(&writer->lock);
+    for (;;)
+    {
+        SaveSlot *slot = NULL;
+        for (int kind = 0; kind < SAVE_KINDS && slot == NULL; kind++)
+        {
+            if (writer->slots[kind].pending) slot = &writer->slots[kind];
+        }
+
+        if (slot == NULL)
+        {
+            pthread_cond_broadcast(&writer->idle);
+            if (writer->stopping) break;
+            pthread_cond_wait(&writer->wake, &writer->lock);
+            continue;
+        }
+
+        // the buffers change hands, the main thread can queue the next save into the slot right away
+        SaveFile *file = slot->file;
+        slot->file = writer->writing;
+        writer->writing = file;
+        size_t size = slot->size;
+        char path[SAVE_PATH_LENGTH];
+        memcpy(path, slot->path, sizeof(path));
+        slot->pending = false;
+        writer->busy = true;
+        pthread_mutex_unlock(&writer->lock);
+
+        double start = Now();
+        bool ok = WriteSaveFile(path, file, size);
+        double seconds = Now() - start;
+
+        pthread_mutex_lock(&writer->lock);
+        writer->busy = false;
+        if (ok) writer->saved++;
+        else writer->failed++;
+        writer->writeSeconds += seconds;
+        if (seconds > writer->writeSecondsMax) writer->writeSecondsMax = seconds;
+    }
+    pthread_mutex_unlock(&writer->lock);
+    return NULL;
+}
+
+bool StartSaveWriter(SaveWriter *writer, const char *directory)
+{
+    memset(writer, 0, sizeof(*writer));
+
+    const char *names[SAVE_KINDS] = { SAVE_PROFILE_NAME, SAVE_QUICK_NAME };
+    for (int kind = 0; kind < SAVE_KINDS; kind++)
+    {
+        SaveSlot *slot = &writer->slots[kind];
+        if (directory != NULL) snprintf(slot->path, sizeof(slot->path), "%s/%s", directory, names[kind]);
+        else snprintf(slot->path, sizeof(slot->path), "%s", names[kind]);
+
+        // the largest save there is, allocated (and touched) once so queueing never allocates or faults
+        slot->file = calloc(1, sizeof(SaveFile));
+        if (slot->file == NULL) return false;
+    }
+    writer->writing = calloc(1, sizeof(SaveFile));
+    if (writer->writing == NULL) return false;
+
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->wake, NULL);
+    pthread_cond_init(&writer->idle, NULL);
+    writer->running = pthread_create(&writer->thread, NULL, SaveWorker, writer) == 0;
+    return writer->running;
+}
+
+void StopSaveWriter(SaveWriter *writer)
+{
+    if (writer->running)
+    {
+        pthread_mutex_lock(&writer->lock);
+        writer->stopping = true;
+        pthread_cond_signal(&writer->wake);
+        pthread_mutex_unlock(&writer->lock);
+        pthread_join(writer->thread, NULL);
+
+        pthread_cond_destroy(&writer->idle);
+        pthread_cond_destroy(&writer->wake);
+        pthread_mutex_destroy(&writer->lock);
+        writer->running = false;
+    }
+
+    for (int kind = 0; kind < SAVE_KINDS; kind++)
+    {
+        free(writer->slots[kind].file);
+        writer->slots[kind].file = NULL;
+    }
+    free(writer->writing);
+    writer->writing = NULL;
+}
+
+// The only part of a save on the main thread: the state into the slot, a copy of a few hundred kilobytes at most
+void QueueSave(SaveWriter *writer, const Game *game, SaveKind kind)
+{
+    if (!writer->running) return;
+
+    double start = Now();
+    SaveSlot *slot = &writer->slots[kind];
+
+    pthread_mutex_lock(&writer->lock);
+    if (slot->pending) writer->replaced++;
+    slot->size = FillSaveFile(slot->file, game, kind == SAVE_QUICK);
+    slot->pending = true;
+    pthread_cond_signal(&writer->wake);
+    pthread_mutex_unlock(&writer->lock);
+
+    double seconds = Now() - start;
+    if (seconds > writer->queueSecondsMax) writer->queueSecondsMax = seconds;
+}
+
+void WaitForSaves(SaveWriter *writer)
+{
+    if (!writer->running) return;
+
+    pthread_mutex_lock(&writer->lock);
+    while (writer->busy || writer->slots[SAVE_PROFILE].pending || writer->slots[SAVE_QUICK].pending)
+    {
+        pthread_cond_wait(&writer->idle, &writer->lock);
+    }
+    pthread_mutex_unlock(&writer->lock);
+}
+
+void PrintSaveReport(const SaveWriter *writer)
+{
+    if (writer->saved + writer->failed == 0) return;
+
+    printf("Saves: %lu written, %lu failed, %lu replaced before they were written, %.1f us max on the main thread, "
+           "%.2f ms per write on the worker (%.2f ms max)\n",
+           writer->saved, writer->failed, writer->replaced, writer->queueSecondsMax * 1e6,
+           writer->writeSeconds * 1000.0 / (double)(writer->saved + writer->failed), writer->writeSecondsMax * 1000.0);
+}
+
+bool MapSaveFile(MappedSave *save, const char *path)
+{
+    memset(save, 0, sizeof(*save));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(SaveHeader))
+    {
+        close(fd);
+        return false;
+    }
+
+    void *data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);                                  // the mapping keeps the file open
+    if (data == MAP_FAILED) return false;
+
+    save->data = data;
+    save->size = (size_t)info.st_size;
+    save->header = data;
+
+    // the size has to be exactly what the header says, a save cut short is no save at all
+    const SaveHeader *header = save->header;
+    bool hasGame = (header->flags & SAVE_HAS_GAME) != 0;
+    bool valid = header->magic == SAVE_MAGIC && header->version == SAVE_VERSION && header->headerSize == SAVE_HEADER_BYTES &&
+                 (header->flags & SAVE_FIXED_SIM) == BuildFlags() &&
+                 header->snapshotSize == (hasGame ? sizeof(SimSnapshot) : 0) &&
+                 save->size == sizeof(SaveHeader) + header->snapshotSize &&
+                 header->worldWidth > 0 && header->worldHeight > 0 && header->asteroidLimit <= MAX_ASTEROIDS &&
+                 header->difficulty < 3 && header->resolution < MAX_RESOLUTIONS &&
+                 SaveChecksum(header, save->data + sizeof(SaveHeader), header->snapshotSize) == header->checksum;
+
+    if (valid && hasGame)
+    {
+        save->snapshot = (const SimSnapshot *)(save->data + sizeof(SaveHeader));
+        valid = save->snapshot->state == GAMEPLAY || save->snapshot->state == GAME_OVER;
+    }
+
+    if (!valid)
+    {
+        UnmapSaveFile(save);
+        return false;
+    }
+    return true;
+}
+
+void UnmapSaveFile(MappedSave *save)
+{
+    if (save->data != NULL) munmap((void *)save->data, save->size);
+    memset(save, 0, sizeof(*save));
+}
+
+// The window only changes at start, a quick load in the middle of a game leaves it alone
+void ApplySavedSettings(Game *game, const SaveHeader *header, bool display)
+{
+    if (header->highScore > game->highScore) game->highScore = header->highScore;
+    game->settings.difficulty = header->difficulty;
+    game->settings.showFPS = header->showFPS != 0;
+
+    if (game->settings.soundEnabled != (header->soundEnabled != 0))
+    {
+        game->settings.soundEnabled = header->soundEnabled != 0;
+        if (game->soundManager != NULL) ToggleSoundEnabled(game->soundManager, game->settings.soundEnabled);
+    }
+    if (game->settings.musicEnabled != (header->musicEnabled != 0))
+    {
+        game->settings.musicEnabled = header->musicEnabled != 0;
+        if (game->soundManager != NULL) ToggleMusicEnabled(game->soundManager, game->settings.musicEnabled);
+    }
+
+    if (!display) return;
+
+    if (header->resolution != game->currentResolution) ChangeResolution(game, header->resolution);
+    if ((header->fullscreen != 0) != game->settings.fullscreen) ToggleFullscreenMode(game);
+    SetRenderScale(header->renderScale);
+    game->settings.renderScale = CanvasScale();
+}
+
+// Straight from the mapping, the world size and the tunables first since the snapshot is played with them
+bool RestoreSavedGame(const MappedSave *save, Game *game)
+{
+    if (save->snapshot == NULL) return false;
+
+    const SaveHeader *header = save->header;
+    if (worldWidth != header->worldWidth) worldWidth = header->worldWidth;
+    if (worldHeight != header->worldHeight) worldHeight = header->worldHeight;
+    if (worldAsteroidLimit != header->asteroidLimit) worldAsteroidLimit = header->asteroidLimit;
+
+    game->tunables = header->tunables;
+    game->autopilot = (header->flags & SAVE_AUTOPILOT) != 0;
+    game->versus = false;
+    RestoreSimSnapshot(game, save->snapshot);
+
+    // the history before the save belongs to another game
+    ClearRewindBuffer(&game->rewind);
+    game->rewinding = false;
+    return true;
+}
+
+bool QuickLoadGame(Game *game, const char *path)
+{
+    MappedSave save;
+    if (!MapSaveFile(&save, path)) return false;
+
+    bool ok = save.snapshot != NULL;
+    if (ok)
+    {
+        ApplySavedSettings(game, save.header, false);
+        ok = RestoreSavedGame(&save, game);
+    }
+    UnmapSaveFile(&save);
+    return ok;
+}
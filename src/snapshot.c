@@ -0,0 +1,273 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-17 14:20:11
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-17 18:02:36
+*/
+
+/*
+ * Snapshots and rewind. The simulation state is flat data (the asteroid grid is rebuilt from
+ * the asteroids, so it doesn't need saving), which means a snapshot is a couple of struct
+ * copies and restoring one is the same copies the other way around.
+ *
+ * Keeping a whole snapshot for every tick of the rewind history would be ~25 MB for 10 seconds,
+ * but from one tick to the next most of the state doesn't change: the empty rows of the entity
+ * tables stay zero and an asteroid only changes its position and rotation. So only the newest
+ * state is kept whole and older ones are stored as the XOR with the state after them, with the runs of unchanged
+ * words left out. XOR works both ways, applying a delta to the newer state gives the older one.
+ */
+
+#include "snapshot.h"
+#include "game.h"
+#include <raylib.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define SNAPSHOT_WORDS (sizeof(SimSnapshot) / sizeof(uint32_t))    // every field in it is 4 byte aligned
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Word access through memcpy so the compiler doesn't have to worry about aliasing, it's still one load
+static inline uint32_t LoadWord(const unsigned char *bytes, size_t word)
+{
+    uint32_t value;
+    memcpy(&value, bytes + word * sizeof(uint32_t), sizeof(value));
+    return value;
+}
+
+/*
+ * Delta format: a list of runs, each one is a 16 bit count of unchanged words to skip, a 16 bit
+ * count of changed words and then those words XORed together. The worst case (every other word
+ * changed) is 4 bytes more than the snapshot itself.
+ */
+static size_t EncodeDelta(const SimSnapshot *older, const SimSnapshot *newer, unsigned char *out)
+{
+    const unsigned char *a = (const unsigned char *)older;
+    const unsigned char *b = (const unsigned char *)newer;
+    size_t size = 0;
+    size_t word = 0;
+
+    while (word < SNAPSHOT_WORDS)
+    {
+        size_t changed = word;
+        while (changed < SNAPSHOT_WORDS && LoadWord(a, changed) == LoadWord(b, changed)) changed++;
+        if (changed == SNAPSHOT_WORDS) break;
+
+        size_t end = changed;
+        while (end < SNAPSHOT_WORDS && LoadWord(a, end) != LoadWord(b, end)) end++;
+
+        uint16_t run[2] = { (uint16_t)(changed - word), (uint16_t)(end - changed) };
+        memcpy(out + size, run, sizeof(run));
+        size += sizeof(run);
+
+        for (size_t i = changed; i < end; i++)
+        {
+            uint32_t x = LoadWord(a, i) ^ LoadWord(b, i);
+            memcpy(out + size, &x, sizeof(x));
+            size += sizeof(x);
+        }
+
+        word = end;
+    }
+
+    return size;
+}
+
+static void ApplyDelta(SimSnapshot *snapshot, const unsigned char *delta, size_t size)
+{
+    unsigned char *bytes = (unsigned char *)snapshot;
+    size_t word = 0;
+    size_t read = 0;
+
+    while (read < size)
+    {
+        uint16_t run[2];
+        memcpy(run, delta + read, sizeof(run));
+        read += sizeof(run);
+        word += run[0];
+
+        for (int i = 0; i < run[1]; i++, word++)
+        {
+            uint32_t x = LoadWord(bytes, word) ^ LoadWord(delta + read, 0);
+            memcpy(bytes + word * sizeof(uint32_t), &x, sizeof(x));
+            read += sizeof(x);
+        }
+    }
+}
+
+void CaptureSimSnapshot(const Game *game, SimSnapshot *snapshot)
+{
+    // clear it first so the padding is always the same and never shows up in a delta
+    memset(snapshot, 0, sizeof(*snapshot));
+
+    snapshot->score = game->score;
+    snapshot->state = game->state;
+    snapshot->rngState = game->rngState;
+    snapshot->tick = game->tick;
+    snapshot->secondScore = game->secondScore;
+    snapshot->versusLoser = game->versusLoser;
+    snapshot->entities = game->entities;
+    snapshot->director = game->director;
+}
+
+void RestoreSimSnapshot(Game *game, const SimSnapshot *snapshot)
+{
+    game->score = snapshot->score;
+    game->state = (GameState)snapshot->state;
+    game->rngState = snapshot->rngState;
+    game->tick = snapshot->tick;
+    game->secondScore = snapshot->secondScore;
+    game->versusLoser = snapshot->versusLoser;
+    game->entities = snapshot->entities;
+    game->director = snapshot->director;
+
+    // the grid relinks only the asteroids that ended up in another cell
+    RefreshAsteroidGrid(game);
+}
+
+// FNV-1a over the snapshot words, CaptureSimSnapshot zeroes the padding so equal states hash the same
+unsigned int HashSimSnapshot(const SimSnapshot *snapshot)
+{
+    const unsigned char *bytes = (const unsigned char *)snapshot;
+    unsigned int hash = 2166136261u;
+
+    for (size_t word = 0; word < SNAPSHOT_WORDS; word++) hash = (hash ^ LoadWord(bytes, word)) * 16777619u;
+    return hash;
+}
+
+// Everything is allocated up front, pushing a state never allocates
+bool InitRewindBuffer(RewindBuffer *rewind, int seconds)
+{
+    memset(rewind, 0, sizeof(*rewind));
+
+    rewind->capacity = seconds * GAME_TICK_RATE;
+    rewind->dataSize = (size_t)rewind->capacity * REWIND_BYTES_PER_TICK;
+    rewind->data = malloc(rewind->dataSize);
+    rewind->entries = malloc(sizeof(RewindEntry) * rewind->capacity);
+    rewind->scratch = malloc(sizeof(SimSnapshot) + 8);
+
+    if (rewind->data == NULL || rewind->entries == NULL || rewind->scratch == NULL)
+    {
+        TraceLog(LOG_WARNING, "REWIND: Could not allocate the rewind buffer, rewind is disabled");
+        FreeRewindBuffer(rewind);
+        return false;
+    }
+
+    return true;
+}
+
+void FreeRewindBuffer(RewindBuffer *rewind)
+{
+    free(rewind->data);
+    free(rewind->entries);
+    free(rewind->scratch);
+    memset(rewind, 0, sizeof(*rewind));
+}
+
+// Forgets the history, the next push starts a new one
+void ClearRewindBuffer(RewindBuffer *rewind)
+{
+    rewind->hasHead = false;
+    rewind->first = 0;
+    rewind->count = 0;
+    rewind->writeOffset = 0;
+    rewind->bytesUsed = 0;
+}
+
+static void DropOldestDelta(RewindBuffer *rewind)
+{
+    rewind->bytesUsed -= rewind->entries[rewind->first].size;
+    rewind->first = (rewind->first + 1) % rewind->capacity;
+    rewind->count--;
+}
+
+// Finds room for a delta in the storage, dropping the oldest ones until it fits
+static size_t ReserveDeltaSpace(RewindBuffer *rewind, size_t size)
+{
+    while (rewind->count > 0)
+    {
+        size_t oldest = rewind->entries[rewind->first].offset;
+        size_t tail = rewind->writeOffset;
+
+        if (tail > oldest)
+        {
+            // the stored deltas sit between oldest and tail, there is free space on both sides of them
+            if (rewind->dataSize - tail >= size) return tail;
+            if (oldest >= size) return 0;
+        }
+        else if (oldest - tail >= size)
+        {
+            return tail;
+        }
+
+        DropOldestDelta(rewind);
+    }
+
+    return 0;
+}
+
+void PushRewindState(RewindBuffer *rewind, const Game *game)
+{
+    if (rewind->data == NULL) return;
+
+    double start = Now();
+
+    SimSnapshot next;
+    CaptureSimSnapshot(game, &next);
+
+    rewind->lastDeltaSize = 0;
+    if (rewind->hasHead)
+    {
+        size_t size = EncodeDelta(&rewind->head, &next, rewind->scratch);
+
+        if (rewind->count == rewind->capacity) DropOldestDelta(rewind);
+
+        size_t offset = ReserveDeltaSpace(rewind, size);
+        memcpy(rewind->data + offset, rewind->scratch, size);
+
+        int slot = (rewind->first + rewind->count) % rewind->capacity;
+        rewind->entries[slot] = (RewindEntry){ offset, size };
+        rewind->count++;
+        rewind->writeOffset = offset + size;
+        rewind->bytesUsed += size;
+        rewind->lastDeltaSize = size;
+    }
+
+    rewind->head = next;
+    rewind->hasHead = true;
+
+    double micros = (Now() - start) * 1e6;
+    rewind->lastPushMicros = micros;
+    rewind->totalPushMicros += micros;
+    if (micros > rewind->maxPushMicros) rewind->maxPushMicros = micros;
+    rewind->pushes++;
+}
+
+bool StepBackRewind(RewindBuffer *rewind, Game *game)
+{
+    if (!rewind->hasHead || rewind->count == 0) return false;
+
+    int newest = (rewind->first + rewind->count - 1) % rewind->capacity;
+    RewindEntry entry = rewind->entries[newest];
+
+    ApplyDelta(&rewind->head, rewind->data + entry.offset, entry.size);
+
+    rewind->count--;
+    rewind->bytesUsed -= entry.size;
+    rewind->writeOffset = entry.offset;
+
+    RestoreSimSnapshot(game, &rewind->head);
+    return true;
+}
+
+float RewindSecondsAvailable(const RewindBuffer *rewind)
+{
+    return (float)rewind->count / GAME_TICK_RATE;
+}
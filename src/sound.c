@@ -14,10 +14,30 @@
 #include <raylib.h>
 #include <stdlib.h>
 
-void InitSoundManager(SoundManager *soundManager)
+// The null device equivalent of gameMusic.ctxData == menuMusic.ctxData, falls back to the menu track
+static int NullGameMusicTrack(SoundManager *soundManager)
 {
-    // Initialize the audio device
-    InitAudioDevice();
+    return soundManager->nullAudio.music[NULL_AUDIO_MUSIC_GAME].data != NULL ? NULL_AUDIO_MUSIC_GAME : NULL_AUDIO_MUSIC_MENU;
+}
+
+void InitSoundManager(SoundManager *soundManager, bool useNullDevice, bool captureAudio)
+{
+    // Initialize the audio device, unless we were asked not to
+    if (!useNullDevice) {
+        InitAudioDevice();
+
+        // No sound card (e.g. test hosts), fall back to mixing in memory so the game still starts
+        if (!IsAudioDeviceReady()) {
+            TraceLog(LOG_WARNING, "SOUND: Audio device not available, using null audio device");
+            useNullDevice = true;
+        }
+    }
+
+    soundManager->nullDevice = useNullDevice;
+    soundManager->soundMuted = false;
+    if (soundManager->nullDevice) {
+        InitNullAudio(&soundManager->nullAudio, captureAudio);
+    }
     
     // Initialize volumes
     soundManager->musicVolume = 0.7f;
@@ -34,44 +54,52 @@ void InitSoundManager(SoundManager *soundManager)
     LoadGameSounds(soundManager);
 }
 
+// Loads one sound effect into the right slot, either as a raylib Sound or into the null mixer
+static void LoadGameSoundFile(SoundManager *soundManager, SoundType soundType, const char *fileName)
+{
+    if (!FileExists(fileName)) return;
+
+    if (soundManager->nullDevice) {
+        soundManager->soundLoaded[soundType] = LoadNullAudioWave(&soundManager->nullAudio, soundType, fileName);
+    } else {
+        soundManager->sounds[soundType] = LoadSound(fileName);
+        soundManager->soundLoaded[soundType] = true;
+    }
+}
+
 void LoadGameSounds(SoundManager *soundManager)
 {
     // Load sound effects - using your specific file names
     
     // Shooting sounds - using alienshoot files
-    if (FileExists("Resources/sounds/alienshoot1.wav")) {
-        soundManager->sounds[SOUND_SHOOT] = LoadSound("Resources/sounds/alienshoot1.wav");
-        soundManager->soundLoaded[SOUND_SHOOT] = true;
-    }
+    LoadGameSoundFile(soundManager, SOUND_SHOOT, "Resources/sounds/alienshoot1.wav");
     
     // Big explosion - using explosion_1.wav (presumably the largest one)
-    if (FileExists("Resources/sounds/explosion_1.wav")) {
-        soundManager->sounds[SOUND_EXPLOSION_BIG] = LoadSound("Resources/sounds/explosion_1.wav");
-        soundManager->soundLoaded[SOUND_EXPLOSION_BIG] = true;
-    }
+    LoadGameSoundFile(soundManager, SOUND_EXPLOSION_BIG, "Resources/sounds/explosion_1.wav");
     
     // Small explosion - using explosion_3.wav (medium sized one)
-    if (FileExists("Resources/sounds/explosion_3.wav")) {
-        soundManager->sounds[SOUND_EXPLOSION_SMALL] = LoadSound("Resources/sounds/explosion_3.wav");
-        soundManager->soundLoaded[SOUND_EXPLOSION_SMALL] = true;
-    }
+    LoadGameSoundFile(soundManager, SOUND_EXPLOSION_SMALL, "Resources/sounds/explosion_3.wav");
     
     // Thrust sound - using engine.wav
-    if (FileExists("Resources/sounds/engine.wav")) {
-        soundManager->sounds[SOUND_THRUST] = LoadSound("Resources/sounds/engine.wav");
-        soundManager->soundLoaded[SOUND_THRUST] = true;
-    }
+    LoadGameSoundFile(soundManager, SOUND_THRUST, "Resources/sounds/engine.wav");
     
     // Menu selection sound
-    if (FileExists("Resources/sounds/menu_select.wav")) {
-        soundManager->sounds[SOUND_MENU_SELECT] = LoadSound("Resources/sounds/menu_select.wav");
-        soundManager->soundLoaded[SOUND_MENU_SELECT] = true;
-    }
+    LoadGameSoundFile(soundManager, SOUND_MENU_SELECT, "Resources/sounds/menu_select.wav");
     
     // Game over sound - you have this as MP3 so we'll use that
-    if (FileExists("Resources/sounds/game_over.mp3")) {
-        soundManager->sounds[SOUND_GAME_OVER] = LoadSound("Resources/sounds/game_over.mp3");
-        soundManager->soundLoaded[SOUND_GAME_OVER] = true;
+    LoadGameSoundFile(soundManager, SOUND_GAME_OVER, "Resources/sounds/game_over.mp3");
+
+    // Saucer shots - the other alienshoot, so they don't sound like the ship's
+    LoadGameSoundFile(soundManager, SOUND_UFO_SHOOT, "Resources/sounds/alienshoot2.wav");
+
+    // The null device decodes music up front, it does not stream it
+    if (soundManager->nullDevice) {
+        soundManager->musicLoaded = LoadNullAudioMusic(&soundManager->nullAudio, NULL_AUDIO_MUSIC_MENU,
+                                                       "Resources/music/menu_music.mp3");
+        // Without a separate game track the menu track is shared, see NullGameMusicTrack()
+        LoadNullAudioMusic(&soundManager->nullAudio, NULL_AUDIO_MUSIC_GAME, "Resources/music/menu_music2.mp3");
+        SetGameMusicVolume(soundManager, soundManager->musicVolume);
+        return;
     }
     
     // Load music files
@@ -93,6 +121,16 @@ void LoadGameSounds(SoundManager *soundManager)
 
 void UnloadGameSounds(SoundManager *soundManager)
 {
+    // The null device owns all its waves, there is no audio device to close
+    if (soundManager->nullDevice) {
+        CloseNullAudio(&soundManager->nullAudio);
+        for (int i = 0; i < MAX_SOUNDS; i++) {
+            soundManager->soundLoaded[i] = false;
+        }
+        soundManager->musicLoaded = false;
+        return;
+    }
+
     // Unload all sound effects that were loaded
     for (int i = 0; i < MAX_SOUNDS; i++) {
         if (soundManager->soundLoaded[i]) {
@@ -122,12 +160,52 @@ void PlayGameSound(SoundManager *soundManager, SoundType soundType)
 {
     // Only play if the sound was loaded successfully and sound is enabled
     if (soundType < MAX_SOUNDS && soundManager->soundLoaded[soundType]) {
-        PlaySound(soundManager->sounds[soundType]);
+        if (soundManager->nullDevice) {
+            PlayNullAudioWave(&soundManager->nullAudio, soundType,
+                              soundManager->soundMuted ? 0.0f : soundManager->soundVolume);
+        } else {
+            PlaySound(soundManager->sounds[soundType]);
+        }
     }
 }
 
+// Null device version of UpdateGameMusic, same rules but it also mixes one tick worth of audio
+static void UpdateNullGameMusic(SoundManager *soundManager, Game *game)
+{
+    NullAudioDevice *device = &soundManager->nullAudio;
+    int gameTrack = NullGameMusicTrack(soundManager);
+
+    if (soundManager->musicLoaded) {
+        if (game->state == GAMEPLAY) {
+            if (gameTrack != NULL_AUDIO_MUSIC_MENU && IsNullAudioMusicPlaying(device, NULL_AUDIO_MUSIC_MENU)) {
+                StopNullAudioMusic(device, NULL_AUDIO_MUSIC_MENU);
+            }
+
+            if (!IsNullAudioMusicPlaying(device, gameTrack) && game->settings.musicEnabled) {
+                PlayNullAudioMusic(device, gameTrack, soundManager->musicVolume);
+            }
+        } else if (game->state != PAUSED) {
+            if (gameTrack != NULL_AUDIO_MUSIC_MENU && IsNullAudioMusicPlaying(device, gameTrack)) {
+                StopNullAudioMusic(device, gameTrack);
+            }
+
+            if (!IsNullAudioMusicPlaying(device, NULL_AUDIO_MUSIC_MENU) && game->settings.musicEnabled) {
+                PlayNullAudioMusic(device, NULL_AUDIO_MUSIC_MENU, soundManager->musicVolume);
+            }
+        }
+    }
+
+    // UpdateGame() runs once per simulation tick so this keeps the mix in step with the simulation
+    MixNullAudio(device, NULL_AUDIO_SAMPLE_RATE / GAME_TICK_RATE);
+}
+
 void UpdateGameMusic(SoundManager *soundManager, Game *game)
 {
+    if (soundManager->nullDevice) {
+        UpdateNullGameMusic(soundManager, game);
+        return;
+    }
+
     // Only update music if it was loaded successfully
     if (!soundManager->musicLoaded) return;
     
@@ -167,6 +245,12 @@ void SetGameSoundVolume(SoundManager *soundManager, float volume)
 {
     // Clamp volume between 0.0 and 1.0
     soundManager->soundVolume = volume < 0.0f ? 0.0f : (volume > 1.0f ? 1.0f : volume);
+
+    // The null device picks the volume up the next time a sound is played
+    if (soundManager->nullDevice) {
+        soundManager->soundMuted = false;
+        return;
+    }
     
     // Apply volume to all loaded sounds
     for (int i = 0; i < MAX_SOUNDS; i++) {
@@ -180,6 +264,12 @@ void SetGameMusicVolume(SoundManager *soundManager, float volume)
 {
     // Clamp volume between 0.0 and 1.0
     soundManager->musicVolume = volume < 0.0f ? 0.0f : (volume > 1.0f ? 1.0f : volume);
+
+    if (soundManager->nullDevice) {
+        SetNullAudioMusicVolume(&soundManager->nullAudio, NULL_AUDIO_MUSIC_MENU, soundManager->musicVolume);
+        SetNullAudioMusicVolume(&soundManager->nullAudio, NULL_AUDIO_MUSIC_GAME, soundManager->musicVolume);
+        return;
+    }
     
     if (soundManager->musicLoaded) {
         SetMusicVolume(soundManager->menuMusic, soundManager->musicVolume);
@@ -193,6 +283,8 @@ void ToggleSoundEnabled(SoundManager *soundManager, bool enabled)
 {
     if (enabled) {
         SetGameSoundVolume(soundManager, soundManager->soundVolume);
+    } else if (soundManager->nullDevice) {
+        soundManager->soundMuted = true;
     } else {
         // Keep the soundManager->soundVolume value but set actual sound output to 0
         for (int i = 0; i < MAX_SOUNDS; i++) {
@@ -206,6 +298,15 @@ void ToggleSoundEnabled(SoundManager *soundManager, bool enabled)
 void ToggleMusicEnabled(SoundManager *soundManager, bool enabled)
 {
     if (!soundManager->musicLoaded) return;
+
+    if (soundManager->nullDevice) {
+        // Volume is kept as it is, UpdateGameMusic starts the right track again when enabled
+        if (!enabled) {
+            PauseNullAudioMusic(&soundManager->nullAudio, NULL_AUDIO_MUSIC_MENU);
+            PauseNullAudioMusic(&soundManager->nullAudio, NULL_AUDIO_MUSIC_GAME);
+        }
+        return;
+    }
     
     if (enabled) {
         SetMusicVolume(soundManager->menuMusic, soundManager->musicVolume);
@@ -228,7 +329,10 @@ void ToggleMusicEnabled(SoundManager *soundManager, bool enabled)
 
 void PauseGameMusic(SoundManager *soundManager)
 {
-    if (soundManager->musicLoaded) {
+    if (soundManager->musicLoaded && soundManager->nullDevice) {
+        PauseNullAudioMusic(&soundManager->nullAudio, NULL_AUDIO_MUSIC_MENU);
+        PauseNullAudioMusic(&soundManager->nullAudio, NULL_AUDIO_MUSIC_GAME);
+    } else if (soundManager->musicLoaded) {
         if (IsMusicStreamPlaying(soundManager->menuMusic)) {
             PauseMusicStream(soundManager->menuMusic);
         }
@@ -247,3 +351,11 @@ void ResumeGameMusic(SoundManager *soundManager)
     // We don't directly resume music here, UpdateGameMusic will handle it
     // based on the current game state
 }
+
+bool ExportGameAudio(SoundManager *soundManager, const char *fileName)
+{
+    // Only the null device keeps what it played, the real device sends it straight to the speakers
+    if (!soundManager->nullDevice) return false;
+
+    return ExportNullAudio(&soundManager->nullAudio, fileName);
+}
@@ -0,0 +1,412 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-15 09:21:44
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-15 17:08:12
+*/
+
+/*
+ * Spatial grid for the asteroid field. Bots, aim assist and the respawn check all want
+ * to ask questions like "which asteroids are near me" and brute forcing every asteroid
+ * for every question gets expensive as soon as the field is big. The grid is updated
+ * once per tick and only asteroids that moved into another cell get relinked. The update
+ * copies every position and radius in by index first and relinks in index order after,
+ * so the lists come out the same however the rows of the asteroid table are shuffled.
+ *
+ * The world is a torus (see WrapPosition), so every distance here is measured to the
+ * closest wrapped copy of the asteroid and cell coordinates wrap around as well.
+ */
+
+#include "spatial.h"
+#include "asteroids.h"
+#include <raylib.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Shortest signed distance on a wrapping axis, without any branches
+static inline float WrapDelta(float delta, float size)
+{
+    return delta - size * floorf(delta / size + 0.5f);
+}
+
+static inline int WrapIndex(int index, int count)
+{
+    index %= count;
+    return index < 0 ? index + count : index;
+}
+
+static int CellOfPosition(const SpatialGrid *grid, Vector2 position)
+{
+    int cx = WrapIndex((int)floorf(position.x / grid->cellWidth), grid->columns);
+    int cy = WrapIndex((int)floorf(position.y / grid->cellHeight), grid->rows);
+    return cy * grid->columns + cx;
+}
+
+// Starts a new query, every asteroid with the new stamp has already been looked at
+static void NextQueryStamp(SpatialGrid *grid)
+{
+    grid->queryStamp++;
+    if (grid->queryStamp == 0) {
+        // it wrapped around after ~4 billion queries, old stamps could collide so clear them
+        memset(grid->stamp, 0, sizeof(unsigned int) * grid->capacity);
+        grid->queryStamp = 1;
+    }
+}
+
+bool InitSpatialGrid(SpatialGrid *grid, float worldWidth, float worldHeight, float cellSize, int capacity)
+{
+    memset(grid, 0, sizeof(*grid));
+
+    grid->worldWidth = worldWidth;
+    grid->worldHeight = worldHeight;
+    grid->columns = (int)(worldWidth / cellSize);
+    grid->rows = (int)(worldHeight / cellSize);
+    if (grid->columns < 1) grid->columns = 1;
+    if (grid->rows < 1) grid->rows = 1;
+    grid->cellWidth = worldWidth / grid->columns;
+    grid->cellHeight = worldHeight / grid->rows;
+    grid->capacity = capacity;
+
+    grid->cellHead = malloc(sizeof(int) * grid->columns * grid->rows);
+    grid->next = malloc(sizeof(int) * capacity);
+    grid->prev = malloc(sizeof(int) * capacity);
+    grid->cellOf = malloc(sizeof(int) * capacity);
+    grid->stamp = calloc(capacity, sizeof(unsigned int));
+    grid->position = calloc(capacity, sizeof(Vector2));
+    grid->radius = malloc(sizeof(float) * capacity);
+
+    if (!grid->cellHead || !grid->next || !grid->prev || !grid->cellOf || !grid->stamp || !grid->position || !grid->radius) {
+        FreeSpatialGrid(grid);
+        return false;
+    }
+
+    ClearSpatialGrid(grid);
+    return true;
+}
+
+void FreeSpatialGrid(SpatialGrid *grid)
+{
+    free(grid->cellHead);
+    free(grid->next);
+    free(grid->prev);
+    free(grid->cellOf);
+    free(grid->stamp);
+    free(grid->position);
+    free(grid->radius);
+    memset(grid, 0, sizeof(*grid));
+}
+
+void ClearSpatialGrid(SpatialGrid *grid)
+{
+    for (int i = 0; i < grid->columns * grid->rows; i++) {
+        grid->cellHead[i] = -1;
+    }
+
+    for (int i = 0; i < grid->capacity; i++) {
+        grid->cellOf[i] = -1;
+        grid->radius[i] = -1.0f;
+    }
+
+    grid->maxRadius = 0.0f;
+}
+
+static void UnlinkAsteroid(SpatialGrid *grid, int index)
+{
+    int cell = grid->cellOf[index];
+
+    if (grid->prev[index] >= 0) grid->next[grid->prev[index]] = grid->next[index];
+    else grid->cellHead[cell] = grid->next[index];
+
+    if (grid->next[index] >= 0) grid->prev[grid->next[index]] = grid->prev[index];
+
+    grid->cellOf[index] = -1;
+}
+
+static void LinkAsteroid(SpatialGrid *grid, int index, int cell)
+{
+    grid->prev[index] = -1;
+    grid->next[index] = grid->cellHead[cell];
+    if (grid->cellHead[cell] >= 0) grid->prev[grid->cellHead[cell]] = index;
+    grid->cellHead[cell] = index;
+    grid->cellOf[index] = cell;
+}
+
+// Relinks every asteroid whose copy says it is in another cell now, in index order
+static void RelinkSpatialGrid(SpatialGrid *grid)
+{
+    float maxRadius = 0.0f;
+
+    for (int i = 0; i < grid->capacity; i++)
+    {
+        if (grid->radius[i] < 0.0f)
+        {
+            // destroyed since the last update
+            if (grid->cellOf[i] >= 0) UnlinkAsteroid(grid, i);
+            continue;
+        }
+
+        // only touch the links if the asteroid actually crossed into another cell
+        int cell = CellOfPosition(grid, grid->position[i]);
+        if (grid->cellOf[i] != cell)
+        {
+            if (grid->cellOf[i] >= 0) UnlinkAsteroid(grid, i);
+            LinkAsteroid(grid, i, cell);
+        }
+
+        if (grid->radius[i] > maxRadius) maxRadius = grid->radius[i];
+    }
+
+    grid->maxRadius = maxRadius;
+}
+
+// The world's asteroids, straight out of their columns
+void UpdateSpatialGrid(SpatialGrid *grid, const EcsWorld *world)
+{
+    for (int i = 0; i < grid->capacity; i++) grid->radius[i] = -1.0f;
+
+    EcsQuery query = EcsQueryAll(world, ASTEROID_COMPONENTS);
+    while (EcsNextArchetype(&query))
+    {
+        const Vector2 *position = EcsColumn(&query, COMPONENT_POSITION);
+        const float *radius = EcsColumn(&query, COMPONENT_RADIUS);
+
+        for (int row = 0; row < query.count; row++)
+        {
+            int i = EcsRowIndex(&query, row);
+            if (i >= grid->capacity) continue;
+            grid->position[i] = position[row];
+            grid->radius[i] = radius[row];
+        }
+    }
+
+    RelinkSpatialGrid(grid);
+}
+
+void UpdateSpatialGridArrays(SpatialGrid *grid, const Vector2 positions[], const float radii[], int count)
+{
+    if (count > grid->capacity) count = grid->capacity;
+
+    for (int i = 0; i < grid->capacity; i++)
+    {
+        grid->position[i] = i < count ? positions[i] : (Vector2){ 0.0f, 0.0f };
+        grid->radius[i] = i < count ? radii[i] : -1.0f;
+    }
+
+    RelinkSpatialGrid(grid);
+}
+
+// Distance from the point to the surface of the closest wrapped copy of the asteroid (negative when inside)
+static float SurfaceDistance(const SpatialGrid *grid, int index, Vector2 point)
+{
+    float dx = WrapDelta(grid->position[index].x - point.x, grid->worldWidth);
+    float dy = WrapDelta(grid->position[index].y - point.y, grid->worldHeight);
+    return sqrtf(dx * dx + dy * dy) - grid->radius[index];
+}
+
+/*
+ * K nearest asteroids to a point, sorted from closest to furthest. Distances are measured to
+ * the asteroid outline (center distance minus radius) because that is what matters for
+ * "how close is the danger". Returns how many were found, at most k.
+ */
+int QueryNearestAsteroids(SpatialGrid *grid, Vector2 point, int k, int outIndices[], float outDistances[])
+{
+    if (k <= 0) return 0;
+
+    NextQueryStamp(grid);
+
+    int found = 0;
+    int cx = (int)floorf(point.x / grid->cellWidth);
+    int cy = (int)floorf(point.y / grid->cellHeight);
+    int maxRing = (grid->columns > grid->rows ? grid->columns : grid->rows) / 2 + 1;
+    float ringStep = grid->cellWidth < grid->cellHeight ? grid->cellWidth : grid->cellHeight;
+
+    for (int ring = 0; ring <= maxRing; ring++)
+    {
+        // nothing in this ring or further out can beat the k-th result any more
+        float closestPossible = (ring - 1) * ringStep - grid->maxRadius;
+        if (found == k && closestPossible > outDistances[k - 1]) break;
+
+        for (int y = cy - ring; y <= cy + ring; y++)
+        {
+            // walk only the outline of the ring, the inside was done by the previous rings
+            bool edgeRow = (y == cy - ring || y == cy + ring);
+            int stepX = edgeRow ? 1 : 2 * ring;
+            if (stepX == 0) stepX = 1;
+
+            for (int x = cx - ring; x <= cx + ring; x += stepX)
+            {
+                int cell = WrapIndex(y, grid->rows) * grid->columns + WrapIndex(x, grid->columns);
+
+                for (int i = grid->cellHead[cell]; i >= 0; i = grid->next[i])
+                {
+                    if (grid->stamp[i] == grid->queryStamp) continue;
+                    grid->stamp[i] = grid->queryStamp;
+
+                    float distance = SurfaceDistance(grid, i, point);
+                    if (found == k && distance >= outDistances[k - 1]) continue;
+
+                    // insertion sort into the small result list
+                    int slot = found < k ? found++ : k - 1;
+                    while (slot > 0 && outDistances[slot - 1] > distance)
+                    {
+                        outIndices[slot] = outIndices[slot - 1];
+                        outDistances[slot] = outDistances[slot - 1];
+                        slot--;
+                    }
+                    outIndices[slot] = i;
+                    outDistances[slot] = distance;
+                }
+            }
+        }
+    }
+
+    return found;
+}
+
+/*
+ * Every asteroid that overlaps the circle around the point. Returns how many were written,
+ * which is at most maxResults even if more asteroids overlap.
+ */
+int QueryAsteroidsInRadius(SpatialGrid *grid, Vector2 point, float radius, int outIndices[], int maxResults)
+{
+    NextQueryStamp(grid);
+
+    int found = 0;
+    int cx = (int)floorf(point.x / grid->cellWidth);
+    int cy = (int)floorf(point.y / grid->cellHeight);
+    int reachX = (int)ceilf((radius + grid->maxRadius) / grid->cellWidth);
+    int reachY = (int)ceilf((radius + grid->maxRadius) / grid->cellHeight);
+
+    // once the query is wider than the world every column or row only needs visiting once
+    int spanX = 2 * reachX + 1 > grid->columns ? grid->columns : 2 * reachX + 1;
+    int spanY = 2 * reachY + 1 > grid->rows ? grid->rows : 2 * reachY + 1;
+
+    for (int y = 0; y < spanY; y++)
+    {
+        int row = WrapIndex(cy - reachY + y, grid->rows);
+
+        for (int x = 0; x < spanX; x++)
+        {
+            int cell = row * grid->columns + WrapIndex(cx - reachX + x, grid->columns);
+
+            for (int i = grid->cellHead[cell]; i >= 0; i = grid->next[i])
+            {
+                if (grid->stamp[i] == grid->queryStamp) continue;
+                grid->stamp[i] = grid->queryStamp;
+
+                if (SurfaceDistance(grid, i, point) <= radius)
+                {
+                    if (found == maxResults) return found;
+                    outIndices[found++] = i;
+                }
+            }
+        }
+    }
+
+    return found;
+}
+
+/*
+ * First asteroid hit by a ray, e.g. "what does my ship's heading hit first". The ray wraps
+ * around the screen edges like everything else. Walks the cells the ray passes through in
+ * order (a DDA) and stops as soon as the next cell starts further away than the best hit.
+ * Returns the asteroid index or -1, and the distance along the ray in hitDistance.
+ */
+int RaycastAsteroids(SpatialGrid *grid, Vector2 origin, Vector2 direction, float maxDistance, float *hitDistance)
+{
+    float length = sqrtf(direction.x * direction.x + direction.y * direction.y);
+    if (length <= 0.0f || maxDistance <= 0.0f) return -1;
+
+    Vector2 dir = { direction.x / length, direction.y / length };
+
+    // asteroids are linked by their center, so look this many cells to the side of the ray
+    int reachX = (int)ceilf(grid->maxRadius / grid->cellWidth);
+    int reachY = (int)ceilf(grid->maxRadius / grid->cellHeight);
+    if (2 * reachX + 1 > grid->columns) reachX = grid->columns / 2;
+    if (2 * reachY + 1 > grid->rows) reachY = grid->rows / 2;
+
+    // cell coordinates here do not wrap, only the lookups into the grid do
+    int cx = (int)floorf(origin.x / grid->cellWidth);
+    int cy = (int)floorf(origin.y / grid->cellHeight);
+    int stepX = dir.x > 0.0f ? 1 : -1;
+    int stepY = dir.y > 0.0f ? 1 : -1;
+
+    float deltaX = dir.x != 0.0f ? fabsf(grid->cellWidth / dir.x) : INFINITY;
+    float deltaY = dir.y != 0.0f ? fabsf(grid->cellHeight / dir.y) : INFINITY;
+    float nextX = dir.x != 0.0f ? ((cx + (stepX > 0)) * grid->cellWidth - origin.x) / dir.x : INFINITY;
+    float nextY = dir.y != 0.0f ? ((cy + (stepY > 0)) * grid->cellHeight - origin.y) / dir.y : INFINITY;
+
+    int best = -1;
+    float bestDistance = maxDistance;
+    float enter = 0.0f;
+    int lapX = 0, lapY = 0;
+
+    NextQueryStamp(grid);
+
+    while (enter <= bestDistance)
+    {
+        // a new copy of the world, asteroids seen on the last lap have to be tested again
+        int cellLapX = (int)floorf((float)cx / grid->columns);
+        int cellLapY = (int)floorf((float)cy / grid->rows);
+        if (cellLapX != lapX || cellLapY != lapY)
+        {
+            lapX = cellLapX;
+            lapY = cellLapY;
+            NextQueryStamp(grid);
+        }
+
+        Vector2 along = { origin.x + dir.x * enter, origin.y + dir.y * enter };
+
+        for (int y = cy - reachY; y <= cy + reachY; y++)
+        {
+            int row = WrapIndex(y, grid->rows);
+
+            for (int x = cx - reachX; x <= cx + reachX; x++)
+            {
+                int cell = row * grid->columns + WrapIndex(x, grid->columns);
+
+                for (int i = grid->cellHead[cell]; i >= 0; i = grid->next[i])
+                {
+                    if (grid->stamp[i] == grid->queryStamp) continue;
+                    grid->stamp[i] = grid->queryStamp;
+
+                    // center of the copy closest to this part of the ray, relative to the origin
+                    float rx = WrapDelta(grid->position[i].x - along.x, grid->worldWidth) + along.x - origin.x;
+                    float ry = WrapDelta(grid->position[i].y - along.y, grid->worldHeight) + along.y - origin.y;
+
+                    float b = rx * dir.x + ry * dir.y;
+                    float c = rx * rx + ry * ry - grid->radius[i] * grid->radius[i];
+                    float discriminant = b * b - c;
+                    if (discriminant < 0.0f) continue;
+
+                    // if the origin is inside the asteroid it is hit straight away
+                    float t = c <= 0.0f ? 0.0f : b - sqrtf(discriminant);
+                    if (t < 0.0f || t >= bestDistance) continue;
+
+                    best = i;
+                    bestDistance = t;
+                }
+            }
+        }
+
+        // step into whichever neighbouring cell the ray reaches first
+        if (nextX < nextY)
+        {
+            enter = nextX;
+            nextX += deltaX;
+            cx += stepX;
+        }
+        else
+        {
+            enter = nextY;
+            nextY += deltaY;
+            cy += stepY;
+        }
+
+        if (enter > maxDistance) break;
+    }
+
+    if (best >= 0 && hitDistance != NULL) *hitDistance = bestDistance;
+    return best;
+}
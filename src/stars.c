@@ -55,19 +55,45 @@ void UpdateStars(Star *stars)
         }
     }
 
-    // Optional adding the paralax effect with layers
+    // the parallax with the layers is in DrawStars, it follows the camera
 }
 
+/*
+ * The stars are wrapped into the canvas, so there is nothing off screen to cull. What they cost is
+ * the shape: a circle is a fan of dozens of triangles, which at 2 or 3 pixels looks no different
+ * from a square of two. So a star is a pixel, a square or a circle by its size on screen.
+ */
 void DrawStars(Star *stars)
 {
+    // when the camera follows the ship around a bigger world the stars drift by, the far layers slower
+    Vector2 travel = WorldScrolls() ? WorldViewTravel() : (Vector2){ 0.0f, 0.0f };
+    float pixelScale = ViewPixelScale();
+
     for (int i = 0; i < MAX_STARS; i++)
     {
-        if (stars[i].size == 1)
+        float depth = (stars[i].layer + 1) / (2.0f * (STAR_LAYERS + 1));
+        Vector2 position = {
+            fmodf(stars[i].position.x - travel.x * depth, (float)screenWidth),
+            fmodf(stars[i].position.y - travel.y * depth, (float)screenHeight)
+        };
+        if (position.x < 0.0f) position.x += screenWidth;
+        if (position.y < 0.0f) position.y += screenHeight;
+
+        float onScreen = stars[i].size * pixelScale;
+        if (onScreen < STAR_LOD_POINT)
+        {
+            DrawPixelV(position, stars[i].color);
+            drawStats.starsPoint++;
+        }
+        else if (onScreen < STAR_LOD_SQUARE)
         {
-            DrawPixelV(stars[i].position, stars[i].color);
+            float side = stars[i].size;
+            DrawRectangleV((Vector2){ position.x - side * 0.5f, position.y - side * 0.5f }, (Vector2){ side, side }, stars[i].color);
+            drawStats.starsReduced++;
         }
         else {
-            DrawCircleV(stars[i].position, stars[i].size * 0.5f, stars[i].color);
+            DrawCircleV(position, stars[i].size * 0.5f, stars[i].color);
+            drawStats.starsFull++;
         }
     }
 }
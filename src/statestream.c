@@ -0,0 +1,955 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-19 10:04:27
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-19 17:48:13
+*/
+
+/*
+ * State stream encoder and decoder. The game is cut into slots: one for the game itself (tick,
+ * score, state) and one for every index of the entity tables (InitGameWorld): the ships, the
+ * asteroids, the bullets, the saucers and their shots. Each slot is a few integers
+ * (positions in 1/256 pixel, angles in 1/65536 of a turn, a bullet's lifetime in ticks) with a
+ * step for each, plus a byte or two that only change when the slot gets something new in it: the
+ * radius and the outline's phase of an asteroid, the palette index of a bullet (compact.h). What
+ * follows from those (the outline, the color, the alpha) is worked out again on the viewer's side.
+ *
+ * Nearly everything in this game moves in a straight line at a constant speed, so both sides
+ * guess that every value goes on changing by its step. The steps come from the real velocities
+ * and are fine grained enough that the guess stays within 1/16 pixel for a long time, and a slot
+ * that is within that of the guess isn't sent at all. Runs of such slots are skipped with one
+ * short count. The rest send how far off the guess was and how the step changed, with a short
+ * variable length code. Spawns send the slot in full, and keyframes send everything in full so
+ * a viewer can start there without knowing anything that came before. A full slot packs its
+ * position into 16 bits a side and its velocity into a heading and a speed (PutFullSlot), the
+ * next delta puts right what that rounded off once it shows.
+ *
+ * The encoder keeps the same copy of the slots the viewers have and only ever compares against
+ * that, so the small errors the guesses are allowed to have can't add up over time.
+ */
+
+#include "statestream.h"
+#include "compact.h"
+#include "fixed.h"
+#include "game.h"
+#include "ufo.h"
+#include "world.h"
+#include <fcntl.h>
+#include <math.h>
+#include <raylib.h>
+#include <raymath.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define POSITION_SCALE   256.0f                // 1/256 pixel
+#define ANGLE_STEPS      65536                 // one turn, must be a power of two
+#define COORDINATE_BITS  16                    // a position in a full slot, as a fraction of the world's width or height
+#define HEADER_SIZE      16
+
+#define SLOT_GAME        0
+#define SLOT_SHIPS       1
+#define SLOT_ASTEROIDS   3
+#define SLOT_BULLETS     (SLOT_ASTEROIDS + MAX_ASTEROIDS)
+#define SLOT_SAUCERS     (SLOT_BULLETS + BULLET_SLOTS)
+#define SLOT_SHOTS       (SLOT_SAUCERS + UFO_MAX_SAUCERS)
+
+// External globals for screen dimensions
+extern int screenWidth;
+extern int screenHeight;
+
+typedef enum SlotKind {
+    KIND_GAME,
+    KIND_SHIP,
+    KIND_ASTEROID,
+    KIND_BULLET,
+    KIND_ENTITY
+} SlotKind;
+
+// How the values of each kind of slot behave
+typedef struct KindInfo {
+    int  fields;
+    int  attributeBytes;
+    bool moving;                               // the first two fields are a position and its steps the velocity
+    bool linear[STREAM_MAX_FIELDS];            // guessed to keep changing by the last step, otherwise to stay the same
+    int  wrap[STREAM_MAX_FIELDS];              // angles wrap around at ANGLE_STEPS, 0 for no wrapping
+    int  tolerance[STREAM_MAX_FIELDS];         // how far off the guess may be before it gets corrected, 1/16 pixel for positions
+} KindInfo;
+
+static const KindInfo kinds[] = {
+    // tick, state, score, second score, loser + 1, versus
+    [KIND_GAME]     = { 6, 0, false, { true }, { 0 }, { 0 } },
+    // x, y, rotation, thrusting
+    [KIND_SHIP]     = { 4, 0, true, { true, true, true, false }, { 0, 0, ANGLE_STEPS, 0 }, { 16, 16, 16, 0 } },
+    // x, y, rotation; radius in half pixels and the phase of the outline
+    [KIND_ASTEROID] = { 3, 2, true, { true, true, true }, { 0, 0, ANGLE_STEPS }, { 16, 16, 16 } },
+    // x, y, lifetime; palette index, the radius, color and alpha follow from it and the lifetime
+    [KIND_BULLET]   = { 3, 1, true, { true, true, true }, { 0 }, { 16, 16, 0 } },
+    // x, y; radius and the saucer kind + 1, 0 for a shot
+    [KIND_ENTITY]   = { 2, 2, true, { true, true }, { 0 }, { 16, 16 } },
+};
+
+// Never more than a slot has room for, also what lets the compiler see the loops stay inside attributes[]
+static int AttributeBytes(const KindInfo *kind)
+{
+    return kind->attributeBytes < STREAM_MAX_ATTRIBUTES ? kind->attributeBytes : STREAM_MAX_ATTRIBUTES;
+}
+
+static SlotKind KindOfSlot(int slot)
+{
+    if (slot == SLOT_GAME) return KIND_GAME;
+    if (slot < SLOT_ASTEROIDS) return KIND_SHIP;
+    if (slot < SLOT_BULLETS) return KIND_ASTEROID;
+    if (slot < SLOT_SAUCERS) return KIND_BULLET;
+    return KIND_ENTITY;
+}
+
+/*
+ * Bit packing, least significant bit first. The writer keeps up to 64 bits in hand and hands
+ * out whole bytes, the reader does the same the other way and reads zeros past the end.
+ */
+typedef struct BitWriter {
+    unsigned char *data;
+    int            capacity;
+    int            size;
+    uint64_t       bits;
+    int            count;
+    bool           overflow;
+} BitWriter;
+
+typedef struct BitReader {
+    const unsigned char *data;
+    int                  size;
+    int                  read;
+    uint64_t             bits;
+    int                  count;
+    bool                 overrun;
+} BitReader;
+
+static void PutBits(BitWriter *writer, uint32_t value, int count)
+{
+    writer->bits |= (uint64_t)(value & (uint32_t)((1ull << count) - 1)) << writer->count;
+    writer->count += count;
+
+    while (writer->count >= 8)
+    {
+        if (writer->size < writer->capacity) writer->data[writer->size++] = (unsigned char)writer->bits;
+        else writer->overflow = true;
+        writer->bits >>= 8;
+        writer->count -= 8;
+    }
+}
+
+static int FinishBits(BitWriter *writer)
+{
+    if (writer->count > 0) PutBits(writer, 0, 8 - writer->count);
+    return writer->overflow ? 0 : writer->size;
+}
+
+static uint32_t GetBits(BitReader *reader, int count)
+{
+    while (reader->count < count)
+    {
+        uint64_t byte = 0;
+        if (reader->read < reader->size) byte = reader->data[reader->read++];
+        else reader->overrun = true;
+        reader->bits |= byte << reader->count;
+        reader->count += 8;
+    }
+
+    uint32_t value = (uint32_t)(reader->bits & ((1ull << count) - 1));
+    reader->bits >>= count;
+    reader->count -= count;
+    return value;
+}
+
+/*
+ * Numbers: one bit for zero, or a one and a 2 bit size class followed by 4, 8, 16 or 32 bits.
+ * Signed ones are zigzagged first so small negative numbers are small too.
+ */
+static const int numberBits[4] = { 4, 8, 16, 32 };
+
+static void PutUnsigned(BitWriter *writer, uint32_t value)
+{
+    if (value == 0)
+    {
+        PutBits(writer, 0, 1);
+        return;
+    }
+
+    int size = value < (1u << 4) ? 0 : value < (1u << 8) ? 1 : value < (1u << 16) ? 2 : 3;
+    PutBits(writer, 1 | (size << 1), 3);
+    PutBits(writer, value, numberBits[size]);
+}
+
+static uint32_t GetUnsigned(BitReader *reader)
+{
+    if (GetBits(reader, 1) == 0) return 0;
+    return GetBits(reader, numberBits[GetBits(reader, 2)]);
+}
+
+static void PutSigned(BitWriter *writer, int value)
+{
+    PutUnsigned(writer, ((uint32_t)value << 1) ^ (uint32_t)(value >> 31));
+}
+
+static int GetSigned(BitReader *reader)
+{
+    uint32_t zigzag = GetUnsigned(reader);
+    return (int)(zigzag >> 1) ^ -(int)(zigzag & 1);
+}
+
+// Differences between angles go the short way around
+static int WrapDelta(int delta, int wrap)
+{
+    if (wrap == 0) return delta;
+    delta &= wrap - 1;
+    return delta >= wrap / 2 ? delta - wrap : delta;
+}
+
+static int WrapValue(int value, int wrap)
+{
+    return wrap == 0 ? value : value & (wrap - 1);
+}
+
+static int QuantizePosition(float value)
+{
+    return (int)lrintf(value * POSITION_SCALE);
+}
+
+static int QuantizeRadians(float radians)
+{
+    return (int)lrintf(radians * (ANGLE_STEPS / (2.0f * PI)));
+}
+
+static unsigned char QuantizeByte(float value)
+{
+    long rounded = lrintf(value);
+    return (unsigned char)(rounded < 0 ? 0 : rounded > 255 ? 255 : rounded);
+}
+
+/*
+ * What the game looks like as slots. The steps are filled in from the velocities, they are what
+ * a spawn or a keyframe tells the viewer to expect next.
+ */
+static void QuantizeGame(const Game *game, StreamSlot slots[STREAM_SLOTS])
+{
+    memset(slots, 0, sizeof(StreamSlot) * STREAM_SLOTS);
+
+    StreamSlot *info = &slots[SLOT_GAME];
+    info->active = true;
+    info->value[0] = (int)game->tick;
+    info->value[1] = game->state;
+    info->value[2] = game->score;
+    info->value[3] = game->secondScore;
+    info->value[4] = game->versusLoser + 1;
+    info->value[5] = game->versus;
+    info->step[0] = game->state == GAMEPLAY ? 1 : 0;
+
+    for (int i = 0; i < 2; i++)
+    {
+        Player ship = GetPlayer(&game->entities, i);
+        StreamSlot *slot = &slots[SLOT_SHIPS + i];
+        slot->active = i == 0 || game->versus;
+        slot->value[0] = QuantizePosition(ship.position.x);
+        slot->value[1] = QuantizePosition(ship.position.y);
+        slot->value[2] = WrapValue(QuantizeRadians(ship.rotation * DEG2RAD), ANGLE_STEPS);
+        slot->value[3] = ship.isThrusting;
+        slot->step[0] = QuantizePosition(ship.velocity.x);
+        slot->step[1] = QuantizePosition(ship.velocity.y);
+        slot->step[2] = QuantizeRadians(ship.rotationVelocity * DEG2RAD);
+    }
+
+    for (int i = 0; i < MAX_ASTEROIDS; i++)
+    {
+        Asteroid asteroid;
+        StreamSlot *slot = &slots[SLOT_ASTEROIDS + i];
+        if (!GetAsteroid(&game->entities, i, &asteroid)) continue;
+
+        slot->active = true;
+        slot->value[0] = QuantizePosition(asteroid.position.x);
+        slot->value[1] = QuantizePosition(asteroid.position.y);
+        slot->value[2] = WrapValue(QuantizeRadians(asteroid.rotation), ANGLE_STEPS);
+        slot->step[0] = QuantizePosition(asteroid.velocity.x);
+        slot->step[1] = QuantizePosition(asteroid.velocity.y);
+        slot->step[2] = QuantizeRadians(asteroid.rotationSpeed);
+
+        // the outline is one wobble, its phase is enough to build it again
+        slot->attributes[0] = QuantizeByte(asteroid.radius * 2.0f);
+        slot->attributes[1] = (unsigned char)AsteroidOutlinePhase(&asteroid);
+    }
+
+    for (int i = 0; i < BULLET_SLOTS; i++)
+    {
+        Bullet bullet;
+        StreamSlot *slot = &slots[SLOT_BULLETS + i];
+        if (!GetBullet(&game->entities, i, &bullet)) continue;
+
+        slot->active = true;
+        slot->value[0] = QuantizePosition(bullet.position.x);
+        slot->value[1] = QuantizePosition(bullet.position.y);
+        slot->value[2] = bullet.lifeTime;
+        slot->step[0] = QuantizePosition(bullet.velocity.x);
+        slot->step[1] = QuantizePosition(bullet.velocity.y);
+        slot->step[2] = -1;                                   // a tick less every tick, see UpdateBullets()
+        slot->attributes[0] = (unsigned char)FindBulletKind(&bullet);
+    }
+
+    // by index, which an entity keeps for as long as it lives while its row moves around
+    EcsQuery query = EcsQueryAll(&game->entities, COMPONENT_BIT(COMPONENT_POSITION) | COMPONENT_BIT(COMPONENT_VELOCITY) |
+                                                  COMPONENT_BIT(COMPONENT_RADIUS) | COMPONENT_BIT(COMPONENT_HOSTILE));
+    while (EcsNextArchetype(&query))
+    {
+        const Vector2 *position = EcsColumn(&query, COMPONENT_POSITION);
+        const Vector2 *velocity = EcsColumn(&query, COMPONENT_VELOCITY);
+        const float *radius = EcsColumn(&query, COMPONENT_RADIUS);
+        const UfoBrain *brain = (query.archetype->mask & COMPONENT_BIT(COMPONENT_UFO)) ? EcsColumn(&query, COMPONENT_UFO) : NULL;
+
+        for (int row = 0; row < query.count; row++)
+        {
+            StreamSlot *slot = &slots[(brain != NULL ? SLOT_SAUCERS : SLOT_SHOTS) + EcsRowIndex(&query, row)];
+            slot->active = true;
+            slot->value[0] = QuantizePosition(position[row].x);
+            slot->value[1] = QuantizePosition(position[row].y);
+            slot->step[0] = QuantizePosition(velocity[row].x);
+            slot->step[1] = QuantizePosition(velocity[row].y);
+            slot->attributes[0] = QuantizeByte(radius[row] * 4.0f);
+            slot->attributes[1] = brain != NULL ? (unsigned char)(brain[row].kind + 1) : 0;
+        }
+    }
+}
+
+// The viewer's slots back into a game DrawGame() can draw
+static void DequantizeGame(const StreamSlot slots[STREAM_SLOTS], Game *game)
+{
+    const StreamSlot *info = &slots[SLOT_GAME];
+    game->tick = (unsigned int)info->value[0];
+    game->state = (GameState)info->value[1];
+    game->score = info->value[2];
+    game->secondScore = info->value[3];
+    game->versusLoser = info->value[4] - 1;
+    game->versus = info->value[5] != 0;
+
+    // every entity is put back at its index, the world is built again from the slots
+    InitGameWorld(&game->entities);
+    for (int i = 0; i < 2; i++)
+    {
+        const StreamSlot *slot = &slots[SLOT_SHIPS + i];
+        Player ship = GetPlayer(&game->entities, i);
+        ship.position = (Vector2){ slot->value[0] / POSITION_SCALE, slot->value[1] / POSITION_SCALE };
+        ship.velocity = (Vector2){ slot->step[0] / POSITION_SCALE, slot->step[1] / POSITION_SCALE };
+        ship.rotation = slot->value[2] * (360.0f / ANGLE_STEPS);
+        ship.isThrusting = slot->value[3] != 0;
+        PutPlayer(&game->entities, i, &ship);
+    }
+
+    for (int i = 0; i < MAX_ASTEROIDS; i++)
+    {
+        const StreamSlot *slot = &slots[SLOT_ASTEROIDS + i];
+        if (!slot->active) continue;
+
+        Asteroid asteroid = { 0 };
+        asteroid.position = (Vector2){ slot->value[0] / POSITION_SCALE, slot->value[1] / POSITION_SCALE };
+        asteroid.velocity = (Vector2){ slot->step[0] / POSITION_SCALE, slot->step[1] / POSITION_SCALE };
+        asteroid.rotation = slot->value[2] * (2.0f * PI / ANGLE_STEPS);
+        asteroid.radius = slot->attributes[0] / 2.0f;
+        RebuildAsteroidOutline(&asteroid, slot->attributes[1]);
+        PutAsteroid(&game->entities, i, &asteroid);
+    }
+
+    for (int i = 0; i < BULLET_SLOTS; i++)
+    {
+        const StreamSlot *slot = &slots[SLOT_BULLETS + i];
+        if (!slot->active) continue;
+
+        Bullet bullet;
+        BulletKind kind = slot->attributes[0] < BULLET_KINDS ? (BulletKind)slot->attributes[0] : BULLET_CENTER;
+        bullet.position = (Vector2){ slot->value[0] / POSITION_SCALE, slot->value[1] / POSITION_SCALE };
+        bullet.velocity = (Vector2){ slot->step[0] / POSITION_SCALE, slot->step[1] / POSITION_SCALE };
+        bullet.lifeTime = slot->value[2];
+        bullet.radius = BulletKindRadius(kind);
+        bullet.color = BulletKindColor(kind);
+        PutBullet(&game->entities, i, &bullet);
+    }
+
+    // enough for DrawUfos(), which only looks at these components
+    for (int i = SLOT_SAUCERS; i < STREAM_SLOTS; i++)
+    {
+        const StreamSlot *slot = &slots[i];
+        if (!slot->active) continue;
+
+        EntityId entity = i < SLOT_SHOTS ? EcsSpawnAt(&game->entities, UFO_COMPONENTS, i - SLOT_SAUCERS)
+                                         : EcsSpawnAt(&game->entities, UFO_SHOT_COMPONENTS, i - SLOT_SHOTS);
+        if (entity == ECS_NO_ENTITY) continue;
+
+        *(Vector2 *)EcsGet(&game->entities, entity, COMPONENT_POSITION) = (Vector2){ slot->value[0] / POSITION_SCALE, slot->value[1] / POSITION_SCALE };
+        *(Vector2 *)EcsGet(&game->entities, entity, COMPONENT_VELOCITY) = (Vector2){ slot->step[0] / POSITION_SCALE, slot->step[1] / POSITION_SCALE };
+        *(float *)EcsGet(&game->entities, entity, COMPONENT_RADIUS) = slot->attributes[0] / 4.0f;
+        if (slot->attributes[1] != 0) ((UfoBrain *)EcsGet(&game->entities, entity, COMPONENT_UFO))->kind = slot->attributes[1] - 1;
+    }
+}
+
+static int PredictValue(const StreamSlot *slot, const KindInfo *kind, int field)
+{
+    if (!kind->linear[field]) return slot->value[field];
+    return WrapValue(slot->value[field] + slot->step[field], kind->wrap[field]);
+}
+
+// Both sides run these on their copy of the slots, the encoder right after it wrote the bits
+static void ApplyPredicted(StreamSlot *slot, const KindInfo *kind)
+{
+    if (!slot->active) return;
+    for (int f = 0; f < kind->fields; f++) slot->value[f] = PredictValue(slot, kind, f);
+}
+
+static void ApplyCorrection(StreamSlot *slot, const KindInfo *kind, const int residuals[STREAM_MAX_FIELDS], const int stepChanges[STREAM_MAX_FIELDS])
+{
+    for (int f = 0; f < kind->fields; f++)
+    {
+        slot->value[f] = WrapValue(PredictValue(slot, kind, f) + residuals[f], kind->wrap[f]);
+        slot->step[f] += stepChanges[f];
+    }
+}
+
+static void PutCorrection(BitWriter *writer, const KindInfo *kind, const int residuals[STREAM_MAX_FIELDS], const int stepChanges[STREAM_MAX_FIELDS])
+{
+    for (int f = 0; f < kind->fields; f++)
+    {
+        PutSigned(writer, residuals[f]);
+        if (kind->linear[f]) PutSigned(writer, stepChanges[f]);
+    }
+}
+
+static void GetCorrection(BitReader *reader, const KindInfo *kind, int residuals[STREAM_MAX_FIELDS], int stepChanges[STREAM_MAX_FIELDS])
+{
+    for (int f = 0; f < kind->fields; f++)
+    {
+        residuals[f] = GetSigned(reader);
+        stepChanges[f] = kind->linear[f] ? GetSigned(reader) : 0;
+    }
+}
+
+/*
+ * How a full slot sends a position and a velocity. The position is a 16 bit fraction of the world
+ * (1/51 pixel on the canvas, 1/4 at the biggest world) and the velocity a heading in ANGLE_STEPS
+ * and a speed in 1/256 pixel. The steps come back through the fixed-point sine table, so the
+ * encoder and every viewer turn the same bits into the same numbers on any machine. A delta
+ * corrects what that rounded off as soon as it is past the tolerance.
+ */
+typedef struct PackedMotion {
+    unsigned int x, y;
+    unsigned int heading;
+    unsigned int speed;
+} PackedMotion;
+
+// Both edges are steps of it, a bullet can be right on the far one
+static unsigned int PackCoordinate(int value, int pixels)
+{
+    long long size = (long long)pixels * (long long)POSITION_SCALE;
+    long long last = (1ll << COORDINATE_BITS) - 1;
+    long long packed = ((long long)value * last + size / 2) / size;
+    return (unsigned int)(packed < 0 ? 0 : packed > last ? last : packed);
+}
+
+static int UnpackCoordinate(unsigned int packed, int pixels)
+{
+    long long size = (long long)pixels * (long long)POSITION_SCALE;
+    long long last = (1ll << COORDINATE_BITS) - 1;
+    return (int)(((long long)packed * size + last / 2) / last);
+}
+
+static PackedMotion PackMotion(const StreamSlot *slot)
+{
+    PackedMotion packed;
+    packed.x = PackCoordinate(slot->value[0], worldWidth);
+    packed.y = PackCoordinate(slot->value[1], worldHeight);
+
+    // scaled up so the CORDIC has bits to work with, its angles are ANGLE_STEPS already
+    long long x = slot->step[0], y = slot->step[1];
+    uint64_t squared = (uint64_t)(x * x + y * y);
+    uint32_t speed = IntegerSqrt64(squared);
+    if (squared - (uint64_t)speed * speed > speed) speed++;                           // rounded, not truncated
+    packed.heading = FixedAtan2((Fixed)(y * 256), (Fixed)(x * 256));
+    packed.speed = speed;
+    return packed;
+}
+
+static void UnpackMotion(StreamSlot *slot, PackedMotion packed)
+{
+    slot->value[0] = UnpackCoordinate(packed.x, worldWidth);
+    slot->value[1] = UnpackCoordinate(packed.y, worldHeight);
+    slot->step[0] = FixedMul((Fixed)packed.speed, FixedCos((BinaryAngle)packed.heading));
+    slot->step[1] = FixedMul((Fixed)packed.speed, FixedSin((BinaryAngle)packed.heading));
+}
+
+// Also leaves the slot the way GetFullSlot will read it, which is what the encoder has to keep
+static void PutFullSlot(BitWriter *writer, StreamSlot *slot, const KindInfo *kind)
+{
+    for (int a = 0; a < AttributeBytes(kind); a++) PutBits(writer, slot->attributes[a], 8);
+
+    int first = 0;
+    if (kind->moving)
+    {
+        PackedMotion packed = PackMotion(slot);
+        PutBits(writer, packed.x, COORDINATE_BITS);
+        PutBits(writer, packed.y, COORDINATE_BITS);
+        PutBits(writer, packed.heading, 16);
+        PutUnsigned(writer, packed.speed);
+        UnpackMotion(slot, packed);
+        first = 2;
+    }
+
+    for (int f = first; f < kind->fields; f++)
+    {
+        PutSigned(writer, slot->value[f]);
+        if (kind->linear[f]) PutSigned(writer, slot->step[f]);
+    }
+}
+
+static void GetFullSlot(BitReader *reader, StreamSlot *slot, const KindInfo *kind)
+{
+    memset(slot, 0, sizeof(*slot));
+    slot->active = true;
+    for (int a = 0; a < AttributeBytes(kind); a++) slot->attributes[a] = (unsigned char)GetBits(reader, 8);
+
+    int first = 0;
+    if (kind->moving)
+    {
+        PackedMotion packed;
+        packed.x = GetBits(reader, COORDINATE_BITS);
+        packed.y = GetBits(reader, COORDINATE_BITS);
+        packed.heading = GetBits(reader, 16);
+        packed.speed = GetUnsigned(reader);
+        UnpackMotion(slot, packed);
+        first = 2;
+    }
+
+    for (int f = first; f < kind->fields; f++)
+    {
+        slot->value[f] = GetSigned(reader);
+        slot->step[f] = kind->linear[f] ? GetSigned(reader) : 0;
+    }
+}
+
+/*
+ * Frame layout: one bit for keyframes, then the slots in order.
+ *   keyframe:   one bit per slot, 0 = empty, 1 = the slot in full
+ *   otherwise:  a count of slots that are as guessed, then a 2 bit op for the next slot
+ *               (0 = corrections, 1 = something new in full, 2 = gone), and again until the end
+ */
+typedef enum SlotOp {
+    OP_PREDICTED = -1,
+    OP_CORRECT,
+    OP_FULL,
+    OP_GONE
+} SlotOp;
+
+int EncodeStreamFrame(StreamCodec *codec, const Game *game, unsigned char *out, int capacity)
+{
+    StreamSlot current[STREAM_SLOTS];
+    QuantizeGame(game, current);
+
+    bool keyframe = codec->forceKeyframe || codec->ticksSinceKeyframe % STREAM_KEYFRAME_TICKS == 0;
+    codec->ticksSinceKeyframe = keyframe ? 1 : codec->ticksSinceKeyframe + 1;
+    codec->forceKeyframe = false;
+
+    BitWriter writer = { out, capacity, 0, 0, 0, false };
+    PutBits(&writer, keyframe, 1);
+
+    uint32_t unchanged = 0;
+    for (int i = 0; i < STREAM_SLOTS; i++)
+    {
+        const KindInfo *kind = &kinds[KindOfSlot(i)];
+        StreamSlot *view = &codec->slots[i];
+        const StreamSlot *now = &current[i];
+
+        if (keyframe)
+        {
+            PutBits(&writer, now->active, 1);
+            *view = *now;
+            if (now->active) PutFullSlot(&writer, view, kind);
+            continue;
+        }
+
+        // what the viewers need to hear about this slot, if anything
+        SlotOp op = OP_PREDICTED;
+        int residuals[STREAM_MAX_FIELDS] = { 0 };
+        int stepChanges[STREAM_MAX_FIELDS] = { 0 };
+
+        if (!now->active)
+        {
+            if (view->active) op = OP_GONE;
+        }
+        else if (!view->active || memcmp(view->attributes, now->attributes, AttributeBytes(kind)) != 0)
+        {
+            op = OP_FULL;
+        }
+        else
+        {
+            for (int f = 0; f < kind->fields; f++)
+            {
+                residuals[f] = WrapDelta(now->value[f] - PredictValue(view, kind, f), kind->wrap[f]);
+                if (abs(residuals[f]) > kind->tolerance[f]) op = OP_CORRECT;
+            }
+        }
+
+        if (op == OP_PREDICTED)
+        {
+            ApplyPredicted(view, kind);
+            unchanged++;
+            continue;
+        }
+
+        PutUnsigned(&writer, unchanged);
+        PutBits(&writer, op, 2);
+        unchanged = 0;
+
+        if (op == OP_GONE)
+        {
+            view->active = false;
+        }
+        else if (op == OP_FULL)
+        {
+            *view = *now;
+            PutFullSlot(&writer, view, kind);
+        }
+        else
+        {
+            // the fresh steps come from the velocities, they are better than anything worked out from the jump
+            for (int f = 0; f < kind->fields; f++) stepChanges[f] = kind->linear[f] ? now->step[f] - view->step[f] : 0;
+            PutCorrection(&writer, kind, residuals, stepChanges);
+            ApplyCorrection(view, kind, residuals, stepChanges);
+        }
+    }
+    if (unchanged > 0) PutUnsigned(&writer, unchanged);
+
+    int size = FinishBits(&writer);
+    if (size == 0) codec->forceKeyframe = true;    // didn't fit, the viewers' copy is out of date now
+    return size;
+}
+
+bool DecodeStreamFrame(StreamCodec *codec, const unsigned char *data, int size, Game *game)
+{
+    BitReader reader = { data, size, 0, 0, 0, false };
+    bool keyframe = GetBits(&reader, 1) != 0;
+
+    // someone who joined late has to wait for a picture of everything
+    if (!keyframe && !codec->synced) return false;
+
+    int i = 0;
+    while (i < STREAM_SLOTS && !reader.overrun)
+    {
+        if (keyframe)
+        {
+            const KindInfo *kind = &kinds[KindOfSlot(i)];
+            StreamSlot *slot = &codec->slots[i];
+
+            if (GetBits(&reader, 1)) GetFullSlot(&reader, slot, kind);
+            else slot->active = false;
+            i++;
+            continue;
+        }
+
+        uint32_t unchanged = GetUnsigned(&reader);
+        for (uint32_t n = 0; n < unchanged && i < STREAM_SLOTS; n++, i++)
+        {
+            ApplyPredicted(&codec->slots[i], &kinds[KindOfSlot(i)]);
+        }
+        if (i == STREAM_SLOTS) break;
+
+        const KindInfo *kind = &kinds[KindOfSlot(i)];
+        StreamSlot *slot = &codec->slots[i];
+        SlotOp op = (SlotOp)GetBits(&reader, 2);
+
+        if (op == OP_GONE)
+        {
+            slot->active = false;
+        }
+        else if (op == OP_FULL)
+        {
+            GetFullSlot(&reader, slot, kind);
+        }
+        else
+        {
+            int residuals[STREAM_MAX_FIELDS] = { 0 };
+            int stepChanges[STREAM_MAX_FIELDS] = { 0 };
+            GetCorrection(&reader, kind, residuals, stepChanges);
+            ApplyCorrection(slot, kind, residuals, stepChanges);
+        }
+        i++;
+    }
+
+    if (reader.overrun)
+    {
+        TraceLog(LOG_WARNING, "STREAM: Frame was cut short, waiting for the next keyframe");
+        codec->synced = false;
+        return false;
+    }
+
+    codec->synced = true;
+    DequantizeGame(codec->slots, game);
+    return true;
+}
+
+static void PutU16(unsigned char *out, unsigned int value)
+{
+    out[0] = value & 0xFF;
+    out[1] = (value >> 8) & 0xFF;
+}
+
+static unsigned int GetU16(const unsigned char *in)
+{
+    return in[0] | (in[1] << 8);
+}
+
+static void PackHeader(unsigned char out[HEADER_SIZE])
+{
+    PutU16(out, STREAM_MAGIC & 0xFFFF);
+    PutU16(out + 2, STREAM_MAGIC >> 16);
+    PutU16(out + 4, STREAM_VERSION);
+    PutU16(out + 6, screenWidth);
+    PutU16(out + 8, screenHeight);
+    PutU16(out + 10, GAME_TICK_RATE);
+    PutU16(out + 12, worldWidth);
+    PutU16(out + 14, worldHeight);
+}
+
+static bool UnpackHeader(const unsigned char in[HEADER_SIZE], StreamHeader *header)
+{
+    header->magic = GetU16(in) | (GetU16(in + 2) << 16);
+    header->version = GetU16(in + 4);
+    header->screenWidth = GetU16(in + 6);
+    header->screenHeight = GetU16(in + 8);
+    header->tickRate = GetU16(in + 10);
+    header->worldWidth = GetU16(in + 12);
+    header->worldHeight = GetU16(in + 14);
+
+    return header->magic == STREAM_MAGIC && header->version == STREAM_VERSION;
+}
+
+bool OpenStreamOutput(StreamOutput *output, const char *filePath, const char *socketPath)
+{
+    memset(output, 0, sizeof(*output));
+    output->listenSocket = -1;
+
+    unsigned char header[HEADER_SIZE];
+    PackHeader(header);
+
+    if (filePath != NULL)
+    {
+        output->file = fopen(filePath, "wb");
+        if (output->file == NULL || fwrite(header, 1, sizeof(header), output->file) != sizeof(header))
+        {
+            TraceLog(LOG_WARNING, "STREAM: Could not write %s", filePath);
+            CloseStreamOutput(output);
+            return false;
+        }
+    }
+
+    if (socketPath != NULL)
+    {
+        struct sockaddr_un address = { 0 };
+        address.sun_family = AF_UNIX;
+        snprintf(address.sun_path, sizeof(address.sun_path), "%s", socketPath);
+        unlink(socketPath);    // left over from last time
+
+        output->listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (output->listenSocket < 0 || bind(output->listenSocket, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+            listen(output->listenSocket, STREAM_MAX_VIEWERS) < 0)
+        {
+            TraceLog(LOG_WARNING, "STREAM: Could not listen on %s", socketPath);
+            CloseStreamOutput(output);
+            return false;
+        }
+
+        fcntl(output->listenSocket, F_SETFL, fcntl(output->listenSocket, F_GETFL, 0) | O_NONBLOCK);
+        snprintf(output->socketPath, sizeof(output->socketPath), "%s", socketPath);
+
+        // a viewer that goes away mid-write shouldn't take the game with it
+        signal(SIGPIPE, SIG_IGN);
+    }
+
+    return true;
+}
+
+static void DropViewer(StreamOutput *output, int index)
+{
+    close(output->viewers[index]);
+    output->viewers[index] = output->viewers[--output->viewerCount];
+}
+
+static void AcceptViewers(StreamOutput *output)
+{
+    if (output->listenSocket < 0) return;
+
+    int viewer;
+    while ((viewer = accept(output->listenSocket, NULL, NULL)) >= 0)
+    {
+        unsigned char header[HEADER_SIZE];
+        PackHeader(header);
+
+        if (output->viewerCount == STREAM_MAX_VIEWERS || send(viewer, header, sizeof(header), 0) != sizeof(header))
+        {
+            close(viewer);
+            continue;
+        }
+
+        fcntl(viewer, F_SETFL, fcntl(viewer, F_GETFL, 0) | O_NONBLOCK);
+        output->viewers[output->viewerCount++] = viewer;
+
+        // the new viewer can't use a delta, everybody gets a keyframe
+        output->codec.forceKeyframe = true;
+    }
+}
+
+void WriteStreamFrame(StreamOutput *output, const Game *game)
+{
+    AcceptViewers(output);
+
+    // with nobody to send it to there's nothing to keep up to date, the next viewer starts with a keyframe anyway
+    if (output->file == NULL && output->viewerCount == 0) return;
+
+    bool keyframe = output->codec.forceKeyframe || output->codec.ticksSinceKeyframe % STREAM_KEYFRAME_TICKS == 0;
+    int size = EncodeStreamFrame(&output->codec, game, output->frame + 2, STREAM_MAX_FRAME - 2);
+    if (size == 0) return;
+
+    PutU16(output->frame, size);
+    size += 2;
+
+    if (output->file != NULL) fwrite(output->frame, 1, size, output->file);
+
+    for (int i = output->viewerCount - 1; i >= 0; i--)
+    {
+        // a viewer that can't keep up is dropped, half a frame would break its stream anyway
+        if (send(output->viewers[i], output->frame, size, 0) != size)
+        {
+            TraceLog(LOG_WARNING, "STREAM: Dropped a viewer that couldn't keep up");
+            DropViewer(output, i);
+        }
+    }
+
+    output->frames++;
+    output->bytes += size;
+    output->lastFrameBytes = size;
+    if (keyframe)
+    {
+        output->keyframes++;
+        output->keyframeBytes += size;
+    }
+}
+
+void CloseStreamOutput(StreamOutput *output)
+{
+    if (output->file != NULL) fclose(output->file);
+    if (output->listenSocket >= 0) close(output->listenSocket);
+    if (output->socketPath[0] != '\0') unlink(output->socketPath);
+    while (output->viewerCount > 0) DropViewer(output, 0);
+
+    output->file = NULL;
+    output->listenSocket = -1;
+}
+
+bool OpenStreamInput(StreamInput *input, const char *path)
+{
+    memset(input, 0, sizeof(*input));
+    input->socket = -1;
+
+    unsigned char header[HEADER_SIZE];
+    struct stat info;
+
+    if (stat(path, &info) == 0 && S_ISSOCK(info.st_mode))
+    {
+        struct sockaddr_un address = { 0 };
+        address.sun_family = AF_UNIX;
+        snprintf(address.sun_path, sizeof(address.sun_path), "%s", path);
+
+        // the game sends the header as soon as it notices us, which is within a frame
+        input->socket = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (input->socket < 0 || connect(input->socket, (struct sockaddr *)&address, sizeof(address)) < 0 ||
+            recv(input->socket, header, sizeof(header), MSG_WAITALL) != sizeof(header))
+        {
+            TraceLog(LOG_WARNING, "STREAM: Could not connect to %s", path);
+            CloseStreamInput(input);
+            return false;
+        }
+
+        fcntl(input->socket, F_SETFL, fcntl(input->socket, F_GETFL, 0) | O_NONBLOCK);
+    }
+    else
+    {
+        input->file = fopen(path, "rb");
+        if (input->file == NULL || fread(header, 1, sizeof(header), input->file) != sizeof(header))
+        {
+            TraceLog(LOG_WARNING, "STREAM: Could not read %s", path);
+            CloseStreamInput(input);
+            return false;
+        }
+    }
+
+    if (!UnpackHeader(header, &input->header))
+    {
+        TraceLog(LOG_WARNING, "STREAM: %s is not a stream this version can read", path);
+        CloseStreamInput(input);
+        return false;
+    }
+
+    return true;
+}
+
+// A recording plays one frame per call, a live stream catches up on everything that came in
+bool ReadStreamFrame(StreamInput *input, Game *game)
+{
+    if (input->ended) return false;
+
+    if (input->file != NULL)
+    {
+        unsigned char size[2];
+        while (fread(size, 1, sizeof(size), input->file) == sizeof(size))
+        {
+            int length = GetU16(size);
+            if (fread(input->buffer, 1, length, input->file) != (size_t)length) break;
+            if (DecodeStreamFrame(&input->codec, input->buffer, length, game)) return true;
+        }
+
+        input->ended = true;
+        return false;
+    }
+
+    for (;;)
+    {
+        ssize_t received = recv(input->socket, input->buffer + input->buffered, sizeof(input->buffer) - input->buffered, 0);
+        if (received == 0) input->ended = true;
+        if (received <= 0) break;
+        input->buffered += (int)received;
+        if (input->buffered == (int)sizeof(input->buffer)) break;
+    }
+
+    bool updated = false;
+    int read = 0;
+    while (input->buffered - read >= 2)
+    {
+        int length = GetU16(input->buffer + read);
+        if (input->buffered - read - 2 < length) break;
+
+        updated |= DecodeStreamFrame(&input->codec, input->buffer + read + 2, length, game);
+        read += 2 + length;
+    }
+
+    memmove(input->buffer, input->buffer + read, input->buffered - read);
+    input->buffered -= read;
+    return updated;
+}
+
+void CloseStreamInput(StreamInput *input)
+{
+    if (input->file != NULL) fclose(input->file);
+    if (input->socket >= 0) close(input->socket);
+
+    input->file = NULL;
+    input->socket = -1;
+}
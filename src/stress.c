@@ -0,0 +1,547 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-29 10:12:44
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-29 16:38:05
+*/
+
+/*
+ * The stress scenario, see stress.h. The pools are pages that are each a game's world, and every
+ * phase runs the real kernel over every page, timed with the pacer's clock.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+#include "stress.h"
+#include "canvas.h"
+#include "game.h"
+#include "pacing.h"
+#include "trig.h"
+#include "ufo.h"
+#include "utils.h"
+#include "world.h"
+
+#define STRESS_MAX_COUNT       100000000       // of any one kind, a plateau past this is a typo
+#define BULLETS_PER_PAGE       MAX_BULLETS     // the first ship's pool, the second one stays empty
+#define PARTICLES_PER_PAGE     UFO_MAX_SHOTS   // rows of the shots' table
+
+// The pages of one plateau, each one a world of the game's tables (InitGameWorld)
+typedef struct StressPools {
+    StressPlateau target;
+    EcsWorld     *pages;                       // as many as the kind that needs the most, the first one is also the pilot's
+    int           pageCount;
+    int           asteroidPages;               // the pages each kind is in, from the first on
+    int           bulletPages;
+    int           particlePages;
+} StressPools;
+
+static const char *phaseNames[STRESS_PHASE_COUNT] = { "asteroids", "bullets", "particles", "collisions", "draw", "present" };
+
+const char *StressPhaseName(StressPhase phase)
+{
+    return phase >= 0 && phase < STRESS_PHASE_COUNT ? phaseNames[phase] : "?";
+}
+
+// A count with an optional k or M after it
+static bool ParseCount(const char **text, int *count)
+{
+    char *end;
+    long long value = strtoll(*text, &end, 10);
+    if (end == *text || value < 0) return false;
+
+    if (*end == 'k' || *end == 'K') { value *= 1000; end++; }
+    else if (*end == 'm' || *end == 'M') { value *= 1000000; end++; }
+    if (value > STRESS_MAX_COUNT) return false;
+
+    *count = (int)value;
+    *text = end;
+    return true;
+}
+
+bool ParseStressSchedule(const char *text, StressOptions *options)
+{
+    options->plateauCount = 0;
+    const char *at = text;
+
+    while (options->plateauCount < STRESS_MAX_PLATEAUS)
+    {
+        // one count is all three kinds, otherwise asteroids/bullets/particles
+        StressPlateau plateau;
+        if (!ParseCount(&at, &plateau.asteroids)) return false;
+        plateau.bullets = plateau.particles = plateau.asteroids;
+        if (*at == '/')
+        {
+            at++;
+            if (!ParseCount(&at, &plateau.bullets) || *at++ != '/' || !ParseCount(&at, &plateau.particles)) return false;
+        }
+        options->plateaus[options->plateauCount++] = plateau;
+
+        if (*at == '\0') return true;
+        if (*at++ != ',') return false;
+    }
+    return false;
+}
+
+static int PagesFor(int count, int pageSize)
+{
+    return (count + pageSize - 1) / pageSize;
+}
+
+// What a page holds when the pool is full, the last one gets what is left
+static int PageTarget(int count, int page, int pageSize)
+{
+    int left = count - page * pageSize;
+    return left < pageSize ? left : pageSize;
+}
+
+static void FreeStressPools(StressPools *pools)
+{
+    free(pools->pages);
+    memset(pools, 0, sizeof(*pools));
+}
+
+// Fresh game worlds, nothing in them but the two ships
+static bool AllocateStressPools(StressPools *pools, StressPlateau target)
+{
+    memset(pools, 0, sizeof(*pools));
+    pools->target = target;
+    pools->asteroidPages = PagesFor(target.asteroids, MAX_ASTEROIDS);
+    pools->bulletPages = PagesFor(target.bullets, BULLETS_PER_PAGE);
+    if (pools->bulletPages == 0) pools->bulletPages = 1;
+    pools->particlePages = PagesFor(target.particles, PARTICLES_PER_PAGE);
+
+    pools->pageCount = pools->bulletPages;
+    if (pools->asteroidPages > pools->pageCount) pools->pageCount = pools->asteroidPages;
+    if (pools->particlePages > pools->pageCount) pools->pageCount = pools->particlePages;
+
+    pools->pages = malloc((size_t)pools->pageCount * sizeof(EcsWorld));
+    if (pools->pages == NULL)
+    {
+        FreeStressPools(pools);
+        return false;
+    }
+
+    for (int p = 0; p < pools->pageCount; p++) InitGameWorld(&pools->pages[p]);
+    return true;
+}
+
+static long long StressPoolBytes(const StressPools *pools)
+{
+    return (long long)pools->pageCount * (long long)sizeof(EcsWorld);
+}
+
+static long long PeakRssBytes(void)
+{
+#ifdef _WIN32
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+#ifdef __APPLE__
+    return (long long)usage.ru_maxrss;          // bytes on macOS
+#else
+    return (long long)usage.ru_maxrss * 1024;   // kilobytes on Linux
+#endif
+#endif
+}
+
+static Vector2 RandomWorldPosition(void)
+{
+    return (Vector2){ (float)SimRandomValue(0, worldWidth - 1), (float)SimRandomValue(0, worldHeight - 1) };
+}
+
+// A saucer shot going some random way, the lifetimes are spread so they don't all go on the same tick
+static bool SpawnParticle(EcsWorld *world)
+{
+    EntityId shot = EcsSpawn(world, UFO_SHOT_COMPONENTS);
+    if (shot == ECS_NO_ENTITY) return false;
+
+    float sinA, cosA;
+    SinCosDegrees((float)SimRandomValue(0, 359), &sinA, &cosA);
+    *(Vector2 *)EcsGet(world, shot, COMPONENT_POSITION) = RandomWorldPosition();
+    *(Vector2 *)EcsGet(world, shot, COMPONENT_VELOCITY) = (Vector2){ cosA * UFO_SHOT_SPEED, sinA * UFO_SHOT_SPEED };
+    *(float *)EcsGet(world, shot, COMPONENT_RADIUS) = UFO_SHOT_RADIUS;
+    *(int *)EcsGet(world, shot, COMPONENT_LIFETIME) = SimRandomValue(1, UFO_SHOT_LIFETIME);
+    return true;
+}
+
+/*
+ * Tops every page up to its share of the plateau with the game's own spawns. ShootBullets fires
+ * three at a time, so the last bullet page can end up two over.
+ */
+static void RefillStressPools(StressPools *pools)
+{
+    for (int p = 0; p < pools->asteroidPages; p++)
+    {
+        EcsWorld *page = &pools->pages[p];
+        int target = PageTarget(pools->target.asteroids, p, MAX_ASTEROIDS);
+        for (int active = EcsCount(page, ASTEROID_COMPONENTS); active < target; active++) SpawnAsteroids(page, 0);
+    }
+
+    for (int p = 0; p < pools->bulletPages; p++)
+    {
+        EcsWorld *page = &pools->pages[p];
+        int target = PageTarget(pools->target.bullets, p, BULLETS_PER_PAGE);
+        while (EcsCount(page, BULLET_COMPONENTS) < target)
+        {
+            ShootBullets(page, 0, RandomWorldPosition(), (float)SimRandomValue(0, 359));
+        }
+    }
+
+    for (int p = 0; p < pools->particlePages; p++)
+    {
+        EcsWorld *world = &pools->pages[p];
+        int target = PageTarget(pools->target.particles, p, PARTICLES_PER_PAGE);
+        for (int active = EcsCount(world, UFO_SHOT_COMPONENTS); active < target; active++)
+        {
+            if (!SpawnParticle(world)) break;
+        }
+    }
+}
+
+// Adds the time since the mark to a phase and moves the mark
+static void Lap(double *phase, double *mark)
+{
+    double now = PacerSeconds();
+    *phase += now - *mark;
+    *mark = now;
+}
+
+/*
+ * One frame over all the pages. The pilot turns all the time, fires whenever it can and thrusts
+ * every other two seconds, nothing can kill it. It flies in the first page and is copied into the
+ * first ship of every other one, that is the ship the collisions and the saucer shots look at in
+ * each of them. False when the frame ran past
+ * STRESS_GIVE_UP_SECONDS, it is cut short at the next page and the times are what it got to.
+ */
+static bool StressFrame(StressPools *pools, Player *pilot, unsigned int tick, double phase[STRESS_PHASE_COUNT], double *frameSeconds)
+{
+    double start = PacerSeconds();
+    double mark = start;
+    bool late = false;
+
+    for (int p = 0; p < pools->asteroidPages && !late; p++)
+    {
+        UpdateWorldAsteroids(&pools->pages[p], &pilot->position, 1, tick);
+        late = PacerSeconds() - start > STRESS_GIVE_UP_SECONDS;
+    }
+    Lap(&phase[STRESS_ASTEROIDS], &mark);
+
+    PlayerInput input = { .rotateRight = true, .shoot = true, .thrust = (tick / (2 * GAME_TICK_RATE)) % 2 == 1 };
+    UpdatePlayer(&pools->pages[0], 0, &input);
+    *pilot = GetPlayer(&pools->pages[0], 0);
+    for (int p = 1; p < pools->pageCount; p++) PutPlayer(&pools->pages[p], 0, pilot);
+    for (int p = 0; p < pools->bulletPages && !late; p++)
+    {
+        UpdateBullets(&pools->pages[p]);
+        late = PacerSeconds() - start > STRESS_GIVE_UP_SECONDS;
+    }
+    Lap(&phase[STRESS_BULLETS], &mark);
+
+    // the shots look for bullets to hit as well, the ones in their own page
+    int score = 0;
+    for (int p = 0; p < pools->particlePages && !late; p++)
+    {
+        UpdateUfos(&pools->pages[p], 0, &score);
+        late = PacerSeconds() - start > STRESS_GIVE_UP_SECONDS;
+    }
+    Lap(&phase[STRESS_PARTICLES], &mark);
+
+    // every asteroid page against every bullet page, the ship is tested once per pair as well
+    GameState state = GAMEPLAY;
+    for (int a = 0; a < pools->asteroidPages && !late; a++)
+    {
+        for (int b = 0; b < pools->bulletPages; b++)
+        {
+            checkCollisions(&pools->pages[a], &pools->pages[b], 0, &score, &state);
+        }
+        late = PacerSeconds() - start > STRESS_GIVE_UP_SECONDS;
+    }
+    Lap(&phase[STRESS_COLLISIONS], &mark);
+
+    memset(&drawStats, 0, sizeof(drawStats));
+    FocusWorldView(pilot->position);
+
+    BeginCanvas();
+        BeginMode2D(WorldViewCamera());
+            // DrawAsteroids takes a list of at most a page, the asteroids out of view it culls itself
+            int visible[MAX_ASTEROIDS];
+            for (int p = 0; p < pools->asteroidPages && !late; p++)
+            {
+                const EcsWorld *page = &pools->pages[p];
+                int count = 0;
+                EcsQuery query = EcsQueryAll(page, ASTEROID_COMPONENTS);
+                while (EcsNextArchetype(&query))
+                {
+                    for (int row = 0; row < query.count; row++) visible[count++] = EcsRowIndex(&query, row);
+                }
+                DrawAsteroids(page, visible, count);
+                late = PacerSeconds() - start > STRESS_GIVE_UP_SECONDS;
+            }
+            for (int p = 0; p < pools->bulletPages && !late; p++)
+            {
+                DrawBullets(&pools->pages[p]);
+            }
+            for (int p = 0; p < pools->particlePages && !late; p++)
+            {
+                DrawUfos(&pools->pages[p]);
+            }
+            DrawPlayer(*pilot);
+        EndMode2D();
+
+        BeginCanvasMode();
+        DrawText(TextFormat("STRESS  %d asteroids  %d bullets  %d particles", pools->target.asteroids, pools->target.bullets,
+                            pools->target.particles), 10, 10, 20, LIME);
+        DrawText("ESC stops and prints the report", 10, 35, 15, GRAY);
+        Lap(&phase[STRESS_DRAW], &mark);
+    EndCanvas();
+    Lap(&phase[STRESS_PRESENT], &mark);
+
+    *frameSeconds = mark - start;
+    return !late && *frameSeconds <= STRESS_GIVE_UP_SECONDS;
+}
+
+static int CompareSeconds(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Mean, percentiles and max of the measured frames, the phase sums become means
+static void SummarizeFrames(StressResult *result, double frames[])
+{
+    int count = result->frames;
+    if (count == 0) return;
+
+    double total = 0.0;
+    for (int i = 0; i < count; i++) total += frames[i];
+    qsort(frames, (size_t)count, sizeof(double), CompareSeconds);
+
+    result->frameMean = total / count;
+    result->frameP50 = frames[(count - 1) * 50 / 100];
+    result->frameP99 = frames[(count - 1) * 99 / 100];
+    result->frameMax = frames[count - 1];
+    for (int k = 0; k < STRESS_PHASE_COUNT; k++) result->phase[k] /= count;
+    result->refill /= count;
+}
+
+static bool StopRequested(void)
+{
+    return WindowShouldClose() || IsKeyPressed(KEY_ESCAPE);
+}
+
+// Warms up, then measures until it has STRESS_PLATEAU_FRAMES or STRESS_PLATEAU_SECONDS went by
+static void MeasurePlateau(StressPools *pools, Player *pilot, unsigned int *tick, StressResult *result, bool *stopped)
+{
+    double frames[STRESS_PLATEAU_FRAMES];
+    int warmup = 0;
+    double since = PacerSeconds();
+
+    while (result->frames < STRESS_PLATEAU_FRAMES)
+    {
+        if (StopRequested())
+        {
+            *stopped = true;
+            break;
+        }
+
+        double refillStart = PacerSeconds();
+        RefillStressPools(pools);
+        double refill = PacerSeconds() - refillStart;
+
+        double phase[STRESS_PHASE_COUNT] = { 0 };
+        double frame;
+        bool finished = StressFrame(pools, pilot, (*tick)++, phase, &frame);
+
+        // a slow plateau doesn't get to spend all of its time warming up
+        bool warming = warmup < STRESS_WARMUP_FRAMES && PacerSeconds() - since < STRESS_PLATEAU_SECONDS / 4;
+        if (warming && finished)
+        {
+            if (++warmup == STRESS_WARMUP_FRAMES) since = PacerSeconds();
+            continue;
+        }
+        if (warmup < STRESS_WARMUP_FRAMES)
+        {
+            warmup = STRESS_WARMUP_FRAMES;
+            since = PacerSeconds() - frame;
+        }
+
+        frames[result->frames++] = frame;
+        for (int k = 0; k < STRESS_PHASE_COUNT; k++) result->phase[k] += phase[k];
+        result->refill += refill;
+
+        if (!finished)
+        {
+            result->gaveUp = true;
+            *stopped = true;
+            break;
+        }
+        if (result->frames >= 3 && PacerSeconds() - since > STRESS_PLATEAU_SECONDS) break;
+    }
+
+    SummarizeFrames(result, frames);
+}
+
+int RunStressScenario(const StressOptions *options)
+{
+    StressResult results[STRESS_MAX_PLATEAUS];
+    int count = 0;
+
+    // its own generator so two runs spawn the same things, and every spawn and split may use any slot
+    unsigned int rngState = 0x57AE55u;
+    BindSimulationRandom(&rngState);
+    BindTunables(NULL);
+    int savedLimit = worldAsteroidLimit;
+    worldAsteroidLimit = MAX_ASTEROIDS;
+
+    Player pilot = { 0 };
+    unsigned int tick = 0;
+    bool stopped = false;
+
+    for (int p = 0; p < options->plateauCount && !stopped; p++)
+    {
+        StressResult *result = &results[count++];
+        memset(result, 0, sizeof(*result));
+        result->plateau = options->plateaus[p];
+
+        printf("stress: %d asteroids, %d bullets, %d particles\n", result->plateau.asteroids, result->plateau.bullets, result->plateau.particles);
+        fflush(stdout);
+
+        StressPools pools;
+        if (!AllocateStressPools(&pools, result->plateau))
+        {
+            result->outOfMemory = true;
+            result->peakRssBytes = PeakRssBytes();
+            break;
+        }
+        result->poolBytes = StressPoolBytes(&pools);
+
+        // where InitGameWorld puts a ship, then wherever the last plateau left it
+        if (tick == 0) pilot = GetPlayer(&pools.pages[0], 0);
+        else PutPlayer(&pools.pages[0], 0, &pilot);
+
+        MeasurePlateau(&pools, &pilot, &tick, result, &stopped);
+        result->peakRssBytes = PeakRssBytes();
+        FreeStressPools(&pools);
+
+        // stopped before a single frame was measured, there is nothing to report for it
+        if (result->frames == 0) count--;
+    }
+
+    worldAsteroidLimit = savedLimit;
+    BindSimulationRandom(NULL);
+
+    PrintStressReport(results, count);
+    if (options->csvFile != NULL && !WriteStressCsv(options->csvFile, results, count))
+    {
+        fprintf(stderr, "Could not write %s\n", options->csvFile);
+        return 1;
+    }
+    return 0;
+}
+
+static long long PlateauEntities(StressPlateau plateau)
+{
+    return (long long)plateau.asteroids + plateau.bullets + plateau.particles;
+}
+
+static int SlowestPhase(const StressResult *result)
+{
+    int slowest = 0;
+    for (int k = 1; k < STRESS_PHASE_COUNT; k++)
+    {
+        if (result->phase[k] > result->phase[slowest]) slowest = k;
+    }
+    return slowest;
+}
+
+/*
+ * The table of every plateau, then how each phase grew against the plateau before it, as the
+ * power of the entity count (1 grows with the count, 2 with its square), and where the frame
+ * first stopped fitting a tick.
+ */
+void PrintStressReport(const StressResult results[], int count)
+{
+    const double tickSeconds = 1.0 / GAME_TICK_RATE;
+
+    printf("\nStress report, a tick is %.1f ms, times are ms per frame\n", tickSeconds * 1000.0);
+    printf("%10s %10s %10s %6s %8s %8s %8s %8s |", "asteroids", "bullets", "particles", "frames", "mean", "p50", "p99", "max");
+    for (int k = 0; k < STRESS_PHASE_COUNT; k++) printf(" %10s", phaseNames[k]);
+    printf(" | %8s %9s %9s\n", "refill", "pool MB", "peak MB");
+
+    for (int i = 0; i < count; i++)
+    {
+        const StressResult *r = &results[i];
+        printf("%10d %10d %10d ", r->plateau.asteroids, r->plateau.bullets, r->plateau.particles);
+        if (r->outOfMemory)
+        {
+            printf("  out of memory for the pages\n");
+            continue;
+        }
+        printf("%6d %8.2f %8.2f %8.2f %8.2f |", r->frames, r->frameMean * 1000.0, r->frameP50 * 1000.0,
+               r->frameP99 * 1000.0, r->frameMax * 1000.0);
+        for (int k = 0; k < STRESS_PHASE_COUNT; k++) printf(" %10.3f", r->phase[k] * 1000.0);
+        printf(" | %8.2f %9.1f %9.1f%s\n", r->refill * 1000.0, r->poolBytes / 1048576.0, r->peakRssBytes / 1048576.0,
+               r->gaveUp ? "  gave up" : "");
+    }
+
+    printf("\nGrowth against the plateau before, the power of the entity count\n");
+    for (int i = 1; i < count; i++)
+    {
+        const StressResult *r = &results[i], *previous = &results[i - 1];
+        double ratio = (double)PlateauEntities(r->plateau) / (double)PlateauEntities(previous->plateau);
+        if (r->outOfMemory || previous->outOfMemory || r->gaveUp || ratio <= 1.0) continue;
+
+        printf("  %lld -> %lld:", PlateauEntities(previous->plateau), PlateauEntities(r->plateau));
+        for (int k = 0; k < STRESS_PHASE_COUNT; k++)
+        {
+            if (r->phase[k] > 0.0 && previous->phase[k] > 0.0) printf("  %s %.2f", phaseNames[k], log(r->phase[k] / previous->phase[k]) / log(ratio));
+        }
+        printf("\n");
+    }
+
+    for (int i = 0; i < count; i++)
+    {
+        const StressResult *r = &results[i];
+        if (r->outOfMemory)
+        {
+            printf("\nRan out of memory at %lld entities\n", PlateauEntities(r->plateau));
+            return;
+        }
+        if (r->gaveUp || r->frameP99 > tickSeconds)
+        {
+            int slowest = SlowestPhase(r);
+            double share = r->frameMean > 0.0 ? r->phase[slowest] / r->frameMean * 100.0 : 0.0;
+            printf("\nCliff: %lld entities%s, p99 frame %.1f ms, %s is %.0f%% of the frame\n", PlateauEntities(r->plateau),
+                   r->gaveUp ? " (gave up)" : "", r->frameP99 * 1000.0, phaseNames[slowest], share);
+            return;
+        }
+    }
+    if (count > 0) printf("\nNo cliff, every plateau up to %lld entities fit a tick\n", PlateauEntities(results[count - 1].plateau));
+}
+
+bool WriteStressCsv(const char *fileName, const StressResult results[], int count)
+{
+    FILE *file = fopen(fileName, "w");
+    if (file == NULL) return false;
+
+    fprintf(file, "asteroids,bullets,particles,frames,frame_mean_ms,frame_p50_ms,frame_p99_ms,frame_max_ms");
+    for (int k = 0; k < STRESS_PHASE_COUNT; k++) fprintf(file, ",%s_ms", phaseNames[k]);
+    fprintf(file, ",refill_ms,pool_bytes,peak_rss_bytes,gave_up,out_of_memory\n");
+
+    for (int i = 0; i < count; i++)
+    {
+        const StressResult *r = &results[i];
+        fprintf(file, "%d,%d,%d,%d,%.4f,%.4f,%.4f,%.4f", r->plateau.asteroids, r->plateau.bullets, r->plateau.particles, r->frames,
+                r->frameMean * 1000.0, r->frameP50 * 1000.0, r->frameP99 * 1000.0, r->frameMax * 1000.0);
+        for (int k = 0; k < STRESS_PHASE_COUNT; k++) fprintf(file, ",%.4f", r->phase[k] * 1000.0);
+        fprintf(file, ",%.4f,%lld,%lld,%d,%d\n", r->refill * 1000.0, r->poolBytes, r->peakRssBytes, r->gaveUp, r->outOfMemory);
+    }
+
+    return fclose(file) == 0;
+}
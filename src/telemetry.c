@@ -0,0 +1,334 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-31 11:05:52
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-31 17:21:40
+*/
+
+/*
+ * Session telemetry, see telemetry.h. The counting on one side, the log and what a log adds up
+ * to on the other.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "telemetry.h"
+#include "game.h"
+#include "world.h"
+
+_Static_assert(sizeof(TelemetryRecord) == TELEMETRY_RECORD_BYTES, "the telemetry record has to stay TELEMETRY_RECORD_BYTES");
+_Static_assert(PAUSED + 1 == TELEMETRY_STATES, "a new GameState needs a new stateFrames slot and TELEMETRY_VERSION bumped");
+
+#define RECORDS_PER_READ 4096                  // half a megabyte a read
+
+static _Thread_local Telemetry *activeTelemetry = NULL;
+
+void InitTelemetry(Telemetry *telemetry, int difficulty)
+{
+    memset(telemetry, 0, sizeof(*telemetry));
+    telemetry->record.magic = TELEMETRY_MAGIC;
+    telemetry->record.version = TELEMETRY_VERSION;
+    telemetry->record.recordSize = TELEMETRY_RECORD_BYTES;
+    telemetry->record.startTime = (uint64_t)time(NULL);
+    telemetry->record.difficulty = (uint8_t)difficulty;
+#ifdef FIXED_SIM
+    telemetry->record.flags |= TELEMETRY_FIXED_SIM;
+#endif
+}
+
+void BindTelemetry(Telemetry *telemetry)
+{
+    activeTelemetry = telemetry;
+}
+
+void CountShots(int bullets)
+{
+    Telemetry *telemetry = activeTelemetry;
+    if (telemetry == NULL || bullets <= 0) return;
+
+    telemetry->record.volleys++;
+    telemetry->record.bulletsFired += (uint32_t)bullets;
+}
+
+void CountAsteroidHit(float radius)
+{
+    Telemetry *telemetry = activeTelemetry;
+    if (telemetry == NULL) return;
+
+    TelemetrySize size = radius > 20.0f ? TELEMETRY_LARGE : TELEMETRY_SMALL;
+    telemetry->record.asteroidHits[size]++;
+}
+
+void CountSaucerHit(int kind)
+{
+    Telemetry *telemetry = activeTelemetry;
+    if (telemetry == NULL || kind < 0 || kind > 1) return;
+
+    telemetry->record.saucerHits[kind]++;
+}
+
+void CountDeath(TelemetryCause cause)
+{
+    Telemetry *telemetry = activeTelemetry;
+    if (telemetry == NULL) return;
+
+    telemetry->record.deaths[cause]++;
+}
+
+// A life ended, by dying or because the session did
+static void EndLife(Telemetry *telemetry)
+{
+    if (telemetry->lifeTicks == 0) return;
+
+    TelemetryRecord *record = &telemetry->record;
+    record->games++;
+    record->scoreTotal += telemetry->lifeScore;
+    if (telemetry->lifeTicks > record->longestLife) record->longestLife = telemetry->lifeTicks;
+    if (telemetry->lifeScore > record->bestScore) record->bestScore = telemetry->lifeScore;
+
+    telemetry->lifeTicks = 0;
+    telemetry->lifeScore = 0;
+}
+
+static uint16_t Peak(uint16_t peak, int count)
+{
+    return count > peak ? (uint16_t)count : peak;
+}
+
+/*
+ * A ship that was hit ends its life here, on the tick it happened. Rewinding out of the game
+ * over screen and playing on starts a new one, the death stays counted.
+ */
+void TelemetryTick(Telemetry *telemetry, const Game *game)
+{
+    TelemetryRecord *record = &telemetry->record;
+    record->ticksPlayed++;
+    record->difficulty = (uint8_t)game->settings.difficulty;
+    if (game->autopilot) record->flags |= TELEMETRY_AUTOPILOT;
+    if (WorldScrolls()) record->flags |= TELEMETRY_WORLD;
+
+    telemetry->lifeTicks++;
+    telemetry->lifeScore = game->score > 0 ? (uint32_t)game->score : 0;
+
+    // a few hundred flags to look at, so not every tick
+    if (++telemetry->sinceSample >= TELEMETRY_PEAK_TICKS)
+    {
+        telemetry->sinceSample = 0;
+
+        BulletList bullets;
+        ListShipBullets(&game->entities, 0, &bullets);
+
+        record->peakAsteroids = Peak(record->peakAsteroids, EcsCount(&game->entities, ASTEROID_COMPONENTS));
+        record->peakBullets = Peak(record->peakBullets, bullets.count);
+        record->peakEntities = Peak(record->peakEntities, EcsCount(&game->entities, COMPONENT_BIT(COMPONENT_HOSTILE)));
+    }
+
+    if (game->state == GAME_OVER) EndLife(telemetry);
+}
+
+void TelemetryFrame(Telemetry *telemetry, const Game *game)
+{
+    telemetry->record.frames++;
+    if (game->state >= 0 && game->state < TELEMETRY_STATES) telemetry->record.stateFrames[game->state]++;
+}
+
+/*
+ * One record at the end of the file. A session that died halfway through writing its record
+ * left the file at an odd length, that part is padded out with zeros first so the records after
+ * it still start on a record boundary, the reader skips the torn one as a bad record.
+ */
+bool AppendTelemetryRecord(Telemetry *telemetry, const char *path)
+{
+    EndLife(telemetry);
+
+    FILE *file = fopen(path, "ab");
+    if (file == NULL) return false;
+
+    bool written = fseek(file, 0, SEEK_END) == 0;
+    long length = ftell(file);
+    if (written && length > 0 && length % TELEMETRY_RECORD_BYTES != 0)
+    {
+        static const unsigned char zeros[TELEMETRY_RECORD_BYTES];
+        size_t pad = TELEMETRY_RECORD_BYTES - (size_t)(length % TELEMETRY_RECORD_BYTES);
+        written = fwrite(zeros, 1, pad, file) == pad;
+    }
+    written = written && fwrite(&telemetry->record, sizeof(TelemetryRecord), 1, file) == 1;
+    return fclose(file) == 0 && written;
+}
+
+/*
+ * The percentiles of a uint16 come from a histogram, one pass and no sort. Session lengths and
+ * lives are sorted, there is one of each per session.
+ */
+typedef struct Histogram16 {
+    uint32_t *counts;                          // 65536 buckets
+    uint16_t  max;
+} Histogram16;
+
+static uint16_t HistogramPercentile(const Histogram16 *histogram, long long total, int percent)
+{
+    long long rank = (total - 1) * percent / 100, seen = 0;
+    for (int value = 0; value <= histogram->max; value++)
+    {
+        seen += histogram->counts[value];
+        if (seen > rank) return (uint16_t)value;
+    }
+    return histogram->max;
+}
+
+static int CompareUint32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+static uint32_t SortedPercentile(uint32_t *values, long long count, int percent)
+{
+    return values[(count - 1) * percent / 100];
+}
+
+static void AddRecord(TelemetrySummary *summary, const TelemetryRecord *record)
+{
+    summary->frames += record->frames;
+    for (int s = 0; s < TELEMETRY_STATES; s++) summary->stateFrames[s] += record->stateFrames[s];
+    summary->ticksPlayed += record->ticksPlayed;
+    summary->games += record->games;
+    for (int d = 0; d < TELEMETRY_DEATHS; d++) summary->deaths[d] += record->deaths[d];
+    summary->scoreTotal += (long long)record->scoreTotal;
+    summary->volleys += record->volleys;
+    summary->bulletsFired += record->bulletsFired;
+    for (int s = 0; s < TELEMETRY_SIZES; s++) summary->asteroidHits[s] += record->asteroidHits[s];
+    summary->saucerHits[0] += record->saucerHits[0];
+    summary->saucerHits[1] += record->saucerHits[1];
+    if (record->flags & TELEMETRY_AUTOPILOT) summary->autopilotSessions++;
+    if (record->longestLife > summary->longestLife) summary->longestLife = record->longestLife;
+    if (record->bestScore > summary->bestScore) summary->bestScore = record->bestScore;
+}
+
+bool SummarizeTelemetryLog(const char *path, TelemetrySummary *summary)
+{
+    memset(summary, 0, sizeof(*summary));
+
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return false;
+
+    TelemetryRecord *records = malloc(sizeof(TelemetryRecord) * RECORDS_PER_READ);
+    Histogram16 peaks[3];
+    for (int p = 0; p < 3; p++)
+    {
+        peaks[p].counts = calloc(65536, sizeof(uint32_t));
+        peaks[p].max = 0;
+    }
+    long long capacity = RECORDS_PER_READ;
+    uint32_t *sessionFrames = malloc(sizeof(uint32_t) * capacity);
+    uint32_t *longestLives = malloc(sizeof(uint32_t) * capacity);
+
+    bool ok = records != NULL && peaks[0].counts != NULL && peaks[1].counts != NULL && peaks[2].counts != NULL &&
+              sessionFrames != NULL && longestLives != NULL;
+
+    size_t read;
+    while (ok && (read = fread(records, sizeof(TelemetryRecord), RECORDS_PER_READ, file)) > 0)
+    {
+        if (summary->sessions + (long long)read > capacity)
+        {
+            capacity *= 2;
+            uint32_t *moreFrames = realloc(sessionFrames, sizeof(uint32_t) * capacity);
+            if (moreFrames != NULL) sessionFrames = moreFrames;
+            uint32_t *moreLives = realloc(longestLives, sizeof(uint32_t) * capacity);
+            if (moreLives != NULL) longestLives = moreLives;
+            ok = moreFrames != NULL && moreLives != NULL;
+            if (!ok) break;
+        }
+
+        for (size_t r = 0; r < read; r++)
+        {
+            const TelemetryRecord *record = &records[r];
+            if (record->magic != TELEMETRY_MAGIC || record->version != TELEMETRY_VERSION || record->recordSize != TELEMETRY_RECORD_BYTES)
+            {
+                summary->badRecords++;
+                continue;
+            }
+
+            AddRecord(summary, record);
+            sessionFrames[summary->sessions] = record->frames;
+            longestLives[summary->sessions] = record->longestLife;
+            uint16_t values[3] = { record->peakAsteroids, record->peakBullets, record->peakEntities };
+            for (int p = 0; p < 3; p++)
+            {
+                peaks[p].counts[values[p]]++;
+                if (values[p] > peaks[p].max) peaks[p].max = values[p];
+            }
+            summary->sessions++;
+        }
+    }
+    fclose(file);
+
+    long long n = summary->sessions;
+    if (ok && n > 0)
+    {
+        qsort(sessionFrames, (size_t)n, sizeof(uint32_t), CompareUint32);
+        qsort(longestLives, (size_t)n, sizeof(uint32_t), CompareUint32);
+        summary->sessionFramesP50 = SortedPercentile(sessionFrames, n, 50);
+        summary->sessionFramesP90 = SortedPercentile(sessionFrames, n, 90);
+        summary->longestLifeP50 = SortedPercentile(longestLives, n, 50);
+        summary->longestLifeP90 = SortedPercentile(longestLives, n, 90);
+
+        summary->peakAsteroidsP50 = HistogramPercentile(&peaks[0], n, 50);
+        summary->peakAsteroidsP99 = HistogramPercentile(&peaks[0], n, 99);
+        summary->peakAsteroidsMax = peaks[0].max;
+        summary->peakBulletsP50 = HistogramPercentile(&peaks[1], n, 50);
+        summary->peakBulletsP99 = HistogramPercentile(&peaks[1], n, 99);
+        summary->peakBulletsMax = peaks[1].max;
+        summary->peakEntitiesP50 = HistogramPercentile(&peaks[2], n, 50);
+        summary->peakEntitiesP99 = HistogramPercentile(&peaks[2], n, 99);
+        summary->peakEntitiesMax = peaks[2].max;
+    }
+
+    free(records);
+    for (int p = 0; p < 3; p++) free(peaks[p].counts);
+    free(sessionFrames);
+    free(longestLives);
+    return ok;
+}
+
+static double Share(long long part, long long whole)
+{
+    return whole > 0 ? 100.0 * part / whole : 0.0;
+}
+
+void PrintTelemetrySummary(const TelemetrySummary *summary)
+{
+    static const char *stateNames[TELEMETRY_STATES] = { "menu", "gameplay", "game over", "options", "controls", "paused" };
+    const double tick = 1.0 / GAME_TICK_RATE;
+
+    printf("%lld sessions (%lld with the autopilot on for a while), %lld bad records skipped\n",
+           summary->sessions, summary->autopilotSessions, summary->badRecords);
+    if (summary->sessions == 0) return;
+
+    printf("  time         %.1f hours, session p50 %.1f min, p90 %.1f min\n", summary->frames * tick / 3600.0,
+           summary->sessionFramesP50 * tick / 60.0, summary->sessionFramesP90 * tick / 60.0);
+    printf("  states      ");
+    for (int s = 0; s < TELEMETRY_STATES; s++) printf(" %s %.1f%%", stateNames[s], Share(summary->stateFrames[s], summary->frames));
+    printf("\n");
+
+    long long games = summary->games > 0 ? summary->games : 1;
+    printf("  games        %lld, %.1f s alive on average, best life p50 %.1f s, p90 %.1f s, longest %.1f s\n",
+           summary->games, summary->ticksPlayed * tick / games, summary->longestLifeP50 * tick,
+           summary->longestLifeP90 * tick, summary->longestLife * tick);
+    printf("  deaths       %lld by asteroids, %lld by saucers\n", summary->deaths[TELEMETRY_DEATH_ASTEROID], summary->deaths[TELEMETRY_DEATH_SAUCER]);
+    printf("  score        %.0f per game, best %u\n", (double)summary->scoreTotal / games, summary->bestScore);
+
+    long long hits = summary->asteroidHits[0] + summary->asteroidHits[1] + summary->saucerHits[0] + summary->saucerHits[1];
+    printf("  shots        %lld bullets in %lld volleys, %.1f%% hit something, %.1f bullets a second\n",
+           summary->bulletsFired, summary->volleys, Share(hits, summary->bulletsFired),
+           summary->ticksPlayed > 0 ? summary->bulletsFired / (summary->ticksPlayed * tick) : 0.0);
+    printf("  hits         asteroids large %lld, small %lld, saucers big %lld, small %lld\n",
+           summary->asteroidHits[TELEMETRY_LARGE], summary->asteroidHits[TELEMETRY_SMALL],
+           summary->saucerHits[0], summary->saucerHits[1]);
+    printf("  peaks        asteroids p50 %u p99 %u max %u, bullets p50 %u p99 %u max %u, entities p50 %u p99 %u max %u\n",
+           summary->peakAsteroidsP50, summary->peakAsteroidsP99, summary->peakAsteroidsMax,
+           summary->peakBulletsP50, summary->peakBulletsP99, summary->peakBulletsMax,
+           summary->peakEntitiesP50, summary->peakEntitiesP99, summary->peakEntitiesMax);
+}
@@ -0,0 +1,56 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-22 10:12:38
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-22 13:47:05
+*/
+
+/*
+ * Sine and cosine together, see trig.h. The scalar and the batched versions do exactly the same
+ * operations, the batched one just does them on four floats at once with the compiler's vector
+ * types (SSE on x86, NEON on ARM), so which one a caller uses never changes a result.
+ */
+
+#include "trig.h"
+#include <string.h>
+
+typedef float    Float4 __attribute__((vector_size(16)));
+typedef uint32_t Bits4  __attribute__((vector_size(16)));
+
+void SinCosArray(const float *radians, float *sines, float *cosines, int count)
+{
+    int i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        Float4 x;
+        memcpy(&x, radians + i, sizeof(x));
+
+        Float4 rounded = x * TRIG_TWO_OVER_PI + TRIG_ROUND_MAGIC;
+        Bits4 quadrant = (Bits4)rounded;
+        Float4 k = rounded - TRIG_ROUND_MAGIC;
+        Float4 r = ((x - k * TRIG_HALF_PI_A) - k * TRIG_HALF_PI_B) - k * TRIG_HALF_PI_C;
+
+        Float4 z = r * r;
+        Float4 s = r + r * z * (TRIG_SIN_1 + z * (TRIG_SIN_2 + z * TRIG_SIN_3));
+        Float4 c = 1.0f - 0.5f * z + z * z * (TRIG_COS_1 + z * (TRIG_COS_2 + z * TRIG_COS_3));
+
+        Bits4 swap = -(quadrant & 1);
+        Bits4 sineBits = ((Bits4)c & swap) | ((Bits4)s & ~swap);
+        Bits4 cosineBits = ((Bits4)s & swap) | ((Bits4)c & ~swap);
+        Float4 sine = (Float4)(sineBits ^ ((quadrant & 2) << 30));
+        Float4 cosine = (Float4)(cosineBits ^ (((quadrant + 1) & 2) << 30));
+
+        memcpy(sines + i, &sine, sizeof(sine));
+        memcpy(cosines + i, &cosine, sizeof(cosine));
+    }
+
+    // whatever doesn't fill a group of four
+    for (; i < count; i++) SinCos(radians[i], &sines[i], &cosines[i]);
+}
+
+void SinCosAngle(BinaryAngle angle, float *sine, float *cosine)
+{
+    *sine = FixedToFloat(FixedSin(angle));
+    *cosine = FixedToFloat(FixedCos(angle));
+}
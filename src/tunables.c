@@ -0,0 +1,99 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-27 10:04:51
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-27 12:38:20
+*/
+
+/*
+ * The gameplay tunables, see tunables.h. The table below is what the sweep tool goes by to set
+ * a tunable from its name, one line per field of the struct.
+ */
+
+#include "tunables.h"
+#include "asteroids.h"
+#include "player.h"
+#include "bullet.h"
+#include <math.h>
+#include <stddef.h>
+#include <strings.h>
+
+typedef struct TunableField {
+    const char *name;
+    size_t      offset;
+    bool        integer;
+} TunableField;
+
+static const TunableField fields[TUNABLE_COUNT] = {
+    { "ASTEROID_SPEED",        offsetof(Tunables, asteroidSpeed),       false },
+    { "SPLIT_FACTOR",          offsetof(Tunables, splitFactor),         false },
+    { "ASTEROID_SPAWN_CHANCE", offsetof(Tunables, asteroidSpawnChance), true  },
+    { "SHIP_ACCELERATION",     offsetof(Tunables, shipAcceleration),    false },
+    { "SHIP_DRAG",             offsetof(Tunables, shipDrag),            false },
+    { "ROTATION_SPEED",        offsetof(Tunables, rotationSpeed),       false },
+    { "BULLET_SPEED",          offsetof(Tunables, bulletSpeed),         false },
+    { "BULLET_COOLDOWN",       offsetof(Tunables, bulletCooldown),      true  },
+    { "BULLET_LIFETIME",       offsetof(Tunables, bulletLifetime),      true  },
+};
+
+static const Tunables defaults = {
+    .asteroidSpeed       = ASTEROID_SPEED,
+    .splitFactor         = 1.5f,
+    .asteroidSpawnChance = 1,
+    .shipAcceleration    = SHIP_ACCELERATION,
+    .shipDrag            = SHIP_DRAG,
+    .rotationSpeed       = ROTATION_SPEED,
+    .bulletSpeed         = BULLET_SPEED,
+    .bulletCooldown      = BULLET_COOLDOWN,
+    .bulletLifetime      = BULLET_LIFETIME,
+};
+
+// The tunables of the game this thread is stepping, like the random generator in utils.c
+static _Thread_local const Tunables *activeTunables = NULL;
+
+Tunables DefaultTunables(void)
+{
+    return defaults;
+}
+
+void BindTunables(const Tunables *tunables)
+{
+    activeTunables = tunables;
+}
+
+const Tunables *ActiveTunables(void)
+{
+    return activeTunables != NULL ? activeTunables : &defaults;
+}
+
+const char *TunableName(int index)
+{
+    return index >= 0 && index < TUNABLE_COUNT ? fields[index].name : "?";
+}
+
+int FindTunable(const char *name)
+{
+    for (int i = 0; i < TUNABLE_COUNT; i++)
+    {
+        if (strcasecmp(name, fields[i].name) == 0) return i;
+    }
+    return -1;
+}
+
+bool TunableIsInteger(int index)
+{
+    return fields[index].integer;
+}
+
+double GetTunable(const Tunables *tunables, int index)
+{
+    const char *field = (const char *)tunables + fields[index].offset;
+    return fields[index].integer ? (double)*(const int *)field : (double)*(const float *)field;
+}
+
+void SetTunable(Tunables *tunables, int index, double value)
+{
+    char *field = (char *)tunables + fields[index].offset;
+    if (fields[index].integer) *(int *)field = (int)lround(value);
+    else *(float *)field = (float)value;
+}
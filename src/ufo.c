@@ -0,0 +1,270 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-24 20:03:55
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-25 00:12:48
+*/
+
+/*
+ * The saucers and their shots, see ufo.h. Each thing they do is a system, a loop over the
+ * archetypes that have the components it needs: moving and running out of time work on anything
+ * hostile with a position and a velocity or a lifetime, the saucer and its shots alike, the brain
+ * only on what has a UfoBrain. Like the rest of the tick it is deterministic: only adds, multiplies,
+ * sqrtf and the SinCosDegrees polynomial, which come out the same on every machine, so it runs
+ * unchanged in the fixed-point build.
+ */
+
+#include "ufo.h"
+#include "narrowphase.h"
+#include "telemetry.h"
+#include "trig.h"
+#include "utils.h"
+#include <math.h>
+
+_Static_assert(sizeof(UfoBrain) == 16, "componentSize[COMPONENT_UFO] in ecs.c has to match UfoBrain");
+
+#define HOSTILE COMPONENT_BIT(COMPONENT_HOSTILE)
+
+// Anything hostile that moves moves, across the edges of the world like the asteroids
+static void MoveSystem(EcsWorld *world)
+{
+    EcsQuery query = EcsQueryAll(world, COMPONENT_BIT(COMPONENT_POSITION) | COMPONENT_BIT(COMPONENT_VELOCITY) | HOSTILE);
+    while (EcsNextArchetype(&query))
+    {
+        Vector2 *position = EcsColumn(&query, COMPONENT_POSITION);
+        const Vector2 *velocity = EcsColumn(&query, COMPONENT_VELOCITY);
+
+        for (int row = 0; row < query.count; row++)
+        {
+            position[row].x += velocity[row].x;
+            position[row].y += velocity[row].y;
+            WrapPosition(&position[row]);
+        }
+    }
+}
+
+// Counts down every lifetime, whatever has none left goes
+static void LifetimeSystem(EcsWorld *world)
+{
+    EcsQuery query = EcsQueryAll(world, COMPONENT_BIT(COMPONENT_LIFETIME) | HOSTILE);
+    while (EcsNextArchetype(&query))
+    {
+        int *lifetime = EcsColumn(&query, COMPONENT_LIFETIME);
+
+        // from the back, the row that moves into a destroyed one has been counted down already
+        for (int row = query.count - 1; row >= 0; row--)
+        {
+            if (--lifetime[row] <= 0) EcsDestroy(world, EcsRowEntity(&query, row));
+        }
+    }
+}
+
+static void FireShot(EcsWorld *world, Vector2 from, Vector2 direction)
+{
+    EntityId shot = EcsSpawn(world, UFO_SHOT_COMPONENTS);
+    if (shot == ECS_NO_ENTITY) return;
+
+    *(Vector2 *)EcsGet(world, shot, COMPONENT_POSITION) = from;
+    *(Vector2 *)EcsGet(world, shot, COMPONENT_VELOCITY) = (Vector2){ direction.x * UFO_SHOT_SPEED, direction.y * UFO_SHOT_SPEED };
+    *(float *)EcsGet(world, shot, COMPONENT_RADIUS) = UFO_SHOT_RADIUS;
+    *(int *)EcsGet(world, shot, COMPONENT_LIFETIME) = UFO_SHOT_LIFETIME;
+}
+
+/*
+ * Drifting up and down now and then, and shooting. A big saucer shoots anywhere, a small one at
+ * the copy of the ship that is closest, off by a few degrees so it can be dodged.
+ */
+static void UfoBrainSystem(EcsWorld *world, const Player *player)
+{
+    EcsQuery query = EcsQueryAll(world, COMPONENT_BIT(COMPONENT_UFO));
+    while (EcsNextArchetype(&query))
+    {
+        const Vector2 *position = EcsColumn(&query, COMPONENT_POSITION);
+        Vector2 *velocity = EcsColumn(&query, COMPONENT_VELOCITY);
+        UfoBrain *brain = EcsColumn(&query, COMPONENT_UFO);
+
+        for (int row = 0; row < query.count; row++)
+        {
+            if (--brain[row].turnCooldown <= 0)
+            {
+                velocity[row].y = SimRandomValue(-1, 1) * brain[row].speed * 0.6f;
+                brain[row].turnCooldown = SimRandomValue(60, 150);
+            }
+
+            if (--brain[row].shootCooldown > 0) continue;
+
+            float s, c;
+            Vector2 direction;
+            if (brain[row].kind == UFO_SMALL)
+            {
+                Vector2 shift = WrapImageOffset(position[row], player->position);
+                Vector2 toShip = { player->position.x + shift.x - position[row].x, player->position.y + shift.y - position[row].y };
+                float length = sqrtf(toShip.x * toShip.x + toShip.y * toShip.y);
+                if (length < 1.0f) length = 1.0f;
+
+                SinCosDegrees((float)SimRandomValue(-UFO_AIM_ERROR, UFO_AIM_ERROR), &s, &c);
+                direction = (Vector2){ (toShip.x * c - toShip.y * s) / length, (toShip.x * s + toShip.y * c) / length };
+                brain[row].shootCooldown = SimRandomValue(40, 70);
+            }
+            else
+            {
+                SinCosDegrees((float)SimRandomValue(0, 359), &s, &c);
+                direction = (Vector2){ c, s };
+                brain[row].shootCooldown = SimRandomValue(60, 100);
+            }
+
+            // shots are another archetype, spawning one leaves this table as it is
+            FireShot(world, position[row], direction);
+        }
+    }
+}
+
+// A saucer comes in from the left or the right edge when the wave director says so, and leaves after one crossing
+bool SpawnUfo(EcsWorld *world, int score)
+{
+    // one at a time for every screen's worth of world
+    int most = worldAsteroidLimit / SCREEN_ASTEROIDS;
+    if (EcsCount(world, COMPONENT_BIT(COMPONENT_UFO)) >= most) return false;
+
+    EntityId ufo = EcsSpawn(world, UFO_COMPONENTS);
+    if (ufo == ECS_NO_ENTITY) return false;
+
+    // more of them small as the score goes up
+    int smallChance = 20 + score / 500;
+    bool small = SimRandomValue(0, 99) < (smallChance > 80 ? 80 : smallChance);
+    float speed = small ? UFO_SMALL_SPEED : UFO_BIG_SPEED;
+    bool fromLeft = SimRandomValue(0, 1) == 0;
+
+    UfoBrain *brain = EcsGet(world, ufo, COMPONENT_UFO);
+    brain->kind = small ? UFO_SMALL : UFO_BIG;
+    brain->speed = speed;
+    brain->shootCooldown = SimRandomValue(30, 60);
+    brain->turnCooldown = SimRandomValue(60, 150);
+
+    *(Vector2 *)EcsGet(world, ufo, COMPONENT_POSITION) = (Vector2){ fromLeft ? 0.0f : (float)(worldWidth - 1),
+                                                                    (float)SimRandomValue(worldHeight / 8, worldHeight * 7 / 8) };
+    *(Vector2 *)EcsGet(world, ufo, COMPONENT_VELOCITY) = (Vector2){ fromLeft ? speed : -speed, 0.0f };
+    *(float *)EcsGet(world, ufo, COMPONENT_RADIUS) = small ? UFO_SMALL_RADIUS : UFO_BIG_RADIUS;
+    *(int *)EcsGet(world, ufo, COMPONENT_LIFETIME) = (int)(worldWidth / speed);
+    return true;
+}
+
+static float DistanceAcrossEdges(Vector2 a, Vector2 b)
+{
+    Vector2 shift = WrapImageOffset(a, b);
+    float dx = b.x + shift.x - a.x, dy = b.y + shift.y - a.y;
+    return sqrtf(dx * dx + dy * dy);
+}
+
+/*
+ * The ship's bullets against the saucers, and the saucers and their shots against the ship.
+ * A shot has to be inside the ship's triangle like a versus bullet, running into a saucer only
+ * has to get within its radius. The bullets are tried in the order of their indices, the first
+ * one that hits is spent.
+ */
+static bool UfoCollisionSystem(EcsWorld *world, const Player *player, int shipIndex, int *score)
+{
+    bool shipHit = false;
+    Vector2 ship[3];
+    GetShipTriangle(player, ship);
+
+    BulletList bullets;
+    ListShipBullets(world, shipIndex, &bullets);
+
+    EcsQuery query = EcsQueryAll(world, COMPONENT_BIT(COMPONENT_POSITION) | COMPONENT_BIT(COMPONENT_RADIUS) | HOSTILE);
+    while (EcsNextArchetype(&query))
+    {
+        const Vector2 *position = EcsColumn(&query, COMPONENT_POSITION);
+        const float *radius = EcsColumn(&query, COMPONENT_RADIUS);
+        const UfoBrain *brain = (query.archetype->mask & COMPONENT_BIT(COMPONENT_UFO)) ? EcsColumn(&query, COMPONENT_UFO) : NULL;
+
+        for (int row = query.count - 1; row >= 0; row--)
+        {
+            if (brain == NULL)
+            {
+                Vector2 shift = WrapImageOffset(player->position, position[row]);
+                if (PointInShip(ship, (Vector2){ position[row].x + shift.x, position[row].y + shift.y }))
+                {
+                    shipHit = true;
+                    EcsDestroy(world, EcsRowEntity(&query, row));
+                }
+                continue;
+            }
+
+            if (DistanceAcrossEdges(position[row], player->position) < radius[row] + SHIP_SIZE * 0.5f) shipHit = true;
+
+            for (int i = 0; i < bullets.count; i++)
+            {
+                if (EcsAlive(world, bullets.entity[i]) && DistanceAcrossEdges(position[row], bullets.position[i]) < radius[row] + bullets.radius[i])
+                {
+                    EcsDestroy(world, bullets.entity[i]);
+                    *score += brain[row].kind == UFO_SMALL ? UFO_SMALL_POINTS : UFO_BIG_POINTS;
+                    CountSaucerHit(brain[row].kind);
+                    EcsDestroy(world, EcsRowEntity(&query, row));
+                    break;
+                }
+            }
+        }
+    }
+    return shipHit;
+}
+
+bool UpdateUfos(EcsWorld *world, int ship, int *score)
+{
+    Player player = GetPlayer(world, ship);
+
+    UfoBrainSystem(world, &player);
+    MoveSystem(world);
+    LifetimeSystem(world);
+    return UfoCollisionSystem(world, &player, ship, score);
+}
+
+// Shots have everything a saucer has except the brain
+int CountUfoShots(const EcsWorld *world)
+{
+    return EcsCount(world, UFO_SHOT_COMPONENTS) - EcsCount(world, COMPONENT_BIT(COMPONENT_UFO));
+}
+
+// The classic saucer: a wide hull, a line round the middle and a dome on top
+static void DrawSaucer(Vector2 center, float r, Color color)
+{
+    Vector2 hull[7] = {
+        { -r, 0.0f }, { -0.45f * r, -0.35f * r }, { 0.45f * r, -0.35f * r }, { r, 0.0f },
+        { 0.45f * r, 0.35f * r }, { -0.45f * r, 0.35f * r }, { -r, 0.0f }
+    };
+    Vector2 dome[4] = { { -0.25f * r, -0.35f * r }, { -0.15f * r, -0.65f * r }, { 0.15f * r, -0.65f * r }, { 0.25f * r, -0.35f * r } };
+
+    for (int j = 1; j < 7; j++)
+    {
+        DrawLineV((Vector2){ center.x + hull[j - 1].x, center.y + hull[j - 1].y }, (Vector2){ center.x + hull[j].x, center.y + hull[j].y }, color);
+    }
+    for (int j = 1; j < 4; j++)
+    {
+        DrawLineV((Vector2){ center.x + dome[j - 1].x, center.y + dome[j - 1].y }, (Vector2){ center.x + dome[j].x, center.y + dome[j].y }, color);
+    }
+    DrawLineV((Vector2){ center.x - r, center.y }, (Vector2){ center.x + r, center.y }, color);
+}
+
+void DrawUfos(EcsWorld *world)
+{
+    EcsQuery query = EcsQueryAll(world, COMPONENT_BIT(COMPONENT_POSITION) | COMPONENT_BIT(COMPONENT_RADIUS) | HOSTILE);
+    while (EcsNextArchetype(&query))
+    {
+        const Vector2 *position = EcsColumn(&query, COMPONENT_POSITION);
+        const float *radius = EcsColumn(&query, COMPONENT_RADIUS);
+        bool saucers = (query.archetype->mask & COMPONENT_BIT(COMPONENT_UFO)) != 0;
+
+        for (int row = 0; row < query.count; row++)
+        {
+            Vector2 offsets[EDGE_COPIES];
+            int copies = ViewImageOffsets(position[row], radius[row], offsets);
+
+            for (int c = 0; c < copies; c++)
+            {
+                Vector2 at = { position[row].x + offsets[c].x, position[row].y + offsets[c].y };
+                if (saucers) DrawSaucer(at, radius[row], LIME);
+                else DrawCircleV(at, radius[row], LIME);
+            }
+        }
+    }
+}
@@ -15,12 +15,47 @@
 #include "bullet.h"
 #include "game.h"
 #include "player.h"
+#include "narrowphase.h"
+#include "telemetry.h"
 #include <raylib.h>
 #include <math.h>
+#include <stddef.h>
+#include <string.h>
 
-// External reference to global screen dimensions defined in main.c
-extern int screenWidth;
-extern int screenHeight;
+// Global screen dimensions, defined here so the tools can link the game code without main.c
+int screenWidth = SCREEN_WIDTH;
+int screenHeight = SCREEN_HEIGHT;
+
+// The generator the simulation draws from, one per thread so games can run side by side
+static unsigned int defaultRandomState = 0x9E3779B9u;
+static _Thread_local unsigned int *activeRandomState = NULL;
+
+void BindSimulationRandom(unsigned int *state)
+{
+    activeRandomState = state;
+}
+
+// Same contract as raylib's GetRandomValue (min and max included) but reproducible from the seed
+int SimRandomValue(int min, int max)
+{
+    unsigned int *state = activeRandomState != NULL ? activeRandomState : &defaultRandomState;
+
+    if (min > max)
+    {
+        int tmp = max;
+        max = min;
+        min = tmp;
+    }
+
+    // xorshift32, it must never be zero
+    unsigned int x = *state ? *state : 0x9E3779B9u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+
+    return min + (int)(x % (unsigned int)(max - min + 1));
+}
 
 bool CheckCollisionCircles(Vector2 center1, float radius1, Vector2 center2, float radius2)
 {
@@ -31,74 +66,305 @@ bool CheckCollisionCircles(Vector2 center1, float radius1, Vector2 center2, floa
     return distance <= radius1 + radius2;
 }
 
+/*
+ * Swept circle test: both circles move in a straight line over one tick (motion is the
+ * distance covered in that tick). Returns the fraction of the tick, 0 to 1, at which they
+ * first touch, 0 if they already overlap at the start, or NO_IMPACT if they never touch.
+ * A fast bullet can skip right over a small asteroid between two ticks, this can't.
+ */
+float SweptCircleImpactTime(Vector2 start1, Vector2 motion1, float radius1, Vector2 start2, Vector2 motion2, float radius2)
+{
+    float dx = start1.x - start2.x;
+    float dy = start1.y - start2.y;
+    float vx = motion1.x - motion2.x;
+    float vy = motion1.y - motion2.y;
+    float reach = radius1 + radius2;
+
+    // solve |d + v t| = reach for the smaller t
+    float a = vx * vx + vy * vy;
+    float b = dx * vx + dy * vy;
+    float c = dx * dx + dy * dy - reach * reach;
+
+    if (c <= 0.0f) return 0.0f;
+    if (a <= 1e-12f) return NO_IMPACT;
+
+    float discriminant = b * b - a * c;
+    if (discriminant < 0.0f) return NO_IMPACT;
+
+    float t = (-b - sqrtf(discriminant)) / a;
+    return (t >= 0.0f && t <= 1.0f) ? t : NO_IMPACT;
+}
+
+// Copies the asteroids into the batch, with their positions at the start of the tick. With a chunk
+// mask (see MarkChunksAround) only the ones in marked chunks, NULL takes all of them. They go in by
+// index, not by row, so a tie between two impacts goes to the same asteroid whatever the rows did
+void GatherAsteroidSweepBatch(AsteroidSweepBatch *batch, const EcsWorld *world, const unsigned char *chunks)
+{
+    batch->count = 0;
+
+    // the asteroids are the only archetype with all of these
+    EcsQuery query = EcsQueryAll(world, ASTEROID_COMPONENTS);
+    if (EcsNextArchetype(&query))
+    {
+        const Vector2 *position = EcsColumn(&query, COMPONENT_POSITION);
+        const Vector2 *velocity = EcsColumn(&query, COMPONENT_VELOCITY);
+        const float *radius = EcsColumn(&query, COMPONENT_RADIUS);
+
+        int rowAt[MAX_ASTEROIDS];
+        for (int i = 0; i < MAX_ASTEROIDS; i++) rowAt[i] = -1;
+        for (int row = 0; row < query.count; row++) rowAt[EcsRowIndex(&query, row)] = row;
+
+        for (int i = 0; i < MAX_ASTEROIDS; i++)
+        {
+            int row = rowAt[i];
+            if (row < 0) continue;
+            if (chunks != NULL && !chunks[WorldChunkAt(position[row])]) continue;
+
+            // collisions run after everything moved, so step back one tick to get the start
+            int n = batch->count++;
+            batch->index[n] = i;
+            batch->x[n] = position[row].x - velocity[row].x;
+            batch->y[n] = position[row].y - velocity[row].y;
+            batch->vx[n] = velocity[row].x;
+            batch->vy[n] = velocity[row].y;
+            batch->radius[n] = radius[row];
+        }
+    }
+
+    // zero the padding lanes, their results are computed but never looked at
+    batch->paddedCount = (batch->count + SWEEP_BATCH_WIDTH - 1) / SWEEP_BATCH_WIDTH * SWEEP_BATCH_WIDTH;
+    for (int n = batch->count; n < batch->paddedCount; n++)
+    {
+        batch->index[n] = -1;
+        batch->x[n] = batch->y[n] = batch->vx[n] = batch->vy[n] = batch->radius[n] = 0.0f;
+    }
+}
+
+/*
+ * The world wraps around, so of all the copies of a point one world apart the one that
+ * matters is the closest (the minimum image). For a difference along one axis this is what
+ * to add to it to get there: nothing, or one world size either way. Selects rather than ifs
+ * or roundf, so the same lines vectorize inside the sweep loop below.
+ */
+static inline float WrapAxisOffset(float delta, float size)
+{
+    float offset = delta > 0.5f * size ? -size : 0.0f;
+    return delta < -0.5f * size ? size : offset;
+}
+
+// What to add to point to get its copy closest to anchor, so an asteroid over the right edge can hit a ship on the left
+Vector2 WrapImageOffset(Vector2 anchor, Vector2 point)
+{
+    return (Vector2){ WrapAxisOffset(point.x - anchor.x, (float)worldWidth),
+                      WrapAxisOffset(point.y - anchor.y, (float)worldHeight) };
+}
+
+/*
+ * Where to draw something that sticks out over an edge: the offsets of the copies to draw,
+ * always starting with its own place (0, 0), plus one on the other side for each edge it is
+ * within radius of and one in the opposite corner when that is two edges. Everything else
+ * is drawn once. Returns how many offsets were written, 1 to EDGE_COPIES.
+ */
+int EdgeGhostOffsets(Vector2 position, float radius, Vector2 offsets[EDGE_COPIES])
+{
+    float width = (float)worldWidth, height = (float)worldHeight;
+    float ghostX = position.x < radius ? width : (position.x > width - radius ? -width : 0.0f);
+    float ghostY = position.y < radius ? height : (position.y > height - radius ? -height : 0.0f);
+
+    // every copy is written, the count only moves past the ones that are needed
+    int count = 1;
+    offsets[0] = (Vector2){ 0.0f, 0.0f };
+    offsets[count] = (Vector2){ ghostX, 0.0f };
+    count += ghostX != 0.0f;
+    offsets[count] = (Vector2){ 0.0f, ghostY };
+    count += ghostY != 0.0f;
+    offsets[count] = (Vector2){ ghostX, ghostY };
+    count += (ghostX != 0.0f) & (ghostY != 0.0f);
+
+    return count;
+}
+
+/*
+ * Same test as SweptCircleImpactTime() for one moving circle against a run of asteroid lanes,
+ * measured across the world edges (WrapAxisOffset) so asteroids halfway over an edge count on
+ * both sides. The loop has no branches, no early outs and a trip count that is a multiple of
+ * the batch width, so the compiler turns it into SIMD code at -O2 and tests several pairs per
+ * instruction. The arrays come in as plain restrict pointers, gcc gives up on the loop when
+ * they are read through the batch struct.
+ */
+static void SweepCircleLanes(int count, const float *restrict ax, const float *restrict ay,
+                             const float *restrict avx, const float *restrict avy, const float *restrict ar,
+                             float sx, float sy, float mx, float my, float radius, float *restrict out)
+{
+    float width = (float)worldWidth, height = (float)worldHeight;
+    count = (count + SWEEP_BATCH_WIDTH - 1) & ~(SWEEP_BATCH_WIDTH - 1);
+
+    for (int k = 0; k < count; k++)
+    {
+        float dx = sx - ax[k];
+        float dy = sy - ay[k];
+        dx += WrapAxisOffset(dx, width);
+        dy += WrapAxisOffset(dy, height);
+        float vx = mx - avx[k];
+        float vy = my - avy[k];
+        float reach = radius + ar[k];
+
+        float a = vx * vx + vy * vy;
+        float b = dx * vx + dy * vy;
+        float c = dx * dx + dy * dy - reach * reach;
+        float discriminant = b * b - a * c;
+
+        float root = sqrtf(discriminant > 0.0f ? discriminant : 0.0f);
+        float t = (-b - root) / (a > 1e-12f ? a : 1e-12f);
+
+        // masks and selects rather than ifs, these become vector compares and blends
+        bool crosses = (a > 1e-12f) & (discriminant >= 0.0f) & (t >= 0.0f) & (t <= 1.0f);
+        t = crosses ? t : NO_IMPACT;
+        out[k] = c <= 0.0f ? 0.0f : t;
+    }
+}
+
+// Sweeps one moving circle against every asteroid in the batch, impactTimes needs room for paddedCount results
+void SweepCircleAgainstBatch(const AsteroidSweepBatch *batch, Vector2 start, Vector2 motion, float radius, float *impactTimes)
+{
+    SweepCircleLanes(batch->count, batch->x, batch->y, batch->vx, batch->vy, batch->radius,
+                     start.x, start.y, motion.x, motion.y, radius, impactTimes);
+}
+
 void WrapPosition(Vector2 *position)
 {
-    if (position->x > screenWidth)
+    if (position->x > worldWidth)
     {
         position->x = 0;
     }
     else if (position->x < 0)
     {
-        position->x = screenWidth;
+        position->x = worldWidth;
     }
     
-    if (position->y > screenHeight)
+    if (position->y > worldHeight)
     {
         position->y = 0;
     }
     else if (position->y < 0)
     {
-        position->y = screenHeight;
+        position->y = worldHeight;
+    }
+}
+
+// Whether the ship touches any asteroid, the circles around the two are the quick test and the triangle against the outline the exact one
+static bool ShipHitsAsteroid(const EcsWorld *field, const Player *player)
+{
+    Vector2 ship[3];
+    GetShipTriangle(player, ship);
+
+    EcsQuery query = EcsQueryAll(field, ASTEROID_COMPONENTS);
+    while (EcsNextArchetype(&query))
+    {
+        const Vector2 *position = EcsColumn(&query, COMPONENT_POSITION);
+        const float *radius = EcsColumn(&query, COMPONENT_RADIUS);
+
+        for (int row = 0; row < query.count; row++)
+        {
+            // the ship is moved next to the copy of the asteroid that is closest to it, across the
+            // edges if that is shorter
+            Vector2 shift = WrapImageOffset(position[row], player->position);
+            Vector2 center = { player->position.x + shift.x, player->position.y + shift.y };
+            if (!CheckCollisionCircles(center, SHIP_SIZE, position[row], radius[row])) continue;
+
+            Asteroid asteroid;
+            GetAsteroid(field, EcsRowIndex(&query, row), &asteroid);
+            Vector2 shipNear[3];
+            for (int k = 0; k < 3; k++) shipNear[k] = (Vector2){ ship[k].x + shift.x, ship[k].y + shift.y };
+            if (ShipTouchesAsteroid(shipNear, &asteroid)) return true;
+        }
     }
+    return false;
 }
 
-/* Function for checking collisions between bullets, asteroids, player and updating the score nad gameState if needed */
-void checkCollisions(Player *player, Asteroid *asteroids, Bullet *bullets, int *score, GameState *gameState)
+/*
+ * Function for checking collisions between bullets, asteroids, player and updating the score nad gameState if needed.
+ * The asteroids are the field's, the ship and its bullets the fleet's, which is the same world in the game
+ * (the stress scenario tries every page of asteroids against every page of bullets)
+ */
+void checkCollisions(EcsWorld *field, EcsWorld *fleet, int ship, int *score, GameState *gameState)
 {
-    // let's check the bullet and asteroid collisions
-    for (int i = 0; i < MAX_BULLETS; i++)
+    // let's check the bullet and asteroid collisions, over the whole path each of them took this tick
+    // so nothing gets skipped when bullets are fast or the tick is long
+    AsteroidSweepBatch batch;
+    float impactTimes[SWEEP_BATCH_CAPACITY];
+    bool destroyed[MAX_ASTEROIDS] = { false };    // indices hit this tick, a fragment might already be reusing them
+
+    // in the order of their indices, like the array they used to be, the first bullet to get there gets the asteroid
+    BulletList bullets;
+    ListShipBullets(fleet, ship, &bullets);
+
+    // only asteroids in the chunks around a bullet can be hit this tick, the rest of the world is left out
+    unsigned char reachable[MAX_WORLD_CHUNKS];
+    memset(reachable, 0, sizeof(reachable));
+    for (int i = 0; i < bullets.count; i++)
     {
-        if(bullets[i].active)
+        MarkChunksAround(reachable, bullets.position[i], 1);
+    }
+
+    GatherAsteroidSweepBatch(&batch, field, reachable);
+
+    for (int i = 0; i < bullets.count && batch.count > 0; i++)
+    {
+        Vector2 position = bullets.position[i];
+        Vector2 velocity = bullets.velocity[i];
+        Vector2 start = { position.x - velocity.x, position.y - velocity.y };
+
+        SweepCircleAgainstBatch(&batch, start, velocity, bullets.radius[i], impactTimes);
+
+        // the bullet hits whichever asteroid outline it reaches first, the circle sweep above
+        // only tells us which ones are worth the exact test
+        int hit = -1;
+        float firstImpact = NO_IMPACT;
+        for (int k = 0; k < batch.count; k++)
         {
-            for (int j = 0; j < MAX_ASTEROIDS; j++)
+            if (impactTimes[k] < firstImpact && !destroyed[batch.index[k]])
             {
-                if (asteroids[j].active)
+                // the exact test runs next to the copy of the asteroid the sweep found closest
+                Asteroid asteroid;
+                GetAsteroid(field, batch.index[k], &asteroid);
+                Vector2 asteroidStart = { batch.x[k], batch.y[k] };
+                Vector2 shift = WrapImageOffset(asteroidStart, start);
+                float impact = BulletAsteroidImpact(&asteroid, asteroidStart,
+                                                    (Vector2){ start.x + shift.x, start.y + shift.y },
+                                                    (Vector2){ position.x + shift.x, position.y + shift.y });
+                if (impact < firstImpact)
                 {
-                    // now we check here if the collision occured really
-                    if (CheckCollisionCircles(bullets[i].position, bullets[i].radius,
-                                              asteroids[j].position, asteroids[j].radius))
-                    {
-                        // if it did occur the asteroid has been hit it seems!
-                        bullets[i].active = false;
-                        asteroids[j].active = false;
-                        *score += 100;
-
-                        if (asteroids[j].radius > 20)
-                        {
-                            SplitAsteroid(asteroids, j);
-                        }
-
-                        break;
-                    }
+                    firstImpact = impact;
+                    hit = batch.index[k];
                 }
             }
         }
-    }
 
-    // now we check the collisions between ship and asteroid
-    for (int i = 0; i < MAX_ASTEROIDS; i++)
-    {
-        // if the asteroid is acctive
-        if (asteroids[i].active)
+        if (hit >= 0)
         {
-            // if we the collision happened
-            if (CheckCollisionCircles(player->position, (float) SHIP_SIZE / 2, 
-                                      asteroids[i].position, asteroids[i].radius))
+            // if it did occur the asteroid has been hit it seems!
+            Asteroid asteroid;
+            GetAsteroid(field, hit, &asteroid);
+            EcsDestroy(fleet, bullets.entity[i]);
+            RemoveAsteroid(field, hit);
+            destroyed[hit] = true;
+            *score += 100;
+            CountAsteroidHit(asteroid.radius);
+
+            if (asteroid.radius > 20)
             {
-                // Player has been HIT!
-                *gameState = GAME_OVER;
-                break;
+                SplitAsteroid(field, asteroid.position, asteroid.radius);
             }
         }
     }
+
+    // now we check the collisions between ship and asteroid
+    Player player = GetPlayer(fleet, ship);
+    if (ShipHitsAsteroid(field, &player))
+    {
+        // Player has been HIT!
+        *gameState = GAME_OVER;
+        CountDeath(TELEMETRY_DEATH_ASTEROID);
+    }
 }
@@ -0,0 +1,301 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-23 10:04:51
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-23 16:38:12
+*/
+
+/*
+ * The world size, the chunks it is cut into and the camera looking at it, see world.h.
+ * The chunks are laid out exactly like the cells of a SpatialGrid made with WORLD_CHUNK_SIZE,
+ * so the game keeps one of those (Game.chunkGrid) as the list of what is in every chunk.
+ */
+
+#include "world.h"
+#include "canvas.h"
+#include "utils.h"
+#include <math.h>
+#include <string.h>
+
+int worldWidth = SCREEN_WIDTH;
+int worldHeight = SCREEN_HEIGHT;
+int worldAsteroidLimit = SCREEN_ASTEROIDS;
+
+DrawStats drawStats;
+
+// Until --world gives it a size of its own the world is the canvas, whatever size the window is
+static bool worldFollowsScreen = true;
+
+// The camera in canvas pixels, only drawing and reading the mouse use it, the simulation never does
+static Camera2D view = { .zoom = 1.0f };
+static Vector2 viewPrevious;
+static double viewTravelX, viewTravelY;
+
+void SetWorldSize(int width, int height)
+{
+    worldFollowsScreen = width <= 0 || height <= 0;
+    if (worldFollowsScreen)
+    {
+        FollowScreenSize();
+        return;
+    }
+
+    worldWidth = width < MIN_WORLD_SIZE ? MIN_WORLD_SIZE : (width > MAX_WORLD_SIZE ? MAX_WORLD_SIZE : width);
+    worldHeight = height < MIN_WORLD_SIZE ? MIN_WORLD_SIZE : (height > MAX_WORLD_SIZE ? MAX_WORLD_SIZE : height);
+
+    // as crowded as the default canvas, but never fewer than it gets
+    long long limit = (long long)SCREEN_ASTEROIDS * worldWidth * worldHeight / ((long long)SCREEN_WIDTH * SCREEN_HEIGHT);
+    worldAsteroidLimit = limit < SCREEN_ASTEROIDS ? SCREEN_ASTEROIDS : (limit > MAX_ASTEROIDS ? MAX_ASTEROIDS : (int)limit);
+}
+
+void FollowScreenSize(void)
+{
+    if (!worldFollowsScreen) return;
+
+    worldWidth = screenWidth;
+    worldHeight = screenHeight;
+    worldAsteroidLimit = SCREEN_ASTEROIDS;
+}
+
+bool WorldScrolls(void)
+{
+    return worldWidth > screenWidth || worldHeight > screenHeight;
+}
+
+static inline int WrapChunk(int index, int count)
+{
+    index %= count;
+    return index < 0 ? index + count : index;
+}
+
+// Same rounding as InitSpatialGrid, the chunk grid and these have to agree
+static void ChunkLayout(int *columns, int *rows, float *chunkWidth, float *chunkHeight)
+{
+    *columns = (int)(worldWidth / WORLD_CHUNK_SIZE);
+    *rows = (int)(worldHeight / WORLD_CHUNK_SIZE);
+    if (*columns < 1) *columns = 1;
+    if (*rows < 1) *rows = 1;
+    *chunkWidth = (float)worldWidth / *columns;
+    *chunkHeight = (float)worldHeight / *rows;
+}
+
+int WorldChunkAt(Vector2 position)
+{
+    int columns, rows;
+    float chunkWidth, chunkHeight;
+    ChunkLayout(&columns, &rows, &chunkWidth, &chunkHeight);
+
+    int cx = WrapChunk((int)floorf(position.x / chunkWidth), columns);
+    int cy = WrapChunk((int)floorf(position.y / chunkHeight), rows);
+    return cy * columns + cx;
+}
+
+// Marks the chunk the position is in and every chunk up to reach away from it, across the edges
+void MarkChunksAround(unsigned char marks[MAX_WORLD_CHUNKS], Vector2 position, int reach)
+{
+    int columns, rows;
+    float chunkWidth, chunkHeight;
+    ChunkLayout(&columns, &rows, &chunkWidth, &chunkHeight);
+
+    int cx = (int)floorf(position.x / chunkWidth);
+    int cy = (int)floorf(position.y / chunkHeight);
+
+    for (int y = cy - reach; y <= cy + reach; y++)
+    {
+        for (int x = cx - reach; x <= cx + reach; x++)
+        {
+            marks[WrapChunk(y, rows) * columns + WrapChunk(x, columns)] = 1;
+        }
+    }
+}
+
+/*
+ * One tick of asteroid movement for the whole world. Asteroids in the chunks around one of the
+ * ships move every tick like they always did. The rest move WORLD_DISTANT_STEP ticks' worth at
+ * once, every WORLD_DISTANT_STEP ticks, staggered by index so only a share of them is touched on
+ * any one tick. Out there nothing can hit them and nobody sees them, so the coarser steps don't
+ * show, and an asteroid drifting into or out of range is off by at most a few ticks of motion.
+ * The chunks come from the positions, so this is as deterministic as the rest of the tick.
+ */
+void UpdateWorldAsteroids(EcsWorld *world, const Vector2 focus[], int focusCount, unsigned int tick)
+{
+    int columns, rows;
+    float chunkWidth, chunkHeight;
+    ChunkLayout(&columns, &rows, &chunkWidth, &chunkHeight);
+
+    unsigned char near[MAX_WORLD_CHUNKS];
+    memset(near, 0, (size_t)(columns * rows));
+
+    for (int f = 0; f < focusCount; f++)
+    {
+        MarkChunksAround(near, focus[f], WORLD_NEAR_CHUNKS);
+    }
+
+    // moving one costs a few multiplies, so the lookup has to be cheaper than that: positions are
+    // already wrapped into the world, a multiply and a clamp find the chunk without floorf and %
+    float perWidth = 1.0f / chunkWidth, perHeight = 1.0f / chunkHeight;
+
+    EcsQuery query = EcsQueryAll(world, ASTEROID_COMPONENTS);
+    while (EcsNextArchetype(&query))
+    {
+        Vector2 *position = EcsColumn(&query, COMPONENT_POSITION);
+        const Vector2 *velocity = EcsColumn(&query, COMPONENT_VELOCITY);
+        AsteroidSpin *spin = EcsColumn(&query, COMPONENT_SPIN);
+
+        for (int row = 0; row < query.count; row++)
+        {
+            int cx = (int)(position[row].x * perWidth);
+            int cy = (int)(position[row].y * perHeight);
+            cx = cx < 0 ? 0 : (cx >= columns ? columns - 1 : cx);
+            cy = cy < 0 ? 0 : (cy >= rows ? rows - 1 : cy);
+
+            if (near[cy * columns + cx])
+            {
+                MoveAsteroid(&position[row], velocity[row], &spin[row], 1);
+            }
+            else if ((EcsRowIndex(&query, row) + tick) % WORLD_DISTANT_STEP == 0)
+            {
+                MoveAsteroid(&position[row], velocity[row], &spin[row], WORLD_DISTANT_STEP);
+            }
+        }
+    }
+}
+
+/*
+ * Points the camera at the focus (the local ship). While the world fits the canvas the camera
+ * doesn't move at all and world and screen coordinates are the same thing, like before there
+ * was a camera. The distance it moved is added up across the edges, so the stars don't jump
+ * when the focus wraps around.
+ */
+void FocusWorldView(Vector2 focus)
+{
+    if (!WorldScrolls())
+    {
+        view.target = (Vector2){ 0.0f, 0.0f };
+        view.offset = (Vector2){ 0.0f, 0.0f };
+        viewPrevious = focus;
+        return;
+    }
+
+    Vector2 shift = WrapImageOffset(viewPrevious, focus);
+    viewTravelX += focus.x + shift.x - viewPrevious.x;
+    viewTravelY += focus.y + shift.y - viewPrevious.y;
+    viewPrevious = focus;
+
+    view.target = focus;
+    view.offset = (Vector2){ screenWidth * 0.5f, screenHeight * 0.5f };
+    view.rotation = 0.0f;
+    view.zoom = 1.0f;
+}
+
+// The camera as raylib wants it, drawing into the canvas texture at the render scale
+Camera2D WorldViewCamera(void)
+{
+    Camera2D scaled = view;
+    scaled.offset = (Vector2){ view.offset.x * CanvasScale(), view.offset.y * CanvasScale() };
+    scaled.zoom = view.zoom * CanvasScale();
+    return scaled;
+}
+
+Vector2 WorldViewTravel(void)
+{
+    return (Vector2){ (float)viewTravelX, (float)viewTravelY };
+}
+
+// Mouse position to world position, around the camera target and not wrapped, so it points the right way from the ship
+Vector2 ScreenToWorld(Vector2 point)
+{
+    return (Vector2){ point.x - view.offset.x + view.target.x, point.y - view.offset.y + view.target.y };
+}
+
+/*
+ * Where to draw something: the offsets to add to its position, one per copy that is on screen,
+ * none when it is out of view. With the whole world on screen these are the copies over the
+ * edges (EdgeGhostOffsets). Otherwise it is the copy closest to the camera, plus the ones a
+ * world away when the world is so narrow that those show as well.
+ */
+int ViewImageOffsets(Vector2 position, float radius, Vector2 offsets[])
+{
+    if (!WorldScrolls()) return EdgeGhostOffsets(position, radius, offsets);
+
+    Vector2 nearest = WrapImageOffset(view.target, position);
+    float reachX = screenWidth * 0.5f + radius;
+    float reachY = screenHeight * 0.5f + radius;
+
+    float shiftX[3], shiftY[3];
+    int columns = 0, rows = 0;
+    for (int k = -1; k <= 1; k++)
+    {
+        float x = nearest.x + k * (float)worldWidth;
+        float y = nearest.y + k * (float)worldHeight;
+        if (fabsf(position.x + x - view.target.x) <= reachX) shiftX[columns++] = x;
+        if (fabsf(position.y + y - view.target.y) <= reachY) shiftY[rows++] = y;
+    }
+
+    int count = 0;
+    for (int y = 0; y < rows; y++)
+    {
+        for (int x = 0; x < columns && count < EDGE_COPIES; x++)
+        {
+            offsets[count++] = (Vector2){ shiftX[x], shiftY[y] };
+        }
+    }
+    return count;
+}
+
+float ViewPixelScale(void)
+{
+    return view.zoom * CanvasScale();
+}
+
+// The chunk rows or columns the view covers on one axis, all of them when it covers the whole world
+static int VisibleSpan(float center, float halfView, float chunkSize, int count, int *first)
+{
+    int from = (int)floorf((center - halfView) / chunkSize);
+    int to = (int)floorf((center + halfView) / chunkSize);
+
+    *first = to - from + 1 >= count ? 0 : from;
+    return to - from + 1 >= count ? count : to - from + 1;
+}
+
+/*
+ * The asteroids in the chunks the camera can see, out of the chunk grid, so whatever is in the
+ * rest of the world isn't even looked at. The view is widened by the biggest radius, an asteroid
+ * in the next chunk can still reach into the picture. indices needs room for MAX_ASTEROIDS.
+ */
+int GatherVisibleAsteroids(const SpatialGrid *chunks, const EcsWorld *world, int indices[])
+{
+    int count = 0;
+
+    // no grid (out of memory), everything then
+    if (chunks->cellHead == NULL)
+    {
+        EcsQuery query = EcsQueryAll(world, ASTEROID_COMPONENTS);
+        while (EcsNextArchetype(&query))
+        {
+            for (int row = 0; row < query.count; row++) indices[count++] = EcsRowIndex(&query, row);
+        }
+        return count;
+    }
+
+    int firstColumn = 0, firstRow = 0;
+    int columns = chunks->columns, rows = chunks->rows;
+    if (WorldScrolls())
+    {
+        columns = VisibleSpan(view.target.x, screenWidth * 0.5f + chunks->maxRadius, chunks->cellWidth, chunks->columns, &firstColumn);
+        rows = VisibleSpan(view.target.y, screenHeight * 0.5f + chunks->maxRadius, chunks->cellHeight, chunks->rows, &firstRow);
+    }
+
+    for (int y = firstRow; y < firstRow + rows; y++)
+    {
+        for (int x = firstColumn; x < firstColumn + columns; x++)
+        {
+            int chunk = WrapChunk(y, chunks->rows) * chunks->columns + WrapChunk(x, chunks->columns);
+            for (int i = chunks->cellHead[chunk]; i >= 0; i = chunks->next[i])
+            {
+                indices[count++] = i;
+            }
+        }
+    }
+    return count;
+}
@@ -0,0 +1,266 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-06-02 16:20:51
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-06-02 18:42:13
+*/
+
+/*
+ * Round trips of what the state stream sends for an asteroid or a bullet. Bot games run on the
+ * canvas sized world and on a big one, and after every tick every asteroid and bullet goes through
+ * what a viewer does with its slot attributes: the radius from half pixels, the outline built
+ * again from its phase, a bullet's color and radius from its palette index. All of that has to
+ * come back exactly as the game had it, except the outline, which may
+ * move by as much as half a phase step turns the wobble.
+ *
+ * Every tick is also sent as a keyframe and read back, where the positions are 16 bit fractions
+ * of the world and the velocities a heading and a speed. Those have to be within half a step of
+ * the game's, and the keyframe is sent again without the bullets and without the asteroids too to
+ * measure what each one of them costs.
+ *
+ * Reports the attribute bytes next to the fields they stand in for, the bytes per entity in a
+ * keyframe next to their table rows, the worst outline, position and velocity errors and the time a
+ * phase and a rebuild take. Any round trip out of bounds makes the exit code 1.
+ *
+ * Usage: ./bin/bench_compact [--ticks N] [--seed S]
+ */
+
+#include "game.h"
+#include "bot.h"
+#include "compact.h"
+#include "statestream.h"
+#include "world.h"
+#include <math.h>
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// What one world size went through
+typedef struct Run {
+    long long ticks;
+    long long asteroids, bullets;
+    long long failures;
+    float     worstOutline;                    // pixels, any point of it
+    float     worstPosition, worstVelocity;    // pixels and pixels per tick, keyframe round trips
+    long long asteroidBytes, bulletBytes;      // what they added to the keyframes
+    double    phaseSeconds, rebuildSeconds;
+} Run;
+
+// Scratch for the keyframes, a fresh codec every time so each frame is one
+static StreamCodec codec, viewerCodec;
+static unsigned char frame[STREAM_MAX_FRAME];
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// The radius and the outline, the way DecodeStreamFrame gets them back
+static bool CheckAsteroid(Run *run, const Asteroid *asteroid)
+{
+    double start = Now();
+    int phase = AsteroidOutlinePhase(asteroid);
+    double found = Now();
+
+    Asteroid back = *asteroid;
+    back.radius = (unsigned char)lrintf(asteroid->radius * 2.0f) / 2.0f;
+    RebuildAsteroidOutline(&back, phase);
+    run->phaseSeconds += found - start;
+    run->rebuildSeconds += Now() - found;
+
+    // the wobble is 0.2 of the radius, half a phase step moves it by at most that times the step
+    float outline = 0.0f;
+    for (int k = 0; k <= ASTEROID_VERTICES; k++)
+    {
+        float d = hypotf(asteroid->outlineX[k] - back.outlineX[k], asteroid->outlineY[k] - back.outlineY[k]);
+        if (d > outline) outline = d;
+    }
+    if (outline > run->worstOutline) run->worstOutline = outline;
+
+    return back.radius == asteroid->radius && back.rotation == asteroid->rotation &&
+           outline <= asteroid->radius * 0.2f * (PI / COMPACT_PHASES) + 0.01f;
+}
+
+static bool CheckBullet(const Bullet *bullet)
+{
+    BulletKind kind = FindBulletKind(bullet);
+    Color color = BulletKindColor(kind);
+
+    return BulletKindRadius(kind) == bullet->radius &&
+           color.r == bullet->color.r && color.g == bullet->color.g && color.b == bullet->color.b && color.a == bullet->color.a;
+}
+
+static int EncodeKeyframe(const Game *game)
+{
+    memset(&codec, 0, sizeof(codec));
+    return EncodeStreamFrame(&codec, game, frame, sizeof(frame));
+}
+
+// Half a step of the world fraction and the two roundings to 1/256 pixel, the game's value on the way in and the step on the way out
+static bool CheckMotion(Run *run, Vector2 position, Vector2 velocity, Vector2 seenPosition, Vector2 seenVelocity)
+{
+    float positionBound = 0.5f * fmaxf((float)worldWidth, (float)worldHeight) / 65535.0f + 1.0f / 256.0f + 1e-4f;
+    float offset = fmaxf(fabsf(position.x - seenPosition.x), fabsf(position.y - seenPosition.y));
+
+    // the heading is within a few steps of 65536 per turn, the speed and the steps within 1/256 pixel
+    float speed = hypotf(velocity.x, velocity.y);
+    float velocityBound = speed * 4.0f * (2.0f * PI / 65536.0f) + 2.0f / 256.0f;
+    float error = hypotf(velocity.x - seenVelocity.x, velocity.y - seenVelocity.y);
+
+    if (offset > run->worstPosition) run->worstPosition = offset;
+    if (error > run->worstVelocity) run->worstVelocity = error;
+    return offset <= positionBound && error <= velocityBound;
+}
+
+// The tick as a keyframe, read back like a viewer that just joined, then without bullets and without asteroids
+static void CheckKeyframe(Run *run, const Game *game, Game *seen, Game *scratch)
+{
+    int size = EncodeKeyframe(game);
+    memset(&viewerCodec, 0, sizeof(viewerCodec));
+    if (size == 0 || !DecodeStreamFrame(&viewerCodec, frame, size, seen))
+    {
+        run->failures++;
+        return;
+    }
+
+    for (int i = 0; i < MAX_ASTEROIDS; i++)
+    {
+        Asteroid asteroid, back;
+        if (!GetAsteroid(&game->entities, i, &asteroid)) continue;
+        run->failures += !GetAsteroid(&seen->entities, i, &back) ||
+                         !CheckMotion(run, asteroid.position, asteroid.velocity, back.position, back.velocity);
+    }
+
+    for (int i = 0; i < BULLET_SLOTS; i++)
+    {
+        Bullet bullet, back;
+        if (!GetBullet(&game->entities, i, &bullet)) continue;
+        run->failures += !GetBullet(&seen->entities, i, &back) ||
+                         !CheckMotion(run, bullet.position, bullet.velocity, back.position, back.velocity);
+    }
+
+    memcpy(scratch, game, sizeof(Game));
+    InitBullets(&scratch->entities, 0);
+    InitBullets(&scratch->entities, 1);
+    int withoutBullets = EncodeKeyframe(scratch);
+    InitAsteroid(&scratch->entities);
+    int withoutEither = EncodeKeyframe(scratch);
+
+    run->bulletBytes += size - withoutBullets;
+    run->asteroidBytes += withoutBullets - withoutEither;
+}
+
+static void CheckTick(Run *run, const Game *game, Game *seen, Game *scratch)
+{
+    run->ticks++;
+    CheckKeyframe(run, game, seen, scratch);
+
+    for (int i = 0; i < MAX_ASTEROIDS; i++)
+    {
+        Asteroid asteroid;
+        if (!GetAsteroid(&game->entities, i, &asteroid)) continue;
+        run->asteroids++;
+        run->failures += !CheckAsteroid(run, &asteroid);
+    }
+
+    for (int i = 0; i < BULLET_SLOTS; i++)
+    {
+        Bullet bullet;
+        if (!GetBullet(&game->entities, i, &bullet)) continue;
+        run->bullets++;
+        run->failures += !CheckBullet(&bullet);
+    }
+}
+
+static void PlayGames(Run *run, int ticks, unsigned int seed)
+{
+    Game *game = malloc(sizeof(Game));
+    Game *seen = calloc(1, sizeof(Game));
+    Game *scratch = malloc(sizeof(Game));
+    Bot bot = CreateAimEvadeBot();
+    InitHeadlessGame(game, seed);
+
+    for (int t = 0; t < ticks; t++)
+    {
+        // the trigger stays down, in a big world the bot seldom has anything in range of its own
+        PlayerInput input = RunBot(&bot, game);
+        input.shoot = true;
+        StepGameplay(game, &input);
+        CheckTick(run, game, seen, scratch);
+
+        if (game->state == GAME_OVER)
+        {
+            UnloadGame(game);
+            InitHeadlessGame(game, ++seed);
+        }
+    }
+
+    UnloadGame(game);
+    free(game);
+    free(seen);
+    free(scratch);
+}
+
+static void PrintRun(const char *name, const Run *run)
+{
+    double asteroids = run->asteroids > 0 ? (double)run->asteroids : 1.0;
+    double bullets = run->bullets > 0 ? (double)run->bullets : 1.0;
+
+    printf("%s (%dx%d): %lld ticks, %lld asteroids and %lld bullets checked\n", name, worldWidth, worldHeight,
+           run->ticks, run->asteroids, run->bullets);
+    printf("  outline         worst %.5f px off, phase %.3f us, rebuild %.3f us per asteroid\n", run->worstOutline,
+           run->phaseSeconds * 1e6 / asteroids, run->rebuildSeconds * 1e6 / asteroids);
+    printf("  keyframes       %.2f bytes per asteroid, %.2f per bullet, worst %.4f px and %.4f px per tick off\n",
+           run->asteroidBytes / asteroids, run->bulletBytes / bullets, run->worstPosition, run->worstVelocity);
+    printf("  round trips     %lld out of bounds\n", run->failures);
+}
+
+int main(int argc, char *argv[])
+{
+    int ticks = GAME_TICK_RATE * 60 * 5;       // five minutes of play per world
+    unsigned int seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) ticks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (unsigned int)atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--ticks N] [--seed S]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (ticks < 1) ticks = 1;
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    Asteroid asteroid;
+    Bullet bullet;
+    printf("derived bytes     %-10s %8s %10s\n", "", "fields", "attributes");
+    printf("                  %-10s %8zu %10d   radius, outline\n", "asteroid",
+           sizeof(asteroid.radius) + sizeof(asteroid.outlineX) + sizeof(asteroid.outlineY), 2);
+    printf("                  %-10s %8zu %10d   radius, color\n", "bullet", sizeof(bullet.radius) + sizeof(bullet.color), 1);
+    printf("row bytes         %-10s %8zu\n                  %-10s %8zu\n", "asteroid", sizeof(Asteroid), "bullet", sizeof(Bullet));
+
+    long long failures = 0;
+
+    Run canvas;
+    memset(&canvas, 0, sizeof(canvas));
+    SetWorldSize(0, 0);
+    PlayGames(&canvas, ticks, seed);
+    PrintRun("canvas world", &canvas);
+    failures += canvas.failures;
+
+    Run big;
+    memset(&big, 0, sizeof(big));
+    SetWorldSize(MAX_WORLD_SIZE / 2, MAX_WORLD_SIZE / 2);
+    PlayGames(&big, ticks, seed);
+    PrintRun("big world", &big);
+    failures += big.failures;
+
+    return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,417 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-25 10:21:37
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-25 12:04:19
+*/
+
+/*
+ * Benchmark and check for the entity storage in src/ecs.c. The asteroids and the bullets live in
+ * the game's EcsWorld now, this times their update systems (UpdateAsteroidFloat, UpdateBulletsFloat)
+ * walking the table rows next to the array versions they replaced, copied below as they were, on the
+ * same entities: a big world with every one of the MAX_ASTEROIDS asteroid slots taken and both ships'
+ * bullet pools full. Then again with every other asteroid and bullet gone, the holes a game leaves in
+ * the arrays. After every round both sides have to hold the same entities at the same indices with
+ * the same positions, turns and lifetimes, and the alpha the arrays kept has to be what BulletAlpha
+ * works out from the lifetime. The ships are one row each and aren't timed.
+ *
+ * Then spawns and destroys entities at random for a while, checking after every step that each live
+ * id still finds its own components and every table row points back at its entity.
+ *
+ * Usage: ./bin/bench_ecs [--ticks N] [--seed S]
+ */
+
+#include "asteroids.h"
+#include "bullet.h"
+#include "ecs.h"
+#include "game.h"
+#include "tunables.h"
+#include "ufo.h"
+#include "utils.h"
+#include "world.h"
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CHURN_STEPS 200000
+#define ROUND_TICKS (BULLET_LIFETIME - BULLET_FADE_TICKS / 2)    // the bullets still there are fading, every round starts from the same field
+
+// The entities the way they were kept before the port, an array slot each with an active flag
+typedef struct LegacyAsteroid {
+    Vector2 position;
+    Vector2 velocity;
+    float   rotation;
+    float   rotationSpeed;
+    float   radius;
+    bool    active;
+    float   outlineX[ASTEROID_VERTICES + 1];
+    float   outlineY[ASTEROID_VERTICES + 1];
+} LegacyAsteroid;
+
+typedef struct LegacyBullet {
+    Vector2 position;
+    Vector2 velocity;
+    float radius;
+    bool active;
+    float lifeTime;
+    Color color;
+    float alpha;
+} LegacyBullet;
+
+// One field on both sides
+typedef struct Field {
+    EcsWorld       world;
+    LegacyAsteroid asteroids[MAX_ASTEROIDS];
+    LegacyBullet   bullets[BULLET_SLOTS];
+    unsigned int   rngState;
+} Field;
+
+// What one field went through
+typedef struct Run {
+    int       asteroids, bullets;
+    double    ecsSeconds, arraySeconds;
+    long long ticks;
+    long long mismatches;
+    long long fading;                  // bullets still there at the checks
+} Run;
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// UpdateAsteroidFloat before the port
+static void LegacyUpdateAsteroids(LegacyAsteroid asteroids[])
+{
+    for (int i = 0; i < MAX_ASTEROIDS; i++)
+    {
+        if (asteroids[i].active)
+        {
+            asteroids[i].position.x += asteroids[i].velocity.x;
+            asteroids[i].position.y += asteroids[i].velocity.y;
+            asteroids[i].rotation += asteroids[i].rotationSpeed;
+            WrapPosition(&asteroids[i].position);
+        }
+    }
+
+    // the spawn roll, the chance is 0 here (see main) so both sides only draw the number
+    (void)SimRandomValue(0, 100);
+}
+
+// UpdateBulletsFloat before the port, one ship's pool
+static void LegacyUpdateBullets(LegacyBullet bullets[])
+{
+    for (int i = 0; i < MAX_BULLETS; i++)
+    {
+        if (bullets[i].active)
+        {
+            bullets[i].position.x += bullets[i].velocity.x;
+            bullets[i].position.y += bullets[i].velocity.y;
+
+            if (bullets[i].position.x < 0 ||
+                bullets[i].position.x > worldWidth ||
+                bullets[i].position.y < 0 ||
+                bullets[i].position.y > worldHeight)
+            {
+                bullets[i].active = false;
+                continue;
+            }
+
+            bullets[i].lifeTime--;
+            if (bullets[i].lifeTime < 40) {
+                bullets[i].alpha = bullets[i].lifeTime / 40.0f;
+            }
+
+            if (bullets[i].lifeTime <= 0)
+            {
+                bullets[i].active = false;
+            }
+        }
+    }
+}
+
+// The arrays copied out of the world index by index
+static void CopyToArrays(Field *field)
+{
+    memset(field->asteroids, 0, sizeof(field->asteroids));
+    memset(field->bullets, 0, sizeof(field->bullets));
+
+    for (int i = 0; i < MAX_ASTEROIDS; i++)
+    {
+        Asteroid asteroid;
+        if (!GetAsteroid(&field->world, i, &asteroid)) continue;
+
+        LegacyAsteroid *legacy = &field->asteroids[i];
+        legacy->position = asteroid.position;
+        legacy->velocity = asteroid.velocity;
+        legacy->rotation = asteroid.rotation;
+        legacy->rotationSpeed = asteroid.rotationSpeed;
+        legacy->radius = asteroid.radius;
+        legacy->active = true;
+        memcpy(legacy->outlineX, asteroid.outlineX, sizeof(legacy->outlineX));
+        memcpy(legacy->outlineY, asteroid.outlineY, sizeof(legacy->outlineY));
+    }
+
+    for (int i = 0; i < BULLET_SLOTS; i++)
+    {
+        Bullet bullet;
+        if (!GetBullet(&field->world, i, &bullet)) continue;
+
+        LegacyBullet *legacy = &field->bullets[i];
+        legacy->position = bullet.position;
+        legacy->velocity = bullet.velocity;
+        legacy->radius = bullet.radius;
+        legacy->active = true;
+        legacy->lifeTime = (float)bullet.lifeTime;
+        legacy->color = bullet.color;
+        legacy->alpha = BulletAlpha(bullet.lifeTime);
+    }
+}
+
+/*
+ * A big world's worth of asteroids spawned the way the game does and both pools shot full from all
+ * over the world, with lifetimes anywhere up to BULLET_LIFETIME so they don't all go at once.
+ * With holes, every other index of both is taken out again.
+ */
+static void FillField(Field *field, unsigned int seed, bool holes)
+{
+    unsigned int rng = seed;
+    BindSimulationRandom(&rng);
+    InitGameWorld(&field->world);
+
+    while (SpawnAsteroidsFloat(&field->world, 0) >= 0) {}
+
+    for (int ship = 0; ship < 2; ship++)
+    {
+        for (int shot = 0; shot < MAX_BULLETS; shot++)
+        {
+            Vector2 position = { (float)SimRandomValue(0, worldWidth), (float)SimRandomValue(0, worldHeight) };
+            ShootBulletsFloat(&field->world, ship, position, (float)SimRandomValue(0, 359));
+        }
+    }
+    for (int i = 0; i < BULLET_SLOTS; i++)
+    {
+        Bullet bullet;
+        if (!GetBullet(&field->world, i, &bullet)) continue;
+        bullet.lifeTime = SimRandomValue(1, BULLET_LIFETIME);
+        PutBullet(&field->world, i, &bullet);
+    }
+
+    if (holes)
+    {
+        for (int i = 1; i < MAX_ASTEROIDS; i += 2) RemoveAsteroid(&field->world, i);
+        for (int i = 1; i < BULLET_SLOTS; i += 2)
+        {
+            EntityId entity = EcsEntityAt(&field->world, BULLET_COMPONENTS, i);
+            if (entity != ECS_NO_ENTITY) EcsDestroy(&field->world, entity);
+        }
+    }
+
+    CopyToArrays(field);
+    field->rngState = rng;
+    BindSimulationRandom(NULL);
+}
+
+// The same entities at the same indices, with the same values
+static long long CompareField(const Field *field)
+{
+    long long mismatches = 0;
+
+    for (int i = 0; i < MAX_ASTEROIDS; i++)
+    {
+        Asteroid asteroid;
+        const LegacyAsteroid *legacy = &field->asteroids[i];
+        bool alive = GetAsteroid(&field->world, i, &asteroid);
+
+        if (alive != legacy->active) mismatches++;
+        else if (alive && (asteroid.position.x != legacy->position.x || asteroid.position.y != legacy->position.y ||
+                           asteroid.rotation != legacy->rotation || asteroid.radius != legacy->radius)) mismatches++;
+    }
+
+    for (int i = 0; i < BULLET_SLOTS; i++)
+    {
+        Bullet bullet;
+        const LegacyBullet *legacy = &field->bullets[i];
+        bool alive = GetBullet(&field->world, i, &bullet);
+
+        if (alive != legacy->active) mismatches++;
+        else if (alive && (bullet.position.x != legacy->position.x || bullet.position.y != legacy->position.y ||
+                           (float)bullet.lifeTime != legacy->lifeTime || BulletAlpha(bullet.lifeTime) != legacy->alpha)) mismatches++;
+    }
+    return mismatches;
+}
+
+static void RunField(Run *run, const Field *start, Field *field, int ticks)
+{
+    run->asteroids = EcsCount(&start->world, ASTEROID_COMPONENTS);
+    run->bullets = EcsCount(&start->world, BULLET_COMPONENTS);
+
+    for (int done = 0; done < ticks; done += ROUND_TICKS)
+    {
+        int round = ticks - done < ROUND_TICKS ? ticks - done : ROUND_TICKS;
+        memcpy(field, start, sizeof(Field));
+
+        unsigned int rng = start->rngState;
+        BindSimulationRandom(&rng);
+        double begin = Now();
+        for (int tick = 0; tick < round; tick++)
+        {
+            UpdateAsteroidFloat(&field->world);
+            UpdateBulletsFloat(&field->world);
+        }
+        run->ecsSeconds += Now() - begin;
+
+        rng = start->rngState;
+        begin = Now();
+        for (int tick = 0; tick < round; tick++)
+        {
+            LegacyUpdateAsteroids(field->asteroids);
+            LegacyUpdateBullets(field->bullets);
+            LegacyUpdateBullets(field->bullets + MAX_BULLETS);
+        }
+        run->arraySeconds += Now() - begin;
+        BindSimulationRandom(NULL);
+
+        run->ticks += round;
+        run->mismatches += CompareField(field);
+        run->fading += EcsCount(&field->world, BULLET_COMPONENTS);
+    }
+}
+
+static void PrintRun(const char *name, const Run *run)
+{
+    double ticks = run->ticks > 0 ? (double)run->ticks : 1.0;
+
+    printf("%-16s %3d asteroids, %3d bullets, %lld ticks\n", name, run->asteroids, run->bullets, run->ticks);
+    printf("  update         ecs rows %8.1f ns   arrays %8.1f ns   per tick\n", run->ecsSeconds / ticks * 1e9, run->arraySeconds / ticks * 1e9);
+    printf("  checks         %lld entities differ, %lld bullets were still fading when checked\n", run->mismatches, run->fading);
+}
+
+// Every live slot's row points back at it
+static bool WorldConsistent(const EcsWorld *world, const EntityId ids[], int idCount)
+{
+    int alive = 0;
+    for (int slot = 0; slot < ECS_MAX_ENTITIES; slot++)
+    {
+        const EcsRecord *record = &world->records[slot];
+        if (!record->alive) continue;
+
+        alive++;
+        const EcsArchetype *archetype = &world->archetypes[record->archetype];
+        if (record->row >= archetype->count || world->rowSlot[archetype->firstSlot + record->row] != slot) return false;
+    }
+    if (alive != EcsCount(world, 0) || alive != idCount) return false;
+
+    for (int i = 0; i < idCount; i++)
+    {
+        if (!EcsAlive(world, ids[i])) return false;
+    }
+    return true;
+}
+
+static void RunChurn(unsigned int seed)
+{
+    EcsWorld *world = malloc(sizeof(EcsWorld));
+    InitEcsWorld(world);
+
+    EntityId ids[ECS_MAX_ENTITIES];
+    EntityId gone[ECS_MAX_ENTITIES];
+    int idCount = 0, goneCount = 0;
+    unsigned int state = seed;
+    long spawns = 0, destroys = 0, failures = 0;
+
+    double start = Now();
+    for (int step = 0; step < CHURN_STEPS; step++)
+    {
+        state = state * 1664525u + 1013904223u;
+        bool spawn = idCount == 0 || (idCount < ECS_MAX_ENTITIES && (state >> 28) < 9);
+
+        if (spawn)
+        {
+            EntityId entity = EcsSpawn(world, (state >> 20) % 5 == 0 ? UFO_COMPONENTS : UFO_SHOT_COMPONENTS);
+            if (entity == ECS_NO_ENTITY) continue;
+
+            *(int *)EcsGet(world, entity, COMPONENT_LIFETIME) = (int)entity;
+            ids[idCount++] = entity;
+            spawns++;
+        }
+        else
+        {
+            int pick = (int)((state >> 8) % (unsigned int)idCount);
+            EcsDestroy(world, ids[pick]);
+            if (goneCount < ECS_MAX_ENTITIES) gone[goneCount++] = ids[pick];
+            ids[pick] = ids[--idCount];
+            destroys++;
+        }
+
+        // every live entity still finds its own components, a destroyed id finds nothing
+        for (int i = 0; i < idCount; i++)
+        {
+            int *tag = EcsGet(world, ids[i], COMPONENT_LIFETIME);
+            if (tag == NULL || *tag != (int)ids[i]) failures++;
+        }
+        for (int i = 0; i < goneCount; i++)
+        {
+            if (EcsAlive(world, gone[i])) failures++;
+        }
+        if (!WorldConsistent(world, ids, idCount)) failures++;
+        if (goneCount == ECS_MAX_ENTITIES) goneCount = 0;
+    }
+    double seconds = Now() - start;
+
+    printf("churn            %ld spawns, %ld destroys in %.2f s with the checks, %ld failures\n", spawns, destroys, seconds, failures);
+    free(world);
+}
+
+int main(int argc, char *argv[])
+{
+    int ticks = 200000;
+    unsigned int seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) ticks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (unsigned int)atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--ticks N] [--seed S]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (ticks < 1) ticks = 1;
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    // big enough that every asteroid slot is in use, and no spawns in the holes so both sides keep the same entities
+    SetWorldSize(MAX_WORLD_SIZE / 2, MAX_WORLD_SIZE / 2);
+    Tunables tunables = DefaultTunables();
+    tunables.asteroidSpawnChance = 0;
+    BindTunables(&tunables);
+
+    Field *start = malloc(sizeof(Field));
+    Field *field = malloc(sizeof(Field));
+    printf("EcsWorld %zu bytes, %d of them in use by the game's tables, %d asteroid slots\n",
+           sizeof(EcsWorld), (InitGameWorld(&start->world), start->world.bytesUsed), worldAsteroidLimit);
+
+    Run full, holes;
+    memset(&full, 0, sizeof(full));
+    memset(&holes, 0, sizeof(holes));
+
+    FillField(start, seed, false);
+    RunField(&full, start, field, ticks);
+    PrintRun("full", &full);
+
+    FillField(start, seed, true);
+    RunField(&holes, start, field, ticks);
+    PrintRun("every other", &holes);
+
+    free(start);
+    free(field);
+
+    RunChurn(seed);
+    return full.mismatches + holes.mismatches > 0 ? 1 : 0;
+}
@@ -0,0 +1,251 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-21 18:44:09
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-21 21:25:33
+*/
+
+/*
+ * Benchmark and check for the fixed-point simulation (include/fixed.h). Measures how far the
+ * table sine, the CORDIC atan2 and the integer square root are from libm, how fast they are next
+ * to it, and how fast the float and fixed versions of the ship, asteroid and bullet physics run
+ * over full entity pools. Both versions are always compiled in, the build only picks which one
+ * the game uses, so one binary can compare them.
+ *
+ * Last it plays a game with scripted inputs through StepGameplay (whichever version this build
+ * uses) and prints a hash of the final state. Builds with FIXED_SIM=1 have to print the same
+ * hash whatever the compiler and the flags were, try it with -O0 and -O3 -march=native.
+ *
+ * Usage: ./bin/bench_fixed [--ticks N] [--seed S]
+ */
+
+#include "game.h"
+#include "fixed.h"
+#include "snapshot.h"
+#include "utils.h"
+#include <raylib.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define TRIG_CALLS     (1 << 24)
+#define KERNEL_ROUNDS  200000
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Keeps results alive so the compiler can't drop the loops being timed
+static volatile float floatSink;
+static volatile Fixed fixedSink;
+
+static void CheckAccuracy(void)
+{
+    double sineError = 0.0, atanError = 0.0, lengthError = 0.0;
+
+    for (int a = 0; a < 65536; a++)
+    {
+        double radians = a * (2.0 * PI / 65536.0);
+        sineError = fmax(sineError, fabs(FixedSin((BinaryAngle)a) / 65536.0 - sin(radians)));
+        sineError = fmax(sineError, fabs(FixedCos((BinaryAngle)a) / 65536.0 - cos(radians)));
+    }
+
+    // vectors of every direction and length from a fraction of a pixel to a whole screen
+    srand(1);
+    for (int i = 0; i < 1000000; i++)
+    {
+        Fixed x = (Fixed)((rand() % 4000001) - 2000000) * (1 + rand() % 64);
+        Fixed y = (Fixed)((rand() % 4000001) - 2000000) * (1 + rand() % 64);
+        if (x == 0 && y == 0) continue;
+
+        double exact = atan2((double)y, (double)x) * (65536.0 / (2.0 * PI));
+        double error = fabs(FixedAtan2(y, x) - exact);
+        atanError = fmax(atanError, fmin(error, 65536.0 - error));
+
+        double length = sqrt((double)x * x + (double)y * y);
+        lengthError = fmax(lengthError, fabs(FixedLength(x, y) - length));
+    }
+
+    printf("accuracy (worst case)\n");
+    printf("  sin/cos table    %.2f / 65536  (%.1e)\n", sineError * 65536.0, sineError);
+    printf("  atan2 (CORDIC)   %.2f binary angle units  (%.4f degrees)\n", atanError, atanError * 360.0 / 65536.0);
+    printf("  length (isqrt)   %.2f / 65536 pixels\n", lengthError);
+}
+
+static void TimeTrig(void)
+{
+    double start = Now();
+    float floatSum = 0.0f;
+    for (int i = 0; i < TRIG_CALLS; i++)
+    {
+        float radians = (float)i * 0.000374f;
+        floatSum += sinf(radians) + cosf(radians);
+    }
+    double libmSeconds = Now() - start;
+    floatSink = floatSum;
+
+    start = Now();
+    Fixed fixedSum = 0;
+    for (int i = 0; i < TRIG_CALLS; i++)
+    {
+        BinaryAngle angle = (BinaryAngle)(i * 3);
+        fixedSum += FixedSin(angle) + FixedCos(angle);
+    }
+    double tableSeconds = Now() - start;
+    fixedSink = fixedSum;
+
+    start = Now();
+    for (int i = 0; i < TRIG_CALLS / 16; i++)
+    {
+        floatSum += atan2f((float)(i & 1023) - 511.5f, (float)(i >> 10) - 511.5f);
+    }
+    double atanSeconds = Now() - start;
+    floatSink = floatSum;
+
+    start = Now();
+    for (int i = 0; i < TRIG_CALLS / 16; i++)
+    {
+        fixedSum += FixedAtan2(FIXED_INT(i & 1023) - FIXED_CONST(511.5), FIXED_INT(i >> 10) - FIXED_CONST(511.5));
+    }
+    double cordicSeconds = Now() - start;
+    fixedSink = fixedSum;
+
+    printf("trig throughput (million calls per second)\n");
+    printf("  sinf+cosf        %8.1f    table sin+cos  %8.1f   (%.2fx)\n",
+           TRIG_CALLS / libmSeconds / 1e6, TRIG_CALLS / tableSeconds / 1e6, libmSeconds / tableSeconds);
+    printf("  atan2f           %8.1f    CORDIC atan2   %8.1f   (%.2fx)\n",
+           TRIG_CALLS / 16 / atanSeconds / 1e6, TRIG_CALLS / 16 / cordicSeconds / 1e6, atanSeconds / cordicSeconds);
+}
+
+// Every asteroid slot, a full bullet pool and a ship turning and thrusting, the start of every round
+static void FillField(Game *game, unsigned int seed)
+{
+    InitHeadlessGame(game, seed);
+    BindSimulationRandom(&game->rngState);
+
+    for (int i = 0; i < MAX_ASTEROIDS; i++) SpawnAsteroidsFloat(&game->entities, 0);
+    for (int i = 0; i < MAX_BULLETS / 3; i++)
+    {
+        Vector2 position = { (float)SimRandomValue(100, worldWidth - 100), (float)SimRandomValue(100, worldHeight - 100) };
+        ShootBulletsFloat(&game->entities, 0, position, (float)SimRandomValue(0, 359));
+    }
+}
+
+typedef void (*AsteroidKernel)(EcsWorld *world);
+typedef void (*BulletKernel)(EcsWorld *world);
+typedef void (*PlayerKernel)(EcsWorld *world, int ship, const PlayerInput *input);
+
+// Runs the three physics steps over the full field, starting over from the same field every 30 ticks
+static double TimeKernels(const Game *field, AsteroidKernel asteroids, BulletKernel bullets, PlayerKernel player)
+{
+    Game *game = malloc(sizeof(Game));
+    PlayerInput input = { .rotateLeft = true, .thrust = true };     // no shooting, the bullet pool stays as full as it started
+
+    double start = Now();
+    for (int round = 0; round < KERNEL_ROUNDS; round++)
+    {
+        if (round % 30 == 0)
+        {
+            game->entities = field->entities;
+        }
+
+        player(&game->entities, 0, &input);
+        asteroids(&game->entities);
+        bullets(&game->entities);
+    }
+    double seconds = Now() - start;
+
+    floatSink = GetPlayer(&game->entities, 0).position.x + (float)EcsCount(&game->entities, BULLET_COMPONENTS);
+    free(game);
+    return seconds;
+}
+
+// Button mashing with the odd switch to mouse controls, from an integer generator so it is the same everywhere
+static PlayerInput ScriptedInput(unsigned int *state, PlayerInput previous)
+{
+    *state = *state * 1664525u + 1013904223u;
+    if ((*state >> 24) > 30) return previous;
+
+    unsigned int bits = *state >> 8;
+    PlayerInput input = { 0 };
+    input.rotateLeft = bits & 1;
+    input.rotateRight = !input.rotateLeft && (bits & 2);
+    input.thrust = (bits & 4) != 0;
+    input.shoot = (bits & 8) != 0;
+    input.toggleControlMode = (bits & 0x1F0) == 0;
+    input.aimTarget = (Vector2){ (float)((bits >> 9) % SCREEN_WIDTH), (float)((bits >> 20) % SCREEN_HEIGHT) };
+    return input;
+}
+
+int main(int argc, char *argv[])
+{
+    int ticks = GAME_TICK_RATE * 60 * 10;
+    unsigned int seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) ticks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (unsigned int)atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--ticks N] [--seed S]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (ticks < 1) ticks = 1;
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    CheckAccuracy();
+    TimeTrig();
+
+    Game *field = malloc(sizeof(Game));
+    FillField(field, seed);
+    double floatSeconds = TimeKernels(field, UpdateAsteroidFloat, UpdateBulletsFloat, UpdatePlayerFloat);
+    double fixedSeconds = TimeKernels(field, UpdateAsteroidFixed, UpdateBulletsFixed, UpdatePlayerFixed);
+    int entities = worldAsteroidLimit + MAX_BULLETS + 1;
+
+    printf("physics, %d asteroids + %d bullets + ship per tick (million entity updates per second)\n", worldAsteroidLimit, MAX_BULLETS);
+    printf("  float            %8.1f    fixed          %8.1f   (%.2fx)\n",
+           (double)entities * KERNEL_ROUNDS / floatSeconds / 1e6, (double)entities * KERNEL_ROUNDS / fixedSeconds / 1e6,
+           floatSeconds / fixedSeconds);
+
+    // the whole simulation, collisions included, with the version this build uses
+    Game *game = malloc(sizeof(Game));
+    InitHeadlessGame(game, seed);
+    unsigned int inputState = seed;
+    PlayerInput input = { 0 };
+    int games = 1;
+
+    double start = Now();
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        if (game->state != GAMEPLAY)
+        {
+            InitHeadlessGame(game, seed + tick);
+            games++;
+        }
+        input = ScriptedInput(&inputState, input);
+        StepGameplay(game, &input);
+    }
+    double gameSeconds = Now() - start;
+
+#ifdef FIXED_SIM
+    const char *mode = "fixed point";
+#else
+    const char *mode = "float";
+#endif
+    printf("StepGameplay (%s build)\n", mode);
+    static SimSnapshot final;
+    CaptureSimSnapshot(game, &final);
+    printf("  %d ticks, %d games, %.0f ticks/s, final state hash %08x\n", ticks, games, ticks / gameSeconds, HashSimSnapshot(&final));
+
+    free(field);
+    free(game);
+    return 0;
+}
@@ -0,0 +1,116 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-26 14:12:40
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-26 15:36:02
+*/
+
+/*
+ * Benchmark for the frame pacer (include/pacing.h), without a window. Every frame does a few
+ * milliseconds of busy work like an update and a draw, now and then a long one, and the "swap"
+ * is the moment the frame is handed over. Runs the power saving and low latency modes (without
+ * vsync, so the power mode has to sleep) and, to compare, what SetTargetFPS does: sleep for
+ * whatever is left of the frame after the work. Prints the pacing error histogram of each and
+ * how much CPU time a frame cost.
+ *
+ * Usage: ./bin/bench_pacing [--frames N] [--seed S]
+ */
+
+#include "pacing.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define FRAME_PERIOD (1.0 / 60.0)
+
+static double ProcessSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 2 to 5 ms of work, and one frame in fifty runs past the period
+static void BusyWork(unsigned int *state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    double seconds = 0.002 + (*state >> 8) / 16777216.0 * 0.003;
+    if ((*state >> 24) < 5) seconds = FRAME_PERIOD * 1.2;
+
+    double until = PacerSeconds() + seconds;
+    while (PacerSeconds() < until) { }
+}
+
+static void RunPaced(PaceMode mode, int frames, unsigned int seed)
+{
+    FramePacer pacer;
+    InitFramePacer(&pacer, mode, FRAME_PERIOD);
+    unsigned int state = seed;
+
+    double cpuStart = ProcessSeconds(), wallStart = PacerSeconds();
+    for (int f = 0; f < frames; f++)
+    {
+        BusyWork(&state);
+        WaitForFrameDeadline(&pacer);
+        FramePresented(&pacer);
+    }
+    double cpu = ProcessSeconds() - cpuStart, wall = PacerSeconds() - wallStart;
+
+    PrintPacingReport(&pacer);
+    printf("  cpu %.2f ms per frame, %.0f%% of one core, %.1f frames/s\n\n", cpu * 1000.0 / frames, cpu / wall * 100.0, frames / wall);
+}
+
+// SetTargetFPS: sleep for what the frame didn't use, measured from the last frame's end
+static void RunSleepRemainder(int frames, unsigned int seed)
+{
+    FramePacer pacer;
+    InitFramePacer(&pacer, PACE_UNCAPPED, FRAME_PERIOD);    // only used to measure, it never waits
+    unsigned int state = seed;
+
+    double cpuStart = ProcessSeconds(), wallStart = PacerSeconds();
+    double frameStart = PacerSeconds();
+    for (int f = 0; f < frames; f++)
+    {
+        BusyWork(&state);
+
+        double left = FRAME_PERIOD - (PacerSeconds() - frameStart);
+        if (left > 0.0)
+        {
+            struct timespec ts = { 0, (long)(left * 1e9) };
+            nanosleep(&ts, NULL);
+        }
+        frameStart = PacerSeconds();
+        FramePresented(&pacer);
+    }
+    double cpu = ProcessSeconds() - cpuStart, wall = PacerSeconds() - wallStart;
+
+    printf("sleep the rest (SetTargetFPS):\n");
+    PrintPacingReport(&pacer);
+    printf("  cpu %.2f ms per frame, %.0f%% of one core, %.1f frames/s\n\n", cpu * 1000.0 / frames, cpu / wall * 100.0, frames / wall);
+}
+
+int main(int argc, char *argv[])
+{
+    int frames = 600;
+    unsigned int seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc) frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (unsigned int)atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--frames N] [--seed S]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (frames < 2) frames = 2;
+
+    printf("%d frames at %.2f ms, 2 to 5 ms of work each, 1 in 50 runs long\n\n", frames, FRAME_PERIOD * 1000.0);
+    RunSleepRemainder(frames, seed);
+    RunPaced(PACE_POWER_SAVING, frames, seed);
+    RunPaced(PACE_LOW_LATENCY, frames, seed);
+    RunPaced(PACE_UNCAPPED, frames, seed);
+    return 0;
+}
@@ -0,0 +1,190 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-20 21:14:37
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-20 22:40:02
+*/
+
+/*
+ * Benchmark and check for the seekable replays in src/replay.c. Records a long headless bot
+ * game (with new games after every death and the odd jump back in time, like holding R) into a
+ * replay file, then plays the file back straight through and checks every tick against the
+ * recording, and finally seeks to random ticks and checks those too. Reports the file size,
+ * what a seek costs next to simulating from the start, and how many states came out different.
+ *
+ * Usage: ./bin/bench_replay [--ticks N] [--seed S] [--seeks N] [--file path] [--keep]
+ */
+
+#include "game.h"
+#include "bot.h"
+#include "replay.h"
+#include "snapshot.h"
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define REWIND_EVERY  2000                     // ticks between jumps back
+#define REWIND_TICKS  90                       // how far each jump goes
+
+static SimSnapshot hashed;                     // the state a hash is taken of
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int CompareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// hashes[t] is the state after replay tick t was played, starts[t] the one it was played from. They
+// differ where a new game or a jump back starts at t, and a seek to t lands on the second
+static bool Record(const char *path, int ticks, unsigned int seed, unsigned int *hashes, unsigned int *starts, int *games, int *rewinds)
+{
+    Game *game = malloc(sizeof(Game));
+    ReplayWriter *writer = malloc(sizeof(ReplayWriter));
+    SimSnapshot *earlier = malloc(sizeof(SimSnapshot));
+    Bot bot = CreateAimEvadeBot();
+
+    if (!OpenReplayWriter(writer, path)) return false;
+    InitHeadlessGame(game, seed);
+    *games = 1;
+
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        if (game->state != GAMEPLAY)
+        {
+            InitHeadlessGame(game, seed + tick);
+            (*games)++;
+        }
+
+        // keep a state to jump back to, and jump to it a bit later
+        if (tick % REWIND_EVERY == REWIND_EVERY - REWIND_TICKS) CaptureSimSnapshot(game, earlier);
+        if (tick % REWIND_EVERY == 0 && tick > 0 && earlier->state == GAMEPLAY)
+        {
+            RestoreSimSnapshot(game, earlier);
+            (*rewinds)++;
+        }
+
+        CaptureSimSnapshot(game, &hashed);
+        starts[tick] = HashSimSnapshot(&hashed);
+
+        PlayerInput input = RunBot(&bot, game);
+        RecordReplayTick(writer, game, &input);
+        StepGameplay(game, &input);
+        CaptureSimSnapshot(game, &hashed);
+        hashes[tick] = HashSimSnapshot(&hashed);
+    }
+
+    bool ok = CloseReplayWriter(writer);
+    free(game);
+    free(writer);
+    free(earlier);
+    return ok;
+}
+
+int main(int argc, char *argv[])
+{
+    int ticks = GAME_TICK_RATE * 60 * 10;      // ten minutes
+    unsigned int seed = 1;
+    int seeks = 1000;
+    const char *path = "/tmp/bench_replay.astr";
+    bool keep = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) ticks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seeks") == 0 && i + 1 < argc) seeks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--file") == 0 && i + 1 < argc) path = argv[++i];
+        else if (strcmp(argv[i], "--keep") == 0) keep = true;
+        else
+        {
+            fprintf(stderr, "Usage: %s [--ticks N] [--seed S] [--seeks N] [--file path] [--keep]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (ticks < 1) ticks = 1;
+    if (seeks < 1) seeks = 1;
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    unsigned int *hashes = malloc(sizeof(unsigned int) * ticks);
+    unsigned int *starts = malloc(sizeof(unsigned int) * (ticks + 1));
+    int games = 0, rewinds = 0;
+    double start = Now();
+    if (!Record(path, ticks, seed, hashes, starts, &games, &rewinds))
+    {
+        fprintf(stderr, "Could not write %s\n", path);
+        return 1;
+    }
+    double recordSeconds = Now() - start;
+
+    Replay replay;
+    start = Now();
+    if (!OpenReplay(&replay, path))
+    {
+        fprintf(stderr, "Could not read %s back\n", path);
+        return 1;
+    }
+    double openSeconds = Now() - start;
+
+    // straight through, every tick has to match the recording
+    Game *game = malloc(sizeof(Game));
+    InitHeadlessGame(game, seed);
+    int linearMismatches = 0;
+    start = Now();
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        StepReplay(&replay, (unsigned int)tick, game);
+        CaptureSimSnapshot(game, &hashed);
+        if (HashSimSnapshot(&hashed) != hashes[tick]) linearMismatches++;
+    }
+    double linearSeconds = Now() - start;
+
+    // random seeks, the state before tick t is what tick t started from, past the end the last one
+    starts[ticks] = hashes[ticks - 1];
+    double *seekTimes = malloc(sizeof(double) * seeks);
+    int seekMismatches = 0;
+    srand(seed);
+    for (int i = 0; i < seeks; i++)
+    {
+        unsigned int target = 1 + (unsigned int)(((unsigned long)rand() * RAND_MAX + rand()) % (unsigned long)ticks);
+
+        double seekStart = Now();
+        SeekReplay(&replay, target, game);
+        seekTimes[i] = (Now() - seekStart) * 1e6;
+
+        CaptureSimSnapshot(game, &hashed);
+        if (HashSimSnapshot(&hashed) != starts[target]) seekMismatches++;
+    }
+    qsort(seekTimes, seeks, sizeof(double), CompareDoubles);
+    double seekMean = 0.0;
+    for (int i = 0; i < seeks; i++) seekMean += seekTimes[i] / seeks;
+
+    double minutes = (double)ticks / GAME_TICK_RATE / 60.0;
+    printf("%d ticks (%.1f minutes), %d games, %d jumps back, keyframe every %d ticks\n",
+           ticks, minutes, games, rewinds, REPLAY_KEYFRAME_TICKS);
+    printf("  file         %zu bytes, %u keyframes, %.0f KB per minute (inputs alone would be %.1f KB)\n",
+           replay.size, replay.header->keyframes, replay.size / 1024.0 / minutes,
+           (double)REPLAY_INPUT_BYTES * GAME_TICK_RATE * 60 / 1024.0);
+    printf("  record       %.2f s, open %.1f us\n", recordSeconds, openSeconds * 1e6);
+    printf("  straight     %.2f s to play everything, %d ticks different\n", linearSeconds, linearMismatches);
+    printf("  seek         mean %.1f us  p50 %.1f us  p99 %.1f us  max %.1f us, %d of %d different\n",
+           seekMean, seekTimes[seeks / 2], seekTimes[(seeks * 99) / 100], seekTimes[seeks - 1], seekMismatches, seeks);
+    printf("  from start   %.1f us on average to reach a random tick without keyframes\n", linearSeconds * 1e6 / 2.0);
+
+    CloseReplay(&replay);
+    if (!keep) remove(path);
+    free(hashes);
+    free(starts);
+    free(seekTimes);
+    free(game);
+    return linearMismatches == 0 && seekMismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,138 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-17 18:10:52
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-17 19:37:20
+*/
+
+/*
+ * Benchmark and check for the rewind buffer in src/snapshot.c. Lets the bot play a headless
+ * game, pushes every tick into a rewind buffer the same way UpdateGame() does and reports what
+ * that costs per tick and how small the deltas are. Then it rewinds the whole history and
+ * checks every state it gets back against a full copy taken on the way forward, and finally
+ * replays the same inputs from a rewound state to check the game plays on identically.
+ *
+ * Usage: ./bin/bench_rewind [--ticks N] [--seed S] [--seconds R]
+ */
+
+#include "game.h"
+#include "bot.h"
+#include "snapshot.h"
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int CompareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+int main(int argc, char *argv[])
+{
+    int ticks = GAME_TICK_RATE * 60;
+    unsigned int seed = 1;
+    int seconds = REWIND_SECONDS;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) ticks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) seconds = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--ticks N] [--seed S] [--seconds R]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (ticks < 1) ticks = 1;
+    if (seconds < 1) seconds = 1;
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    Game *game = malloc(sizeof(Game));
+    InitHeadlessGame(game, seed);
+    Bot bot = CreateAimEvadeBot();
+
+    RewindBuffer rewind;
+    if (!InitRewindBuffer(&rewind, seconds)) return 1;
+
+    // full copies of every state and the inputs that led to it, to check the rewind against
+    SimSnapshot *history = malloc(sizeof(SimSnapshot) * (ticks + 1));
+    PlayerInput *inputs = malloc(sizeof(PlayerInput) * (ticks + 1));
+    double *pushTimes = malloc(sizeof(double) * (ticks + 1));
+    size_t deltaBytes = 0;
+
+    PushRewindState(&rewind, game);
+    CaptureSimSnapshot(game, &history[0]);
+
+    int played = 0;
+    while (played < ticks && game->state == GAMEPLAY)
+    {
+        inputs[played] = RunBot(&bot, game);
+        StepGameplay(game, &inputs[played]);
+        played++;
+
+        PushRewindState(&rewind, game);
+        pushTimes[played - 1] = rewind.lastPushMicros;
+        deltaBytes += rewind.lastDeltaSize;
+        CaptureSimSnapshot(game, &history[played]);
+    }
+
+    qsort(pushTimes, played, sizeof(double), CompareDoubles);
+    double pushTotal = 0.0;
+    for (int i = 0; i < played; i++) pushTotal += pushTimes[i];
+
+    printf("%d ticks played (seed %u), snapshot is %d bytes\n", played, seed, (int)sizeof(SimSnapshot));
+    printf("push per tick     mean %6.2f us  p50 %6.2f us  p99 %6.2f us  max %6.2f us\n",
+           pushTotal / played, pushTimes[played / 2], pushTimes[(played * 99) / 100], pushTimes[played - 1]);
+    printf("delta per tick    mean %6.0f bytes (%.1fx smaller than a full snapshot)\n",
+           (double)deltaBytes / played, sizeof(SimSnapshot) * (double)played / (deltaBytes > 0 ? deltaBytes : 1));
+    printf("history           %.1f s held in %d KB of deltas (%d KB reserved), full copies would be %d KB\n",
+           RewindSecondsAvailable(&rewind), (int)(rewind.bytesUsed / 1024), (int)(rewind.dataSize / 1024),
+           (int)(rewind.count * sizeof(SimSnapshot) / 1024));
+
+    // rewind everything that's held and compare each state with the copy from the way forward
+    int held = rewind.count;
+    int mismatches = 0;
+    double start = Now();
+    for (int i = 1; i <= held; i++)
+    {
+        StepBackRewind(&rewind, game);
+
+        SimSnapshot now;
+        CaptureSimSnapshot(game, &now);
+        if (memcmp(&now, &history[played - i], sizeof(SimSnapshot)) != 0) mismatches++;
+    }
+    double back = Now() - start;
+
+    printf("rewind            %d ticks back in %.2f ms (%.2f us per tick), %d mismatches\n",
+           held, back * 1e3, held > 0 ? back * 1e6 / held : 0.0, mismatches);
+
+    // from the oldest state we have, the same inputs have to end in the same place as before
+    int replayFrom = played - held;
+    for (int i = replayFrom; i < played; i++) StepGameplay(game, &inputs[i]);
+
+    SimSnapshot replayed;
+    CaptureSimSnapshot(game, &replayed);
+    bool identical = memcmp(&replayed, &history[played], sizeof(SimSnapshot)) == 0;
+    printf("replay            %d ticks from tick %d: %s\n", played - replayFrom, replayFrom,
+           identical ? "identical" : "DIFFERENT");
+
+    FreeRewindBuffer(&rewind);
+    UnloadGame(game);
+    free(history);
+    free(inputs);
+    free(pushTimes);
+    free(game);
+    return mismatches == 0 && identical ? 0 : 1;
+}
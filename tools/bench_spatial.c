@@ -0,0 +1,218 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-15 17:30:02
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-15 18:55:40
+*/
+
+/*
+ * Benchmark for the spatial grid in src/spatial.c. Fills a field with a lot of asteroids
+ * at roughly the same density as the real game and measures how many k-nearest, radius
+ * and ray queries per second the grid answers compared to walking every asteroid. The field is
+ * plain arrays of positions and radii (UpdateSpatialGridArrays), the game's tables stop at
+ * MAX_ASTEROIDS.
+ * Every grid answer is also checked against the brute force answer.
+ *
+ * Usage: ./bin/bench_spatial [queries]
+ */
+
+#include "spatial.h"
+#include <raylib.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define KNN_COUNT      4
+#define QUERY_RADIUS   150.0f
+#define RAY_DISTANCE   1500.0f
+
+static unsigned int benchSeed = 12345u;
+
+// Small LCG so the field is the same on every machine
+static float RandomFloat(float min, float max)
+{
+    benchSeed = benchSeed * 1664525u + 1013904223u;
+    return min + (max - min) * ((benchSeed >> 8) / 16777216.0f);
+}
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static float WrapDelta(float delta, float size)
+{
+    return delta - size * floorf(delta / size + 0.5f);
+}
+
+// Brute force versions of the queries, used as the baseline and for checking results
+static int BruteNearest(const Vector2 *positions, const float *radii, int count, float w, float h, Vector2 p, float *distance)
+{
+    int best = -1;
+    for (int i = 0; i < count; i++)
+    {
+        float dx = WrapDelta(positions[i].x - p.x, w);
+        float dy = WrapDelta(positions[i].y - p.y, h);
+        float d = sqrtf(dx * dx + dy * dy) - radii[i];
+        if (best < 0 || d < *distance) { best = i; *distance = d; }
+    }
+    return best;
+}
+
+static int BruteRadius(const Vector2 *positions, const float *radii, int count, float w, float h, Vector2 p, float radius)
+{
+    int found = 0;
+    for (int i = 0; i < count; i++)
+    {
+        float dx = WrapDelta(positions[i].x - p.x, w);
+        float dy = WrapDelta(positions[i].y - p.y, h);
+        if (sqrtf(dx * dx + dy * dy) - radii[i] <= radius) found++;
+    }
+    return found;
+}
+
+static int BruteRay(const Vector2 *positions, const float *radii, int count, float w, float h, Vector2 o, Vector2 d, float maxDistance,
+                    float *hitDistance)
+{
+    // only valid for rays shorter than the world, which is what the benchmark uses
+    int best = -1;
+    float bestT = maxDistance;
+    for (int i = 0; i < count; i++)
+    {
+        for (int copy = 0; copy < 2; copy++)
+        {
+            // test the copy closest to the origin and the one closest to the end of the ray
+            Vector2 ref = copy == 0 ? o : (Vector2){ o.x + d.x * maxDistance, o.y + d.y * maxDistance };
+            float rx = WrapDelta(positions[i].x - ref.x, w) + ref.x - o.x;
+            float ry = WrapDelta(positions[i].y - ref.y, h) + ref.y - o.y;
+            float b = rx * d.x + ry * d.y;
+            float c = rx * rx + ry * ry - radii[i] * radii[i];
+            float disc = b * b - c;
+            if (disc < 0.0f) continue;
+            float t = c <= 0.0f ? 0.0f : b - sqrtf(disc);
+            if (t >= 0.0f && t < bestT) { bestT = t; best = i; }
+        }
+    }
+    *hitDistance = bestT;
+    return best;
+}
+
+static void RunBenchmark(int count, int queries)
+{
+    // same density as the real game: 20 asteroids on a 1280x920 screen
+    float area = 1280.0f * 920.0f / 20.0f * count;
+    float w = sqrtf(area * 1280.0f / 920.0f);
+    float h = area / w;
+
+    Vector2 *positions = malloc(sizeof(Vector2) * count);
+    Vector2 *velocities = malloc(sizeof(Vector2) * count);
+    float *radii = malloc(sizeof(float) * count);
+    for (int i = 0; i < count; i++)
+    {
+        positions[i] = (Vector2){ RandomFloat(0, w), RandomFloat(0, h) };
+        velocities[i] = (Vector2){ RandomFloat(-1.2f, 1.2f), RandomFloat(-1.2f, 1.2f) };
+        radii[i] = RandomFloat(10, 40);
+    }
+
+    Vector2 *points = malloc(sizeof(Vector2) * queries);
+    Vector2 *dirs = malloc(sizeof(Vector2) * queries);
+    for (int i = 0; i < queries; i++)
+    {
+        float angle = RandomFloat(0, 2 * PI);
+        points[i] = (Vector2){ RandomFloat(0, w), RandomFloat(0, h) };
+        dirs[i] = (Vector2){ cosf(angle), sinf(angle) };
+    }
+
+    SpatialGrid grid;
+    InitSpatialGrid(&grid, w, h, SPATIAL_CELL_SIZE, count);
+
+    // incremental update cost: move everything one tick and update
+    double start = Now();
+    UpdateSpatialGridArrays(&grid, positions, radii, count);
+    double build = Now() - start;
+
+    for (int i = 0; i < count; i++)
+    {
+        positions[i].x = fmodf(positions[i].x + velocities[i].x + w, w);
+        positions[i].y = fmodf(positions[i].y + velocities[i].y + h, h);
+    }
+    start = Now();
+    UpdateSpatialGridArrays(&grid, positions, radii, count);
+    double update = Now() - start;
+
+    int indices[256];
+    float distances[256];
+    int mismatches = 0;
+    volatile int sink = 0;
+
+    // k nearest
+    start = Now();
+    for (int q = 0; q < queries; q++) sink += QueryNearestAsteroids(&grid, points[q], KNN_COUNT, indices, distances);
+    double knn = Now() - start;
+
+    // radius
+    start = Now();
+    for (int q = 0; q < queries; q++) sink += QueryAsteroidsInRadius(&grid, points[q], QUERY_RADIUS, indices, 256);
+    double radius = Now() - start;
+
+    // ray
+    start = Now();
+    for (int q = 0; q < queries; q++) sink += RaycastAsteroids(&grid, points[q], dirs[q], RAY_DISTANCE, NULL);
+    double ray = Now() - start;
+
+    // brute force baseline on a smaller share of the queries, it gets slow fast
+    int bruteQueries = queries / 10 > 0 ? queries / 10 : 1;
+    start = Now();
+    for (int q = 0; q < bruteQueries; q++)
+    {
+        float d = 0.0f;
+        int brute = BruteNearest(positions, radii, count, w, h, points[q], &d);
+        QueryNearestAsteroids(&grid, points[q], 1, indices, distances);
+        if (indices[0] != brute && fabsf(distances[0] - d) > 1e-3f) mismatches++;
+    }
+    double bruteKnn = Now() - start;
+
+    for (int q = 0; q < bruteQueries; q++)
+    {
+        if (BruteRadius(positions, radii, count, w, h, points[q], QUERY_RADIUS) !=
+            QueryAsteroidsInRadius(&grid, points[q], QUERY_RADIUS, indices, 256)) mismatches++;
+
+        // compare hit distances rather than indices, the origin can be inside two asteroids at once
+        // and rays that only graze an asteroid can go either way with float rounding
+        float rayLength = RAY_DISTANCE < w && RAY_DISTANCE < h ? RAY_DISTANCE : 0.5f * (w < h ? w : h);
+        float bruteT = rayLength, gridT = rayLength;
+        BruteRay(positions, radii, count, w, h, points[q], dirs[q], rayLength, &bruteT);
+        RaycastAsteroids(&grid, points[q], dirs[q], rayLength, &gridT);
+        if (fabsf(bruteT - gridT) > 0.5f) mismatches++;
+    }
+
+    printf("%8d asteroids %6.0fx%-6.0f  build %7.3f ms  update %7.3f ms\n", count, w, h, build * 1e3, update * 1e3);
+    printf("         knn(k=%d) %10.0f q/s   radius(%.0f) %10.0f q/s   ray(%.0f) %10.0f q/s\n",
+           KNN_COUNT, queries / knn, QUERY_RADIUS, queries / radius, RAY_DISTANCE, queries / ray);
+    printf("         brute force nearest %10.0f q/s   mismatches %d\n\n", bruteQueries / bruteKnn, mismatches);
+
+    (void)sink;
+    FreeSpatialGrid(&grid);
+    free(points);
+    free(dirs);
+    free(positions);
+    free(velocities);
+    free(radii);
+}
+
+int main(int argc, char *argv[])
+{
+    int queries = argc > 1 ? atoi(argv[1]) : 100000;
+    if (queries <= 0) queries = 100000;
+
+    int sizes[] = { 20, 1000, 10000, 100000 };
+    for (int i = 0; i < (int)(sizeof(sizes) / sizeof(sizes[0])); i++)
+    {
+        RunBenchmark(sizes[i], queries);
+    }
+
+    return 0;
+}
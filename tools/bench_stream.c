@@ -0,0 +1,241 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-19 18:02:51
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-19 20:15:09
+*/
+
+/*
+ * Benchmark and check for the state stream in src/statestream.c. Encodes every tick of a
+ * headless game, decodes it again and reports the bandwidth next to what sending the whole
+ * snapshot would cost, what encoding and decoding take, and how far the decoded positions are
+ * from the real ones. A second decoder joins a third of the way in, like a late spectator, and
+ * has to end up with exactly the same picture as the one that saw everything.
+ *
+ * Two runs: a normal game flown by the bot, and a stress run with two ships and every asteroid
+ * and bullet slot kept full on every tick.
+ *
+ * Usage: ./bin/bench_stream [--ticks N] [--seed S]
+ */
+
+#include "game.h"
+#include "bot.h"
+#include "snapshot.h"
+#include "statestream.h"
+#include "world.h"
+#include <math.h>
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+typedef struct StreamRun {
+    unsigned long bytes;
+    unsigned long keyframeBytes;
+    int           keyframes;
+    int           frames;
+    int           entities;                    // live asteroids and bullets, summed over the frames
+    int           keyframeEntities;            // the same over the keyframes only
+    double        encodeSeconds;
+    double        decodeSeconds;
+    float         maxError;                    // pixels
+    int           activeMismatches;
+    int           lateJoinTick;                // tick the late viewer got its first picture
+    int           lateMismatches;              // frames after that where the two viewers disagreed
+} StreamRun;
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static float PositionError(Vector2 a, Vector2 b)
+{
+    return fmaxf(fabsf(a.x - b.x), fabsf(a.y - b.y));
+}
+
+// Every asteroid and bullet slot full, the most the stream can ever have to carry
+static void FillEverySlot(Game *game)
+{
+    for (int i = 0; i < MAX_ASTEROIDS; i++) SpawnAsteroids(&game->entities, 0);
+
+    for (int ship = 0; ship < 2; ship++)
+    {
+        for (int i = 0; i < MAX_BULLETS / 3; i++)
+        {
+            Vector2 position = { (float)(rand() % worldWidth), (float)(rand() % worldHeight) };
+            ShootBullets(&game->entities, ship, position, (float)(rand() % 360));
+        }
+    }
+}
+
+static int CountEntities(const Game *game)
+{
+    return EcsCount(&game->entities, ASTEROID_COMPONENTS) + EcsCount(&game->entities, BULLET_COMPONENTS);
+}
+
+static void CompareWithGame(StreamRun *run, const Game *real, const Game *seen)
+{
+    for (int i = 0; i < MAX_ASTEROIDS; i++)
+    {
+        Asteroid realAsteroid, seenAsteroid;
+        bool active = GetAsteroid(&real->entities, i, &realAsteroid);
+        if (active != GetAsteroid(&seen->entities, i, &seenAsteroid)) run->activeMismatches++;
+        else if (active) run->maxError = fmaxf(run->maxError, PositionError(realAsteroid.position, seenAsteroid.position));
+    }
+
+    for (int i = 0; i < BULLET_SLOTS; i++)
+    {
+        Bullet realBullet, seenBullet;
+        bool active = GetBullet(&real->entities, i, &realBullet);
+        if (active != GetBullet(&seen->entities, i, &seenBullet)) run->activeMismatches++;
+        else if (active) run->maxError = fmaxf(run->maxError, PositionError(realBullet.position, seenBullet.position));
+    }
+
+    run->maxError = fmaxf(run->maxError, PositionError(GetPlayer(&real->entities, 0).position, GetPlayer(&seen->entities, 0).position));
+}
+
+// Off the keyframe grid, so the late viewer actually has to wait for one
+static int LateJoinTick(int ticks)
+{
+    return ticks / 3 + 7;
+}
+
+// Empty slots keep whatever was in them last, only the live ones have to match
+static bool SameSlots(const StreamCodec *a, const StreamCodec *b)
+{
+    for (int i = 0; i < STREAM_SLOTS; i++)
+    {
+        if (a->slots[i].active != b->slots[i].active) return false;
+        if (a->slots[i].active && memcmp(&a->slots[i], &b->slots[i], sizeof(StreamSlot)) != 0) return false;
+    }
+    return true;
+}
+
+static StreamRun RunStream(int ticks, unsigned int seed, bool stress)
+{
+    StreamRun run = { 0 };
+    Game *game = calloc(1, sizeof(Game));
+    Game *viewer = calloc(1, sizeof(Game));
+    Game *lateViewer = calloc(1, sizeof(Game));
+    StreamCodec *encoder = calloc(1, sizeof(StreamCodec));
+    StreamCodec *decoder = calloc(1, sizeof(StreamCodec));
+    StreamCodec *lateDecoder = calloc(1, sizeof(StreamCodec));
+    unsigned char *frame = malloc(STREAM_MAX_FRAME);
+
+    Bot bots[2] = { CreateAimEvadeBot(), CreateAimEvadeBot() };
+    InitHeadlessGame(game, seed);
+    if (stress) StartVersusGame(game, seed);
+    srand(seed);
+
+    run.lateJoinTick = -1;
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        if (stress)
+        {
+            if (game->state != GAMEPLAY) StartVersusGame(game, seed + tick);
+
+            PlayerInput inputs[2] = { RunBotForShip(&bots[0], game, 0), RunBotForShip(&bots[1], game, 1) };
+            StepVersusGameplay(game, inputs);
+            FillEverySlot(game);
+        }
+        else
+        {
+            if (game->state != GAMEPLAY) InitHeadlessGame(game, seed + tick);
+
+            PlayerInput input = RunBot(&bots[0], game);
+            StepGameplay(game, &input);
+        }
+
+        double start = Now();
+        int size = EncodeStreamFrame(encoder, game, frame, STREAM_MAX_FRAME);
+        double encoded = Now();
+        DecodeStreamFrame(decoder, frame, size, viewer);
+        double decoded = Now();
+
+        bool keyframe = frame[0] & 1;
+        run.encodeSeconds += encoded - start;
+        run.decodeSeconds += decoded - encoded;
+        run.bytes += size + 2;
+        run.frames++;
+        run.entities += CountEntities(game);
+        if (keyframe)
+        {
+            run.keyframes++;
+            run.keyframeBytes += size + 2;
+            run.keyframeEntities += CountEntities(game);
+        }
+
+        CompareWithGame(&run, game, viewer);
+
+        // the late viewer only starts listening a third of the way in
+        if (tick >= LateJoinTick(ticks) && DecodeStreamFrame(lateDecoder, frame, size, lateViewer))
+        {
+            if (run.lateJoinTick < 0) run.lateJoinTick = tick;
+            if (!SameSlots(lateDecoder, decoder)) run.lateMismatches++;
+        }
+    }
+
+    free(game);
+    free(viewer);
+    free(lateViewer);
+    free(encoder);
+    free(decoder);
+    free(lateDecoder);
+    free(frame);
+    return run;
+}
+
+static void PrintRun(const char *name, const StreamRun *run, int ticks)
+{
+    int deltas = run->frames - run->keyframes;
+    double seconds = (double)run->frames / GAME_TICK_RATE;
+
+    printf("%s: %.0f live asteroids and bullets on average\n", name, (double)run->entities / run->frames);
+    printf("  stream          %8.0f bytes/s  (%.1f KB/s, a full snapshot every tick would be %.0f KB/s)\n",
+           run->bytes / seconds, run->bytes / seconds / 1024.0, sizeof(SimSnapshot) * (double)GAME_TICK_RATE / 1024.0);
+    printf("  frames          keyframe %6.0f bytes (%.1f per asteroid or bullet in it), delta %6.1f bytes on average\n",
+           run->keyframes > 0 ? (double)run->keyframeBytes / run->keyframes : 0.0,
+           run->keyframeEntities > 0 ? (double)run->keyframeBytes / run->keyframeEntities : 0.0,
+           deltas > 0 ? (double)(run->bytes - run->keyframeBytes) / deltas : 0.0);
+    printf("  time per frame  encode %.2f us, decode %.2f us\n",
+           run->encodeSeconds * 1e6 / run->frames, run->decodeSeconds * 1e6 / run->frames);
+    printf("  accuracy        max position error %.3f px, %d slots active on only one side\n",
+           run->maxError, run->activeMismatches);
+    printf("  late viewer     joined at tick %d, first picture at tick %d, %d frames different after that\n",
+           LateJoinTick(ticks), run->lateJoinTick, run->lateMismatches);
+}
+
+int main(int argc, char *argv[])
+{
+    int ticks = GAME_TICK_RATE * 60;
+    unsigned int seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) ticks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (unsigned int)atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--ticks N] [--seed S]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (ticks < 3) ticks = 3;
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    StreamRun typical = RunStream(ticks, seed, false);
+    StreamRun stress = RunStream(ticks, seed, true);
+
+    printf("%d ticks per run, keyframe every %d ticks\n", ticks, STREAM_KEYFRAME_TICKS);
+    PrintRun("typical (bot game)", &typical, ticks);
+    PrintRun("stress (versus, every slot full)", &stress, ticks);
+
+    bool ok = typical.activeMismatches == 0 && stress.activeMismatches == 0 && typical.lateMismatches == 0 &&
+              stress.lateMismatches == 0 && typical.maxError < 0.2f && stress.maxError < 0.2f;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-31 19:12:30
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-31 21:55:08
+*/
+
+/*
+ * What the telemetry (telemetry.h) costs. Two bot games with the same seeds run side by side,
+ * one with the telemetry bound and counting the way UpdateGame does it, one without, in
+ * alternating blocks of ticks so both see the same machine. Reports the tick time of both, the
+ * difference, and checks that the two games never part ways (counting must not change the
+ * simulation).
+ *
+ * Every bot game is then a session in a log, copied round until there are --sessions of them,
+ * and the log is appended one record at a time and read back with the report's reader.
+ *
+ * Usage: ./bin/bench_telemetry [--ticks N] [--sessions N] [--seed S] [--file path] [--keep]
+ */
+
+#include "game.h"
+#include "bot.h"
+#include "snapshot.h"
+#include "telemetry.h"
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define BLOCK_TICKS   500                      // ticks of one game before the other one gets a turn
+#define MAX_SESSIONS  4096                     // bot games kept to copy into the log
+
+static SimSnapshot plainState, countedState;   // what the two games are compared by
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * A block of ticks of one game, restarting it with the next seed when the ship dies. The counted
+ * one gets a session of its own per game and the frame, bind and tick calls UpdateGame and main
+ * make around StepGameplay.
+ */
+static double RunBlock(Game *game, Bot *bot, unsigned int *seed, Telemetry *telemetry, TelemetryRecord *sessions, int *sessionCount)
+{
+    double start = Now();
+    for (int t = 0; t < BLOCK_TICKS; t++)
+    {
+        PlayerInput input = RunBot(bot, game);
+
+        if (telemetry != NULL)
+        {
+            BindTelemetry(telemetry);
+            StepGameplay(game, &input);
+            BindTelemetry(NULL);
+            TelemetryTick(telemetry, game);
+            TelemetryFrame(telemetry, game);
+        }
+        else
+        {
+            StepGameplay(game, &input);
+        }
+
+        if (game->state == GAME_OVER)
+        {
+            if (telemetry != NULL)
+            {
+                if (*sessionCount < MAX_SESSIONS) sessions[(*sessionCount)++] = telemetry->record;
+                InitTelemetry(telemetry, DIRECTOR_NORMAL);
+            }
+            InitHeadlessGame(game, ++*seed);
+        }
+    }
+    return Now() - start;
+}
+
+int main(int argc, char *argv[])
+{
+    int ticks = GAME_TICK_RATE * 60 * 60;      // an hour of play
+    int sessions = 100000;
+    unsigned int seed = 1;
+    const char *path = "/tmp/bench_telemetry.astl";
+    bool keep = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) ticks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--sessions") == 0 && i + 1 < argc) sessions = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--file") == 0 && i + 1 < argc) path = argv[++i];
+        else if (strcmp(argv[i], "--keep") == 0) keep = true;
+        else
+        {
+            fprintf(stderr, "Usage: %s [--ticks N] [--sessions N] [--seed S] [--file path] [--keep]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (ticks < BLOCK_TICKS) ticks = BLOCK_TICKS;
+    if (sessions < 1) sessions = 1;
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    Game *plain = malloc(sizeof(Game));
+    Game *counted = malloc(sizeof(Game));
+    Bot plainBot = CreateAimEvadeBot(), countedBot = CreateAimEvadeBot();
+    unsigned int plainSeed = seed, countedSeed = seed;
+    InitHeadlessGame(plain, plainSeed);
+    InitHeadlessGame(counted, countedSeed);
+
+    Telemetry telemetry;
+    InitTelemetry(&telemetry, DIRECTOR_NORMAL);
+    TelemetryRecord *records = malloc(sizeof(TelemetryRecord) * MAX_SESSIONS);
+    int recordCount = 0;
+
+    // which one goes first swaps every block, so neither always gets the warm caches
+    double plainSeconds = 0.0, countedSeconds = 0.0;
+    int blocks = ticks / BLOCK_TICKS, parted = 0;
+    for (int b = 0; b < blocks; b++)
+    {
+        if (b % 2 == 0)
+        {
+            plainSeconds += RunBlock(plain, &plainBot, &plainSeed, NULL, NULL, NULL);
+            countedSeconds += RunBlock(counted, &countedBot, &countedSeed, &telemetry, records, &recordCount);
+        }
+        else
+        {
+            countedSeconds += RunBlock(counted, &countedBot, &countedSeed, &telemetry, records, &recordCount);
+            plainSeconds += RunBlock(plain, &plainBot, &plainSeed, NULL, NULL, NULL);
+        }
+        CaptureSimSnapshot(plain, &plainState);
+        CaptureSimSnapshot(counted, &countedState);
+        if (HashSimSnapshot(&plainState) != HashSimSnapshot(&countedState)) parted++;
+    }
+    if (recordCount == 0) records[recordCount++] = telemetry.record;
+
+    double played = (double)blocks * BLOCK_TICKS;
+    double plainTick = plainSeconds * 1e9 / played, countedTick = countedSeconds * 1e9 / played;
+    printf("%.0f ticks of bot play, %d games (%.1f minutes each on average)\n", played, countedSeed - seed + 1,
+           played / (countedSeed - seed + 1) / GAME_TICK_RATE / 60.0);
+    printf("  tick         %.1f ns without telemetry, %.1f ns with it, %+.1f ns (%+.2f%%)\n",
+           plainTick, countedTick, countedTick - plainTick, (countedTick - plainTick) * 100.0 / plainTick);
+    printf("  simulation   %d of %d blocks ended with the two games different\n", parted, blocks);
+
+    // the log, a record at a time like sessions closing one after the other
+    remove(path);
+    double start = Now();
+    for (int s = 0; s < sessions; s++)
+    {
+        Telemetry session = { .record = records[s % recordCount] };
+        if (!AppendTelemetryRecord(&session, path))
+        {
+            fprintf(stderr, "Could not write %s\n", path);
+            return 1;
+        }
+    }
+    double appendSeconds = Now() - start;
+
+    TelemetrySummary summary;
+    start = Now();
+    bool read = SummarizeTelemetryLog(path, &summary);
+    double readSeconds = Now() - start;
+    if (!read)
+    {
+        fprintf(stderr, "Could not read %s back\n", path);
+        return 1;
+    }
+
+    printf("  append       %d sessions, %.1f us each (open, write %d bytes, close)\n", sessions,
+           appendSeconds * 1e6 / sessions, TELEMETRY_RECORD_BYTES);
+    printf("  read         %.2f ms for all of them, %.1f million sessions a second, %lld read back, %lld bad\n",
+           readSeconds * 1000.0, summary.sessions / readSeconds / 1e6, summary.sessions, summary.badRecords);
+    printf("\n");
+    PrintTelemetrySummary(&summary);
+
+    if (!keep) remove(path);
+    free(records);
+    UnloadGame(plain);
+    UnloadGame(counted);
+    free(plain);
+    free(counted);
+    return parted == 0 && summary.sessions == sessions && summary.badRecords == 0 ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-22 13:52:10
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-22 15:18:44
+*/
+
+/*
+ * Benchmark and check for the sine and cosine in src/trig.c. Measures the worst error of each
+ * version against double precision sin and cos over millions of angles in a few ranges, checks
+ * that the batched version gives the same bits as the scalar one, and times them all next to
+ * the libm calls the game used to make (double sin and cos, and sinf and cosf).
+ *
+ * Usage: ./bin/bench_trig [--calls N]
+ */
+
+#include "trig.h"
+#include <raylib.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define ACCURACY_SAMPLES  (1 << 24)
+#define BATCH             256                  // angles per SinCosArray call, about what a frame of asteroids has
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Keeps results alive so the compiler can't drop the loops being timed
+static volatile float sink;
+
+// Evenly spread over [-range, range], so every size of angle in it gets tested
+static float SampleAngle(int i, float range)
+{
+    return (float)(((double)i / (ACCURACY_SAMPLES - 1) * 2.0 - 1.0) * range);
+}
+
+static double RadiansError(float range, bool useLibm)
+{
+    double worst = 0.0;
+    for (int i = 0; i < ACCURACY_SAMPLES; i++)
+    {
+        float x = SampleAngle(i, range);
+        float s, c;
+        if (useLibm)
+        {
+            s = sinf(x);
+            c = cosf(x);
+        }
+        else SinCos(x, &s, &c);
+
+        worst = fmax(worst, fmax(fabs(s - sin((double)x)), fabs(c - cos((double)x))));
+    }
+    return worst;
+}
+
+static double DegreesError(float range)
+{
+    double worst = 0.0;
+    for (int i = 0; i < ACCURACY_SAMPLES; i++)
+    {
+        float degrees = SampleAngle(i, range);
+        double radians = fmod((double)degrees, 360.0) * (PI / 180.0);
+        float s, c;
+        SinCosDegrees(degrees, &s, &c);
+
+        worst = fmax(worst, fmax(fabs(s - sin(radians)), fabs(c - cos(radians))));
+    }
+    return worst;
+}
+
+static double AngleError(void)
+{
+    double worst = 0.0;
+    for (int a = 0; a < 65536; a++)
+    {
+        double radians = a * (2.0 * PI / 65536.0);
+        float s, c;
+        SinCosAngle((BinaryAngle)a, &s, &c);
+
+        worst = fmax(worst, fmax(fabs(s - sin(radians)), fabs(c - cos(radians))));
+    }
+    return worst;
+}
+
+// How many angles come out of SinCosArray different from SinCos, in batches of odd sizes so the tail runs too
+static int BatchMismatches(void)
+{
+    static float angles[BATCH], sines[BATCH], cosines[BATCH];
+    int mismatches = 0;
+
+    for (int round = 0; round < 4096; round++)
+    {
+        int count = 1 + round % BATCH;
+        for (int i = 0; i < count; i++) angles[i] = SampleAngle(round * 4093 + i * 17, 8192.0f);
+        SinCosArray(angles, sines, cosines, count);
+
+        for (int i = 0; i < count; i++)
+        {
+            float s, c;
+            SinCos(angles[i], &s, &c);
+            if (memcmp(&s, &sines[i], sizeof(s)) != 0 || memcmp(&c, &cosines[i], sizeof(c)) != 0) mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+static void PrintRate(const char *name, int calls, double seconds, double baseline)
+{
+    printf("  %-26s %8.1f   (%.2fx)\n", name, calls / seconds / 1e6, baseline / seconds);
+}
+
+static void TimeAll(int calls)
+{
+    static float angles[BATCH], sines[BATCH], cosines[BATCH];
+    float sum = 0.0f;
+
+    // the angles a game sees, ship rotations in degrees and asteroid turns in radians
+    for (int i = 0; i < BATCH; i++) angles[i] = (float)i * 0.0491f;
+
+    double start = Now();
+    for (int i = 0; i < calls; i++)
+    {
+        double radians = (float)(i & 1023) * 0.35f * DEG2RAD;
+        sum += (float)cos(radians) + (float)sin(radians);
+    }
+    double doubleSeconds = Now() - start;
+    sink = sum;
+
+    start = Now();
+    for (int i = 0; i < calls; i++)
+    {
+        float radians = (float)(i & 1023) * 0.35f * DEG2RAD;
+        sum += cosf(radians) + sinf(radians);
+    }
+    double floatSeconds = Now() - start;
+    sink = sum;
+
+    start = Now();
+    for (int i = 0; i < calls; i++)
+    {
+        float s, c;
+        SinCos((float)(i & 1023) * 0.35f * DEG2RAD, &s, &c);
+        sum += c + s;
+    }
+    double sinCosSeconds = Now() - start;
+    sink = sum;
+
+    start = Now();
+    for (int i = 0; i < calls; i++)
+    {
+        float s, c;
+        SinCosDegrees((float)(i & 1023) * 0.35f, &s, &c);
+        sum += c + s;
+    }
+    double degreesSeconds = Now() - start;
+    sink = sum;
+
+    start = Now();
+    for (int i = 0; i < calls; i += BATCH)
+    {
+        angles[i & (BATCH - 1)] += 1e-3f;
+        SinCosArray(angles, sines, cosines, BATCH);
+        sum += sines[i & (BATCH - 1)] + cosines[BATCH - 1];
+    }
+    double arraySeconds = Now() - start;
+    sink = sum;
+
+    start = Now();
+    for (int i = 0; i < calls; i++)
+    {
+        float s, c;
+        SinCosAngle((BinaryAngle)(i * 37), &s, &c);
+        sum += c + s;
+    }
+    double angleSeconds = Now() - start;
+    sink = sum;
+
+    printf("throughput (million sine + cosine pairs per second)\n");
+    PrintRate("sin + cos (double)", calls, doubleSeconds, doubleSeconds);
+    PrintRate("sinf + cosf", calls, floatSeconds, doubleSeconds);
+    PrintRate("SinCos", calls, sinCosSeconds, doubleSeconds);
+    PrintRate("SinCosDegrees", calls, degreesSeconds, doubleSeconds);
+    PrintRate("SinCosArray (256 at once)", calls, arraySeconds, doubleSeconds);
+    PrintRate("SinCosAngle (table)", calls, angleSeconds, doubleSeconds);
+}
+
+int main(int argc, char *argv[])
+{
+    int calls = 1 << 25;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--calls") == 0 && i + 1 < argc) calls = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--calls N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (calls < BATCH) calls = BATCH;
+
+    printf("accuracy (worst absolute error against double sin and cos)\n");
+    printf("  sinf + cosf, |x| <= 8192      %.1e\n", RadiansError(8192.0f, true));
+    printf("  SinCos, |x| <= 2 pi           %.1e\n", RadiansError(2.0f * PI, false));
+    printf("  SinCos, |x| <= 8192           %.1e\n", RadiansError(8192.0f, false));
+    printf("  SinCos, |x| <= 65536          %.1e\n", RadiansError(65536.0f, false));
+    printf("  SinCosDegrees, <= 360         %.1e\n", DegreesError(360.0f));
+    printf("  SinCosDegrees, <= 10^7        %.1e\n", DegreesError(1e7f));
+    printf("  SinCosAngle, every angle      %.1e\n", AngleError());
+    printf("  SinCosArray against SinCos    %d different\n", BatchMismatches());
+
+    TimeAll(calls);
+    return 0;
+}
@@ -0,0 +1,157 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-23 16:52:30
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-23 18:07:14
+*/
+
+/*
+ * Benchmark for the scrolling world (include/world.h). Plays worlds of one, four, nine and twelve
+ * windows with every asteroid the world allows, and for each one measures the whole tick, the
+ * asteroid update next to moving every asteroid every tick like a world without chunks would,
+ * and how many asteroids the camera gathers and draws. The last two should hardly change from
+ * one world to the next while the population grows with the area.
+ *
+ * Nothing is drawn, the visible asteroids are counted with the same calls DrawWorld makes.
+ *
+ * Usage: ./bin/bench_world [--ticks N] [--seed S]
+ */
+
+#include "game.h"
+#include "utils.h"
+#include "world.h"
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Turning, thrusting and shooting in bursts, so the ship travels around the world
+static PlayerInput ScriptedInput(unsigned int *state, PlayerInput previous)
+{
+    *state = *state * 1664525u + 1013904223u;
+    if ((*state >> 24) > 30) return previous;
+
+    unsigned int bits = *state >> 8;
+    PlayerInput input = { 0 };
+    input.rotateLeft = bits & 1;
+    input.rotateRight = !input.rotateLeft && (bits & 2);
+    input.thrust = (bits & 12) != 0;
+    input.shoot = (bits & 16) != 0;
+    return input;
+}
+
+// A new game with every slot the world allows in use
+static void FillWorld(Game *game, unsigned int seed)
+{
+    InitHeadlessGame(game, seed);
+    BindSimulationRandom(&game->rngState);
+    for (int i = 0; i < worldAsteroidLimit; i++) SpawnAsteroids(&game->entities, 0);
+    RefreshAsteroidGrid(game);
+}
+
+static void RunWorld(int screensWide, int screensHigh, int ticks, unsigned int seed)
+{
+    SetWorldSize(SCREEN_WIDTH * screensWide, SCREEN_HEIGHT * screensHigh);
+
+    Game *game = malloc(sizeof(Game));
+    FillWorld(game, seed);
+
+    unsigned int inputState = seed;
+    PlayerInput input = { 0 };
+    long population = 0, gathered = 0, drawn = 0;
+    int indices[MAX_ASTEROIDS];
+    double stepSeconds = 0.0;
+
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        if (game->state != GAMEPLAY)
+        {
+            UnloadGame(game);
+            FillWorld(game, seed + tick);
+        }
+        input = ScriptedInput(&inputState, input);
+
+        double start = Now();
+        StepGameplay(game, &input);
+        stepSeconds += Now() - start;
+
+        // what DrawWorld would draw this frame
+        FocusWorldView(GetPlayer(&game->entities, 0).position);
+        int count = GatherVisibleAsteroids(&game->chunkGrid, &game->entities, indices);
+        for (int k = 0; k < count; k++)
+        {
+            Vector2 offsets[EDGE_COPIES];
+            Asteroid asteroid;
+            GetAsteroid(&game->entities, indices[k], &asteroid);
+            drawn += ViewImageOffsets(asteroid.position, asteroid.radius, offsets) > 0;
+        }
+        gathered += count;
+        population += EcsCount(&game->entities, ASTEROID_COMPONENTS);
+    }
+
+    // the asteroid update alone, chunked and at full rate, on the same field
+    static EcsWorld field;
+    field = game->entities;
+    Vector2 focus = GetPlayer(&game->entities, 0).position;
+
+    double start = Now();
+    for (int tick = 0; tick < ticks; tick++) UpdateWorldAsteroids(&field, &focus, 1, (unsigned int)tick);
+    double chunkedSeconds = Now() - start;
+
+    field = game->entities;
+    start = Now();
+    for (int tick = 0; tick < ticks; tick++)
+    {
+        EcsQuery query = EcsQueryAll(&field, ASTEROID_COMPONENTS);
+        while (EcsNextArchetype(&query))
+        {
+            Vector2 *position = EcsColumn(&query, COMPONENT_POSITION);
+            const Vector2 *velocity = EcsColumn(&query, COMPONENT_VELOCITY);
+            AsteroidSpin *spin = EcsColumn(&query, COMPONENT_SPIN);
+            for (int row = 0; row < query.count; row++) MoveAsteroid(&position[row], velocity[row], &spin[row], 1);
+        }
+    }
+    double fullSeconds = Now() - start;
+
+    printf("%2dx%-2d %5dx%-5d %3d chunks %6.1f   %6.2f us  %6.2f us  %6.2f us   %6.1f  %6.1f\n",
+           screensWide, screensHigh, worldWidth, worldHeight, game->chunkGrid.columns * game->chunkGrid.rows,
+           (double)population / ticks, stepSeconds / ticks * 1e6, chunkedSeconds / ticks * 1e6, fullSeconds / ticks * 1e6,
+           (double)gathered / ticks, (double)drawn / ticks);
+
+    UnloadGame(game);
+    free(game);
+}
+
+int main(int argc, char *argv[])
+{
+    int ticks = 20000;
+    unsigned int seed = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) ticks = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (unsigned int)atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--ticks N] [--seed S]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (ticks < 1) ticks = 1;
+
+    printf("%d ticks per world, window %dx%d\n", ticks, SCREEN_WIDTH, SCREEN_HEIGHT);
+    printf("screens world       chunks     asteroids   tick       chunked    full rate   gathered  drawn\n");
+    RunWorld(1, 1, ticks, seed);
+    RunWorld(2, 2, ticks, seed);
+    RunWorld(3, 3, ticks, seed);
+    RunWorld(4, 3, ticks, seed);
+    return 0;
+}
@@ -0,0 +1,207 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-16 17:02:40
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-16 19:21:13
+*/
+
+/*
+ * Bot evaluation harness. Plays the baseline bot over a lot of seeds, headless and on
+ * every core, and reports the score distribution, how long the ship survived and how
+ * many ticks per second the simulation ran at. Used to soak test balance changes like
+ * ASTEROID_SPEED or SHIP_DRAG without having to play hundreds of games by hand.
+ *
+ * --difficulty picks the wave director's difficulty (0 easy, 1 normal, 2 hard), and the wave the
+ * games got to and the spawns the director held back are printed with the rest.
+ *
+ * Usage: ./bin/bot_harness [--seeds N] [--first-seed S] [--threads T] [--max-ticks M] [--difficulty D]
+ */
+
+#include "game.h"
+#include "bot.h"
+#include <raylib.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct GameResult {
+    int score;
+    unsigned int ticks;
+    bool died;
+    int wave;
+    int heldBack;
+} GameResult;
+
+typedef struct HarnessJob {
+    unsigned int firstSeed;
+    int seeds;
+    unsigned int maxTicks;
+    int difficulty;
+    atomic_int nextGame;                       // games are handed out one at a time to whichever thread is free
+    atomic_ullong totalTicks;
+    GameResult *results;
+} HarnessJob;
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *HarnessWorker(void *arg)
+{
+    HarnessJob *job = arg;
+    Game *game = malloc(sizeof(Game));
+    Bot bot = CreateAimEvadeBot();
+
+    for (int i = atomic_fetch_add(&job->nextGame, 1); i < job->seeds; i = atomic_fetch_add(&job->nextGame, 1))
+    {
+        InitHeadlessGame(game, job->firstSeed + (unsigned int)i);
+        if (job->difficulty != DIRECTOR_NORMAL) StartWaveDirector(&game->director, job->difficulty, game->tick);
+
+        while (game->state == GAMEPLAY && game->tick < job->maxTicks)
+        {
+            PlayerInput input = RunBot(&bot, game);
+            StepGameplay(game, &input);
+        }
+
+        job->results[i].score = game->score;
+        job->results[i].ticks = game->tick;
+        job->results[i].died = game->state == GAME_OVER;
+        job->results[i].wave = game->director.wave;
+        job->results[i].heldBack = game->director.heldBack;
+        atomic_fetch_add(&job->totalTicks, game->tick);
+
+        UnloadGame(game);
+    }
+
+    free(game);
+    return NULL;
+}
+
+static int CompareInts(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+// Prints mean, spread and percentiles of a list of values (sorts it in place)
+static void PrintDistribution(const char *name, int *values, int count, double scale)
+{
+    qsort(values, count, sizeof(int), CompareInts);
+
+    double sum = 0.0, sumSquares = 0.0;
+    for (int i = 0; i < count; i++)
+    {
+        sum += values[i] * scale;
+        sumSquares += values[i] * scale * values[i] * scale;
+    }
+    double mean = sum / count;
+    double stddev = sqrt(fmax(0.0, sumSquares / count - mean * mean));
+
+    printf("%-14s mean %9.1f  sd %8.1f  min %8.1f  p10 %8.1f  p50 %8.1f  p90 %8.1f  max %8.1f\n",
+           name, mean, stddev, values[0] * scale, values[count / 10] * scale, values[count / 2] * scale,
+           values[(count * 9) / 10] * scale, values[count - 1] * scale);
+}
+
+// Text histogram of the scores, ten buckets between the lowest and highest score
+static void PrintScoreHistogram(const int *sortedScores, int count)
+{
+    int low = sortedScores[0], high = sortedScores[count - 1];
+    int width = (high - low) / 10 + 1;
+    int buckets[10] = { 0 };
+
+    for (int i = 0; i < count; i++)
+    {
+        int b = (sortedScores[i] - low) / width;
+        buckets[b > 9 ? 9 : b]++;
+    }
+
+    for (int b = 0; b < 10; b++)
+    {
+        int bar = (int)(50.0 * buckets[b] / count + 0.5);
+        printf("  %7d - %-7d %6d |", low + b * width, low + (b + 1) * width - 1, buckets[b]);
+        for (int i = 0; i < bar; i++) putchar('#');
+        putchar('\n');
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int seeds = 1000;
+    unsigned int firstSeed = 1;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int maxTicks = GAME_TICK_RATE * 60 * 5;     // five minutes of game time
+    int difficulty = DIRECTOR_NORMAL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seeds") == 0 && i + 1 < argc) seeds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--first-seed") == 0 && i + 1 < argc) firstSeed = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc) maxTicks = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--difficulty") == 0 && i + 1 < argc) difficulty = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--seeds N] [--first-seed S] [--threads T] [--max-ticks M] [--difficulty D]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (seeds < 1) seeds = 1;
+    if (threads < 1) threads = 1;
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    HarnessJob job = { .firstSeed = firstSeed, .seeds = seeds, .maxTicks = maxTicks, .difficulty = difficulty };
+    atomic_init(&job.nextGame, 0);
+    atomic_init(&job.totalTicks, 0);
+    job.results = calloc(seeds, sizeof(GameResult));
+
+    printf("Running bot '%s' on %d seeds (%u..%u) with %d threads, max %u ticks per game\n",
+           CreateAimEvadeBot().name, seeds, firstSeed, firstSeed + seeds - 1, threads, maxTicks);
+
+    double start = Now();
+    pthread_t *workers = malloc(sizeof(pthread_t) * threads);
+    for (int i = 0; i < threads; i++) pthread_create(&workers[i], NULL, HarnessWorker, &job);
+    for (int i = 0; i < threads; i++) pthread_join(workers[i], NULL);
+    double elapsed = Now() - start;
+
+    int *scores = malloc(sizeof(int) * seeds);
+    int *ticks = malloc(sizeof(int) * seeds);
+    int *waves = malloc(sizeof(int) * seeds);
+    int deaths = 0;
+    long heldBack = 0;
+    for (int i = 0; i < seeds; i++)
+    {
+        scores[i] = job.results[i].score;
+        ticks[i] = (int)job.results[i].ticks;
+        waves[i] = job.results[i].wave;
+        deaths += job.results[i].died;
+        heldBack += job.results[i].heldBack;
+    }
+
+    unsigned long long totalTicks = atomic_load(&job.totalTicks);
+
+    printf("\n");
+    PrintDistribution("score", scores, seeds, 1.0);
+    PrintDistribution("survival (s)", ticks, seeds, 1.0 / GAME_TICK_RATE);
+    PrintDistribution("wave reached", waves, seeds, 1.0);
+    printf("died before the tick limit: %d of %d (%.1f%%), spawns held back %.1f per game\n\n", deaths, seeds,
+           100.0 * deaths / seeds, (double)heldBack / seeds);
+    PrintScoreHistogram(scores, seeds);
+    printf("\n%llu ticks in %.2f s: %.0f ticks/s total, %.0f ticks/s per thread\n",
+           totalTicks, elapsed, totalTicks / elapsed, totalTicks / elapsed / threads);
+
+    free(scores);
+    free(ticks);
+    free(waves);
+    free(workers);
+    free(job.results);
+    return 0;
+}
@@ -0,0 +1,175 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-18 20:02:13
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-18 22:31:48
+*/
+
+/*
+ * Rollback test over a real UDP connection on 127.0.0.1. Two headless games play a versus match
+ * against each other in one process, one hosting and one joining, each behind a bad network
+ * (latency, jitter and loss from src/net.c). A frame is 1/60 of a second of a virtual clock, so
+ * the run is as fast as the machine and the delays are still exact.
+ *
+ * Both ships are flown by the aim and evade bot (or by random button mashing with --random, which
+ * is much harder on the predictions). At the end it reports how often each side had to roll back,
+ * how deep, what re-simulating cost per frame, how many frames stalled, how many guesses were
+ * right, the bandwidth, and whether the two sides ever disagreed about a confirmed state.
+ *
+ * Usage: ./bin/net_loopback [--ticks N] [--latency ms] [--jitter ms] [--loss percent] [--seed S] [--random]
+ */
+
+#include "game.h"
+#include "bot.h"
+#include "net.h"
+#include "rollback.h"
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static int CompareDoubles(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Button mashing that changes every few ticks, the bots are a lot more predictable than this
+static PlayerInput RandomInput(unsigned int *state, PlayerInput previous)
+{
+    *state = *state * 1664525u + 1013904223u;
+    if ((*state >> 24) > 40) return previous;
+
+    unsigned int bits = *state >> 8;
+    PlayerInput input = { 0 };
+    input.rotateLeft = bits & 1;
+    input.rotateRight = !input.rotateLeft && (bits & 2);
+    input.thrust = (bits & 4) != 0;
+    input.shoot = (bits & 8) != 0;
+    return input;
+}
+
+static void PrintSide(const char *name, const RollbackSession *session, double *resimTimes, int frames)
+{
+    const RollbackStats *stats = &session->stats;
+    const NetLink *link = &session->link;
+    double seconds = (double)stats->frames / GAME_TICK_RATE;
+
+    qsort(resimTimes, frames, sizeof(double), CompareDoubles);
+
+    printf("%s\n", name);
+    printf("  rollbacks        %.1f/s, %.2f ticks deep on average (%lu ticks resimulated)\n",
+           stats->rollbacks / seconds, stats->rollbacks > 0 ? (double)stats->resimulatedTicks / stats->rollbacks : 0.0,
+           stats->resimulatedTicks);
+    printf("  resim per frame  mean %.2f us  p99 %.2f us  max %.2f us\n",
+           stats->resimMicros / stats->frames, resimTimes[(frames * 99) / 100], resimTimes[frames - 1]);
+    printf("  stalls           %lu frames (%.2f%%), %lu held back to stay in step\n",
+           stats->stalls, 100.0 * stats->stalls / stats->frames, stats->syncWaits);
+    printf("  predictions      %lu/%lu right (%.1f%%)\n", stats->correctPredictions, stats->predictedTicks,
+           stats->predictedTicks > 0 ? 100.0 * stats->correctPredictions / stats->predictedTicks : 100.0);
+    printf("  sent             %lu packets, %.0f bytes/s, %lu dropped\n",
+           link->packetsSent, link->bytesSent / seconds, link->packetsDropped);
+    printf("  checksums        %lu compared, %lu desyncs\n", stats->checksumsCompared, stats->desyncs);
+}
+
+int main(int argc, char *argv[])
+{
+    int frames = GAME_TICK_RATE * 60;
+    unsigned int seed = 1;
+    bool randomInputs = false;
+    NetConditions conditions = { 60.0f, 15.0f, 5.0f };
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--latency") == 0 && i + 1 < argc) conditions.latencyMs = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--jitter") == 0 && i + 1 < argc) conditions.jitterMs = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--loss") == 0 && i + 1 < argc) conditions.lossPercent = (float)atof(argv[++i]);
+        else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) seed = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--random") == 0) randomInputs = true;
+        else
+        {
+            fprintf(stderr, "Usage: %s [--ticks N] [--latency ms] [--jitter ms] [--loss percent] [--seed S] [--random]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (frames < 1) frames = 1;
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    Game *games[2] = { malloc(sizeof(Game)), malloc(sizeof(Game)) };
+    RollbackSession *sessions[2] = { malloc(sizeof(RollbackSession)), malloc(sizeof(RollbackSession)) };
+    InitHeadlessGame(games[0], seed);
+    InitHeadlessGame(games[1], seed);
+
+    if (!HostRollbackSession(sessions[0], games[0], 0, conditions, seed) ||
+        !JoinRollbackSession(sessions[1], games[1], "127.0.0.1", GetNetLinkPort(&sessions[0]->link), conditions))
+    {
+        fprintf(stderr, "Could not open the loopback sockets\n");
+        return 1;
+    }
+
+    Bot bots[2] = { CreateAimEvadeBot(), CreateAimEvadeBot() };
+    PlayerInput inputs[2] = { 0 };
+    unsigned int randomStates[2] = { seed * 2 + 1, seed * 2 + 2 };
+    double *resimTimes[2] = { malloc(sizeof(double) * frames), malloc(sizeof(double) * frames) };
+    int counted[2] = { 0, 0 };
+
+    printf("%d frames, %.0f ms latency, %.0f ms jitter, %.1f%% loss, %s inputs, seed %u\n",
+           frames, conditions.latencyMs, conditions.jitterMs, conditions.lossPercent,
+           randomInputs ? "random" : "bot", seed);
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        double now = (double)frame / GAME_TICK_RATE;
+
+        for (int side = 0; side < 2; side++)
+        {
+            RollbackSession *session = sessions[side];
+
+            // the bot looks at this side's (partly predicted) game, the same way a person would
+            if (randomInputs) inputs[side] = RandomInput(&randomStates[side], inputs[side]);
+            else if (session->connected) inputs[side] = RunBotForShip(&bots[side], games[side], RollbackLocalSlot(session));
+
+            AdvanceRollbackSession(session, &inputs[side], now);
+
+            if (session->connected) resimTimes[side][counted[side]++] = session->stats.lastResimMicros;
+        }
+    }
+
+    for (int side = 0; side < 2; side++)
+    {
+        if (!sessions[side]->connected || counted[side] == 0)
+        {
+            fprintf(stderr, "The two sides never connected\n");
+            return 1;
+        }
+    }
+
+    PrintSide("host", sessions[0], resimTimes[0], counted[0]);
+    PrintSide("client", sessions[1], resimTimes[1], counted[1]);
+
+    // the newest state both sides have a checksum for has to be the same on both
+    unsigned int tick = sessions[0]->lastChecksumTick < sessions[1]->lastChecksumTick ? sessions[0]->lastChecksumTick : sessions[1]->lastChecksumTick;
+    unsigned int checksums[2];
+    bool compared = false;
+    for (int back = 0; back < ROLLBACK_HISTORY && !compared && tick >= (unsigned int)back; back++)
+    {
+        compared = RollbackChecksum(sessions[0], tick - back, &checksums[0]) && RollbackChecksum(sessions[1], tick - back, &checksums[1]);
+        if (compared) tick -= back;
+    }
+
+    printf("match             %s after %u ticks, P1 %d  P2 %d\n",
+           games[0]->state == GAME_OVER ? "over" : "still going", games[0]->tick, games[0]->score, games[0]->secondScore);
+    if (compared)
+    {
+        printf("final check       tick %u: host %08x, client %08x, %s\n", tick, checksums[0], checksums[1],
+               checksums[0] == checksums[1] ? "same" : "DIFFERENT");
+    }
+
+    bool ok = sessions[0]->stats.desyncs == 0 && sessions[1]->stats.desyncs == 0 && (!compared || checksums[0] == checksums[1]);
+
+    CloseRollbackSession(sessions[0]);
+    CloseRollbackSession(sessions[1]);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,292 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-20 22:47:15
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-21 00:32:40
+*/
+
+/*
+ * Renders the frames of a replay to numbered PNG files (frame_000000.png, ...), for turning a
+ * game into a video with something like ffmpeg -framerate 60 -i frame_%06d.png. Every segment
+ * of the replay starts from its own keyframe, so the segments don't depend on each other and
+ * each thread takes the next one that nobody is working on yet, with its own game and image.
+ *
+ * raylib's normal drawing goes through the one OpenGL context of the window, which can't be
+ * shared between threads, so the frames are drawn on the CPU with the Image functions instead:
+ * asteroids, bullets, saucers and ships the way DrawGame draws them, without the stars and the text.
+ *
+ * Usage: ./bin/replay_export <replay> [--out dir] [--threads T] [--from tick] [--to tick] [--every N] [--compare]
+ */
+
+#include "game.h"
+#include "replay.h"
+#include "trig.h"
+#include "ufo.h"
+#include "utils.h"
+#include <raylib.h>
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+typedef struct ExportJob {
+    const Replay *replay;
+    const char   *outDir;
+    unsigned int  from;                        // ticks [from, to) are exported
+    unsigned int  to;
+    unsigned int  every;                       // every Nth tick
+    int           firstSegment;
+    int           lastSegment;
+    atomic_int    nextSegment;                 // handed out one at a time to whichever thread is free
+    atomic_int    frames;
+    atomic_int    failed;
+} ExportJob;
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// The image has no alpha blending against what is under it, so faded things are darkened instead
+static Color Faded(Color color, float alpha)
+{
+    return (Color){ (unsigned char)(color.r * alpha), (unsigned char)(color.g * alpha), (unsigned char)(color.b * alpha), 255 };
+}
+
+static Vector2 Shifted(Vector2 point, Vector2 offset)
+{
+    return (Vector2){ point.x + offset.x, point.y + offset.y };
+}
+
+static void DrawShipImage(Image *image, const Player *player, Color color)
+{
+    Vector2 ship[3];
+    float cosA, sinA;
+    GetShipTriangle(player, ship);
+    SinCosDegrees(player->rotation, &sinA, &cosA);
+
+    // copies over the edges like DrawPlayerColored
+    Vector2 offsets[EDGE_COPIES];
+    int copies = EdgeGhostOffsets(player->position, SHIP_SIZE * 2.0f, offsets);
+
+    for (int c = 0; c < copies; c++)
+    {
+        ImageDrawLineV(image, Shifted(ship[0], offsets[c]), Shifted(ship[1], offsets[c]), color);
+        ImageDrawLineV(image, Shifted(ship[1], offsets[c]), Shifted(ship[2], offsets[c]), color);
+        ImageDrawLineV(image, Shifted(ship[2], offsets[c]), Shifted(ship[0], offsets[c]), color);
+
+        // the window version flickers the flame with GetRandomValue, here it has a fixed length
+        if (player->isThrusting)
+        {
+            Vector2 thrustPos = { player->position.x + offsets[c].x - cosA * SHIP_SIZE * 0.5f,
+                                  player->position.y + offsets[c].y - sinA * SHIP_SIZE * 0.5f };
+            ImageDrawLineV(image, thrustPos, (Vector2){ thrustPos.x - cosA * SHIP_SIZE, thrustPos.y - sinA * SHIP_SIZE }, YELLOW);
+        }
+    }
+}
+
+// The first ship's, a replay is a single player game
+static void DrawBulletsImage(Image *image, const EcsWorld *entities)
+{
+    for (int i = 0; i < MAX_BULLETS; i++)
+    {
+        Bullet bullet;
+        if (!GetBullet(entities, i, &bullet)) continue;
+
+        float alpha = BulletAlpha(bullet.lifeTime);
+        ImageDrawCircleV(image, bullet.position, (int)bullet.radius, Faded(bullet.color, alpha));
+        ImageDrawCircleV(image, bullet.position, (int)(bullet.radius * 0.5f), Faded(WHITE, alpha));
+    }
+}
+
+// Saucers as a ring and their shots as dots, the image has no line widths to draw the hull with
+static void DrawUfosImage(Image *image, EcsWorld *entities)
+{
+    EcsQuery query = EcsQueryAll(entities, COMPONENT_BIT(COMPONENT_POSITION) | COMPONENT_BIT(COMPONENT_RADIUS) | COMPONENT_BIT(COMPONENT_HOSTILE));
+    while (EcsNextArchetype(&query))
+    {
+        const Vector2 *position = EcsColumn(&query, COMPONENT_POSITION);
+        const float *radius = EcsColumn(&query, COMPONENT_RADIUS);
+        bool saucers = (query.archetype->mask & COMPONENT_BIT(COMPONENT_UFO)) != 0;
+
+        for (int row = 0; row < query.count; row++)
+        {
+            Vector2 offsets[EDGE_COPIES];
+            int copies = EdgeGhostOffsets(position[row], radius[row], offsets);
+            for (int c = 0; c < copies; c++)
+            {
+                Vector2 at = Shifted(position[row], offsets[c]);
+                if (saucers) ImageDrawCircleLines(image, (int)at.x, (int)at.y, (int)radius[row], LIME);
+                else ImageDrawCircleV(image, at, (int)radius[row], LIME);
+            }
+        }
+    }
+}
+
+static void DrawFrameImage(Image *image, Game *game)
+{
+    ImageClearBackground(image, BLACK);
+
+    for (int i = 0; i < MAX_ASTEROIDS; i++)
+    {
+        Asteroid asteroid;
+        if (!GetAsteroid(&game->entities, i, &asteroid)) continue;
+
+        float sinA, cosA;
+        Vector2 outline[ASTEROID_VERTICES + 1];
+        SinCos(asteroid.rotation, &sinA, &cosA);
+        AsteroidOutlinePoints(&asteroid, sinA, cosA, outline);
+
+        Vector2 offsets[EDGE_COPIES];
+        int copies = EdgeGhostOffsets(asteroid.position, asteroid.radius, offsets);
+        for (int c = 0; c < copies; c++)
+        {
+            for (int j = 1; j <= ASTEROID_VERTICES; j++)
+            {
+                ImageDrawLineV(image, Shifted(outline[j - 1], offsets[c]), Shifted(outline[j], offsets[c]), WHITE);
+            }
+        }
+    }
+
+    DrawBulletsImage(image, &game->entities);
+    DrawUfosImage(image, &game->entities);
+    Player ship = GetPlayer(&game->entities, 0);
+    DrawShipImage(image, &ship, WHITE);
+}
+
+static void *ExportWorker(void *arg)
+{
+    ExportJob *job = arg;
+    const Replay *replay = job->replay;
+    Game *game = malloc(sizeof(Game));
+    Image image = GenImageColor(worldWidth, worldHeight, BLACK);
+    char path[4096];
+
+    // only for the spatial grid, everything else comes from the keyframes
+    InitHeadlessGame(game, 1);
+
+    for (int k = job->firstSegment + atomic_fetch_add(&job->nextSegment, 1); k <= job->lastSegment;
+         k = job->firstSegment + atomic_fetch_add(&job->nextSegment, 1))
+    {
+        const ReplayKeyframe *segment = &replay->keyframes[k];
+        unsigned int first = segment->tick > job->from ? segment->tick : job->from;
+        unsigned int end = segment->tick + segment->inputCount < job->to ? segment->tick + segment->inputCount : job->to;
+
+        SeekReplay(replay, first, game);
+        for (unsigned int tick = first; tick < end; tick++)
+        {
+            StepReplay(replay, tick, game);
+            if ((tick - job->from) % job->every != 0) continue;
+
+            // frames are numbered from 0 without gaps, whatever --from and --every are
+            DrawFrameImage(&image, game);
+            snprintf(path, sizeof(path), "%s/frame_%06u.png", job->outDir, (tick - job->from) / job->every);
+            if (ExportImage(image, path)) atomic_fetch_add(&job->frames, 1);
+            else atomic_fetch_add(&job->failed, 1);
+        }
+    }
+
+    UnloadImage(image);
+    free(game);
+    return NULL;
+}
+
+static double RunExport(ExportJob *job, int threads)
+{
+    atomic_store(&job->nextSegment, 0);
+    atomic_store(&job->frames, 0);
+    atomic_store(&job->failed, 0);
+
+    double start = Now();
+    pthread_t *workers = malloc(sizeof(pthread_t) * threads);
+    for (int i = 0; i < threads; i++) pthread_create(&workers[i], NULL, ExportWorker, job);
+    for (int i = 0; i < threads; i++) pthread_join(workers[i], NULL);
+    free(workers);
+    return Now() - start;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *replayPath = NULL;
+    const char *outDir = "frames";
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    long from = 0, to = -1, every = 1;
+    bool compare = false;
+    bool usage = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) outDir = argv[++i];
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--from") == 0 && i + 1 < argc) from = atol(argv[++i]);
+        else if (strcmp(argv[i], "--to") == 0 && i + 1 < argc) to = atol(argv[++i]);
+        else if (strcmp(argv[i], "--every") == 0 && i + 1 < argc) every = atol(argv[++i]);
+        else if (strcmp(argv[i], "--compare") == 0) compare = true;
+        else if (argv[i][0] != '-' && replayPath == NULL) replayPath = argv[i];
+        else usage = true;
+    }
+    if (usage || replayPath == NULL)
+    {
+        fprintf(stderr, "Usage: %s <replay> [--out dir] [--threads T] [--from tick] [--to tick] [--every N] [--compare]\n", argv[0]);
+        return 1;
+    }
+    if (threads < 1) threads = 1;
+    if (every < 1) every = 1;
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    Replay replay;
+    if (!OpenReplay(&replay, replayPath))
+    {
+        fprintf(stderr, "Could not open the replay %s\n", replayPath);
+        return 1;
+    }
+    if (mkdir(outDir, 0755) != 0 && errno != EEXIST)
+    {
+        fprintf(stderr, "Could not create %s\n", outDir);
+        return 1;
+    }
+
+    // set before the threads start, they only ever read it. The frames show the whole world, not just the window
+    screenWidth = replay.header->screenWidth;
+    screenHeight = replay.header->screenHeight;
+    worldWidth = replay.keyframes[0].worldWidth;
+    worldHeight = replay.keyframes[0].worldHeight;
+    worldAsteroidLimit = replay.keyframes[0].asteroidLimit;
+
+    unsigned int ticks = ReplayTicks(&replay);
+    if (to < 0 || to > (long)ticks) to = ticks;
+    if (from < 0) from = 0;
+    if (from >= to)
+    {
+        fprintf(stderr, "Nothing to export, the replay has %u ticks\n", ticks);
+        return 1;
+    }
+
+    ExportJob job = { .replay = &replay, .outDir = outDir, .from = (unsigned int)from, .to = (unsigned int)to,
+                      .every = (unsigned int)every };
+    job.firstSegment = FindReplayKeyframe(&replay, job.from);
+    job.lastSegment = FindReplayKeyframe(&replay, job.to - 1);
+
+    printf("Exporting ticks %u..%u of %s (%d segments) to %s with %d threads\n",
+           job.from, job.to - 1, replayPath, job.lastSegment - job.firstSegment + 1, outDir, threads);
+
+    double single = compare ? RunExport(&job, 1) : 0.0;
+    double elapsed = RunExport(&job, threads);
+    int frames = atomic_load(&job.frames);
+
+    printf("  %d frames in %.2f s, %.0f frames/s\n", frames, elapsed, frames / elapsed);
+    if (compare) printf("  1 thread took %.2f s, %.2fx faster with %d threads\n", single, single / elapsed, threads);
+    if (atomic_load(&job.failed) > 0) fprintf(stderr, "  %d frames could not be written\n", atomic_load(&job.failed));
+
+    CloseReplay(&replay);
+    return atomic_load(&job.failed) == 0 ? 0 : 1;
+}
@@ -0,0 +1,284 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-30 09:47:21
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-30 15:02:36
+*/
+
+/*
+ * Plays recorded replays headlessly and times the hot functions of the tick on the states the
+ * games really went through. This is the training run of the profile guided build (make pgo) and
+ * the measuring stick of make pgo-compare.
+ *
+ * Before every tick the tick's kernels run once more on copies of the state, in the order
+ * StepGameplay runs them, and each call is timed on its own: UpdatePlayer with the recorded
+ * input, UpdateWorldAsteroids, UpdateBullets, checkCollisions, UpdateUfos. Then the tick itself
+ * is played and timed. So the profile sees the branches real games take (what the bullets hit,
+ * how many asteroids are near the ship), not a loop made up for it. Every pass keeps its own
+ * means and the report has the best pass of each function, the least disturbed by the rest of
+ * the machine. The clock reads are in every number, the same in every build.
+ *
+ * --out writes the table for a later run to compare against with --against, which adds the
+ * speedup of every function. The state hash at the end has to be the same in both builds, the
+ * optimizer is only allowed to make the game faster, not different.
+ *
+ * Usage: ./bin/replay_profile [--passes N] [--out file] [--against file] replay.astr...
+ */
+
+#include "game.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "ufo.h"
+#include "utils.h"
+#include <raylib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_REPLAYS 64
+
+typedef enum ProfiledFunction {
+    PROFILE_PLAYER,
+    PROFILE_ASTEROIDS,
+    PROFILE_BULLETS,
+    PROFILE_COLLISIONS,
+    PROFILE_UFOS,
+    PROFILE_GRID,
+    PROFILE_SNAPSHOT,
+    PROFILE_TICK,
+    PROFILE_COUNT
+} ProfiledFunction;
+
+static const char *functionNames[PROFILE_COUNT] = {
+    "UpdatePlayer", "UpdateWorldAsteroids", "UpdateBullets", "checkCollisions",
+    "UpdateUfos", "RefreshAsteroidGrid", "CaptureSimSnapshot", "StepGameplay(tick)"
+};
+
+typedef struct Timings {
+    double    seconds[PROFILE_COUNT];
+    long long calls[PROFILE_COUNT];
+} Timings;
+
+// The state the kernels are run on, copied from the game before every tick
+static EcsWorld    scratchEntities;
+static SimSnapshot scratchSnapshot;
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void Lap(Timings *timings, ProfiledFunction function, double *mark)
+{
+    double now = Now();
+    timings->seconds[function] += now - *mark;
+    timings->calls[function]++;
+    *mark = now;
+}
+
+/*
+ * The kernels of the coming tick on copies, in StepGameplay's order so each one sees what the
+ * one before it left. They get their own random generator, a copy of the game's, so the spawns
+ * in the splits go the same way without moving the game's generator on.
+ */
+static void ProfileKernels(Game *game, const PlayerInput *input, Timings *timings)
+{
+    unsigned int rngState = game->rngState;
+    BindSimulationRandom(&rngState);
+    BindTunables(&game->tunables);
+
+    scratchEntities = game->entities;
+    int score = game->score;
+    GameState state = game->state;
+
+    double mark = Now();
+    UpdatePlayer(&scratchEntities, 0, input);
+    Vector2 ship = GetPlayer(&scratchEntities, 0).position;
+    Lap(timings, PROFILE_PLAYER, &mark);
+    UpdateWorldAsteroids(&scratchEntities, &ship, 1, game->tick);
+    Lap(timings, PROFILE_ASTEROIDS, &mark);
+    UpdateBullets(&scratchEntities);
+    Lap(timings, PROFILE_BULLETS, &mark);
+    checkCollisions(&scratchEntities, &scratchEntities, 0, &score, &state);
+    Lap(timings, PROFILE_COLLISIONS, &mark);
+    UpdateUfos(&scratchEntities, 0, &score);
+    Lap(timings, PROFILE_UFOS, &mark);
+
+    // both only read the game, the grid comes out the same as it already is
+    RefreshAsteroidGrid(game);
+    Lap(timings, PROFILE_GRID, &mark);
+    CaptureSimSnapshot(game, &scratchSnapshot);
+    Lap(timings, PROFILE_SNAPSHOT, &mark);
+}
+
+// Plays one replay from the start, the hashes of where every replay ended go into *stateHash
+static void PlayReplay(const Replay *replay, Game *game, Timings *timings, unsigned int *stateHash)
+{
+    InitHeadlessGame(game, 1);
+    unsigned int ticks = ReplayTicks(replay);
+
+    for (unsigned int tick = 0; tick < ticks; tick++)
+    {
+        // a keyframe has to be in place before the copies are taken, StepReplay would load it anyway
+        int keyframe = FindReplayKeyframe(replay, tick);
+        if (replay->keyframes[keyframe].tick == tick) RestoreReplayKeyframe(replay, keyframe, game);
+
+        PlayerInput input = GetReplayInput(replay, tick);
+        ProfileKernels(game, &input, timings);
+
+        double mark = Now();
+        StepReplay(replay, tick, game);
+        Lap(timings, PROFILE_TICK, &mark);
+    }
+
+    CaptureSimSnapshot(game, &scratchSnapshot);
+    *stateHash = (*stateHash ^ HashSimSnapshot(&scratchSnapshot)) * 16777619u;
+}
+
+// A table written by --out: one line per function, name then calls then nanoseconds per call
+static bool ReadBaseline(const char *path, double baseline[PROFILE_COUNT], unsigned int *stateHash)
+{
+    FILE *file = fopen(path, "r");
+    if (file == NULL) return false;
+
+    for (int f = 0; f < PROFILE_COUNT; f++) baseline[f] = 0.0;
+    *stateHash = 0;
+
+    char name[64];
+    long long calls;
+    double nanoseconds;
+    while (fscanf(file, "%63s", name) == 1)
+    {
+        if (strcmp(name, "state") == 0)
+        {
+            if (fscanf(file, "%x", stateHash) != 1) break;
+            continue;
+        }
+        if (fscanf(file, "%lld %lf", &calls, &nanoseconds) != 2) break;
+        for (int f = 0; f < PROFILE_COUNT; f++)
+        {
+            if (strcmp(name, functionNames[f]) == 0) baseline[f] = nanoseconds;
+        }
+    }
+
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    int passes = 3;
+    const char *outPath = NULL;
+    const char *againstPath = NULL;
+    const char *paths[MAX_REPLAYS];
+    int replayCount = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--passes") == 0 && i + 1 < argc) passes = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+        else if (strcmp(argv[i], "--against") == 0 && i + 1 < argc) againstPath = argv[++i];
+        else if (argv[i][0] != '-' && replayCount < MAX_REPLAYS) paths[replayCount++] = argv[i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [--passes N] [--out file] [--against file] replay.astr...\n", argv[0]);
+            return 1;
+        }
+    }
+    if (passes < 1) passes = 1;
+    if (replayCount == 0)
+    {
+        fprintf(stderr, "No replays given, record some games with ./bin/asteroids --record file.astr\n");
+        return 1;
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    Replay replays[MAX_REPLAYS];
+    unsigned long long totalTicks = 0;
+    for (int r = 0; r < replayCount; r++)
+    {
+        if (!OpenReplay(&replays[r], paths[r]))
+        {
+            fprintf(stderr, "Could not open the replay %s (written by a different build?)\n", paths[r]);
+            return 1;
+        }
+        totalTicks += ReplayTicks(&replays[r]);
+    }
+
+    // the best pass of every function, as nanoseconds per call
+    double best[PROFILE_COUNT];
+    long long calls[PROFILE_COUNT] = { 0 };
+    for (int f = 0; f < PROFILE_COUNT; f++) best[f] = -1.0;
+
+    Game *game = malloc(sizeof(Game));
+    unsigned int stateHash = 2166136261u;
+    double start = Now();
+    for (int pass = 0; pass < passes; pass++)
+    {
+        Timings timings;
+        memset(&timings, 0, sizeof(timings));
+        unsigned int passHash = 2166136261u;
+
+        for (int r = 0; r < replayCount; r++) PlayReplay(&replays[r], game, &timings, &passHash);
+        stateHash = passHash;
+
+        for (int f = 0; f < PROFILE_COUNT; f++)
+        {
+            if (timings.calls[f] == 0) continue;
+            double perCall = timings.seconds[f] * 1e9 / timings.calls[f];
+            if (best[f] < 0.0 || perCall < best[f]) best[f] = perCall;
+            calls[f] = timings.calls[f];
+        }
+    }
+    double seconds = Now() - start;
+
+    double baseline[PROFILE_COUNT] = { 0 };
+    unsigned int baselineHash = 0;
+    bool comparing = againstPath != NULL;
+    if (comparing && !ReadBaseline(againstPath, baseline, &baselineHash))
+    {
+        fprintf(stderr, "Could not read %s\n", againstPath);
+        comparing = false;
+    }
+
+    printf("%d replays, %llu ticks (%.1f minutes of play), %d passes in %.1f s, best pass per function\n",
+           replayCount, totalTicks, totalTicks / (double)GAME_TICK_RATE / 60.0, passes, seconds);
+    printf("  %-22s %10s %12s", "function", "calls", "ns per call");
+    if (comparing) printf(" %12s %8s", "baseline", "speedup");
+    printf("\n");
+
+    for (int f = 0; f < PROFILE_COUNT; f++)
+    {
+        if (best[f] < 0.0) continue;
+        printf("  %-22s %10lld %12.1f", functionNames[f], calls[f], best[f]);
+        if (comparing && baseline[f] > 0.0) printf(" %12.1f %7.2fx", baseline[f], baseline[f] / best[f]);
+        printf("\n");
+    }
+    printf("  state hash %08x", stateHash);
+    if (comparing) printf(", baseline %08x%s", baselineHash, baselineHash == stateHash ? " (same)" : " (DIFFERENT, the builds don't simulate the same)");
+    printf("\n");
+
+    if (outPath != NULL)
+    {
+        FILE *file = fopen(outPath, "w");
+        if (file == NULL)
+        {
+            fprintf(stderr, "Could not write %s\n", outPath);
+            return 1;
+        }
+        for (int f = 0; f < PROFILE_COUNT; f++)
+        {
+            if (best[f] >= 0.0) fprintf(file, "%s %lld %.3f\n", functionNames[f], calls[f], best[f]);
+        }
+        fprintf(file, "state %08x\n", stateHash);
+        fclose(file);
+    }
+
+    for (int r = 0; r < replayCount; r++) CloseReplay(&replays[r]);
+    free(game);
+    return comparing && baselineHash != stateHash ? 1 : 0;
+}
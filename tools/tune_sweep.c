@@ -0,0 +1,391 @@
+/*
+* @Author: karlosiric
+* @Date:   2025-05-27 13:15:02
+* @Last Modified by:   karlosiric
+* @Last Modified time: 2025-05-27 16:48:37
+*/
+
+/*
+ * Parameter sweep over the gameplay tunables (include/tunables.h). Every point of the sweep is a
+ * set of tunables, and the baseline bot plays the same seeds at each of them, headless and on every
+ * core like bot_harness. The result is a table with one row per point: score, how long the ship
+ * lasted and how often it died. Balancing goes from a recompile per try to one run.
+ *
+ * Each --set is one axis of the sweep:
+ *   --set ASTEROID_SPEED=0.6,0.8,1.0        these values
+ *   --set SHIP_DRAG=0.95:0.99:5             5 values evenly from 0.95 to 0.99 (no :5 is just the two ends)
+ * The points are every combination of the axes, or with --random N, N points that each take a
+ * random value from every axis (anywhere in a lo:hi range, one of the values of a list). Tunables
+ * without an axis keep their defaults.
+ *
+ * Usage: ./bin/tune_sweep --set NAME=VALUES [--set ...] [--random N] [--sample-seed S] [--seeds N]
+ *                         [--first-seed S] [--threads T] [--max-ticks M] [--out results.csv]
+ */
+
+#include "game.h"
+#include "bot.h"
+#include "tunables.h"
+#include <raylib.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define MAX_AXIS_VALUES 64
+#define MAX_POINTS      100000
+
+// One --set, either a list of values or a range
+typedef struct SweepAxis {
+    int    tunable;
+    int    count;
+    double values[MAX_AXIS_VALUES];
+    bool   range;                              // lo:hi:steps, --random picks anywhere between values[0] and the last
+} SweepAxis;
+
+typedef struct GameResult {
+    int score;
+    unsigned int ticks;
+    bool died;
+} GameResult;
+
+typedef struct SweepJob {
+    Tunables *points;
+    int pointCount;
+    int seeds;                                 // games per point, the same seeds at every point
+    unsigned int firstSeed;
+    unsigned int maxTicks;
+    atomic_int nextGame;                       // point * seeds + seed, handed out one at a time
+    atomic_ullong totalTicks;
+    GameResult *results;
+} SweepJob;
+
+static double Now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *SweepWorker(void *arg)
+{
+    SweepJob *job = arg;
+    Game *game = malloc(sizeof(Game));
+    Bot bot = CreateAimEvadeBot();
+    int total = job->pointCount * job->seeds;
+
+    for (int i = atomic_fetch_add(&job->nextGame, 1); i < total; i = atomic_fetch_add(&job->nextGame, 1))
+    {
+        int point = i / job->seeds;
+        InitTunedHeadlessGame(game, job->firstSeed + (unsigned int)(i % job->seeds), &job->points[point]);
+
+        while (game->state == GAMEPLAY && game->tick < job->maxTicks)
+        {
+            PlayerInput input = RunBot(&bot, game);
+            StepGameplay(game, &input);
+        }
+
+        job->results[i].score = game->score;
+        job->results[i].ticks = game->tick;
+        job->results[i].died = game->state == GAME_OVER;
+        atomic_fetch_add(&job->totalTicks, game->tick);
+
+        UnloadGame(game);
+    }
+
+    free(game);
+    return NULL;
+}
+
+// NAME=a,b,c or NAME=lo:hi:steps
+static bool ParseAxis(const char *text, SweepAxis *axis)
+{
+    const char *equals = strchr(text, '=');
+    if (equals == NULL) return false;
+
+    char name[64];
+    size_t length = (size_t)(equals - text);
+    if (length == 0 || length >= sizeof(name)) return false;
+    memcpy(name, text, length);
+    name[length] = '\0';
+
+    axis->tunable = FindTunable(name);
+    if (axis->tunable < 0) return false;
+
+    const char *values = equals + 1;
+    double low, high;
+    int steps;
+    char end;
+    if (strchr(values, ':') != NULL)
+    {
+        int read = sscanf(values, "%lf:%lf:%d%c", &low, &high, &steps, &end);
+        if (read == 2) steps = 2;                              // just the ends, --random needs no more
+        else if (read != 3 || steps < 1 || steps > MAX_AXIS_VALUES) return false;
+
+        axis->range = true;
+        axis->count = steps;
+        for (int s = 0; s < steps; s++) axis->values[s] = steps == 1 ? low : low + (high - low) * s / (steps - 1);
+        return true;
+    }
+
+    axis->range = false;
+    axis->count = 0;
+    while (*values != '\0' && axis->count < MAX_AXIS_VALUES)
+    {
+        char *next;
+        axis->values[axis->count++] = strtod(values, &next);
+        if (next == values || (*next != ',' && *next != '\0')) return false;
+        values = *next == ',' ? next + 1 : next;
+    }
+    return axis->count > 0 && *values == '\0';
+}
+
+// xorshift32 like the simulation's, the sample seed makes a random sweep repeatable
+static double SampleUniform(unsigned int *state)
+{
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return (x >> 8) / 16777216.0;
+}
+
+// Every combination of the axes, the last axis changing fastest
+static int BuildGrid(const SweepAxis axes[], int axisCount, Tunables **points)
+{
+    long count = 1;
+    for (int a = 0; a < axisCount; a++) count *= axes[a].count;
+    if (count > MAX_POINTS) return -1;
+
+    *points = malloc(sizeof(Tunables) * count);
+    for (long p = 0; p < count; p++)
+    {
+        Tunables tunables = DefaultTunables();
+        long rest = p;
+        for (int a = axisCount - 1; a >= 0; a--)
+        {
+            SetTunable(&tunables, axes[a].tunable, axes[a].values[rest % axes[a].count]);
+            rest /= axes[a].count;
+        }
+        (*points)[p] = tunables;
+    }
+    return (int)count;
+}
+
+static int BuildRandomSample(const SweepAxis axes[], int axisCount, int count, unsigned int sampleSeed, Tunables **points)
+{
+    unsigned int state = sampleSeed ? sampleSeed : 1;
+
+    *points = malloc(sizeof(Tunables) * count);
+    for (int p = 0; p < count; p++)
+    {
+        Tunables tunables = DefaultTunables();
+        for (int a = 0; a < axisCount; a++)
+        {
+            const SweepAxis *axis = &axes[a];
+            double u = SampleUniform(&state);
+            double value = axis->range ? axis->values[0] + (axis->values[axis->count - 1] - axis->values[0]) * u
+                                       : axis->values[(int)(u * axis->count)];
+            SetTunable(&tunables, axis->tunable, value);
+        }
+        (*points)[p] = tunables;
+    }
+    return count;
+}
+
+typedef struct PointSummary {
+    double scoreMean;
+    double scoreSpread;
+    int    scoreMedian;
+    double survivalMean;                       // seconds
+    double diedPercent;
+} PointSummary;
+
+static int CompareInts(const void *a, const void *b)
+{
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+static PointSummary SummarizePoint(const GameResult results[], int seeds, int *scratch)
+{
+    PointSummary summary = { 0 };
+    double sum = 0.0, sumSquares = 0.0, ticks = 0.0;
+    int deaths = 0;
+
+    for (int s = 0; s < seeds; s++)
+    {
+        scratch[s] = results[s].score;
+        sum += results[s].score;
+        sumSquares += (double)results[s].score * results[s].score;
+        ticks += results[s].ticks;
+        deaths += results[s].died;
+    }
+    qsort(scratch, seeds, sizeof(int), CompareInts);
+
+    summary.scoreMean = sum / seeds;
+    summary.scoreSpread = sqrt(fmax(0.0, sumSquares / seeds - summary.scoreMean * summary.scoreMean));
+    summary.scoreMedian = scratch[seeds / 2];
+    summary.survivalMean = ticks / seeds / GAME_TICK_RATE;
+    summary.diedPercent = 100.0 * deaths / seeds;
+    return summary;
+}
+
+static void PrintValue(FILE *out, const Tunables *tunables, int tunable, int width)
+{
+    if (TunableIsInteger(tunable)) fprintf(out, "%*d", width, (int)GetTunable(tunables, tunable));
+    else fprintf(out, "%*.4g", width, GetTunable(tunables, tunable));
+}
+
+int main(int argc, char *argv[])
+{
+    SweepAxis axes[TUNABLE_COUNT];
+    int axisCount = 0;
+    int randomPoints = 0;
+    unsigned int sampleSeed = 1;
+    int seeds = 100;
+    unsigned int firstSeed = 1;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    unsigned int maxTicks = GAME_TICK_RATE * 60 * 5;     // five minutes of game time
+    const char *outPath = NULL;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--set") == 0 && i + 1 < argc && axisCount < TUNABLE_COUNT)
+        {
+            if (!ParseAxis(argv[++i], &axes[axisCount]))
+            {
+                fprintf(stderr, "Can't read --set %s, it takes NAME=a,b,c or NAME=lo:hi[:steps] with NAME one of\n ", argv[i]);
+                for (int t = 0; t < TUNABLE_COUNT; t++) fprintf(stderr, " %s", TunableName(t));
+                fprintf(stderr, "\n");
+                return 1;
+            }
+            axisCount++;
+        }
+        else if (strcmp(argv[i], "--random") == 0 && i + 1 < argc) randomPoints = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--sample-seed") == 0 && i + 1 < argc) sampleSeed = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--seeds") == 0 && i + 1 < argc) seeds = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--first-seed") == 0 && i + 1 < argc) firstSeed = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--max-ticks") == 0 && i + 1 < argc) maxTicks = (unsigned int)atoi(argv[++i]);
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s --set NAME=VALUES [--set ...] [--random N] [--sample-seed S] [--seeds N]\n"
+                            "       [--first-seed S] [--threads T] [--max-ticks M] [--out results.csv]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (seeds < 1) seeds = 1;
+    if (threads < 1) threads = 1;
+
+    Tunables *points = NULL;
+    int pointCount;
+    if (axisCount == 0)
+    {
+        // nothing to sweep, the defaults on their own
+        points = malloc(sizeof(Tunables));
+        points[0] = DefaultTunables();
+        pointCount = 1;
+    }
+    else if (randomPoints > 0)
+    {
+        pointCount = BuildRandomSample(axes, axisCount, randomPoints > MAX_POINTS ? MAX_POINTS : randomPoints, sampleSeed, &points);
+    }
+    else
+    {
+        pointCount = BuildGrid(axes, axisCount, &points);
+        if (pointCount < 0)
+        {
+            fprintf(stderr, "More than %d points in the grid, use fewer values or --random\n", MAX_POINTS);
+            return 1;
+        }
+    }
+
+    SetTraceLogLevel(LOG_WARNING);
+
+    SweepJob job = { .points = points, .pointCount = pointCount, .seeds = seeds, .firstSeed = firstSeed, .maxTicks = maxTicks };
+    atomic_init(&job.nextGame, 0);
+    atomic_init(&job.totalTicks, 0);
+    job.results = calloc((size_t)pointCount * seeds, sizeof(GameResult));
+
+    printf("Sweeping %d points x %d seeds (%u..%u) with %d threads, max %u ticks per game\n\n",
+           pointCount, seeds, firstSeed, firstSeed + seeds - 1, threads, maxTicks);
+
+    double start = Now();
+    pthread_t *workers = malloc(sizeof(pthread_t) * threads);
+    for (int i = 0; i < threads; i++) pthread_create(&workers[i], NULL, SweepWorker, &job);
+    for (int i = 0; i < threads; i++) pthread_join(workers[i], NULL);
+    double elapsed = Now() - start;
+
+    FILE *csv = NULL;
+    if (outPath != NULL)
+    {
+        csv = fopen(outPath, "w");
+        if (csv == NULL) fprintf(stderr, "Can't write %s, the table only goes to the screen\n", outPath);
+    }
+
+    // the table has a column for every tunable that was swept
+    for (int a = 0; a < axisCount; a++) printf("%*s ", (int)strlen(TunableName(axes[a].tunable)), TunableName(axes[a].tunable));
+    printf("%10s %9s %8s %12s %7s\n", "score", "sd", "median", "survival s", "died %");
+    if (csv != NULL)
+    {
+        for (int t = 0; t < TUNABLE_COUNT; t++) fprintf(csv, "%s,", TunableName(t));
+        fprintf(csv, "seeds,score_mean,score_sd,score_median,survival_mean_s,died_percent\n");
+    }
+
+    int *scratch = malloc(sizeof(int) * seeds);
+    int best = 0;
+    double bestScore = -1.0;
+    for (int p = 0; p < pointCount; p++)
+    {
+        PointSummary summary = SummarizePoint(&job.results[(size_t)p * seeds], seeds, scratch);
+        if (summary.scoreMean > bestScore)
+        {
+            bestScore = summary.scoreMean;
+            best = p;
+        }
+
+        for (int a = 0; a < axisCount; a++)
+        {
+            PrintValue(stdout, &points[p], axes[a].tunable, (int)strlen(TunableName(axes[a].tunable)));
+            putchar(' ');
+        }
+        printf("%10.1f %9.1f %8d %12.1f %7.1f\n", summary.scoreMean, summary.scoreSpread, summary.scoreMedian,
+               summary.survivalMean, summary.diedPercent);
+
+        if (csv != NULL)
+        {
+            for (int t = 0; t < TUNABLE_COUNT; t++)
+            {
+                PrintValue(csv, &points[p], t, 0);
+                fputc(',', csv);
+            }
+            fprintf(csv, "%d,%.2f,%.2f,%d,%.2f,%.2f\n", seeds, summary.scoreMean, summary.scoreSpread, summary.scoreMedian,
+                    summary.survivalMean, summary.diedPercent);
+        }
+    }
+
+    unsigned long long totalTicks = atomic_load(&job.totalTicks);
+    if (axisCount > 0)
+    {
+        printf("\nhighest mean score at point %d:", best + 1);
+        for (int a = 0; a < axisCount; a++) printf(" %s=%g", TunableName(axes[a].tunable), GetTunable(&points[best], axes[a].tunable));
+    }
+    printf("\n%d games, %llu ticks in %.2f s: %.0f ticks/s total\n", pointCount * seeds, totalTicks, elapsed, totalTicks / elapsed);
+    if (csv != NULL)
+    {
+        fclose(csv);
+        printf("table written to %s\n", outPath);
+    }
+
+    free(scratch);
+    free(workers);
+    free(job.results);
+    free(points);
+    return 0;
+}